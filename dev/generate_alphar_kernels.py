@@ -0,0 +1,183 @@
+"""
+Generate specialized kernels for the generalized exponential terms of the
+residual Helmholtz energy of a few fluids that are used a lot.
+
+The coefficients are read from dev/fluids/*.json and written into the code as
+literals; the terms are unrolled, the factors of the derivatives of the
+polynomial terms are computed here, and u = -delta^l and its derivatives are
+shared between all the terms with the same l.  The operations on each term are
+the same as in ResidualHelmholtzGeneralizedExponential::all(), but the literals
+can differ in the last bit from the coefficients parsed from the JSON, so the
+results agree with the generic evaluation to 1e-12 rather than bit for bit.  The
+kernels are compiled in when CMake is run with -DCOOLPROP_SPECIALIZED_KERNELS=ON,
+which is the default for the builds of the Catch tests (-DCOOLPROP_CATCH_MODULE=ON),
+and are attached to a fluid by attach_specialized_alphar_kernel() in
+HelmholtzEOSBackend if the coefficients that were loaded are the same as the
+ones the kernel was generated from, up to that last bit.
+
+Usage: python generate_alphar_kernels.py [Fluid1 Fluid2 ...]
+"""
+from __future__ import division, print_function, unicode_literals
+from datetime import datetime
+import os
+import sys
+import json
+
+repo_root_path = os.path.normpath(os.path.join(os.path.abspath(__file__), '..', '..'))
+
+default_fluids = ['Water', 'CarbonDioxide', 'Nitrogen', 'R1234yf', 'n-Propane']
+
+# The order of the coefficients of an element in the table of the generated file, the same
+# as the fields of ResidualHelmholtzGeneralizedExponentialElement
+element_keys = ['n', 'd', 't', 'c', 'l', 'omega', 'm', 'eta1', 'epsilon1', 'eta2', 'epsilon2', 'beta1', 'gamma1', 'beta2', 'gamma2']
+flag_keys = ['delta_li_in_u', 'tau_mi_in_u', 'eta1_in_u', 'eta2_in_u', 'beta1_in_u', 'beta2_in_u']
+
+
+class UnsupportedTerm(Exception):
+    pass
+
+
+def literal(x):
+    """ A C++ literal that gives back exactly the same double """
+    s = repr(float(x))
+    if 'e' not in s and '.' not in s and 'n' not in s:
+        s += '.0'
+    return s
+
+
+def to_elements(alphar):
+    """ Convert the JSON terms in the same way as ResidualHelmholtzGeneralizedExponential::add_Power and add_Gaussian """
+    elements = []
+    flags = dict([(k, False) for k in flag_keys])
+    for term in alphar:
+        if term['type'] == 'ResidualHelmholtzPower':
+            for n, d, t, l in zip(term['n'], term['d'], term['t'], term['l']):
+                el = dict([(k, 0.0) for k in element_keys])
+                el.update(n=n, d=d, t=t, l=l, c=1.0 if l > 0 else 0.0)
+                elements.append(el)
+            flags['delta_li_in_u'] = True
+        elif term['type'] == 'ResidualHelmholtzGaussian':
+            for n, d, t, eta, epsilon, beta, gamma in zip(term['n'], term['d'], term['t'], term['eta'], term['epsilon'], term['beta'], term['gamma']):
+                el = dict([(k, 0.0) for k in element_keys])
+                el.update(n=n, d=d, t=t, eta2=eta, epsilon2=epsilon, beta2=beta, gamma2=gamma)
+                elements.append(el)
+            flags['eta2_in_u'] = True
+            flags['beta2_in_u'] = True
+        elif term['type'] in ['ResidualHelmholtzNonAnalytic', 'ResidualHelmholtzSAFTAssociating', 'ResidualHelmholtzXiangDeiters', 'ResidualHelmholtzGaoB']:
+            # Not a part of the generalized exponential terms, stays with the generic implementation
+            pass
+        else:
+            raise UnsupportedTerm(term['type'])
+    for el in elements:
+        if el['l'] > 0 and el['l'] != int(el['l']):
+            raise UnsupportedTerm('non-integer l')
+    return elements, flags
+
+
+def constant_B(p):
+    """ The same as generalized_exponential_B(1.0, p, 0, 0, 0, 0, B) """
+    B0 = 1.0 * 0 + p
+    B1 = 1.0 * 0 + (B0 - 1) * B0
+    B2 = 1.0 * 0 + (B0 - 2) * B1
+    B3 = 1.0 * 0 + (B0 - 3) * B2
+    return [B0, B1, B2, B3]
+
+
+def kernel_code(fluid, elements, flags):
+    poly = [el for el in elements if el['c'] == 0 and el['eta2'] == 0 and el['beta2'] == 0]
+    expo = [el for el in elements if el['c'] != 0]
+    gauss = [el for el in elements if el['c'] == 0 and (el['eta2'] != 0 or el['beta2'] != 0)]
+    ls = sorted(set([int(el['l']) for el in expo]))
+    ident = fluid.replace('-', '_')
+
+    lines = []
+    lines.append('/// {f:s}: {p:d} polynomial, {e:d} exponential and {g:d} Gaussian terms'.format(f=fluid, p=len(poly), e=len(expo), g=len(gauss)))
+    lines.append('static const double {i:s}_alphar_elements[{N:d}][15] = {{'.format(i=ident, N=len(elements)))
+    lines += ['    {' + ', '.join([literal(el[k]) for k in element_keys]) + '},' for el in elements]
+    lines.append('};')
+    lines.append('static void {i:s}_alphar(const CoolPropDbl tau, const CoolPropDbl delta, std::size_t max_order, HelmholtzDerivatives &derivs)'.format(i=ident))
+    lines.append('{')
+    lines.append('    const CoolPropDbl log_tau = log(tau), log_delta = log(delta), one_over_delta = 1/delta, one_over_tau = 1/tau;')
+    lines.append('    HelmholtzDerivatives s = derivs;')
+    lines.append('    CoolPropDbl ndteu, B_delta[4], B_tau[4];')
+    if poly:
+        lines.append('')
+        lines.append('    // Polynomial terms, all the factors B are constant')
+        for el in poly:
+            lines.append('    ndteu = {n:s}*exp({t:s}*log_tau + {d:s}*log_delta);'.format(n=literal(el['n']), t=literal(el['t']), d=literal(el['d'])))
+            lines.append('    {{ static const CoolPropDbl Bd[4] = {{{Bd:s}}}, Bt[4] = {{{Bt:s}}};'.format(Bd=', '.join([literal(B) for B in constant_B(el['d'])]),
+                                                                                                     Bt=', '.join([literal(B) for B in constant_B(el['t'])])))
+            lines.append('      add_generalized_exponential_term(s, ndteu, Bd, Bt, max_order); }')
+    if expo:
+        lines.append('')
+        lines.append('    // Exponential terms, u = -delta^l and its derivatives are shared by the terms with the same l')
+        for l in ls:
+            lines.append('    const CoolPropDbl u_{l:d} = -powInt(delta, {l:d});'.format(l=l))
+            lines.append('    const CoolPropDbl du_{l:d} = {L:s}*u_{l:d}*one_over_delta, d2u_{l:d} = {Lm1:s}*du_{l:d}*one_over_delta, d3u_{l:d} = {Lm2:s}*d2u_{l:d}*one_over_delta, d4u_{l:d} = {Lm3:s}*d3u_{l:d}*one_over_delta;'.format(
+                l=l, L=literal(l), Lm1=literal(l - 1), Lm2=literal(l - 2), Lm3=literal(l - 3)))
+        for el in expo:
+            l = int(el['l'])
+            lines.append('    ndteu = {n:s}*exp({t:s}*log_tau + {d:s}*log_delta + u_{l:d});'.format(n=literal(el['n']), t=literal(el['t']), d=literal(el['d']), l=l))
+            lines.append('    generalized_exponential_B(delta, {d:s}, du_{l:d}, d2u_{l:d}, d3u_{l:d}, d4u_{l:d}, B_delta, max_order);'.format(d=literal(el['d']), l=l))
+            lines.append('    {{ static const CoolPropDbl Bt[4] = {{{Bt:s}}};'.format(Bt=', '.join([literal(B) for B in constant_B(el['t'])])))
+            lines.append('      add_generalized_exponential_term(s, ndteu, B_delta, Bt, max_order); }')
+    if gauss:
+        lines.append('')
+        lines.append('    // Gaussian terms')
+        for el in gauss:
+            lines.append('    {{ const CoolPropDbl ddelta = delta - {e:s}, dtau = tau - {g:s};'.format(e=literal(el['epsilon2']), g=literal(el['gamma2'])))
+            lines.append('      const CoolPropDbl u = {meta:s}*POW2(ddelta) + {mbeta:s}*POW2(dtau);'.format(meta=literal(-el['eta2']), mbeta=literal(-el['beta2'])))
+            lines.append('      ndteu = {n:s}*exp({t:s}*log_tau + {d:s}*log_delta + u);'.format(n=literal(el['n']), t=literal(el['t']), d=literal(el['d'])))
+            lines.append('      generalized_exponential_B(delta, {d:s}, {m2eta:s}*ddelta, {m2eta:s}, 0, 0, B_delta, max_order);'.format(d=literal(el['d']), m2eta=literal(-2 * el['eta2'])))
+            lines.append('      generalized_exponential_B(tau, {t:s}, {m2beta:s}*dtau, {m2beta:s}, 0, 0, B_tau, max_order);'.format(t=literal(el['t']), m2beta=literal(-2 * el['beta2'])))
+            lines.append('      add_generalized_exponential_term(s, ndteu, B_delta, B_tau, max_order); }')
+    lines.append('')
+    lines.append('    scale_generalized_exponential_sums(s, one_over_delta, one_over_tau, max_order);')
+    lines.append('    derivs = s;')
+    lines.append('}')
+    lines.append('')
+    entry = '    {{"{f:s}", {N:d}, {i:s}_alphar_elements, {{{flags:s}}}, {i:s}_alphar}},'.format(
+        f=fluid, N=len(elements), i=ident, flags=', '.join(['true' if flags[k] else 'false' for k in flag_keys]))
+    return '\n'.join(lines), entry
+
+
+def generate(fluids=default_fluids, output=os.path.join(repo_root_path, 'include', 'specialized_alphar_kernels.h')):
+    code = []
+    entries = []
+    for fluid in fluids:
+        jj = json.load(open(os.path.join(repo_root_path, 'dev', 'fluids', fluid + '.json'), 'r'))
+        try:
+            elements, flags = to_elements(jj['EOS'][0]['alphar'])
+        except UnsupportedTerm as err:
+            print('no specialized kernel for ' + fluid + ', it has unsupported terms: ' + str(err))
+            continue
+        c, e = kernel_code(jj['INFO']['NAME'], elements, flags)
+        code.append(c)
+        entries.append(e)
+    if not entries:
+        raise ValueError('None of the fluids ' + str(fluids) + ' can have a specialized kernel')
+
+    output_string = '// File generated by the script dev/generate_alphar_kernels.py on ' + str(datetime.now()) + '\n\n'
+    output_string += '#include "Backends/Helmholtz/SpecializedAlpharKernels.h"\n\n'
+    output_string += 'namespace CoolProp{\n\n'
+    output_string += '\n'.join(code)
+    output_string += '\nstatic const SpecializedAlpharKernel specialized_alphar_kernels[] = {\n' + '\n'.join(entries) + '\n};\n\n'
+    output_string += '} /* namespace CoolProp */\n'
+
+    # Only write the file if the kernels changed, to avoid rebuilding for nothing
+    if os.path.exists(output):
+        old = open(output, 'r').read()
+        if old.split('\n', 1)[1] == output_string.split('\n', 1)[1]:
+            print(output + ' is up to date')
+            return
+    f = open(output, 'w')
+    f.write(output_string)
+    f.close()
+    print(output + ' written to file')
+
+
+if __name__ == '__main__':
+    if len(sys.argv) > 1:
+        generate(fluids=sys.argv[1:])
+    else:
+        generate()
@@ -0,0 +1,359 @@
+"""
+Fit the superancillary equations of the pure fluids and store them in the fluid files
+
+For each pure fluid of dev/fluids, the saturation states of the first equation of state are found by solving the
+equal pressure and equal Gibbs energy conditions with a Newton iteration in the reduced densities.  Chebyshev
+expansions in T of ln(p), rhoL and ln(rhoV) are fitted at the Chebyshev-Lobatto nodes of adjacent intervals, and
+an interval is bisected until the last coefficients of its expansions are negligible, exactly like
+SuperAncillary::build in src/Backends/Helmholtz/Fluids/Ancillaries.cpp does at runtime.  The coefficients are written
+to ANCILLARIES/superancillary of the fluid file; the library only fits them at runtime for the fluids that do
+not have them (for instance a fluid that is added or whose equation of state is changed by the user).
+
+Only the residual Helmholtz energy is needed, so the script does not depend on a build of CoolProp.  Run it from
+the root of the repository after the equation of state of a fluid has been changed:
+
+    python dev/scripts/fit_superancillaries.py [fluid ...]
+"""
+from __future__ import print_function, division
+import glob, json, math, os, sys
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+from package_json import json_options
+
+N = 16  # The degree of the expansions
+TOLERANCE = 1e-12  # The relative magnitude of the last coefficients of a converged expansion
+
+
+class Jet(object):
+    """ A value and its first two derivatives with respect to delta """
+
+    def __init__(self, v, d1=0.0, d2=0.0):
+        self.v, self.d1, self.d2 = v, d1, d2
+
+    @staticmethod
+    def lift(x):
+        return x if isinstance(x, Jet) else Jet(x)
+
+    def __add__(self, o):
+        o = Jet.lift(o)
+        return Jet(self.v + o.v, self.d1 + o.d1, self.d2 + o.d2)
+    __radd__ = __add__
+
+    def __neg__(self):
+        return Jet(-self.v, -self.d1, -self.d2)
+
+    def __sub__(self, o):
+        return self + (-Jet.lift(o))
+
+    def __rsub__(self, o):
+        return Jet.lift(o) - self
+
+    def __mul__(self, o):
+        o = Jet.lift(o)
+        return Jet(self.v * o.v, self.d1 * o.v + self.v * o.d1, self.d2 * o.v + 2 * self.d1 * o.d1 + self.v * o.d2)
+    __rmul__ = __mul__
+
+    def __truediv__(self, o):
+        o = Jet.lift(o)
+        r = Jet(1 / o.v, -o.d1 / o.v**2, 2 * o.d1**2 / o.v**3 - o.d2 / o.v**2)
+        return self * r
+    __div__ = __truediv__
+
+    def __rtruediv__(self, o):
+        return Jet.lift(o) / self
+    __rdiv__ = __rtruediv__
+
+    def exp(self):
+        e = math.exp(self.v)
+        return Jet(e, e * self.d1, e * (self.d2 + self.d1**2))
+
+    def log(self):
+        return Jet(math.log(self.v), self.d1 / self.v, self.d2 / self.v - self.d1**2 / self.v**2)
+
+    def __pow__(self, a):
+        p = self.v**a
+        return Jet(p, a * self.v**(a - 1) * self.d1, a * (a - 1) * self.v**(a - 2) * self.d1**2 + a * self.v**(a - 1) * self.d2)
+
+
+class Alphar(object):
+    """ The residual Helmholtz energy of an equation of state of the fluid files and its derivatives in delta """
+
+    def __init__(self, alphar):
+        self.genexp, self.jets = [], []
+        for term in alphar:
+            tp = term['type']
+            k = len(term.get('n', []))
+            if tp == 'ResidualHelmholtzPower':
+                for i in range(k):
+                    self.genexp.append(dict(n=term['n'][i], d=term['d'][i], t=term['t'][i], c=1.0 if term['l'][i] > 0 else 0.0, l=term['l'][i]))
+            elif tp == 'ResidualHelmholtzExponential':
+                for i in range(k):
+                    self.genexp.append(dict(n=term['n'][i], d=term['d'][i], t=term['t'][i], c=term['g'][i], l=term['l'][i]))
+            elif tp == 'ResidualHelmholtzGaussian':
+                for i in range(k):
+                    self.genexp.append(dict(n=term['n'][i], d=term['d'][i], t=term['t'][i], eta=term['eta'][i], epsilon=term['epsilon'][i],
+                                            beta=term['beta'][i], gamma=term['gamma'][i]))
+            elif tp == 'ResidualHelmholtzLemmon2005':
+                for i in range(k):
+                    self.genexp.append(dict(n=term['n'][i], d=term['d'][i], t=term['t'][i], c=1.0, l=term['l'][i], omega=1.0, m=term['m'][i]))
+            elif tp == 'ResidualHelmholtzNonAnalytic':
+                for i in range(k):
+                    self.jets.append(self.non_analytic(*[term[key][i] for key in ['n', 'a', 'b', 'beta', 'A', 'B', 'C', 'D']]))
+            elif tp == 'ResidualHelmholtzGaoB':
+                for i in range(k):
+                    self.jets.append(self.gao_b(*[term[key][i] for key in ['n', 't', 'd', 'eta', 'beta', 'gamma', 'epsilon', 'b']]))
+            elif tp == 'ResidualHelmholtzAssociating':
+                self.jets.append(self.associating(*[term[key] for key in ['a', 'm', 'epsilonbar', 'vbarn', 'kappabar']]))
+            else:
+                raise ValueError('Unsupported residual Helmholtz term ' + tp)
+
+    @staticmethod
+    def non_analytic(n, a, b, beta, A, B, C, D):
+        def f(tau, delta):
+            dm1 = delta - 1
+            dm1sq = dm1 * dm1
+            theta = (1 - tau) + A * dm1sq**(1 / (2 * beta))
+            DELTA = theta * theta + B * dm1sq**a
+            PSI = (-C * dm1sq - D * (tau.v - 1)**2).exp()
+            return n * DELTA**b * delta * PSI
+        return f
+
+    @staticmethod
+    def gao_b(n, t, d, eta, beta, gamma, epsilon, b):
+        def f(tau, delta):
+            Ftau = tau.v**t * math.exp(1 / (b + beta * (tau.v - gamma)**2))
+            return n * Ftau * delta**d * (eta * (delta - epsilon) * (delta - epsilon)).exp()
+        return f
+
+    @staticmethod
+    def associating(a, m, epsilonbar, vbarn, kappabar):
+        def f(tau, delta):
+            eta = vbarn * delta
+            g = 0.5 * (2 - eta) / ((1 - eta) * (1 - eta) * (1 - eta))
+            Deltabar = g * (math.exp(epsilonbar * tau.v) - 1) * kappabar
+            X = 2 / ((1 + 4 * Deltabar * delta)**0.5 + 1)
+            return m * a * (X.log() - X / 2.0 + 0.5)
+        return f
+
+    def __call__(self, tau, delta):
+        """ Return alphar, dalphar/ddelta and d2alphar/ddelta2 """
+        A = A1 = A2 = 0.0
+        for el in self.genexp:
+            u = -el.get('omega', 0.0) * tau**el['m'] if el.get('m', 0) else 0.0
+            du = d2u = 0.0
+            if el.get('c', 0.0) != 0 and el.get('l', 0) > 0:
+                dl = el['c'] * delta**el['l']
+                u -= dl
+                du -= el['l'] * dl / delta
+                d2u -= el['l'] * (el['l'] - 1) * dl / delta**2
+            if 'eta' in el:
+                u -= el['eta'] * (delta - el['epsilon'])**2 + el['beta'] * (tau - el['gamma'])**2
+                du -= 2 * el['eta'] * (delta - el['epsilon'])
+                d2u -= 2 * el['eta']
+            f = el['n'] * math.exp(el['t'] * math.log(tau) + el['d'] * math.log(delta) + u)
+            g = el['d'] / delta + du
+            A += f
+            A1 += f * g
+            A2 += f * (g * g - el['d'] / delta**2 + d2u)
+        for f in self.jets:
+            j = f(Jet(tau), Jet(delta, 1.0, 0.0))
+            A += j.v
+            A1 += j.d1
+            A2 += j.d2
+        return A, A1, A2
+
+
+def ancillary(anc, T):
+    """ Evaluate a saturation ancillary of the fluid files """
+    theta = 1 - T / anc['T_r']
+    summer = sum(n * theta**t for n, t in zip(anc['n'], anc['t']))
+    if anc['type'] == 'rhoLnoexp':
+        return anc['reducing_value'] * (1 + summer)
+    tau_r = anc['T_r'] / T if anc['using_tau_r'] else 1.0
+    return anc['reducing_value'] * math.exp(tau_r * summer)
+
+
+class Saturation(object):
+    """ The saturation states of the first equation of state of a fluid file """
+
+    def __init__(self, fluid):
+        EOS = fluid['EOS'][0]
+        self.alphar = Alphar(EOS['alphar'])
+        self.R = EOS['gas_constant']
+        self.Tr = EOS['STATES']['reducing']['T']
+        self.rhor = EOS['STATES']['reducing']['rhomolar']
+        self.ancillaries = fluid['ANCILLARIES']
+        self.solved = {}  # The states that have been found, by temperature
+
+    def solve(self, T):
+        """ Return p in Pa and rhoL and rhoV in mol/m^3 at T; raises ValueError if they cannot be found """
+        # Start from the closest state found so far, which is a better guess than the ancillaries near the critical point
+        T0 = min(self.solved, key=lambda Ts: abs(Ts - T)) if self.solved else None
+        guesses = [self.solved[T0][1:]] if T0 is not None else []
+        guesses.append((ancillary(self.ancillaries['rhoL'], T), ancillary(self.ancillaries['rhoV'], T)))
+        state = None
+        for rhoL, rhoV in guesses:
+            try:
+                state = self.newton(T, rhoL, rhoV)
+                break
+            except (ValueError, OverflowError, ZeroDivisionError):
+                pass
+        if state is None and T0 is not None:
+            # Follow the saturation curve from the closest state
+            for n in [10, 100, 1000]:
+                try:
+                    state = self.solved[T0]
+                    for k in range(1, n + 1):
+                        state = self.newton(T0 + (T - T0) * k / n, state[1], state[2])
+                    break
+                except (ValueError, OverflowError, ZeroDivisionError):
+                    state = None
+        if state is None:
+            raise ValueError('saturation did not converge at T=%g K' % T)
+        self.solved[T] = state
+        return state
+
+    def newton(self, T, rhoL, rhoV):
+        """ Solve for the saturation state at T with a Newton iteration from the densities rhoL and rhoV """
+        tau = self.Tr / T
+        dL, dV = rhoL / self.rhor, rhoV / self.rhor
+        converged = 0
+        for it in range(100):
+            aL, aL1, aL2 = self.alphar(tau, dL)
+            aV, aV1, aV2 = self.alphar(tau, dV)
+            # Reduced pressure p/(rhor*R*T) and Gibbs energy g/(R*T), less the terms that are the same for both phases
+            JL, JV = dL * (1 + dL * aL1), dV * (1 + dV * aV1)
+            KL, KV = dL * aL1 + aL + math.log(dL), dV * aV1 + aV + math.log(dV)
+            dJL, dJV = 1 + 2 * dL * aL1 + dL**2 * aL2, 1 + 2 * dV * aV1 + dV**2 * aV2
+            dKL, dKV = dJL / dL, dJV / dV
+            det = dJV * dKL - dJL * dKV
+            if det == 0:
+                raise ValueError('singular Jacobian')
+            stepL = ((JL - JV) * dKV - (KL - KV) * dJV) / det
+            stepV = ((JL - JV) * dKL - (KL - KV) * dJL) / det
+            if not (math.isfinite(stepL) and math.isfinite(stepV)):
+                raise ValueError('invalid step')
+            # Keep the densities positive
+            while dL + stepL <= 0 or dV + stepV <= 0:
+                stepL /= 2
+                stepV /= 2
+            dL += stepL
+            dV += stepV
+            # The steps end at the noise of the residuals (about 1e-13 at low temperature, 1e-10 near the critical point);
+            # polish with two more steps once they are small
+            if converged > 0 or (abs(stepL) < 1e-9 * dL and abs(stepV) < 1e-9 * dV):
+                converged += 1
+                if converged == 3:
+                    break
+        else:
+            raise ValueError('saturation did not converge at T=%g K' % T)
+        if not (dL > 1.001 * dV):
+            raise ValueError('trivial solution at T=%g K' % T)
+        aV, aV1, aV2 = self.alphar(tau, dV)
+        # The vapor pressure is much better conditioned than the liquid one at low temperature
+        p = dV * self.rhor * self.R * T * (1 + dV * aV1)
+        return p, dL * self.rhor, dV * self.rhor
+
+
+def nodes(xmin, xmax, n):
+    x = [0.5 * (xmax - xmin) * -math.cos(math.pi * k / n) + 0.5 * (xmax + xmin) for k in range(n + 1)]
+    x[0], x[n] = xmin, xmax
+    return x
+
+
+def coefficients(values):
+    """ The coefficients of the expansion of degree len(values)-1 through the values at the nodes in increasing order """
+    n = len(values) - 1
+    c = []
+    for j in range(n + 1):
+        summer = 0.0
+        for k in range(n + 1):
+            term = values[n - k] * math.cos(math.pi * j * k / n)
+            summer += 0.5 * term if k == 0 or k == n else term
+        c.append((1.0 if j == 0 or j == n else 2.0) / n * summer)
+    return c
+
+
+def converged(c):
+    return max(abs(c[-1]), abs(c[-2])) <= TOLERANCE * max(abs(cj) for cj in c)
+
+
+def clenshaw(c, xmin, xmax, x):
+    t = (2 * x - (xmax + xmin)) / (xmax - xmin)
+    b1 = b2 = 0.0
+    for cj in reversed(c[1:]):
+        b1, b2 = cj + 2 * t * b1 - b2, b1
+    return c[0] + t * b1 - b2
+
+
+def fit(sat, Tmin, Tmax):
+    """ Fit the expansions between Tmin and Tmax; the range ends at the first interval that cannot be solved or fitted """
+    T_breaks, lnp, rhoL, lnrhoV = [], [], [], []
+    min_width = 1e-6 * Tmax
+    stack = [(Tmin, Tmax)]
+    while stack:
+        a, b = stack.pop()
+        T = nodes(a, b, N)
+        try:
+            states = [sat.solve(Tk) for Tk in T]
+            c_lnp = coefficients([math.log(p) for p, rL, rV in states])
+            c_rhoL = coefficients([rL for p, rL, rV in states])
+            c_lnrhoV = coefficients([math.log(rV) for p, rL, rV in states])
+            ok = converged(c_lnp) and converged(c_rhoL) and converged(c_lnrhoV)
+        except ValueError:
+            ok = False
+        if not ok:
+            if b - a < min_width:
+                break
+            mid = 0.5 * (a + b)
+            stack.append((mid, b))
+            stack.append((a, mid))
+            continue
+        if not T_breaks:
+            T_breaks.append(a)
+        T_breaks.append(b)
+        lnp.append(c_lnp)
+        rhoL.append(c_rhoL)
+        lnrhoV.append(c_lnrhoV)
+    return T_breaks, lnp, rhoL, lnrhoV
+
+
+def inject(path):
+    with open(path) as fp:
+        fluid = json.load(fp)
+    name = fluid['INFO']['NAME']
+    EOS = fluid['EOS'][0]
+    if EOS['pseudo_pure']:
+        return
+    sat = Saturation(fluid)
+    Tmin = max(EOS['STATES']['sat_min_liquid']['T'], EOS['STATES']['sat_min_vapor']['T'])
+    # Very close to the critical point the expansions converge too slowly; the critical splines or the usual solvers are used there
+    Tmax = 0.9999 * fluid['STATES']['critical']['T']
+    T_breaks, lnp, rhoL, lnrhoV = fit(sat, Tmin, Tmax)
+    if not T_breaks:
+        print(name, 'no interval could be fitted')
+        return
+    # Check the expansions between the nodes
+    err = 0
+    for i in range(len(lnp)):
+        a, b = T_breaks[i], T_breaks[i + 1]
+        for T in [a + (b - a) * (k + 0.5) / 7 for k in range(7)]:
+            p, rL, rV = sat.solve(T)
+            err = max(err, abs(math.exp(clenshaw(lnp[i], a, b, T)) / p - 1), abs(clenshaw(rhoL[i], a, b, T) / rL - 1),
+                      abs(math.exp(clenshaw(lnrhoV[i], a, b, T)) / rV - 1))
+    print('%s: %d intervals from %g K to %g K, max. relative error %.2g' % (name, len(lnp), T_breaks[0], T_breaks[-1], err))
+    fluid['ANCILLARIES']['superancillary'] = dict(
+        T_breaks=T_breaks, lnp=lnp, rhoL=rhoL, lnrhoV=lnrhoV,
+        _note="Chebyshev expansions of degree %d in T [K] of ln(p) [Pa], rhoL [mol/m^3] and ln(rhoV) [mol/m^3] over the intervals "
+              "[T_breaks[i], T_breaks[i+1]] of the first equation of state; generated by dev/scripts/fit_superancillaries.py" % N)
+    with open(path, 'w') as fp:
+        fp.write(json.dumps(fluid, **json_options))
+
+
+if __name__ == '__main__':
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'fluids')
+    if len(sys.argv) > 1:
+        paths = [os.path.join(root, f + '.json') for f in sys.argv[1:]]
+    else:
+        paths = sorted(glob.glob(os.path.join(root, '*.json')))
+    for path in paths:
+        inject(path)
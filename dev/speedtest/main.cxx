@@ -0,0 +1,18 @@
+// Timings of the evaluation and flash routines; build with
+// cmake ..\CoolProp.git -DCOOLPROP_MY_MAIN=dev/speedtest/main.cxx
+// and run the Main executable
+#include "SpeedTest.h"
+#include <iostream>
+#include <stdlib.h>
+using namespace CoolProp;
+int main()
+{
+    const char *fluids[] = {"Water", "CarbonDioxide", "R134a"};
+    for (std::size_t i = 0; i < sizeof(fluids)/sizeof(fluids[0]); ++i){
+        time_generalized_exponential(fluids[i], 1000000);
+    }
+    for (std::size_t i = 0; i < sizeof(fluids)/sizeof(fluids[0]); ++i){
+        time_HP_flash_singlephase(fluids[i], 10000);
+    }
+    return EXIT_SUCCESS;
+}
@@ -74,6 +74,7 @@ protected:
     long _fluid_type;
     phases _phase; ///< The key for the phase from CoolProp::phases enum
     phases imposed_phase_index; ///< If the phase is imposed, the imposed phase index
+    bool _skip_property_limits; ///< If true, the inputs to this state are not checked against the property limits
 
     bool isSupercriticalPhase(void){
         return (this->_phase == iphase_supercritical || this->_phase == iphase_supercritical_liquid || this->_phase == iphase_supercritical_gas);
@@ -415,7 +416,7 @@ protected:
     virtual void calc_change_EOS(const std::size_t i, const std::string &EOS_name){ throw NotImplementedError("calc_change_EOS is not implemented for this backend"); };
 public:
 
-    AbstractState() :_fluid_type(FLUID_TYPE_UNDEFINED), _phase(iphase_unknown){ clear(); }
+    AbstractState() :_fluid_type(FLUID_TYPE_UNDEFINED), _phase(iphase_unknown), _skip_property_limits(false){ clear(); }
     virtual ~AbstractState(){};
 
     /// A factory function to return a pointer to a new-allocated instance of one of the backends.
@@ -548,6 +549,48 @@ public:
     /// Some or all of the guesses will be used - this is backend dependent
     virtual void update_with_guesses(CoolProp::input_pairs input_pair, double Value1, double Value2, const GuessesStructure &guesses){ throw NotImplementedError("update_with_guesses is not implemented for this backend"); };
 
+    /// Skip the checks of the inputs against the property limits for this state only, as the configuration
+    /// key DONT_CHECK_PROPERTY_LIMITS does for all the states
+    void set_skip_property_limits(bool skip){ _skip_property_limits = skip; };
+    /// Return true if the inputs to this state are not checked against the property limits, either for this state or for all of them
+    bool skip_property_limits(void);
+
+    /// Turn the warm-start mode on or off; in this mode each update is seeded with the converged state of the previous one
+    /// and goes back to the usual flash routines when that fails - which inputs use it is backend dependent
+    virtual void set_warm_start(bool enabled){ throw NotImplementedError("set_warm_start is not implemented for this backend"); };
+    /// Return true if the warm-start mode is on
+    virtual bool get_warm_start(void){ return false; };
+
+    /**
+     * @brief Update the state for a batch of state points and collect keyed outputs for all of them
+     * @param input_pair The input pair, the same for all the state points
+     * @param Value1 Pointer to the array of the first input values, of length n
+     * @param Value2 Pointer to the array of the second input values, of length n
+     * @param n The number of state points
+     * @param outputs The keys of the outputs that are desired
+     * @param out_soa Output array of length n*outputs.size() in structure-of-arrays layout; the j-th output of the i-th state point is stored at out_soa[j*n+i]
+     *
+     * Outputs that cannot be calculated, as well as all the outputs of a state point whose update failed, are set to _HUGE.
+     * The default implementation evaluates trivial outputs only once and then loops over update() and keyed_output();
+     * if the configuration variable SORT_BATCH_INPUTS is true, the points are visited in the order of get_batch_order(),
+     * in warm-start mode if the backend supports it.  Backends can override this function to amortize more work over the whole batch.
+     */
+    virtual void update_batch(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, const std::vector<parameters> &outputs, double *out_soa);
+
+    /**
+     * @brief Order the state points of a batch along a Hilbert curve in the plane of the two inputs
+     * @param input_pair The input pair, the same for all the state points
+     * @param Value1 Pointer to the array of the first input values, of length n
+     * @param Value2 Pointer to the array of the second input values, of length n
+     * @param n The number of state points
+     * @param order The indices of the state points, in the order in which they should be evaluated
+     *
+     * Consecutive points in this order are close to each other in the plane of the inputs, so that each one can be seeded
+     * with the state of the previous one.  Pressures and densities are used through their logarithms, and the inputs are
+     * scaled to their ranges in the batch.  Points with invalid inputs come last.
+     */
+    static void get_batch_order(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, std::vector<std::size_t> &order);
+
     /// A function that says whether the backend instance can be instantiated in the high-level interface
     /// In general this should be true, except for some other backends (especially the tabular backends)
     /// To disable use in high-level interface, implement this function and return false
@@ -1167,6 +1210,22 @@ public:
     };
 };
 
+/// Turns the warm-start mode of a state on while the instance is alive, if the backend supports it, and then restores it
+class WarmStartScope{
+private:
+    AbstractState &AS;
+    bool was_enabled, changed;
+public:
+    explicit WarmStartScope(AbstractState &AS) : AS(AS), was_enabled(AS.get_warm_start()), changed(false){
+        if (was_enabled){ return; }
+        try{ AS.set_warm_start(true); changed = true; }
+        catch(NotImplementedError &){}
+    };
+    ~WarmStartScope(){
+        if (changed){ AS.set_warm_start(false); }
+    };
+};
+
 /** An abstract AbstractState generator class
  *
  *  This class should be derived and statically initialized in a C++ file.  In the initializer,
@@ -3,6 +3,8 @@
 
 #include "Exceptions.h"
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include "rapidjson_include.h"
 #include "Eigen/Core"
 #include "PolyMath.h"
@@ -134,6 +136,118 @@ public:
     double get_Tmax(void){return Tmax;};
 };
 
+/**
+ * \brief A Chebyshev expansion of a function of x over the interval [xmin, xmax]
+ *
+ * \f[ y = \sum_{i=0}^{N} c_i T_i(t) \f]
+ * with
+ * \f[ t = \frac{2x-(x_{\rm max}+x_{\rm min})}{x_{\rm max}-x_{\rm min}} \f]
+ *
+ * The coefficients are obtained from the values of the function at the N+1 Chebyshev-Lobatto nodes of the interval, or are given
+ * directly by from_coeffs()
+ */
+class ChebyshevExpansion
+{
+private:
+    std::vector<double> c, ///< The coefficients of the expansion
+                        dc; ///< The coefficients of the derivative of the expansion with respect to t
+    double xmin, xmax;
+    /// Calculate dc from c
+    void calc_derivative_coeffs();
+public:
+    ChebyshevExpansion() : xmin(_HUGE), xmax(_HUGE) {};
+    /// Fit the expansion of degree values.size()-1 to the values of the function at the nodes given by nodes(xmin, xmax, values.size()-1)
+    ChebyshevExpansion(double xmin, double xmax, const std::vector<double> &values);
+    /// The N+1 Chebyshev-Lobatto nodes of the interval [xmin, xmax] for an expansion of degree N, in increasing order
+    static std::vector<double> nodes(double xmin, double xmax, std::size_t N);
+    /// The expansion over [xmin, xmax] with the coefficients c, in increasing order
+    static ChebyshevExpansion from_coeffs(double xmin, double xmax, const std::vector<double> &c);
+    /// Get the coefficients
+    const std::vector<double> & coeffs() const { return c; };
+    double get_xmin() const { return xmin; };
+    double get_xmax() const { return xmax; };
+    /// True if the magnitude of the last two coefficients is below tolerance times the magnitude of the largest coefficient, in which case the expansion has converged
+    bool is_converged(double tolerance) const;
+    /// Evaluate the expansion with the Clenshaw recurrence
+    double evaluate(double x) const;
+    /// Evaluate the derivative of the expansion with respect to x
+    double derivative(double x) const;
+    /// Find x in [xmin, xmax] for which the expansion is equal to y with a Newton iteration kept inside a bracket; the expansion must be monotonic over the interval
+    double solve(double y) const;
+};
+
+/**
+ * \brief The superancillary equations for the saturation curve of a pure fluid
+ *
+ * The logarithm of the vapor pressure, the saturated liquid density and the logarithm of the saturated vapor density are given by
+ * Chebyshev expansions in temperature over adjacent intervals.  They are fitted to the saturation states of the equation of state
+ * at the Chebyshev-Lobatto nodes of each interval, and an interval is bisected until the last coefficients of its expansions are
+ * negligible, so that the expansions reproduce the equation of state to nearly machine precision.  A saturation call is then a few
+ * polynomial evaluations instead of an iterative solution of the equation of state.
+ *
+ * The coefficients are generated offline by dev/scripts/fit_superancillaries.py and stored in the "superancillary" entry of the
+ * ancillaries of the fluid files.  A fluid without them, such as one added by the user or one whose equation of state has been
+ * changed, gets expansions built by build() the first time they are needed, which can happen in several threads at the same time.
+ * Copies of a fluid share the same superancillary equations.
+ */
+class SuperAncillary
+{
+public:
+    /// The saturation solver of the equation of state that provides the values that are fitted
+    class SaturationSolver{
+    public:
+        virtual ~SaturationSolver(){};
+        /// Calculate the vapor pressure in Pa and the saturated liquid and vapor densities in mol/m^3 at T; throws if they cannot be found
+        virtual void solve(double T, double &p, double &rhoL, double &rhoV) = 0;
+    };
+private:
+    std::vector<ChebyshevExpansion> lnp, ///< The expansions of the logarithm of the vapor pressure, one per interval, in increasing temperature
+                                    rhoL, ///< The expansions of the saturated liquid density
+                                    lnrhoV; ///< The expansions of the logarithm of the saturated vapor density
+    std::vector<double> T_breaks, ///< The temperatures at the ends of the intervals, in increasing order
+                        lnp_breaks; ///< The logarithm of the vapor pressure at T_breaks
+    std::atomic<bool> built; ///< True once build() has been called, even if it could not fit any interval; the expansions are never modified afterwards
+    bool loaded; ///< True if the expansions were loaded from the fluid file, false if they are fitted at run time by build()
+    std::mutex build_mutex; ///< Held while the expansions are built
+    /// The index of the interval that contains T
+    std::size_t get_interval(double T) const;
+public:
+    SuperAncillary() : built(false), loaded(false) {};
+    /// Load the expansions from the "superancillary" entry of the ancillaries of a fluid file; they are built already
+    SuperAncillary(rapidjson::Value &json_code);
+    /**
+     * \brief Build the expansions between Tmin and Tmax, unless they are already built
+     *
+     * An interval in which the solver fails or the expansions do not converge is bisected; the range of the expansions ends at the
+     * first interval narrower than 1e-6*Tmax that still cannot be fitted
+     */
+    void build(SaturationSolver &solver, double Tmin, double Tmax);
+    /// True if build() has been called
+    bool is_built() const { return built; };
+    /// True if the expansions were loaded from the fluid file rather than fitted at run time
+    bool is_loaded() const { return loaded; };
+    /// True if the expansions are built and cover some range of temperature
+    bool is_available() const { return built && !T_breaks.empty(); };
+    /// Get the minimum temperature in K of the expansions
+    double get_Tmin() const { return T_breaks.front(); };
+    /// Get the maximum temperature in K of the expansions
+    double get_Tmax() const { return T_breaks.back(); };
+    /// True if the expansions are available and T is in their range
+    bool contains_T(double T) const { return is_available() && T >= T_breaks.front() && T <= T_breaks.back(); };
+    /// True if the expansions are available and the vapor pressure p is in their range
+    bool contains_p(double p) const;
+    /// Evaluate the vapor pressure in Pa at T
+    double eval_p(double T) const { std::size_t i = get_interval(T); return exp(lnp[i].evaluate(T)); };
+    /// Evaluate the saturated liquid density in mol/m^3 at T
+    double eval_rhoL(double T) const { return rhoL[get_interval(T)].evaluate(T); };
+    /// Evaluate the saturated vapor density in mol/m^3 at T
+    double eval_rhoV(double T) const { return exp(lnrhoV[get_interval(T)].evaluate(T)); };
+    /// Calculate the saturation temperature in K for the vapor pressure p
+    double get_T_from_p(double p) const;
+    /// Get the number of intervals
+    std::size_t get_Nintervals() const { return lnp.size(); };
+};
+
 // ****************************************************************************
 // ****************************************************************************
 //                                 MELTING LINE
@@ -19,6 +19,15 @@ std::string join_path(const std::string &one, const std::string &two);
 /// Make directory and all required intermediate directories
 void make_dirs(std::string file_path);
 
+/// Return the names (not the paths) of the subdirectories of a directory; empty if the directory does not exist
+std::vector<std::string> get_subdirectories(const std::string &path);
+
+/// Remove a directory and everything it contains; the files that cannot be removed are left in place
+void remove_dirs(const std::string &path);
+
+/// Return the time of the last modification of a file or a directory in seconds since the epoch, or 0 if it does not exist
+double get_modification_time(const std::string &path);
+
 /// Get the size of a directory in bytes
 #if defined(__ISWINDOWS__)
 unsigned long long CalculateDirSize(const std::wstring &path, std::vector<std::wstring> *errVect = NULL);
@@ -33,4 +42,26 @@ std::string get_file_contents(const char *filename);
 /// Get all the contents of a binary file
 std::vector<char> get_binary_file_contents(const char *filename);
 
+/** \brief A read-only memory map of a whole file
+ *
+ * The pages of the file are only read from disk when they are first used, and they are shared by all
+ * the processes that map the same file.  The constructor throws if the file cannot be opened or mapped.
+ */
+class MappedFile
+{
+private:
+    const char *m_data;
+    std::size_t m_size;
+    void *m_file_handle, *m_mapping_handle; ///< Only used on Windows
+    MappedFile(const MappedFile &);
+    MappedFile& operator=(const MappedFile &);
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    /// The first byte of the file
+    const char * data() const { return m_data; }
+    /// The size of the file in bytes
+    std::size_t size() const { return m_size; }
+};
+
 #endif
\ No newline at end of file
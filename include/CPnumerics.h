@@ -209,14 +209,15 @@ template <typename T> std::vector<T> logspace(T xmin, T xmax, std::size_t n) {
  * @brief Use bisection to find the inputs that bisect the value you want, the trick
  * here is that this function is allowed to have "holes" where parts of the the array are 
  * also filled with invalid numbers for which ValidNumber(x) is false
- * @param vec The vector to be bisected
+ * @param vec A pointer to the first element of the array to be bisected
+ * @param N The number of elements in the array
  * @param val The value to be found
  * @param i The index to the left of the final point; i and i+1 bound the value
  */
-template <typename T> void bisect_vector(const std::vector<T> &vec, T val, std::size_t &i)
+template <typename T> void bisect_array(const T *vec, std::size_t N, T val, std::size_t &i)
 {
     T rL, rM, rR;
-    std::size_t N = vec.size(), L = 0, R = N-1, M = (L+R)/2;
+    std::size_t L = 0, R = N-1, M = (L+R)/2;
     // Move the right limits in until they are good
     while (!ValidNumber(vec[R])){
         if (R == 1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
@@ -224,7 +225,7 @@ template <typename T> void bisect_vector(const std::vector<T> &vec, T val, std::
     }
     // Move the left limits in until they are good
     while (!ValidNumber(vec[L])){
-        if (L == vec.size()-1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
+        if (L == N-1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
         L++;
     }
     rL = vec[L] - val; rR = vec[R] - val;
@@ -233,7 +234,7 @@ template <typename T> void bisect_vector(const std::vector<T> &vec, T val, std::
             std::size_t MR = M, ML = M;
             // Move middle-right to the right until it is ok
             while (!ValidNumber(vec[MR])){
-                if (MR == vec.size()-1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
+                if (MR == N-1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
                 MR++;
             }
             // Move middle-left to the left until it is ok
@@ -273,19 +274,30 @@ template <typename T> void bisect_vector(const std::vector<T> &vec, T val, std::
     i = L;
 }
 
+/**
+ * @brief Use bisection to find the inputs that bisect the value you want; see bisect_array
+ * @param vec The vector to be bisected
+ * @param val The value to be found
+ * @param i The index to the left of the final point; i and i+1 bound the value
+ */
+template <typename T> void bisect_vector(const std::vector<T> &vec, T val, std::size_t &i)
+{
+    bisect_array(&(vec[0]), vec.size(), val, i);
+}
+
 /**
  * @brief Use bisection to find the inputs that bisect the value you want, the trick
  * here is that this function is allowed to have "holes" where parts of the the array are 
  * also filled with invalid numbers for which ValidNumber(x) is false
- * @param matrix The vector to be bisected
+ * @param mat The matrix to be bisected; anything with size() giving the number of rows and mat[i][j] giving an element
  * @param j The index of the matric in the off-grain dimension
  * @param val The value to be found
  * @param i The index to the left of the final point; i and i+1 bound the value
  */
-template <typename T> void bisect_segmented_vector_slice(const std::vector<std::vector<T> > &mat, std::size_t j, T val, std::size_t &i)
+template <typename Matrix, typename T> void bisect_segmented_vector_slice(const Matrix &mat, std::size_t j, T val, std::size_t &i)
 {
     T rL, rM, rR;
-    std::size_t N = mat[j].size(), L = 0, R = N-1, M = (L+R)/2;
+    std::size_t N = mat.size(), L = 0, R = N-1, M = (L+R)/2;
     // Move the right limits in until they are good
     while (!ValidNumber(mat[R][j])){
         if (R == 1){ throw CoolProp::ValueError("All the values in bisection vector are invalid"); }
@@ -524,6 +536,73 @@ template<class T> T is_in_closed_range( T x1, T x2, T x)
     return (x >= std::min(x1,x2) && x <= std::max(x1,x2));
 };
 
+/** \brief Finds the segments [x[i], x[i+1]] of a curve that contain a value without searching the whole curve
+ *
+ * The range of the values is split into as many buckets of the same width (in log space if logscale is true) as
+ * there are segments, and each bucket holds the indices of the segments that overlap it, in increasing order.  For a
+ * monotonic vector a bucket holds one or two segments, so the segment that brackets a value is found in constant time;
+ * a curve that is not monotonic, like a phase envelope, can be indexed in the same way.  Segments with an endpoint that
+ * is not a valid number (or not positive in log space) are not indexed.
+ */
+class SegmentBucketIndex
+{
+private:
+    bool logscale;
+    double fmin, inv_width; ///< The start of the first bucket and the inverse of the width of a bucket, in log space if logscale
+    std::vector<std::size_t> offsets; ///< The segments of bucket k are segments[offsets[k]] to segments[offsets[k+1]-1]
+    std::vector<std::size_t> segments;
+    double scaled(double x) const { return logscale ? log(x) : x; };
+    std::size_t bucket(double x) const { return bucket_scaled(scaled(x)); };
+    std::size_t bucket_scaled(double f) const {
+        double t = (f - fmin)*inv_width;
+        std::size_t Nbuckets = offsets.size() - 1;
+        if (!(t > 0)){ return 0; }
+        return std::min(static_cast<std::size_t>(t), Nbuckets - 1);
+    };
+    bool indexed(double x) const { return ValidNumber(x) && (!logscale || x > 0); };
+public:
+    SegmentBucketIndex() : logscale(false), fmin(0), inv_width(0) {};
+    /// Index the segments of x
+    void build(const std::vector<double> &x, bool logscale);
+    void clear(){ offsets.clear(); segments.clear(); };
+    bool empty() const { return segments.empty(); };
+    /// The segments that might contain a value whose logarithm (if logscale) is f, as a range of indices of their first point; the range is empty if the value is not in the range of x
+    std::pair<const std::size_t *, const std::size_t *> candidates_scaled(double f) const {
+        double t = (f - fmin)*inv_width;
+        // The ends of the range can be a few ulps outside of [0, Nbuckets] after scaling; the segments are checked exactly anyway
+        const double slack = 1e-9;
+        if (empty() || !(t >= -slack && t <= static_cast<double>(offsets.size() - 1) + slack)){ return std::pair<const std::size_t *, const std::size_t *>(NULL, NULL); }
+        std::size_t k = bucket_scaled(f);
+        const std::size_t *first = &(segments[0]);
+        return std::pair<const std::size_t *, const std::size_t *>(first + offsets[k], first + offsets[k+1]);
+    };
+    /// The segments that might contain val; see candidates_scaled()
+    std::pair<const std::size_t *, const std::size_t *> candidates(double val) const {
+        if (!indexed(val)){ return std::pair<const std::size_t *, const std::size_t *>(NULL, NULL); }
+        return candidates_scaled(scaled(val));
+    };
+    /**
+     * @brief Find the first segment of x that contains val; x must be the vector the index was built from
+     * @param x The indexed vector
+     * @param val The value to be found
+     * @param f The logarithm of val if logscale, val otherwise; it is often needed by the caller anyway
+     * @param i The index to the left of the segment; i and i+1 bound the value
+     * @returns false if no indexed segment contains val
+     */
+    bool find_scaled(const std::vector<double> &x, double val, double f, std::size_t &i) const {
+        std::pair<const std::size_t *, const std::size_t *> range = candidates_scaled(f);
+        for (const std::size_t *s = range.first; s != range.second; ++s){
+            if (is_in_closed_range(x[*s], x[*s+1], val)){ i = *s; return true; }
+        }
+        return false;
+    };
+    /// Find the first segment of x that contains val; see find_scaled()
+    bool find(const std::vector<double> &x, double val, std::size_t &i) const {
+        if (!indexed(val)){ return false; }
+        return find_scaled(x, val, scaled(val), i);
+    };
+};
+
 /** \brief Solve a cubic with coefficients in decreasing order
     * 
     * 0 = ax^3 + b*x^2 + c*x + d
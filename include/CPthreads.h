@@ -0,0 +1,72 @@
+#ifndef COOLPROP_THREADS_H
+#define COOLPROP_THREADS_H
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace CoolProp {
+
+/// Get the number of worker threads to be used for N work items
+/// @param requested The requested number of threads; if zero or negative, the number of hardware threads is used
+/// @param N The number of work items; never more threads than work items are returned
+inline std::size_t get_thread_count(int requested, std::size_t N)
+{
+    std::size_t Nthreads = (requested > 0) ? static_cast<std::size_t>(requested) : static_cast<std::size_t>(std::thread::hardware_concurrency());
+    if (Nthreads < 1){ Nthreads = 1; }
+    if (Nthreads > N){ Nthreads = (N > 0) ? N : 1; }
+    return Nthreads;
+}
+
+/// Split the range [0, N) into Nthreads contiguous chunks and call f(ithread, ibegin, iend) for each chunk in its own thread
+///
+/// The partitioning only depends on N and Nthreads, chunk 0 is run in the calling thread.  If one of the calls throws,
+/// all the threads are joined and the exception of the lowest chunk index is re-thrown in the calling thread.  If a thread
+/// cannot be started, the threads already started are joined and the std::system_error is re-thrown.
+template<class Function>
+void parallel_for_chunks(std::size_t N, std::size_t Nthreads, Function &f)
+{
+    if (Nthreads < 1){ Nthreads = 1; }
+    std::vector<std::size_t> bounds(Nthreads + 1, 0);
+    for (std::size_t k = 0; k <= Nthreads; ++k){
+        bounds[k] = (N*k)/Nthreads;
+    }
+    std::vector<std::exception_ptr> errors(Nthreads);
+
+    struct ChunkRunner{
+        Function &f;
+        std::size_t ithread, ibegin, iend;
+        std::exception_ptr &error;
+        ChunkRunner(Function &f, std::size_t ithread, std::size_t ibegin, std::size_t iend, std::exception_ptr &error)
+            : f(f), ithread(ithread), ibegin(ibegin), iend(iend), error(error){};
+        void operator()(){
+            try{ f(ithread, ibegin, iend); }
+            catch(...){ error = std::current_exception(); }
+        }
+    };
+
+    // Joins the threads that were started, also if starting one of the others throws; a joinable thread must never be destroyed
+    struct WorkerJoiner{
+        std::vector<std::thread> workers;
+        ~WorkerJoiner(){
+            for (std::size_t k = 0; k < workers.size(); ++k){
+                if (workers[k].joinable()){ workers[k].join(); }
+            }
+        }
+    } joiner;
+    joiner.workers.reserve(Nthreads);
+    for (std::size_t k = 1; k < Nthreads; ++k){
+        joiner.workers.push_back(std::thread(ChunkRunner(f, k, bounds[k], bounds[k+1], errors[k])));
+    }
+    ChunkRunner(f, 0, bounds[0], bounds[1], errors[0])();
+    for (std::size_t k = 0; k < joiner.workers.size(); ++k){
+        joiner.workers[k].join();
+    }
+    for (std::size_t k = 0; k < Nthreads; ++k){
+        if (errors[k]){ std::rethrow_exception(errors[k]); }
+    }
+}
+
+} /* namespace CoolProp */
+#endif
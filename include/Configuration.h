@@ -22,7 +22,12 @@
     X(NORMALIZE_GAS_CONSTANTS, "NORMALIZE_GAS_CONSTANTS", true, "If true, for mixtures, the molar gas constant (R) will be set to the CODATA value") \
     X(CRITICAL_WITHIN_1UK, "CRITICAL_WITHIN_1UK", true, "If true, any temperature within 1 uK of the critical temperature will be considered to be AT the critical point") \
     X(CRITICAL_SPLINES_ENABLED, "CRITICAL_SPLINES_ENABLED", true, "If true, the critical splines will be used in the near-vicinity of the critical point") \
+    X(SUPERANCILLARIES_ENABLED, "SUPERANCILLARIES_ENABLED", false, "If true, the saturation states of pure fluids are evaluated with Chebyshev expansions fitted to the equation of state (superancillary equations), rather than with the iterative saturation solvers; the expansions are stored with the fluids, and are only fitted, in between about 5 and 60 ms, for a fluid without them the first time they are needed") \
     X(SAVE_RAW_TABLES, "SAVE_RAW_TABLES", false, "If true, the raw, uncompressed tables will also be written to file") \
+    X(USE_FLAT_TABLES, "USE_FLAT_TABLES", true, "If true, the tabular backends also write the tables and the bicubic coefficients uncompressed in a flat layout (.flat files), and load the tables by memory-mapping these files rather than by inflating and deserializing the compressed tables") \
+    X(TABULAR_BUILD_NUM_THREADS, "TABULAR_BUILD_NUM_THREADS", static_cast<int>(0), "The number of threads used to build the tables of the tabular backends, each one with its own copy of the state; 1 builds the tables serially, 0 uses all the hardware threads.  The tables do not depend on the number of threads") \
+    X(TABULAR_GRID_TOLERANCE, "TABULAR_GRID_TOLERANCE", 0.0, "If greater than zero, the knots of the single-phase tables of the tabular backends are not evenly spaced, but chosen so that the relative error of the interpolated density and temperature is below this value; if zero, the tables have evenly spaced knots") \
+    X(TABULAR_GRID_MAX_NODES, "TABULAR_GRID_MAX_NODES", static_cast<int>(1000), "The maximum number of knots of each axis of the single-phase tables of the tabular backends when TABULAR_GRID_TOLERANCE is greater than zero") \
     X(ALTERNATIVE_TABLES_DIRECTORY, "ALTERNATIVE_TABLES_DIRECTORY", "", "If provided, this path will be the root directory for the tabular data.  Otherwise, ${HOME}/.CoolProp/Tables is used") \
     X(ALTERNATIVE_REFPROP_PATH, "ALTERNATIVE_REFPROP_PATH", "", "An alternative path to be provided to the directory that contains REFPROP's fluids and mixtures directories.  If provided, the SETPATH function will be called with this directory prior to calling any REFPROP functions.") \
     X(ALTERNATIVE_REFPROP_HMX_BNC_PATH, "ALTERNATIVE_REFPROP_HMX_BNC_PATH", "", "An alternative path to the HMX.BNC file.  If provided, it will be passed into REFPROP's SETUP or SETMIX routines") \
@@ -32,7 +37,8 @@
     X(REFPROP_USE_GERG, "REFPROP_USE_GERG", false, "If true, rather than using the highly-accurate pure fluid equations of state, use the pure-fluid EOS from GERG-2008") \
     X(REFPROP_ERROR_THRESHOLD, "REFPROP_ERROR_THRESHOLD", static_cast<int>(0), "The highest acceptable error code without throwing an exception") \
     X(REFPROP_USE_PENGROBINSON, "REFPROP_USE_PENGROBINSON", false, "If true, rather than using the highly-accurate pure fluid equations of state, use the Peng-Robinson EOS") \
-    X(MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB, "MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB", 1.0, "The maximum allowed size of the directory that is used to store tabular data") \
+    X(MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB, "MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB", 1.0, "The maximum allowed size of the directory that is used to store tabular data; the least recently used tables that are not pinned are removed from it before new tables are written") \
+    X(MAXIMUM_TABLE_MEMORY_IN_GB, "MAXIMUM_TABLE_MEMORY_IN_GB", 0.0, "The maximum memory used by the tables of the tabular backends that are loaded; the least recently used tables that are not pinned or in use are unloaded when it is exceeded.  Zero for no limit") \
     X(DONT_CHECK_PROPERTY_LIMITS, "DONT_CHECK_PROPERTY_LIMITS", false, "If true, when possible, CoolProp will skip checking whether values are inside the property limits") \
 	X(HENRYS_LAW_TO_GENERATE_VLE_GUESSES, "HENRYS_LAW_TO_GENERATE_VLE_GUESSES", false, "If true, when doing water-based mixture dewpoint calculations, use Henry's Law to generate guesses for liquid-phase composition") \
     X(PHASE_ENVELOPE_STARTING_PRESSURE_PA, "PHASE_ENVELOPE_STARTING_PRESSURE_PA", 100.0, "Starting pressure [Pa] for phase envelope construction") \
@@ -43,6 +49,10 @@
     X(OVERWRITE_DEPARTURE_FUNCTION, "OVERWRITE_DEPARTURE_FUNCTION", false, "If true, and a departure function to be added is already there, rather than not adding the departure function (and probably throwing an exception), overwrite it") \
     X(OVERWRITE_BINARY_INTERACTION, "OVERWRITE_BINARY_INTERACTION", false, "If true, and a pair of binary interaction pairs to be added is already there, rather than not adding the binary interaction pair (and probably throwing an exception), overwrite it") \
     X(USE_GUESSES_IN_PROPSSI, "USE_GUESSES_IN_PROPSSI", false, "If true, calls to the vectorized versions of PropsSI use the previous state as guess value while looping over the input vectors, only makes sense when working with a single fluid and with points that are not too far from each other.") \
+    X(SORT_BATCH_INPUTS, "SORT_BATCH_INPUTS", false, "If true, the vectorized versions of PropsSI and the batch updates evaluate the state points along a Hilbert curve in the plane of the two inputs, in warm-start mode when the backend supports it, and return the results in the order of the inputs; this helps when the points are not ordered") \
+    X(PROPSSI_NUM_THREADS, "PROPSSI_NUM_THREADS", static_cast<int>(1), "The number of threads used by the vectorized versions of PropsSI to evaluate the input vectors; 1 evaluates the inputs serially, 0 uses all the hardware threads") \
+    X(PROPSSI_PARALLEL_MIN_POINTS, "PROPSSI_PARALLEL_MIN_POINTS", static_cast<int>(1000), "The minimum length of the input vectors of the vectorized versions of PropsSI for them to be split between several threads") \
+    X(PROPSSI_STATE_CACHE_SIZE, "PROPSSI_STATE_CACHE_SIZE", static_cast<int>(16), "The maximum number of initialized AbstractState instances that PropsSI keeps between calls, keyed by backend, fluids and fractions; 0 disables the cache") \
     X(ASSUME_CRITICAL_POINT_STABLE, "ASSUME_CRITICAL_POINT_STABLE", false, "If true, evaluation of the stability of critical point will be skipped and point will be assumed to be stable") \
     X(VTPR_ALWAYS_RELOAD_LIBRARY, "VTPR_ALWAYS_RELOAD_LIBRARY", false, "If true, the library will always be reloaded, no matter what is currently loaded") \
     X(FLOAT_PUNCTUATION, "FLOAT_PUNCTUATION", ".", "The first character of this string will be used as the separator between the number fraction.") \
@@ -19,6 +19,7 @@ You might want to start by looking at CoolProp.h
     #include <string>
     #include <vector>
     #include "DataStructures.h"
+    #include "crossplatform_shared_ptr.h"
 
     namespace CoolProp {
 
@@ -55,6 +56,38 @@ You might want to start by looking at CoolProp.h
                                                    const std::vector<std::string> &fluids, 
                                                    const std::vector<double> &fractions);
 
+    class PropsSI_plan_data;
+
+    /**
+     * @brief A PropsSI call whose strings have been parsed once, so that it can be evaluated repeatedly with numbers alone
+     *
+     * The output, input names and fluid string take the same form as for PropsSI, and can include derivatives and an imposed phase.
+     * A plan owns its own state instance; it can be copied cheaply, but the copies share that state, so a plan must not be
+     * evaluated concurrently from several threads.
+     */
+    class PropsSI_plan{
+    private:
+        shared_ptr<PropsSI_plan_data> data;
+    public:
+        /// @param Outputs The output parameter(s), separated by '&', for instance "Dmass&Hmass&d(Hmass)/d(T)|P"
+        /// @param Name1 The first state variable name, possibly with an imposed phase, like "P|gas"
+        /// @param Name2 The second state variable name
+        /// @param FluidName The fluid name, with optional backend and fractions, for instance "HEOS::R32[0.5]&R125[0.5]"
+        PropsSI_plan(const std::string &Outputs, const std::string &Name1, const std::string &Name2, const std::string &FluidName);
+        /// The number of outputs of the plan
+        std::size_t num_outputs() const;
+        /// Evaluate the plan at one state point, the outputs are written to out[0] ... out[num_outputs()-1]; throws if the state update fails
+        void evaluate(double Prop1, double Prop2, double *out);
+        /// Evaluate a plan that has a single output at one state point; throws if the state update fails
+        double evaluate(double Prop1, double Prop2);
+        /// Evaluate the plan at N state points, output j of point i is written to out[j*N+i]; outputs that cannot be calculated are set to _HUGE
+        void evaluate(const double *Prop1, const double *Prop2, std::size_t N, double *out);
+    };
+
+    /// Release all the states that are kept between calls to PropsSI; this is done automatically when the fluid libraries,
+    /// the reference states, the mixture parameters or the configuration are modified
+    void clear_PropsSI_state_cache();
+
     /// Get the debug level
     /// @returns level The level of the verbosity for the debugging output (0-10) 0: no debgging output
     int get_debug_level();
@@ -21,6 +21,7 @@
 #include "Eigen/Core"
 #include "PolyMath.h"
 #include "Ancillaries.h"
+#include "crossplatform_shared_ptr.h"
 
 namespace CoolProp {
 
@@ -341,6 +342,8 @@ struct Ancillaries
     SaturationAncillaryFunction pL, pV, rhoL, rhoV, hL, hLV, sL, sLV;
     MeltingLineVariables melting_line;
     SurfaceTensionCorrelation surface_tension;
+    shared_ptr<SuperAncillary> superancillary; ///< The superancillary equations of the saturation curve, shared by the copies of the fluid and built on first use
+    Ancillaries() : superancillary(new SuperAncillary()) {};
 };
 
 /// The core class for an equation of state
@@ -262,6 +262,9 @@
     
     /**
      * @brief Generate an AbstractState instance, return an integer handle to the state class generated to be used in the other low-level accessor functions
+     *
+     * Handles can be generated, used and released from several threads at the same time, but one state class must only be used by one thread at a time.
+     * Using a handle that has been released gives an error.
      * @param backend The backend you will use, "HEOS", "REFPROP", etc.
      * @param fluids '&' delimited list of fluids
      * @param errcode The errorcode that is returned (0 = no error, !0 = error)
@@ -443,6 +446,31 @@
     */
     EXPORT_CODE void CONVENTION AbstractState_update_and_5_out(const long handle, const long input_pair, const double* value1, const double* value2, const long length, long *outputs, double* out1, double* out2, double* out3, double* out4, double* out5, long *errcode, char *message_buffer, const long buffer_length);
 
+    /**
+    * @brief Update the state of the AbstractState and get any number of outputs from the AbstractState using strided arrays,
+    * @brief so that interleaved data (for instance one record per cell of a CFD mesh, or a column of a NumPy array) can be used without copying
+    * @param handle The integer handle for the state class stored in memory
+    * @param input_pair The integer value for the input pair obtained from get_input_pair_index
+    * @param value1 The pointer to the first of the first input parameters, the i-th one is value1[i*stride1]
+    * @param stride1 The distance between two consecutive first input parameters, in number of doubles (0 to use the same value for all the points)
+    * @param value2 The pointer to the first of the second input parameters, the i-th one is value2[i*stride2]
+    * @param stride2 The distance between two consecutive second input parameters, in number of doubles (0 to use the same value for all the points)
+    * @param length The number of points
+    * @param outputs The nout-element vector of indices for the outputs desired
+    * @param nout The number of outputs desired
+    * @param out The pointer to the output array, output j of the i-th point is stored in out[i*out_stride + j]
+    * @param out_stride The distance between the outputs of two consecutive points, in number of doubles; must be at least nout
+    * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+    * @param message_buffer A buffer for the error code
+    * @param buffer_length The length of the buffer for the error code
+    * @return
+    *
+    * @note The strides are given in number of doubles, not in bytes; divide the strides of a NumPy array by its itemsize
+    * @note If there is an error in an update call for one of the inputs, its outputs are set to _HUGE, the other points are
+    * still calculated, and errcode and message_buffer report the number of points that could not be calculated
+    */
+    EXPORT_CODE void CONVENTION AbstractState_update_and_n_out(const long handle, const long input_pair, const double* value1, const long stride1, const double* value2, const long stride2, const long length, const long* outputs, const long nout, double* out, const long out_stride, long *errcode, char *message_buffer, const long buffer_length);
+
     /**
     * @brief Set binary interraction parrameter for mixtures
     * @param handle The integer handle for the state class stored in memory
@@ -560,6 +588,103 @@
      */
     EXPORT_CODE void CONVENTION AbstractState_all_critical_points(const long handle, const long length, double *T, double *p, double *rhomolar, long *stable, long *errcode, char *message_buffer, const long buffer_length);
 
+    /**
+     * @brief Parse the strings of a PropsSI call once, and return an integer handle to the plan that can be evaluated repeatedly with numbers alone
+     * @param Output The output parameter(s), separated by '&', for instance "Dmass&Hmass"
+     * @param Name1 The first state variable name, possibly with an imposed phase, like "P|gas"
+     * @param Name2 The second state variable name
+     * @param FluidName The fluid name, with optional backend and fractions, as for PropsSI
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return A handle to the plan
+     *
+     * @note A plan holds its own state; do not evaluate the same plan from several threads at the same time
+     */
+    EXPORT_CODE long CONVENTION PropsSI_plan_compile(const char *Output, const char *Name1, const char *Name2, const char *FluidName, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Evaluate a plan with a single output at one state point
+     * @param handle The integer handle for the plan stored in memory
+     * @param Prop1 The first state variable value
+     * @param Prop2 The second state variable value
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return The output value
+     */
+    EXPORT_CODE double CONVENTION PropsSI_plan_evaluate(const long handle, const double Prop1, const double Prop2, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Evaluate a plan at several state points
+     * @param handle The integer handle for the plan stored in memory
+     * @param Prop1 The pointer to the array of the first state variable values
+     * @param Prop2 The pointer to the array of the second state variable values
+     * @param length The number of elements stored in the input arrays
+     * @param out The pointer to the output array, of size length times the number of outputs; output j of point i is stored in out[j*length+i]
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return
+     *
+     * @note Outputs that cannot be calculated are set to _HUGE
+     */
+    EXPORT_CODE void CONVENTION PropsSI_plan_evaluate_n(const long handle, const double *Prop1, const double *Prop2, const long length, double *out, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Release a plan generated by PropsSI_plan_compile
+     * @param handle The integer handle for the plan stored in memory
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return
+     */
+    EXPORT_CODE void CONVENTION PropsSI_plan_free(const long handle, long *errcode, char *message_buffer, const long buffer_length);
+
+    /**
+     * @brief List the sets of tables of the tabular backends in memory and on disk
+     * @param paths The buffer that receives the paths of the sets, one per line
+     * @param paths_length The length of the buffer for the paths
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return The number of sets
+     *
+     * @note The state of each set (in memory, in use, on disk, pinned, sizes) is only available from C++, see list_tabular_data_sets() in TabularDataSets.h
+     */
+    EXPORT_CODE long CONVENTION list_tabular_data_sets(char *paths, const long paths_length, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Load (or build) the tables of a tabular backend
+     * @param backend The tabular backend, for instance "BICUBIC&HEOS"
+     * @param fluid_names The fluid name(s)
+     * @param path The buffer that receives the path of the set of tables
+     * @param path_length The length of the buffer for the path
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return
+     *
+     * @note No backend uses the tables once they are loaded, so they can be evicted again to stay below MAXIMUM_TABLE_MEMORY_IN_GB unless they are pinned with pin_tabular_data_set
+     */
+    EXPORT_CODE void CONVENTION preload_tabular_data_set(const char *backend, const char *fluid_names, char *path, const long path_length, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Pin a set of tables so that it is never evicted automatically, or unpin it
+     * @param path The path of the set of tables
+     * @param pin 1 to pin the set, 0 to unpin it
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return
+     */
+    EXPORT_CODE void CONVENTION pin_tabular_data_set(const char *path, const long pin, long *errcode, char *message_buffer, const long buffer_length);
+    /**
+     * @brief Remove a set of tables from memory, and from disk if from_disk is 1; the backends that use it can still use it
+     * @param path The path of the set of tables
+     * @param from_disk 1 to remove the tables from disk as well
+     * @param errcode The errorcode that is returned (0 = no error, !0 = error)
+     * @param message_buffer A buffer for the error code
+     * @param buffer_length The length of the buffer for the error code
+     * @return
+     */
+    EXPORT_CODE void CONVENTION evict_tabular_data_set(const char *path, const long from_disk, long *errcode, char *message_buffer, const long buffer_length);
+
     // *************************************************************************************
     // *************************************************************************************
     // *****************************  DEPRECATED *******************************************
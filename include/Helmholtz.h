@@ -71,6 +71,15 @@ struct HelmholtzDerivatives
         #undef X
         return _new;
     }
+    /// Set the derivatives of total order greater than max_order (2 or 3) to zero
+    void clear_above_order(std::size_t max_order){
+        if (max_order < 3){
+            d3alphar_ddelta3 = 0; d3alphar_ddelta_dtau2 = 0; d3alphar_ddelta2_dtau = 0; d3alphar_dtau3 = 0;
+        }
+        if (max_order < 4){
+            d4alphar_ddelta4 = 0; d4alphar_ddelta3_dtau = 0; d4alphar_ddelta2_dtau2 = 0; d4alphar_ddelta_dtau3 = 0; d4alphar_dtau4 = 0;
+        }
+    }
     HelmholtzDerivatives(){reset(0.0); T_red = _HUGE; rhomolar_red = _HUGE;};
     /// Retrieve a single value based on the number of derivatives with respect to tau and delta
     double get(std::size_t itau, std::size_t idelta){
@@ -201,6 +210,15 @@ public:
     virtual CoolPropDbl dDelta4(const CoolPropDbl &tau, const CoolPropDbl &delta) throw(){HelmholtzDerivatives deriv; all(tau,delta,deriv); return deriv.d4alphar_ddelta4;};
     
     virtual void all(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw() = 0;
+    /// Add the contributions of this term to the derivatives of total order up to max_order (2 to 4); the derivatives of higher
+    /// orders may or may not be added.  By default all() is called, terms that are expensive to evaluate skip the higher orders
+    virtual void all_upto(const CoolPropDbl &tau, const CoolPropDbl &delta, std::size_t max_order, HelmholtzDerivatives &derivs) throw(){
+        all(tau, delta, derivs);
+    };
+    /// Add the contributions of this term at N points (tau[i], delta[i]) to derivs[i]; by default all() is called for each point
+    virtual void all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *derivs) throw(){
+        for (std::size_t i = 0; i < N; ++i){ all(tau[i], delta[i], derivs[i]); }
+    };
 };
                     
 struct ResidualHelmholtzGeneralizedExponentialElement
@@ -224,6 +242,130 @@ struct ResidualHelmholtzGeneralizedExponentialElement
         l_int = 0; m_int = 0; l_is_int = false; m_is_int = true;
     };
 };
+// The SIMD loops over the polynomial and exponential terms of ResidualHelmholtzGeneralizedExponential work on doubles, so they are
+// only compiled in if CoolPropDbl is double, and only for x86-64 with compilers that can target AVX2 and AVX-512 per function
+#if defined(COOLPROPDBL_MAPS_TO_DOUBLE) && (defined(__x86_64__) || defined(_M_X64)) && !defined(COOLPROP_NO_SIMD) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || (defined(_MSC_VER) && _MSC_VER >= 1910))
+    #define COOLPROP_GENEXP_SIMD
+#endif
+
+/// The instruction sets of the SIMD loops over the polynomial and exponential terms of ResidualHelmholtzGeneralizedExponential
+enum generalized_exponential_simd_levels { GENEXP_SIMD_NONE = 0, GENEXP_SIMD_AVX2, GENEXP_SIMD_AVX512 };
+/// Get the best of these instruction sets that is compiled in and, according to cpuid, supported by the processor and enabled
+/// by the operating system; GENEXP_SIMD_NONE if there is none.  The processor is only queried the first time
+generalized_exponential_simd_levels get_generalized_exponential_simd_support();
+
+/// The terms of a ResidualHelmholtzGeneralizedExponential grouped by shape, built by ResidualHelmholtzGeneralizedExponential::finish()
+///
+/// Each group is evaluated in its own loop over contiguous arrays, without per-term branches, and with the factors of the
+/// derivatives that do not depend on the state computed once up front
+struct ResidualHelmholtzGeneralizedExponentialGroups
+{
+    /// Polynomial terms \f$ n\delta^d\tau^t \f$
+    std::vector<CoolPropDbl> poly_n, poly_d, poly_t;
+    /// The factors \f$ B_{\delta,k} \f$ and \f$ B_{\tau,k} \f$ (k=1..4) of the polynomial terms, four consecutive entries per term
+    std::vector<CoolPropDbl> poly_B_delta, poly_B_tau;
+    /// Exponential terms \f$ n\delta^d\tau^t\exp(-c\delta^l) \f$ with integer l from 1 to 31
+    std::vector<CoolPropDbl> exp_n, exp_d, exp_t, exp_c, exp_l_double;
+    std::vector<int> exp_l_int;
+    /// The factors \f$ B_{\tau,k} \f$ (k=1..4) of the exponential terms, four consecutive entries per term
+    std::vector<CoolPropDbl> exp_B_tau;
+    /// Gaussian and GERG-2008 terms \f$ n\delta^d\tau^t\exp(-\eta_1(\delta-\epsilon_1)-\eta_2(\delta-\epsilon_2)^2-\beta_1(\tau-\gamma_1)-\beta_2(\tau-\gamma_2)^2) \f$
+    std::vector<CoolPropDbl> gauss_n, gauss_d, gauss_t, gauss_eta1, gauss_epsilon1, gauss_eta2, gauss_epsilon2, gauss_beta1, gauss_gamma1, gauss_beta2, gauss_gamma2;
+    /// Indices of the elements that fit none of the groups above (non-integer l, tau^m in the exponential, ...)
+    std::vector<std::size_t> other;
+#if defined(COOLPROP_GENEXP_SIMD)
+    /// The polynomial and exponential terms again for the SIMD loops, padded with terms with n = 0 to simd_Npoly and simd_Nexp
+    /// terms, a multiple of 8.  The factors of the 14 derivatives of polynomial term i, in the order of
+    /// add_generalized_exponential_term(), are in simd_poly_C[(j-1)*simd_Npoly + i], j=1..14, and the factor
+    /// \f$ B_{\tau,k} \f$ of exponential term i is in simd_exp_B_tau[(k-1)*simd_Nexp + i]
+    std::size_t simd_Npoly, simd_Nexp;
+    std::vector<double> simd_poly_n, simd_poly_d, simd_poly_t, simd_poly_C;
+    std::vector<double> simd_exp_n, simd_exp_d, simd_exp_t, simd_exp_c, simd_exp_l_double, simd_exp_B_tau;
+    std::vector<int> simd_exp_l_int;
+#endif
+
+    void clear(){
+        poly_n.clear(); poly_d.clear(); poly_t.clear(); poly_B_delta.clear(); poly_B_tau.clear();
+        exp_n.clear(); exp_d.clear(); exp_t.clear(); exp_c.clear(); exp_l_double.clear(); exp_l_int.clear(); exp_B_tau.clear();
+        gauss_n.clear(); gauss_d.clear(); gauss_t.clear(); gauss_eta1.clear(); gauss_epsilon1.clear(); gauss_eta2.clear();
+        gauss_epsilon2.clear(); gauss_beta1.clear(); gauss_gamma1.clear(); gauss_beta2.clear(); gauss_gamma2.clear();
+        other.clear();
+#if defined(COOLPROP_GENEXP_SIMD)
+        simd_Npoly = 0; simd_Nexp = 0;
+        simd_poly_n.clear(); simd_poly_d.clear(); simd_poly_t.clear(); simd_poly_C.clear();
+        simd_exp_n.clear(); simd_exp_d.clear(); simd_exp_t.clear(); simd_exp_c.clear(); simd_exp_l_double.clear(); simd_exp_B_tau.clear();
+        simd_exp_l_int.clear();
+#endif
+    }
+};
+/// Get the factors B_k = x^k/f*d^k(f)/dx^k, k=1..max_order, of a term f = x^p*exp(u(x)) from the derivatives of u with respect to x
+inline void generalized_exponential_B(const CoolPropDbl x, const CoolPropDbl p, const CoolPropDbl du, const CoolPropDbl d2u, const CoolPropDbl d3u, const CoolPropDbl d4u, CoolPropDbl *B, const std::size_t max_order = 4)
+{
+    const CoolPropDbl dB_dx = x*d2u + du;
+
+    B[0] = (x*du + p);
+    B[1] = x*dB_dx + (B[0] - 1)*B[0];
+    if (max_order < 3){ return; }
+    const CoolPropDbl d2B_dx2 = x*d3u + 2*d2u;
+    const CoolPropDbl dB2_dx = x*d2B_dx2 + 2*B[0]*dB_dx;
+    B[2] = x*dB2_dx + (B[0] -  2)*B[1];
+    if (max_order < 4){ return; }
+    const CoolPropDbl d3B_dx3 = x*d4u + 3*d3u;
+    const CoolPropDbl dB3_dx = x*x*d3B_dx3 + 3*x*B[0]*d2B_dx2 + 3*x*POW2(dB_dx)+3*B[0]*(B[0]-1)*dB_dx;
+    B[3] = x*dB3_dx + (B[0] -  3)*B[2];
+}
+/// Add the contribution of one term, where ndteu = n*delta^d*tau^t*exp(u), to the (not yet scaled) sums of the derivatives up to the order max_order
+inline void add_generalized_exponential_term(HelmholtzDerivatives &derivs, const CoolPropDbl ndteu, const CoolPropDbl *B_delta, const CoolPropDbl *B_tau, const std::size_t max_order = 4)
+{
+    derivs.alphar += ndteu;
+
+    derivs.dalphar_ddelta += ndteu*B_delta[0];
+    derivs.dalphar_dtau += ndteu*B_tau[0];
+
+    derivs.d2alphar_ddelta2 += ndteu*B_delta[1];
+    derivs.d2alphar_ddelta_dtau += ndteu*B_delta[0]*B_tau[0];
+    derivs.d2alphar_dtau2 += ndteu*B_tau[1];
+
+    if (max_order < 3){ return; }
+    derivs.d3alphar_ddelta3 += ndteu*B_delta[2];
+    derivs.d3alphar_ddelta2_dtau += ndteu*B_delta[1]*B_tau[0];
+    derivs.d3alphar_ddelta_dtau2 += ndteu*B_delta[0]*B_tau[1];
+    derivs.d3alphar_dtau3 += ndteu*B_tau[2];
+
+    if (max_order < 4){ return; }
+    derivs.d4alphar_ddelta4 += ndteu*B_delta[3];
+    derivs.d4alphar_ddelta3_dtau += ndteu*B_delta[2]*B_tau[0];
+    derivs.d4alphar_ddelta2_dtau2 += ndteu*B_delta[1]*B_tau[1];
+    derivs.d4alphar_ddelta_dtau3 += ndteu*B_delta[0]*B_tau[2];
+    derivs.d4alphar_dtau4 += ndteu*B_tau[3];
+}
+/// Scale the sums of the derivatives up to the order max_order by the powers of 1/delta and 1/tau
+inline void scale_generalized_exponential_sums(HelmholtzDerivatives &derivs, const CoolPropDbl one_over_delta, const CoolPropDbl one_over_tau, const std::size_t max_order = 4)
+{
+    derivs.dalphar_ddelta         *= one_over_delta;
+    derivs.dalphar_dtau           *= one_over_tau;
+    derivs.d2alphar_ddelta2       *= POW2(one_over_delta);
+    derivs.d2alphar_dtau2         *= POW2(one_over_tau);
+    derivs.d2alphar_ddelta_dtau   *= one_over_delta*one_over_tau;
+    
+    if (max_order < 3){ return; }
+    derivs.d3alphar_ddelta3       *= POW3(one_over_delta);
+    derivs.d3alphar_dtau3         *= POW3(one_over_tau);
+    derivs.d3alphar_ddelta2_dtau  *= POW2(one_over_delta)*one_over_tau;
+    derivs.d3alphar_ddelta_dtau2  *= one_over_delta*POW2(one_over_tau);
+    
+    if (max_order < 4){ return; }
+    derivs.d4alphar_ddelta4       *= POW4(one_over_delta);
+    derivs.d4alphar_dtau4         *= POW4(one_over_tau);
+    derivs.d4alphar_ddelta3_dtau  *= POW3(one_over_delta)*one_over_tau;
+    derivs.d4alphar_ddelta2_dtau2 *= POW2(one_over_delta)*POW2(one_over_tau);
+    derivs.d4alphar_ddelta_dtau3  *= one_over_delta*POW3(one_over_tau);
+}
+
+/// A kernel that evaluates the generalized exponential terms of one particular fluid, generated by dev/generate_alphar_kernels.py
+typedef void (*ResidualHelmholtzGeneralizedExponentialKernel)(const CoolPropDbl tau, const CoolPropDbl delta, std::size_t max_order, HelmholtzDerivatives &derivs);
+
 /** \brief A generalized residual helmholtz energy container that can deal with a wide range of terms which can be converted to this general form
  * 
  * \f$ \alpha^r=\sum_i n_i \delta^{d_i} \tau^{t_i}\exp(u_i) \f$
@@ -248,10 +390,17 @@ public:
     //Eigen::ArrayXd uE, du_ddeltaE, du_dtauE, d2u_ddelta2E, d2u_dtau2E, d3u_ddelta3E, d3u_dtau3E;
         
     std::vector<ResidualHelmholtzGeneralizedExponentialElement> elements;
+    /// The elements grouped by shape, only valid once finish() has been called
+    ResidualHelmholtzGeneralizedExponentialGroups groups;
+    /// A specialized kernel generated for exactly these elements, used instead of the groups if not NULL; see attach_specialized_alphar_kernel()
+    ResidualHelmholtzGeneralizedExponentialKernel kernel;
+    /// The SIMD loops used for the polynomial and exponential groups, set by finish() to get_generalized_exponential_simd_support();
+    /// the scalar loops are used if it is GENEXP_SIMD_NONE
+    generalized_exponential_simd_levels simd;
     // Default Constructor
     ResidualHelmholtzGeneralizedExponential()
         : delta_li_in_u(false),tau_mi_in_u(false),eta1_in_u(false),
-          eta2_in_u(false),beta1_in_u(false),beta2_in_u(false),finished(false), N(0) {};
+          eta2_in_u(false),beta1_in_u(false),beta2_in_u(false),finished(false), N(0), kernel(NULL), simd(GENEXP_SIMD_NONE) {};
     /** \brief Add and convert an old-style power (polynomial) term to generalized form
 	 * 
 	 * Term of the format
@@ -275,6 +424,7 @@ public:
             elements.push_back(el);
         }
         delta_li_in_u = true;
+        elements_changed();
     };
 	/** \brief Add and convert an old-style exponential term to generalized form
 	 * 
@@ -297,6 +447,7 @@ public:
             elements.push_back(el);
         }
         delta_li_in_u = true;
+        elements_changed();
     }
 	/** \brief Add and convert an old-style Gaussian term to generalized form
 	 * 
@@ -326,6 +477,7 @@ public:
         }
         eta2_in_u = true;
         beta2_in_u = true;
+        elements_changed();
     };
 	/** \brief Add and convert an old-style Gaussian term from GERG 2008 natural gas model to generalized form
 	 * 
@@ -354,6 +506,7 @@ public:
         }
         eta2_in_u = true;
         eta1_in_u = true;
+        elements_changed();
     };
 	/** \brief Add and convert a term from Lemmon and Jacobsen (2005) used for R125
 	 * 
@@ -382,6 +535,7 @@ public:
         }
         delta_li_in_u = true;
         tau_mi_in_u = true;
+        elements_changed();
     };
     
     void finish(){
@@ -419,13 +573,36 @@ public:
 //        d3u_ddelta3E.resize(elements.size());
 //        d3u_dtau3E.resize(elements.size());
         
+        group_elements();
+        simd = get_generalized_exponential_simd_support();
         finished = true;
     };
 
     void to_json(rapidjson::Value &el, rapidjson::Document &doc);
     
-    void all(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw();
+    /// Sort the elements into groups by shape, see ResidualHelmholtzGeneralizedExponentialGroups
+    void group_elements();
+    /// Evaluate the terms group by group if finish() has been called, otherwise term by term
+    ///
+    /// With the scalar loops, the contribution of each term is the same as in all_term_by_term(); the sums are only reordered
+    /// if the terms of different shapes are interleaved, in which case the results differ at the level of the round-off error
+    /// of the sums.  The SIMD loops evaluate four (AVX2) or eight (AVX-512) polynomial or exponential terms at a time with their
+    /// own exponential function, so their results differ from the scalar ones at the level of the round-off error
+    void all(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw(){ all_upto(tau, delta, 4, derivs); };
+    /// The same as all(), but the B factors and sums of the derivatives of orders higher than max_order are skipped in the groups
+    void all_upto(const CoolPropDbl &tau, const CoolPropDbl &delta, std::size_t max_order, HelmholtzDerivatives &derivs) throw();
+    /// Add the contribution of the element i, in its general form, to the sums of all() before they are scaled by the powers of 1/delta and 1/tau
+    void add_element(std::size_t i, const CoolPropDbl tau, const CoolPropDbl delta, const CoolPropDbl log_tau, const CoolPropDbl log_delta,
+                     const CoolPropDbl one_over_tau, const CoolPropDbl one_over_delta, HelmholtzDerivatives &s, const std::size_t max_order = 4) const;
+    /// Evaluate the terms one by one, in the order in which they were added
+    void all_term_by_term(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw();
+    /// Evaluate the groups of terms for blocks of points, looping over the points of a block for each term; the results are the same as from all().
+    /// With a specialized kernel or the SIMD loops, which run over the terms, the points are evaluated one by one
+    void all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *derivs) throw();
     //void allEigen(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw();
+private:
+    /// The groups and the specialized kernel no longer match the elements once an element has been added
+    void elements_changed(){ finished = false; kernel = NULL; };
 };
 
 struct ResidualHelmholtzNonAnalyticElement
@@ -622,6 +799,10 @@ public:
     
     virtual void empty_the_EOS() = 0;
     virtual HelmholtzDerivatives all(const CoolPropDbl tau, const CoolPropDbl delta, bool cache_values) = 0;
+    /// Evaluate all the derivatives at N points (tau[i], delta[i]), out[i] gets the same values as all(tau[i], delta[i]); nothing is cached
+    virtual void all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *out){
+        for (std::size_t i = 0; i < N; ++i){ out[i] = all(tau[i], delta[i], false); }
+    };
     
     CoolPropDbl base(CoolPropDbl tau, CoolPropDbl delta, const bool dont_use_cache = false) {
         if (!_base || dont_use_cache)
@@ -710,14 +891,20 @@ public:
     };
     
     HelmholtzDerivatives all(const CoolPropDbl tau, const CoolPropDbl delta, bool cache_values = false)
+    {
+        return all_upto(tau, delta, 4, cache_values);
+    };
+    /// Calculate the derivatives of total order up to max_order (2 to 4), the derivatives of higher orders are set to zero
+    HelmholtzDerivatives all_upto(const CoolPropDbl tau, const CoolPropDbl delta, std::size_t max_order, bool cache_values = false)
     {
         HelmholtzDerivatives derivs; // zeros out the elements
-        GenExp.all(tau, delta, derivs);
-        NonAnalytic.all(tau, delta, derivs);
-        SAFT.all(tau, delta, derivs);
-        cubic.all(tau, delta, derivs);
-        XiangDeiters.all(tau, delta, derivs);
-        GaoB.all(tau, delta, derivs);
+        GenExp.all_upto(tau, delta, max_order, derivs);
+        NonAnalytic.all_upto(tau, delta, max_order, derivs);
+        SAFT.all_upto(tau, delta, max_order, derivs);
+        cubic.all_upto(tau, delta, max_order, derivs);
+        XiangDeiters.all_upto(tau, delta, max_order, derivs);
+        GaoB.all_upto(tau, delta, max_order, derivs);
+        derivs.clear_above_order(max_order);
         if (cache_values){
             _base = derivs.alphar;
             _dDelta = derivs.dalphar_ddelta;
@@ -725,13 +912,28 @@ public:
             _dDelta2 = derivs.d2alphar_ddelta2;
             _dTau2 = derivs.d2alphar_dtau2;
             _dDelta_dTau = derivs.d2alphar_ddelta_dtau;
-            _dDelta3 = derivs.d3alphar_ddelta3;
-            _dTau3 = derivs.d3alphar_dtau3;
-            _dDelta2_dTau = derivs.d3alphar_ddelta2_dtau;
-            _dDelta_dTau2 = derivs.d3alphar_ddelta_dtau2;
+            if (max_order >= 3){
+                _dDelta3 = derivs.d3alphar_ddelta3;
+                _dTau3 = derivs.d3alphar_dtau3;
+                _dDelta2_dTau = derivs.d3alphar_ddelta2_dtau;
+                _dDelta_dTau2 = derivs.d3alphar_ddelta_dtau2;
+            }
+            else{
+                _dDelta3.clear(); _dTau3.clear(); _dDelta2_dTau.clear(); _dDelta_dTau2.clear();
+            }
         }
         return derivs;
     };
+    void all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *out)
+    {
+        for (std::size_t i = 0; i < N; ++i){ out[i] = HelmholtzDerivatives(); } // zeros out the elements
+        GenExp.all_batch(tau, delta, N, out);
+        NonAnalytic.all_batch(tau, delta, N, out);
+        SAFT.all_batch(tau, delta, N, out);
+        cubic.all_batch(tau, delta, N, out);
+        XiangDeiters.all_batch(tau, delta, N, out);
+        GaoB.all_batch(tau, delta, N, out);
+    };
 };
 
 // #############################################################################
@@ -1275,6 +1477,21 @@ public:
             }
             return derivs*_prefactor;
         };
+        void all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *out)
+        {
+            for (std::size_t i = 0; i < N; ++i){ out[i] = HelmholtzDerivatives(); } // zeros out the elements
+            Lead.all_batch(tau, delta, N, out);
+            EnthalpyEntropyOffsetCore.all_batch(tau, delta, N, out);
+            EnthalpyEntropyOffset.all_batch(tau, delta, N, out);
+            LogTau.all_batch(tau, delta, N, out);
+            Power.all_batch(tau, delta, N, out);
+            PlanckEinstein.all_batch(tau, delta, N, out);
+            CP0Constant.all_batch(tau, delta, N, out);
+            CP0PolyT.all_batch(tau, delta, N, out);
+            GERG2004Cosh.all_batch(tau, delta, N, out);
+            GERG2004Sinh.all_batch(tau, delta, N, out);
+            for (std::size_t i = 0; i < N; ++i){ out[i] = out[i]*_prefactor; }
+        };
     };
 }; /* namespace CoolProp */
 
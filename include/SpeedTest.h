@@ -7,6 +7,17 @@ namespace CoolProp{
 
 void compare_REFPROP_and_CoolProp(const std::string &fluid, int inputs, double val1, double val2, std::size_t N, double d1 = 0, double d2 = 0);
 
+/// Time the evaluation of the generalized exponential residual Helmholtz terms of a pure fluid with the term-by-term loop,
+/// with the scalar loops over the groups of terms and with each of the SIMD loops the processor supports, with N calls
+/// each, and print the time per call (for instance for Water, CarbonDioxide and R134a).  The first two differ only in the
+/// grouping of the terms; the SIMD loops only add the vectorization of the polynomial and exponential groups
+void time_generalized_exponential(const std::string &fluid, std::size_t N);
+
+/// Time the direct Newton solver of the single-phase (P,H) flash of a pure fluid against the bounded solver, for a liquid
+/// and a vapor state at 30% of the critical pressure, with N calls each, and print the time per call (for instance for
+/// Water, CarbonDioxide and R134a)
+void time_HP_flash_singlephase(const std::string &fluid, std::size_t N);
+
 } /* namespace CoolProp */
 
 #endif
\ No newline at end of file
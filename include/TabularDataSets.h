@@ -0,0 +1,43 @@
+/*
+This header file includes the functions that manage the sets of tables of the tabular backends (TTSE, bicubic) in memory
+and on disk.  They are meant to be accessed via C++; the C-style wrappers are in CoolPropLib.h
+
+\sa CoolPropLib.h
+*/
+
+#ifndef TABULARDATASETS_H
+#define TABULARDATASETS_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace CoolProp {
+
+/// The state of a set of tables, as returned by list_tabular_data_sets()
+struct TabularDataSetInfo{
+    std::string path; ///< The directory of the tables, which is also the key of the set
+    bool in_memory; ///< True if the set is loaded in this process
+    bool in_use; ///< True if a backend of this process uses the set
+    bool on_disk; ///< True if the tables have been written to disk
+    bool pinned; ///< True if the set is never evicted automatically
+    std::size_t memory_size; ///< The heap memory used by the set in bytes, see TabularDataSet::memory_size()
+    unsigned long long disk_size; ///< The size of the directory of the tables in bytes
+    double last_used; ///< The time the tables were last loaded from disk, in seconds since the epoch
+    TabularDataSetInfo() : in_memory(false), in_use(false), on_disk(false), pinned(false), memory_size(0), disk_size(0), last_used(0){};
+};
+
+/// List the sets of tables of the tabular backends in memory and on disk
+std::vector<TabularDataSetInfo> list_tabular_data_sets();
+/// Load (or build) the tables of a tabular backend, for instance ("BICUBIC&HEOS", "Water"), and return their path
+///
+/// The backend that loads the tables is destroyed right away, so the set is kept in memory but not in use; it can be evicted
+/// again when the tables in memory exceed MAXIMUM_TABLE_MEMORY_IN_GB, unless it is pinned with pin_tabular_data_set()
+std::string preload_tabular_data_set(const std::string &backend, const std::string &fluid_names);
+/// Pin a set of tables so that it is never evicted automatically, or unpin it
+void pin_tabular_data_set(const std::string &path, bool pin = true);
+/// Remove a set of tables from memory, and from disk if from_disk is true; the backends that use it can still use it
+void evict_tabular_data_set(const std::string &path, bool from_disk = false);
+
+} /* namespace CoolProp */
+#endif
@@ -5,16 +5,71 @@
  *  and assures that the objects used for testing are the
  *  same in all places.
  */
+#ifndef TESTOBJECTS_H
+#define TESTOBJECTS_H
+
 #include "IncompressibleFluid.h"
 #include "Eigen/Core"
 #include "MatrixMath.h"
 
 #if defined ENABLE_CATCH
+#include "catch.hpp"
+#include "Helmholtz.h"
+#include "Configuration.h"
+
 namespace CoolPropTesting {
 
 Eigen::MatrixXd makeMatrix(const std::vector<double> &coefficients);
 //CoolProp::IncompressibleFluid incompressibleFluidObject();
 //IncompressibleBackend incompressibleBackendObject();
 
+/// The pure fluids with which the faster code paths are checked against the reference ones; they cover all the kinds of residual Helmholtz terms
+inline std::vector<std::string> referenceFluids(){
+    const char *fluids[] = {"Water", "CarbonDioxide", "R134a", "R125", "n-Propane"};
+    return std::vector<std::string>(fluids, fluids + sizeof(fluids)/sizeof(fluids[0]));
+}
+
+/// The (tau, delta) points at which the Helmholtz energy terms are checked, from the dilute gas to the compressed liquid
+class TauDeltaGrid{
+public:
+    std::vector<CoolPropDbl> tau, delta;
+    TauDeltaGrid(double dtau = 0.25, double ddelta = 0.25){
+        for (double t = 0.5; t < 3; t += dtau){
+            for (double d = 0.01; d < 3.5; d += ddelta){
+                tau.push_back(t); delta.push_back(d);
+            }
+        }
+    };
+    std::size_t size() const { return tau.size(); };
+};
+
+/// Check the derivatives of the Helmholtz energy up to fourth order; the ones above max_order must not have been calculated
+inline void checkHelmholtzDerivatives(CoolProp::HelmholtzDerivatives actual, CoolProp::HelmholtzDerivatives expected, double rel_tol, double abs_tol, std::size_t max_order = 4){
+    for (std::size_t itau = 0; itau <= 4; ++itau){
+        for (std::size_t idelta = 0; itau + idelta <= 4; ++idelta){
+            CAPTURE(itau); CAPTURE(idelta);
+            if (itau + idelta <= max_order){
+                CHECK(std::abs(actual.get(itau, idelta) - expected.get(itau, idelta)) <= rel_tol*std::abs(expected.get(itau, idelta)) + abs_tol);
+            }
+            else{
+                CHECK(actual.get(itau, idelta) == 0);
+            }
+        }
+    }
+}
+
+/// Set a configuration flag for the lifetime of the object; the previous value is restored when it goes out of scope, also if a check throws
+class ConfigBoolScope{
+private:
+    configuration_keys key;
+    bool previous;
+public:
+    ConfigBoolScope(configuration_keys key, bool value) : key(key), previous(CoolProp::get_config_bool(key)){
+        CoolProp::set_config_bool(key, value);
+    };
+    ~ConfigBoolScope(){ CoolProp::set_config_bool(key, previous); };
+};
+
 } // namespace CoolPropTesting
 #endif // ENABLE_CATCH
+#endif // TESTOBJECTS_H
@@ -10,6 +10,8 @@
 #endif
 
 #include <stdlib.h>
+#include <algorithm>
+#include <limits>
 #include "math.h"
 #include "AbstractState.h"
 #include "DataStructures.h"
@@ -121,9 +123,20 @@ AbstractState * AbstractState::factory(const std::string &backend, const std::ve
         std::cout << "AbstractState::factory(" << backend << "," << stringvec_to_string(fluid_names) << ")" << std::endl;
     }
 
+    // The tabular backends can be given the specification of their tables in brackets, like BICUBIC&HEOS[Nx=400,pmax=30e6]
+    std::string backend_string = backend, table_specification;
+    std::size_t ibracket = backend.find('[');
+    if (ibracket != std::string::npos && endswith(backend, "]")){
+        backend_string = backend.substr(0, ibracket);
+        table_specification = backend.substr(ibracket + 1, backend.size() - ibracket - 2);
+    }
+
     backend_families f1;
     std::string f2;
-    extract_backend_families_string(backend, f1, f2);
+    extract_backend_families_string(backend_string, f1, f2);
+    if (!table_specification.empty() && f1 != TTSE_BACKEND_FAMILY && f1 != BICUBIC_BACKEND_FAMILY){
+        throw ValueError(format("Only the tabular backends accept a table specification in brackets, not [%s]", backend.c_str()));
+    }
 
     std::map<backend_families,shared_ptr<AbstractStateGenerator> >::const_iterator gen, end;
     get_backend_library().get_generator_iterators(f1, gen, end);
@@ -141,13 +154,13 @@ AbstractState * AbstractState::factory(const std::string &backend, const std::ve
     {
         // Will throw if there is a problem with this backend
         shared_ptr<AbstractState> AS(factory(f2, fluid_names));
-        return new TTSEBackend(AS);
+        return new TTSEBackend(AS, TableSpecification(table_specification));
     }
     else if (f1==BICUBIC_BACKEND_FAMILY)
     {
         // Will throw if there is a problem with this backend
         shared_ptr<AbstractState> AS(factory(f2, fluid_names));
-        return new BicubicBackend(AS);
+        return new BicubicBackend(AS, TableSpecification(table_specification));
     }
     #endif
     else if (!backend.compare("?") || backend.empty())
@@ -174,6 +187,10 @@ std::vector<std::string> AbstractState::fluid_names(void)
 {
     return calc_fluid_names();
 }
+bool AbstractState::skip_property_limits(void){
+    return _skip_property_limits || get_config_bool(DONT_CHECK_PROPERTY_LIMITS);
+}
+
 bool AbstractState::clear_comp_change(){
     // Reset all instances of CachedElement and overwrite
     // the internal double values with -_HUGE
@@ -259,6 +276,11 @@ bool AbstractState::clear() {
     this->_d3alphar_dDelta_dTau2.clear();
     this->_d3alphar_dDelta2_dTau.clear();
     this->_d3alphar_dDelta3.clear();
+    this->_d4alphar_dTau4.clear();
+    this->_d4alphar_dDelta_dTau3.clear();
+    this->_d4alphar_dDelta2_dTau2.clear();
+    this->_d4alphar_dDelta3_dTau.clear();
+    this->_d4alphar_dDelta4.clear();
 
     this->_dalphar_dDelta_lim.clear();
     this->_d2alphar_dDelta2_lim.clear();
@@ -505,6 +527,114 @@ double AbstractState::keyed_output(parameters key)
         throw ValueError(format("This input [%d: \"%s\"] is not valid for keyed_output",key,get_parameter_information(key,"short").c_str()));
     }
 }
+void AbstractState::update_batch(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, const std::vector<parameters> &outputs, double *out_soa)
+{
+    // Trivial outputs do not depend on the state; evaluate them once and broadcast them
+    std::vector<std::size_t> state_outputs;
+    for (std::size_t j = 0; j < outputs.size(); ++j){
+        double *out = out_soa + j*n;
+        if (is_trivial_parameter(outputs[j])){
+            double val;
+            try{ val = trivial_keyed_output(outputs[j]); }
+            catch(...){ val = _HUGE; }
+            std::fill(out, out + n, val);
+        }
+        else{
+            state_outputs.push_back(j);
+        }
+    }
+    if (state_outputs.empty()){ return; }
+
+    // Visit the points along a Hilbert curve so that each update can start from the previous state
+    std::vector<std::size_t> order;
+    shared_ptr<WarmStartScope> warm_start;
+    if (get_config_bool(SORT_BATCH_INPUTS) && n > 2){
+        get_batch_order(input_pair, Value1, Value2, n, order);
+        warm_start.reset(new WarmStartScope(*this));
+    }
+
+    for (std::size_t k = 0; k < n; ++k){
+        std::size_t i = (order.empty()) ? k : order[k];
+        try{
+            update(input_pair, Value1[i], Value2[i]);
+        }
+        catch(...){
+            for (std::size_t m = 0; m < state_outputs.size(); ++m){ out_soa[state_outputs[m]*n + i] = _HUGE; }
+            continue;
+        }
+        for (std::size_t m = 0; m < state_outputs.size(); ++m){
+            std::size_t j = state_outputs[m];
+            try{ out_soa[j*n + i] = keyed_output(outputs[j]); }
+            catch(...){ out_soa[j*n + i] = _HUGE; }
+        }
+    }
+}
+
+/// The index of the cell (x, y) of a 2^bits x 2^bits grid along the Hilbert curve that fills it
+static uint64_t hilbert_index(uint32_t x, uint32_t y, unsigned int bits)
+{
+    const uint32_t N = static_cast<uint32_t>(1) << bits;
+    uint64_t d = 0;
+    for (uint32_t s = N/2; s > 0; s /= 2){
+        uint32_t rx = (x & s) ? 1 : 0, ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s)*s*((3*rx) ^ ry);
+        // Rotate the quadrant so that the curve is continuous
+        if (ry == 0){
+            if (rx == 1){ x = N - 1 - x; y = N - 1 - y; }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+void AbstractState::get_batch_order(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, std::vector<std::size_t> &order)
+{
+    parameters keys[2];
+    split_input_pair(input_pair, keys[0], keys[1]);
+    const double *values[2] = {Value1, Value2};
+    const unsigned int bits = 16;
+    const double cells = static_cast<double>((static_cast<uint32_t>(1) << bits) - 1);
+
+    // Pressures and densities span orders of magnitude, use their logarithms if they are all positive
+    std::vector<double> coords[2];
+    std::vector<char> valid(n, 1);
+    for (int k = 0; k < 2; ++k){
+        bool use_log = (keys[k] == iP || keys[k] == iDmolar || keys[k] == iDmass);
+        for (std::size_t i = 0; i < n; ++i){
+            if (!ValidNumber(values[k][i])){ valid[i] = 0; }
+            else if (values[k][i] <= 0){ use_log = false; }
+        }
+        coords[k].resize(n);
+        for (std::size_t i = 0; i < n; ++i){
+            coords[k][i] = (valid[i] && use_log) ? log(values[k][i]) : values[k][i];
+        }
+    }
+    double min[2] = {_HUGE, _HUGE}, max[2] = {-_HUGE, -_HUGE};
+    for (std::size_t i = 0; i < n; ++i){
+        if (!valid[i]){ continue; }
+        for (int k = 0; k < 2; ++k){
+            min[k] = std::min(min[k], coords[k][i]);
+            max[k] = std::max(max[k], coords[k][i]);
+        }
+    }
+
+    // Sort by the index along the curve; the index of the point breaks the ties so that the order is deterministic
+    std::vector<std::pair<uint64_t, std::size_t> > keyed(n);
+    for (std::size_t i = 0; i < n; ++i){
+        if (!valid[i]){
+            keyed[i] = std::make_pair(std::numeric_limits<uint64_t>::max(), i);
+            continue;
+        }
+        uint32_t cell[2];
+        for (int k = 0; k < 2; ++k){
+            double range = max[k] - min[k];
+            cell[k] = (range > 0) ? static_cast<uint32_t>((coords[k][i] - min[k])/range*cells + 0.5) : 0;
+        }
+        keyed[i] = std::make_pair(hilbert_index(cell[0], cell[1], bits), i);
+    }
+    std::sort(keyed.begin(), keyed.end());
+    order.resize(n);
+    for (std::size_t i = 0; i < n; ++i){ order[i] = keyed[i].second; }
+}
 
 double AbstractState::tau(void){
     if (!_tau) _tau = calc_reciprocal_reduced_temperature();
@@ -1146,4 +1276,80 @@ TEST_CASE("Check derivatives in first_partial_deriv","[derivs_in_first_partial_d
     CHECK( std::abs(dspeed_sound_drho_analyt/dspeed_sound_drho_num-1) < eps);
 }
 
+TEST_CASE("Check batch update against scalar updates","[update_batch]")
+{
+    shared_ptr<CoolProp::AbstractState> Water(CoolProp::AbstractState::factory("HEOS", "Water"));
+    std::vector<double> p(3, 101325), T;
+    T.push_back(300); T.push_back(400); T.push_back(-1); // Last point is invalid
+    std::vector<CoolProp::parameters> outputs;
+    outputs.push_back(CoolProp::iDmass);
+    outputs.push_back(CoolProp::imolar_mass);
+    outputs.push_back(CoolProp::iHmass);
+    std::vector<double> out(p.size()*outputs.size());
+    Water->update_batch(CoolProp::PT_INPUTS, &(p[0]), &(T[0]), p.size(), outputs, &(out[0]));
+    for (std::size_t i = 0; i < 2; ++i){
+        Water->update(CoolProp::PT_INPUTS, p[i], T[i]);
+        CAPTURE(T[i]);
+        CHECK(out[0*p.size() + i] == Water->rhomass());
+        CHECK(out[1*p.size() + i] == Water->molar_mass());
+        CHECK(out[2*p.size() + i] == Water->hmass());
+    }
+    CHECK(!ValidNumber(out[0*p.size() + 2]));
+    CHECK(out[1*p.size() + 2] == Water->molar_mass());
+    CHECK(!ValidNumber(out[2*p.size() + 2]));
+}
+
+TEST_CASE("Check the Hilbert order of the points of a batch","[update_batch]")
+{
+    // A 32x32 grid in (log(p), h), visited in a scrambled order
+    std::vector<double> h, p;
+    for (std::size_t k = 0; k < 1024; ++k){
+        std::size_t i = (k*389) % 1024;
+        h.push_back(1000.0*static_cast<double>(i % 32));
+        p.push_back(1e5*pow(2.0, static_cast<double>(i / 32)/4.0));
+    }
+    h[7] = _HUGE; // An invalid point
+    std::vector<std::size_t> order;
+    CoolProp::AbstractState::get_batch_order(CoolProp::HmassP_INPUTS, &(h[0]), &(p[0]), h.size(), order);
+    REQUIRE(order.size() == h.size());
+    CHECK(order.back() == 7);
+    std::vector<std::size_t> sorted(order);
+    std::sort(sorted.begin(), sorted.end());
+    for (std::size_t i = 0; i < sorted.size(); ++i){ CHECK(sorted[i] == i); }
+    // Consecutive valid points along a Hilbert curve in a full grid are neighbours on the grid, except where the invalid point was removed
+    std::size_t jumps = 0;
+    for (std::size_t k = 1; k + 1 < order.size(); ++k){
+        double dh = std::abs(h[order[k]] - h[order[k-1]])/1000.0, dlogp = std::abs(log(p[order[k]]/p[order[k-1]]))/(log(2.0)/4.0);
+        if (dh + dlogp > 1.5){ jumps++; }
+    }
+    CHECK(jumps <= 1);
+}
+
+TEST_CASE("Check sorted batch updates against scalar updates","[update_batch]")
+{
+    shared_ptr<CoolProp::AbstractState> Water(CoolProp::AbstractState::factory("HEOS", "Water"));
+    // Liquid, two-phase and vapor states in a scrambled order
+    std::vector<double> h, p;
+    for (std::size_t k = 0; k < 200; ++k){
+        std::size_t i = (k*73) % 200;
+        h.push_back(2e5 + 1.5e4*static_cast<double>(i % 20));
+        p.push_back(1e5*pow(10.0, static_cast<double>(i / 20)/10.0));
+    }
+    std::vector<CoolProp::parameters> outputs(1, CoolProp::iT);
+    outputs.push_back(CoolProp::iDmass);
+    std::vector<double> out(h.size()*outputs.size());
+    bool sort_inputs = CoolProp::get_config_bool(SORT_BATCH_INPUTS);
+    CoolProp::set_config_bool(SORT_BATCH_INPUTS, true);
+    Water->update_batch(CoolProp::HmassP_INPUTS, &(h[0]), &(p[0]), h.size(), outputs, &(out[0]));
+    CoolProp::set_config_bool(SORT_BATCH_INPUTS, sort_inputs);
+    CHECK(Water->get_warm_start() == false);
+    for (std::size_t i = 0; i < h.size(); ++i){
+        CAPTURE(h[i]);
+        CAPTURE(p[i]);
+        Water->update(CoolProp::HmassP_INPUTS, h[i], p[i]);
+        CHECK(std::abs(out[0*h.size() + i]/Water->T() - 1) < 1e-8);
+        CHECK(std::abs(out[1*h.size() + i]/Water->rhomass() - 1) < 1e-8);
+    }
+}
+
 #endif
@@ -332,7 +332,8 @@ public:
     }
 
     /// All the derivatives of the residual Helmholtz energy w.r.t. tau and delta that do not involve composition derivative
-    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, const std::vector<CoolPropDbl> &mole_fractions, double tau, double delta, bool cache_values = false)
+    /// up to the total order max_order; the derivatives of higher orders are left at zero
+    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, const std::vector<CoolPropDbl> &mole_fractions, double tau, double delta, bool cache_values = false, std::size_t max_order = 4)
     {
 		HelmholtzDerivatives a;
 		std::vector<double> z = std::vector<double>(mole_fractions.begin(), mole_fractions.end());
@@ -343,10 +344,12 @@ public:
         a.d2alphar_dtau2 = cubic->alphar(tau, delta, z, 2, 0);
         a.d2alphar_ddelta_dtau = cubic->alphar(tau, delta, z, 1, 1);
         a.d2alphar_ddelta2 = cubic->alphar(tau, delta, z, 0, 2);
+        if (max_order < 3){ return a; }
         a.d3alphar_dtau3 = cubic->alphar(tau, delta, z, 3, 0);
         a.d3alphar_ddelta_dtau2 = cubic->alphar(tau, delta, z, 2, 1);
         a.d3alphar_ddelta2_dtau = cubic->alphar(tau, delta, z, 1, 2);
         a.d3alphar_ddelta3 = cubic->alphar(tau, delta, z, 0, 3);
+        if (max_order < 4){ return a; }
         a.d4alphar_dtau4 = cubic->alphar(tau, delta, z, 4, 0);
         a.d4alphar_ddelta_dtau3 = cubic->alphar(tau, delta, z, 3, 1);
         a.d4alphar_ddelta2_dtau2 = cubic->alphar(tau, delta, z, 2, 2);
@@ -7,6 +7,7 @@
 
 #if defined(ENABLE_CATCH)
 #include "catch.hpp"
+#include "TestObjects.h"
 #include "Backends/Cubics/CubicBackend.h"
 #endif
 
@@ -268,6 +269,26 @@ public:
     }
 };
 
+class DQ_flash_superancillary_residual : public FuncWrapper1D
+{
+public:
+    const SuperAncillary &superancillary;
+    double rhomolar, Q_target;
+    DQ_flash_superancillary_residual(const SuperAncillary &superancillary, double rhomolar, double Q_target) : superancillary(superancillary), rhomolar(rhomolar), Q_target(Q_target) {};
+    double call(double T){
+        double rhoL = superancillary.eval_rhoL(T);
+        double rhoV = superancillary.eval_rhoV(T);
+        /// Error between calculated and target vapor quality based on densities
+        return (1/rhomolar - 1/rhoL)/(1/rhoV - 1/rhoL) - Q_target;
+    }
+};
+/// Update HEOS.SatL and HEOS.SatV to the saturation states at T given by the superancillary equations
+static void superancillary_saturation_T(HelmholtzEOSMixtureBackend &HEOS, const SuperAncillary &superancillary, CoolPropDbl T)
+{
+    HEOS.SatL->update_DmolarT_direct(superancillary.eval_rhoL(T), T);
+    HEOS.SatV->update_DmolarT_direct(superancillary.eval_rhoV(T), T);
+}
+
 void FlashRoutines::DQ_flash(HelmholtzEOSMixtureBackend &HEOS)
 {
     SaturationSolvers::saturation_PHSU_pure_options options;
@@ -279,8 +300,24 @@ void FlashRoutines::DQ_flash(HelmholtzEOSMixtureBackend &HEOS)
         double Tmin = HEOS.Tmin() + 0.1;
         double rhomolar = HEOS._rhomolar;
         double Q = HEOS._Q;
-        DQ_flash_residual resid(HEOS, rhomolar, Q);
-        Brent(resid, Tmin, Tmax, DBL_EPSILON, 1e-10, 100);
+        bool solved = false;
+        SuperAncillary *superancillary = HEOS.get_superancillary();
+        if (superancillary != NULL){
+            // The residual is only a few polynomial evaluations with the superancillary equations
+            try{
+                DQ_flash_superancillary_residual resid(*superancillary, rhomolar, Q);
+                double T = Brent(resid, std::max(Tmin, superancillary->get_Tmin()), std::min(Tmax, superancillary->get_Tmax()), DBL_EPSILON, 1e-12, 100);
+                superancillary_saturation_T(HEOS, *superancillary, T);
+                solved = true;
+            }
+            catch(std::exception &){
+                // The solution is not in the range of the superancillary equations
+            }
+        }
+        if (!solved){
+            DQ_flash_residual resid(HEOS, rhomolar, Q);
+            Brent(resid, Tmin, Tmax, DBL_EPSILON, 1e-10, 100);
+        }
         HEOS._p = HEOS.SatV->p();
         HEOS._T = HEOS.SatV->T();
         HEOS._rhomolar = rhomolar;
@@ -379,6 +416,9 @@ void FlashRoutines::QT_flash(HelmholtzEOSMixtureBackend &HEOS)
         // Get a reference to keep the code a bit cleaner
         const CriticalRegionSplines &splines = HEOS.components[0].EOS().critical_region_splines;
         
+        // NULL for pseudo-pure fluids, or if disabled
+        SuperAncillary *superancillary = HEOS.get_superancillary();
+        
         // If exactly(ish) at the critical temperature, liquid and vapor have the critial density
         if ((get_config_bool(CRITICAL_WITHIN_1UK) && std::abs(T-Tmax_sat)< 1e-6) || std::abs(T-Tmax_sat)< 1e-12){
              HEOS.SatL->update(DmolarT_INPUTS, HEOS.rhomolar_critical(), HEOS._T);
@@ -386,7 +426,7 @@ void FlashRoutines::QT_flash(HelmholtzEOSMixtureBackend &HEOS)
              HEOS._rhomolar = HEOS.rhomolar_critical();
              HEOS._p = 0.5*HEOS.SatV->p() + 0.5*HEOS.SatL->p();
         }
-        else if (!is_in_closed_range(Tmin_sat-0.1, Tmax_sat, T) && (CoolProp::get_config_bool(DONT_CHECK_PROPERTY_LIMITS) == false)){
+        else if (!is_in_closed_range(Tmin_sat-0.1, Tmax_sat, T) && !HEOS.skip_property_limits()){
             throw ValueError(format("Temperature to QT_flash [%0.8Lg K] must be in range [%0.8Lg K, %0.8Lg K]", T, Tmin_sat-0.1, Tmax_sat));
         }
         else if (get_config_bool(CRITICAL_SPLINES_ENABLED) && splines.enabled && HEOS._T > splines.T_min){
@@ -398,6 +438,12 @@ void FlashRoutines::QT_flash(HelmholtzEOSMixtureBackend &HEOS)
             HEOS._p = 0.5*HEOS.SatV->p() + 0.5*HEOS.SatL->p();
             HEOS._rhomolar = 1/(HEOS._Q/HEOS.SatV->rhomolar() + (1 - HEOS._Q)/HEOS.SatL->rhomolar());
         }
+        else if (superancillary != NULL && superancillary->contains_T(T)){
+            // Evaluate the superancillary equations rather than solving for the saturation state
+            superancillary_saturation_T(HEOS, *superancillary, T);
+            HEOS._p = superancillary->eval_p(T);
+            HEOS._rhomolar = 1/(HEOS._Q/HEOS.SatV->rhomolar() + (1 - HEOS._Q)/HEOS.SatL->rhomolar());
+        }
         else if (!(HEOS.components[0].EOS().pseudo_pure))
         {
             // Set some input options
@@ -574,7 +620,7 @@ void FlashRoutines::PQ_flash(HelmholtzEOSMixtureBackend &HEOS)
             }
             
             // Check limits
-            if (CoolProp::get_config_bool(DONT_CHECK_PROPERTY_LIMITS) == false){
+            if (!HEOS.skip_property_limits()){
                 if (!is_in_closed_range(pmin_sat*0.999999, pmax_sat*1.000001, static_cast<CoolPropDbl>(HEOS._p))){
                     throw ValueError(format("Pressure to PQ_flash [%6g Pa] must be in range [%8Lg Pa, %8Lg Pa]",HEOS._p, pmin_sat, pmax_sat));
                 }
@@ -583,37 +629,44 @@ void FlashRoutines::PQ_flash(HelmholtzEOSMixtureBackend &HEOS)
             // It is a pure fluid
             // ------------------
 
-            // Set some input options
-            SaturationSolvers::saturation_PHSU_pure_options options;
-            // Specified variable is pressure
-            options.specified_variable = SaturationSolvers::saturation_PHSU_pure_options::IMPOSED_PL;
-            // Use logarithm of delta as independent variables
-            options.use_logdelta = false;
+            SuperAncillary *superancillary = HEOS.get_superancillary();
+            if (superancillary != NULL && superancillary->contains_p(HEOS._p)){
+                // Evaluate the superancillary equations rather than solving for the saturation state
+                superancillary_saturation_T(HEOS, *superancillary, superancillary->get_T_from_p(HEOS._p));
+            }
+            else{
+                // Set some input options
+                SaturationSolvers::saturation_PHSU_pure_options options;
+                // Specified variable is pressure
+                options.specified_variable = SaturationSolvers::saturation_PHSU_pure_options::IMPOSED_PL;
+                // Use logarithm of delta as independent variables
+                options.use_logdelta = false;
             
-            double increment = 0.4;
+                double increment = 0.4;
 
-            try{
-                for (double omega = 1.0; omega > 0; omega -= increment){
-                    try{
-                        options.omega = omega;
+                try{
+                    for (double omega = 1.0; omega > 0; omega -= increment){
+                        try{
+                            options.omega = omega;
                         
-                        // Actually call the solver
-                        SaturationSolvers::saturation_PHSU_pure(HEOS, HEOS._p, options);
+                            // Actually call the solver
+                            SaturationSolvers::saturation_PHSU_pure(HEOS, HEOS._p, options);
                         
-                        // If you get here, there was no error, all is well
-                        break;
-                    }
-                    catch(...){
-                        if (omega < 1.1*increment){
-                            throw;
+                            // If you get here, there was no error, all is well
+                            break;
+                        }
+                        catch(...){
+                            if (omega < 1.1*increment){
+                                throw;
+                            }
+                            // else we are going to try again with a smaller omega
                         }
-                        // else we are going to try again with a smaller omega
                     }
                 }
-            }
-            catch(...){
-                // We may need to polish the solution at low pressure
-                SaturationSolvers::saturation_P_pure_1D_T(HEOS, HEOS._p, options);
+                catch(...){
+                    // We may need to polish the solution at low pressure
+                    SaturationSolvers::saturation_P_pure_1D_T(HEOS, HEOS._p, options);
+                }
             }
 
             // Load the outputs
@@ -1465,6 +1518,82 @@ void FlashRoutines::HSU_P_flash_singlephase_Brent(HelmholtzEOSMixtureBackend &HE
     }
 }
 
+bool FlashRoutines::HSU_P_flash_singlephase_direct(HelmholtzEOSMixtureBackend &HEOS, parameters other, CoolPropDbl value, CoolPropDbl T0, CoolPropDbl rhomolar0, CoolPropDbl Tmin, CoolPropDbl Tmax)
+{
+    if (!HEOS.is_pure_or_pseudopure || !ValidNumber(HEOS._p) || !ValidNumber(value) || !ValidNumber(T0) || !ValidNumber(rhomolar0) || T0 <= 0 || rhomolar0 <= 0){
+        return false;
+    }
+    if (other != iHmolar && other != iSmolar && other != iUmolar){ return false; }
+
+    EquationOfState &E = HEOS.components[0].EOS();
+    const SimpleState &reducing = HEOS.get_reducing_state();
+    CoolPropDbl Tr = reducing.T, rhor = reducing.rhomolar, R = HEOS.gas_constant(), p = HEOS._p;
+    // The ideal-gas part is a function of Tc/T and rho/rhoc, which are tau and delta for multiparameter EOS
+    CoolPropDbl Tc = HEOS.get_fluid_constant(0, iT_reducing), rhoc = HEOS.get_fluid_constant(0, irhomolar_reducing);
+    CoolPropDbl tau_ratio = Tc/Tr, delta_ratio = rhor/rhoc;
+    E.alpha0.set_Tred(Tc);
+
+    CoolPropDbl tau = Tr/T0, delta = rhomolar0/rhor;
+    CoolPropDbl p_scaled = p/(rhor*R*Tr), y_scaled = (other == iSmolar) ? value/R : value/(R*Tr);
+    for (int iter = 0; iter < 50; ++iter)
+    {
+        // All the derivatives needed by the Jacobian, in one evaluation of each part
+        HelmholtzDerivatives ar = HEOS.residual_helmholtz->all(HEOS, HEOS.mole_fractions, tau, delta, false, 2);
+        HelmholtzDerivatives a0 = E.alpha0.all(tau_ratio*tau, delta_ratio*delta, false);
+        CoolPropDbl da0_dtau = tau_ratio*a0.dalphar_dtau, d2a0_dtau2 = POW2(tau_ratio)*a0.d2alphar_dtau2;
+        CoolPropDbl da0_ddelta = delta_ratio*a0.dalphar_ddelta;
+
+        // p/(rhor*R*Tr) = delta/tau*(1+delta*dar_ddelta)
+        CoolPropDbl f1 = delta/tau*(1 + delta*ar.dalphar_ddelta) - p_scaled;
+        CoolPropDbl df1_dtau = -delta/POW2(tau)*(1 + delta*ar.dalphar_ddelta) + POW2(delta)/tau*ar.d2alphar_ddelta_dtau;
+        CoolPropDbl df1_ddelta = (1 + 2*delta*ar.dalphar_ddelta + POW2(delta)*ar.d2alphar_ddelta2)/tau;
+        CoolPropDbl f2, df2_dtau, df2_ddelta;
+        switch (other)
+        {
+            case iHmolar:
+                // h*tau/(R*Tr) = 1+delta*dar_ddelta+tau*(da0_dtau+dar_dtau)
+                f2 = 1 + delta*ar.dalphar_ddelta + tau*(da0_dtau + ar.dalphar_dtau) - tau*y_scaled;
+                df2_dtau = delta*ar.d2alphar_ddelta_dtau + da0_dtau + ar.dalphar_dtau + tau*(d2a0_dtau2 + ar.d2alphar_dtau2) - y_scaled;
+                df2_ddelta = ar.dalphar_ddelta + delta*ar.d2alphar_ddelta2 + tau*ar.d2alphar_ddelta_dtau;
+                break;
+            case iSmolar:
+                // s/R = tau*(da0_dtau+dar_dtau)-a0-ar
+                f2 = tau*(da0_dtau + ar.dalphar_dtau) - a0.alphar - ar.alphar - y_scaled;
+                df2_dtau = tau*(d2a0_dtau2 + ar.d2alphar_dtau2);
+                df2_ddelta = tau*ar.d2alphar_ddelta_dtau - da0_ddelta - ar.dalphar_ddelta;
+                break;
+            default:
+                // u/(R*Tr) = da0_dtau+dar_dtau
+                f2 = da0_dtau + ar.dalphar_dtau - y_scaled;
+                df2_dtau = d2a0_dtau2 + ar.d2alphar_dtau2;
+                df2_ddelta = ar.d2alphar_ddelta_dtau;
+                break;
+        }
+        CoolPropDbl det = df1_dtau*df2_ddelta - df1_ddelta*df2_dtau;
+        if (!ValidNumber(f1) || !ValidNumber(f2) || !ValidNumber(det) || det == 0){ return false; }
+        CoolPropDbl dtau = -(df2_ddelta*f1 - df1_ddelta*f2)/det;
+        CoolPropDbl ddelta = -(-df2_dtau*f1 + df1_dtau*f2)/det;
+
+        // Limit the steps so that the iterations do not jump to another branch of the isobar
+        CoolPropDbl scale = 1;
+        if (std::abs(dtau) > 0.1*tau){ scale = 0.1*tau/std::abs(dtau); }
+        if (std::abs(ddelta) > 0.5*delta){ scale = std::min(scale, 0.5*delta/std::abs(ddelta)); }
+        tau += scale*dtau;
+        delta += scale*ddelta;
+
+        if (scale == 1 && std::abs(dtau) < 1e-12*tau && std::abs(ddelta) < 1e-12*delta){
+            CoolPropDbl T = Tr/tau, rhomolar = delta*rhor;
+            // Only accept a mechanically stable state within the limits of the phase
+            CoolPropDbl dp_ddelta__tau = rhor*R*Tr/tau*(1 + 2*delta*ar.dalphar_ddelta + POW2(delta)*ar.d2alphar_ddelta2);
+            if (T < Tmin || T > Tmax || dp_ddelta__tau <= 0){ return false; }
+            HEOS._T = T;
+            HEOS._rhomolar = rhomolar;
+            return true;
+        }
+    }
+    return false;
+}
+
 // P given and one of H, S, or U
 void FlashRoutines::HSU_P_flash(HelmholtzEOSMixtureBackend &HEOS, parameters other)
 {
@@ -1541,11 +1670,29 @@ void FlashRoutines::HSU_P_flash(HelmholtzEOSMixtureBackend &HEOS, parameters oth
                 default:
                 { throw ValueError(format("Not a valid homogeneous state")); }
             }
-            try{
-                HSU_P_flash_singlephase_Brent(HEOS, other, value, Tmin, Tmax, HEOS._phase);
+            // Start from the saturated state of the phase if there is one, otherwise go straight to the bounded solver
+            CoolPropDbl T0 = -1, rhomolar0 = -1;
+            if (HEOS._phase == iphase_gas){
+                T0 = Tmin;
+                if (HEOS._p < HEOS.p_triple()){ rhomolar0 = HEOS._p/(HEOS.gas_constant()*T0); }
+                else if (saturation_called){ rhomolar0 = HEOS.SatV->rhomolar(); }
+                else{ rhomolar0 = HEOS.components[0].ancillaries.rhoV.evaluate(T0); }
+            }
+            else if (HEOS._phase == iphase_liquid){
+                T0 = Tmax;
+                rhomolar0 = (saturation_called) ? HEOS.SatL->rhomolar() : HEOS.components[0].ancillaries.rhoL.evaluate(T0);
             }
-            catch(std::exception &e){
-                throw ValueError(format("unable to solve 1phase PY flash with Tmin=%Lg, Tmax=%Lg due to error: %s",Tmin, Tmax, e.what()));
+            bool solved = false;
+            if (T0 > 0){
+                solved = HSU_P_flash_singlephase_direct(HEOS, other, value, T0, rhomolar0, Tmin, Tmax);
+            }
+            if (!solved){
+                try{
+                    HSU_P_flash_singlephase_Brent(HEOS, other, value, Tmin, Tmax, HEOS._phase);
+                }
+                catch(std::exception &e){
+                    throw ValueError(format("unable to solve 1phase PY flash with Tmin=%Lg, Tmax=%Lg due to error: %s",Tmin, Tmax, e.what()));
+                }
             }
             HEOS._Q = -1;
             // Update the state for conditions where the state was guessed
@@ -2015,6 +2162,198 @@ void FlashRoutines::HS_flash(HelmholtzEOSMixtureBackend &HEOS)
     Brent(resid, Tmin, Tmax, DBL_EPSILON, 1e-10, 100);
 }
 
+/// True for the state variables that the single-phase warm start can be given
+static bool is_warm_start_variable(parameters key)
+{
+    return key == iT || key == iP || key == iDmolar || key == iHmolar || key == iSmolar || key == iUmolar;
+}
+/// The derivative of a state variable with respect to T or rho, the other one being constant
+static CoolPropDbl warm_start_derivative(HelmholtzEOSMixtureBackend &HEOS, parameters key, parameters wrt)
+{
+    if (key == wrt){ return 1; }
+    if (key == iT || key == iDmolar){ return 0; }
+    return HEOS.first_partial_deriv(key, wrt, (wrt == iT) ? iDmolar : iT);
+}
+/// Saturation of a pure fluid at T, with the Maxwell solver started from the saturated densities rhoL and rhoV, which are then updated
+static bool warm_start_saturation_T(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T, CoolPropDbl &rhoL, CoolPropDbl &rhoV)
+{
+    SaturationSolvers::saturation_T_pure_Akasaka_options options(true);
+    options.rhoL = rhoL; options.rhoV = rhoV;
+    SaturationSolvers::saturation_T_pure_Maxwell(HEOS, T, options);
+    rhoL = HEOS.SatL->rhomolar(); rhoV = HEOS.SatV->rhomolar();
+    // The solver may also end up on the trivial solution with the same density for both phases
+    return rhoL > HEOS.rhomolar_critical() && rhoV < HEOS.rhomolar_critical();
+}
+
+/// The values of key for the saturated liquid and vapor of the saturation state in HEOS; the density is given as its inverse,
+/// so that the value of a two-phase state is linear in the quality
+static void warm_start_saturated_values(HelmholtzEOSMixtureBackend &HEOS, parameters key, CoolPropDbl &yL, CoolPropDbl &yV)
+{
+    if (key == iDmolar){ yL = 1/HEOS.SatL->rhomolar(); yV = 1/HEOS.SatV->rhomolar(); }
+    else{ yL = HEOS.SatL->keyed_output(key); yV = HEOS.SatV->keyed_output(key); }
+}
+
+bool FlashRoutines::warm_start_flash(HelmholtzEOSMixtureBackend &HEOS, input_pairs input_pair, CoolPropDbl value1, CoolPropDbl value2, const WarmStartState &previous)
+{
+    parameters key1, key2;
+    try{
+        split_input_pair(input_pair, key1, key2);
+        if (previous.phase == iphase_twophase){
+            return warm_start_twophase(HEOS, key1, value1, key2, value2, previous);
+        }
+        else{
+            return warm_start_singlephase(HEOS, key1, value1, key2, value2, previous);
+        }
+    }
+    catch(std::exception &){
+        // The usual flash routines will either find the state or give the error
+        return false;
+    }
+}
+
+bool FlashRoutines::warm_start_singlephase(HelmholtzEOSMixtureBackend &HEOS, parameters key1, CoolPropDbl value1, parameters key2, CoolPropDbl value2, const WarmStartState &previous)
+{
+    if (!is_warm_start_variable(key1) || !is_warm_start_variable(key2)){ return false; }
+
+    // Newton iteration in T and rho from the previous state; an imposed T or rho stays at its value
+    CoolPropDbl T = previous.T, rhomolar = previous.rhomolar;
+    if (key1 == iT){ T = value1; } else if (key1 == iDmolar){ rhomolar = value1; }
+    if (key2 == iT){ T = value2; } else if (key2 == iDmolar){ rhomolar = value2; }
+    bool converged = false;
+    for (int iter = 0; iter < 20 && !converged; ++iter){
+        HEOS.update_DmolarT_direct(rhomolar, T);
+        CoolPropDbl r1 = HEOS.keyed_output(key1) - value1, r2 = HEOS.keyed_output(key2) - value2;
+        CoolPropDbl J11 = warm_start_derivative(HEOS, key1, iT), J12 = warm_start_derivative(HEOS, key1, iDmolar);
+        CoolPropDbl J21 = warm_start_derivative(HEOS, key2, iT), J22 = warm_start_derivative(HEOS, key2, iDmolar);
+        CoolPropDbl det = J11*J22 - J12*J21;
+        CoolPropDbl dT = -(J22*r1 - J12*r2)/det, drhomolar = -(J11*r2 - J21*r1)/det;
+        // A step this large means that the previous state is too far away
+        if (!ValidNumber(dT) || !ValidNumber(drhomolar) || std::abs(dT) > 0.25*T || std::abs(drhomolar) > 0.5*rhomolar){ return false; }
+        T += dT; rhomolar += drhomolar;
+        converged = (std::abs(dT) < 1e-10*T && std::abs(drhomolar) < 1e-10*rhomolar);
+    }
+    if (!converged){ return false; }
+    HEOS.update_DmolarT_direct(rhomolar, T);
+    if (HEOS._T > HEOS.Tmax() || HEOS._p > HEOS.pmax()){ return false; }
+
+    // Below the critical point, the phase is only certain if the pressure is away from the vapor pressure by more
+    // than the error of the ancillaries; metastable states are rejected as well
+    CoolPropDbl Tc = HEOS.T_critical(), pc = HEOS.p_critical(), rhoc = HEOS.rhomolar_critical();
+    if (HEOS._T < Tc && HEOS._p < pc){
+        if (HEOS._T > 0.99*Tc || HEOS._T < HEOS.Ttriple()){ return false; }
+        CoolPropFluid &component = HEOS.components[0];
+        bool liquid = (HEOS._rhomolar > rhoc && HEOS._p > 1.02*component.ancillaries.pL.evaluate(HEOS._T));
+        bool gas = (HEOS._rhomolar < rhoc && HEOS._p < 0.98*component.ancillaries.pV.evaluate(HEOS._T));
+        if (!liquid && !gas){ return false; }
+    }
+    // Load the other outputs
+    if (HEOS._p > pc){
+        HEOS._phase = (HEOS._T > Tc) ? iphase_supercritical : iphase_supercritical_liquid;
+    }
+    else if (HEOS._T > Tc){
+        HEOS._phase = iphase_supercritical_gas;
+    }
+    else{
+        HEOS._phase = (HEOS._rhomolar > rhoc) ? iphase_liquid : iphase_gas;
+    }
+    HEOS._Q = -1;
+    return true;
+}
+
+bool FlashRoutines::warm_start_twophase(HelmholtzEOSMixtureBackend &HEOS, parameters key1, CoolPropDbl value1, parameters key2, CoolPropDbl value2, const WarmStartState &previous)
+{
+    // Pseudo-pure fluids use the ancillaries in the two-phase region
+    if (HEOS.components[0].EOS().pseudo_pure || !ValidNumber(previous.rhomolar_liq) || !ValidNumber(previous.rhomolar_vap)){ return false; }
+
+    // Close to the critical point the saturation solvers need their usual starting values
+    const CriticalRegionSplines &splines = HEOS.components[0].EOS().critical_region_splines;
+    CoolPropDbl Tmax_sat = 0.99*HEOS.T_critical();
+    if (get_config_bool(CRITICAL_SPLINES_ENABLED) && splines.enabled){ Tmax_sat = std::min(Tmax_sat, static_cast<CoolPropDbl>(splines.T_min)); }
+    CoolPropDbl Tmin_sat = HEOS.Ttriple();
+
+    CoolPropDbl T = previous.T, rhoL = previous.rhomolar_liq, rhoV = previous.rhomolar_vap, Q = _HUGE, p = _HUGE, other_value = _HUGE;
+    parameters other = INVALID_PARAMETER;
+    bool imposed_T = false, imposed_p = false;
+    if (key1 == iQ && key2 == iT){ Q = value1; T = value2; imposed_T = true; }
+    else if (key1 == iP && key2 == iQ){ p = value1; Q = value2; imposed_p = true; }
+    else if (key1 == iDmolar && key2 == iT){ other = iDmolar; other_value = value1; T = value2; imposed_T = true; }
+    else if (key1 == iHmolar && key2 == iP){ other = iHmolar; other_value = value1; p = value2; imposed_p = true; }
+    else if (key1 == iP && (key2 == iSmolar || key2 == iUmolar)){ p = value1; other = key2; other_value = value2; imposed_p = true; }
+    // Any pair of density, enthalpy, entropy and internal energy (DH, DS, DU, HS, SU); T is found along the saturation curve
+    else if ((key1 == iDmolar || key1 == iHmolar || key1 == iSmolar) && (key2 == iHmolar || key2 == iSmolar || key2 == iUmolar) && key1 != key2){
+        other = key1; other_value = value1;
+    }
+    else{ return false; }
+    if (other == INVALID_PARAMETER && (Q < 0 || Q > 1)){ return false; }
+
+    if (imposed_T){
+        if (T < Tmin_sat || T > Tmax_sat || std::abs(T - previous.T) > 0.05*previous.T){ return false; }
+        if (!warm_start_saturation_T(HEOS, T, rhoL, rhoV)){ return false; }
+        p = 0.5*HEOS.SatV->p() + 0.5*HEOS.SatL->p();
+    }
+    else if (!imposed_p){
+        // Secant iteration in T along the saturation curve; the quality is given by the first input at each T, and the
+        // residual is the second input at that quality
+        CoolPropDbl x = (key1 == iDmolar) ? 1/value1 : value1, T_prev = _HUGE, r_prev = _HUGE;
+        bool converged = false;
+        for (int iter = 0; iter < 20 && !converged; ++iter){
+            if (T < Tmin_sat || T > Tmax_sat){ return false; }
+            if (!warm_start_saturation_T(HEOS, T, rhoL, rhoV)){ return false; }
+            CoolPropDbl xL, xV, yL, yV;
+            warm_start_saturated_values(HEOS, key1, xL, xV);
+            warm_start_saturated_values(HEOS, key2, yL, yV);
+            CoolPropDbl r = yL + (x - xL)/(xV - xL)*(yV - yL) - value2;
+            converged = (r == 0 || (iter > 0 && std::abs(T - T_prev) < 1e-10*T));
+            if (!converged){
+                // The first step only gives the slope of the residual
+                CoolPropDbl dT = (iter == 0) ? 1e-6*T : -r*(T - T_prev)/(r - r_prev);
+                // A step this large means that the previous state is too far away
+                if (!ValidNumber(dT) || std::abs(dT) > 0.05*T){ return false; }
+                T_prev = T; r_prev = r;
+                T += dT;
+            }
+        }
+        if (!converged){ return false; }
+        T = HEOS.SatL->T();
+        p = 0.5*HEOS.SatV->p() + 0.5*HEOS.SatL->p();
+    }
+    else{
+        // Newton iteration in T for the saturation pressure, with the slope from the Clausius-Clapeyron equation
+        bool converged = false;
+        for (int iter = 0; iter < 10 && !converged; ++iter){
+            if (T < Tmin_sat || T > Tmax_sat){ return false; }
+            if (!warm_start_saturation_T(HEOS, T, rhoL, rhoV)){ return false; }
+            CoolPropDbl psat = 0.5*HEOS.SatV->p() + 0.5*HEOS.SatL->p();
+            converged = (std::abs(psat - p) < 1e-10*p);
+            if (!converged){
+                CoolPropDbl dpdT = (HEOS.SatV->smolar() - HEOS.SatL->smolar())/(1/rhoV - 1/rhoL);
+                CoolPropDbl dT = -(psat - p)/dpdT;
+                // A step this large means that the previous state is too far away
+                if (!ValidNumber(dT) || std::abs(dT) > 0.05*T){ return false; }
+                T += dT;
+            }
+        }
+        if (!converged){ return false; }
+        // The pressure is an input, so it is kept; only T and the properties that are not inputs come from the saturation state
+        T = HEOS.SatL->T();
+    }
+    if (other != INVALID_PARAMETER){
+        CoolPropDbl yL, yV;
+        warm_start_saturated_values(HEOS, other, yL, yV);
+        Q = (((other == iDmolar) ? 1/other_value : other_value) - yL)/(yV - yL);
+    }
+    // The state has left the two-phase region
+    if (!ValidNumber(Q) || Q < 0 || Q > 1){ return false; }
+
+    // Load the outputs
+    HEOS._T = T;
+    HEOS._p = p;
+    HEOS._Q = Q;
+    HEOS._rhomolar = (other == iDmolar) ? other_value : 1/(Q/rhoV + (1 - Q)/rhoL);
+    HEOS._phase = iphase_twophase;
+    return true;
+}
+
 #if defined(ENABLE_CATCH)
 
 
@@ -2027,6 +2366,118 @@ TEST_CASE("PD with T very large should yield error","[PDflash]")
 	CHECK_THROWS(HEOS->update(DmassP_INPUTS, 2, 5*HEOS->p()));
 }
 
+TEST_CASE("Warm-start flashes give the same states as the usual flashes","[warm_start]")
+{
+    shared_ptr<HelmholtzEOSMixtureBackend> warm(new HelmholtzEOSMixtureBackend(strsplit("Water",'&')));
+    shared_ptr<HelmholtzEOSMixtureBackend> cold(new HelmholtzEOSMixtureBackend(strsplit("Water",'&')));
+    warm->set_warm_start(true);
+    
+    SECTION("HP along an isobar through the two-phase region"){
+        // Small steps in enthalpy from the liquid through the two-phase region to the vapor
+        cold->update(PQ_INPUTS, 1e6, 0);
+        double hL = cold->hmolar();
+        cold->update(PQ_INPUTS, 1e6, 1);
+        double hV = cold->hmolar();
+        for (double h = hL - 2000; h < hV + 2000; h += 250){
+            CAPTURE(h);
+            cold->update(HmolarP_INPUTS, h, 1e6);
+            CHECK_NOTHROW(warm->update(HmolarP_INPUTS, h, 1e6));
+            CHECK(warm->phase() == cold->phase());
+            CHECK(std::abs(warm->T()/cold->T() - 1) < 1e-8);
+            CHECK(std::abs(warm->rhomolar()/cold->rhomolar() - 1) < 1e-8);
+        }
+    }
+    SECTION("Other input pairs in single-phase and two-phase states"){
+        double p[] = {2e5, 2.1e5, 5e6, 5.2e5, 1e5};
+        double T[] = {500, 505, 550, 420, 400};
+        for (int i = 0; i < 5; ++i){
+            cold->update(PT_INPUTS, p[i], T[i]);
+            CAPTURE(p[i]);
+            CAPTURE(T[i]);
+            CHECK_NOTHROW(warm->update(PT_INPUTS, p[i], T[i]));
+            CHECK(std::abs(warm->rhomolar()/cold->rhomolar() - 1) < 1e-8);
+            double rho = cold->rhomolar(), s = cold->smolar(), u = cold->umolar();
+            CHECK_NOTHROW(warm->update(PSmolar_INPUTS, p[i], s));
+            CHECK(std::abs(warm->T()/cold->T() - 1) < 1e-8);
+            CHECK_NOTHROW(warm->update(DmolarUmolar_INPUTS, rho, u));
+            CHECK(std::abs(warm->T()/cold->T() - 1) < 1e-8);
+            CHECK(warm->phase() == cold->phase());
+        }
+        for (double Tsat = 400; Tsat < 450; Tsat += 5){
+            CAPTURE(Tsat);
+            cold->update(QT_INPUTS, 0.3, Tsat);
+            CHECK_NOTHROW(warm->update(QT_INPUTS, 0.3, Tsat));
+            CHECK(std::abs(warm->p()/cold->p() - 1) < 1e-8);
+            double psat = cold->p();
+            cold->update(PQ_INPUTS, psat, 0.7);
+            CHECK_NOTHROW(warm->update(PQ_INPUTS, psat, 0.7));
+            // The pressure is an input and is not recalculated from the saturation state
+            CHECK(warm->p() == psat);
+            CHECK(std::abs(warm->T()/cold->T() - 1) < 1e-8);
+            CHECK(std::abs(warm->rhomolar()/cold->rhomolar() - 1) < 1e-8);
+        }
+    }
+    SECTION("Two-phase states from pairs of density, enthalpy, entropy and internal energy"){
+        input_pairs pairs[] = {HmolarSmolar_INPUTS, DmolarHmolar_INPUTS, DmolarSmolar_INPUTS, DmolarUmolar_INPUTS, SmolarUmolar_INPUTS};
+        for (int i = 0; i < 5; ++i){
+            CAPTURE(get_input_pair_short_desc(pairs[i]));
+            warm->update(QT_INPUTS, 0.4, 400);
+            for (double Tsat = 401; Tsat < 450; Tsat += 1){
+                CAPTURE(Tsat);
+                cold->update(QT_INPUTS, 0.4, Tsat);
+                parameters key1, key2;
+                split_input_pair(pairs[i], key1, key2);
+                double value1 = cold->keyed_output(key1), value2 = cold->keyed_output(key2);
+                CHECK_NOTHROW(warm->update(pairs[i], value1, value2));
+                CHECK(warm->phase() == iphase_twophase);
+                CHECK(std::abs(warm->T()/Tsat - 1) < 1e-8);
+                CHECK(std::abs(warm->Q() - 0.4) < 1e-8);
+                CHECK(std::abs(warm->rhomolar()/cold->rhomolar() - 1) < 1e-8);
+            }
+        }
+    }
+}
+
+TEST_CASE("The direct single-phase PH, PS and PU flashes give the states of the PT flash","[HSU_P_flash]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    for (std::size_t i = 0; i < fluids.size(); ++i){
+        shared_ptr<HelmholtzEOSMixtureBackend> HEOS(new HelmholtzEOSMixtureBackend(strsplit(fluids[i],'&')));
+        shared_ptr<HelmholtzEOSMixtureBackend> ref(new HelmholtzEOSMixtureBackend(strsplit(fluids[i],'&')));
+        CAPTURE(fluids[i]);
+        double reduced_p[] = {0.1, 0.3, 0.8};
+        for (int j = 0; j < 3; ++j){
+            double p = reduced_p[j]*HEOS->p_critical();
+            ref->update(PQ_INPUTS, p, 0);
+            double Tsat = ref->T(), rhoL = ref->rhomolar();
+            ref->update(PQ_INPUTS, p, 1);
+            double rhoV = ref->rhomolar();
+            CAPTURE(p);
+            double T[] = {std::max(HEOS->Ttriple(), Tsat - 40) + 1, Tsat - 1, Tsat + 1, Tsat + 50, Tsat + 300};
+            for (int k = 0; k < 5; ++k){
+                CAPTURE(T[k]);
+                ref->update(PT_INPUTS, p, T[k]);
+                parameters others[] = {iHmolar, iSmolar, iUmolar};
+                for (int l = 0; l < 3; ++l){
+                    CAPTURE(get_parameter_information(others[l], "short"));
+                    bool liquid = T[k] < Tsat;
+                    HEOS->update_DmolarT_direct(ref->rhomolar(), ref->T());
+                    double value = ref->keyed_output(others[l]);
+                    bool solved = FlashRoutines::HSU_P_flash_singlephase_direct(*HEOS, others[l], value, Tsat, liquid ? rhoL : rhoV,
+                                                                                 liquid ? HEOS->Tmin() : Tsat, liquid ? Tsat : 1.5*HEOS->Tmax());
+                    CHECK(solved);
+                    CHECK(std::abs(HEOS->T()/ref->T() - 1) < 1e-8);
+                    CHECK(std::abs(HEOS->rhomolar()/ref->rhomolar() - 1) < 1e-8);
+                    // And through the usual update
+                    input_pairs pair = (others[l] == iHmolar) ? HmolarP_INPUTS : ((others[l] == iSmolar) ? PSmolar_INPUTS : PUmolar_INPUTS);
+                    if (pair == HmolarP_INPUTS){ HEOS->update(pair, value, p); } else{ HEOS->update(pair, p, value); }
+                    CHECK(std::abs(HEOS->T()/ref->T() - 1) < 1e-8);
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("Stability testing","[stability]")
 {
     shared_ptr<HelmholtzEOSMixtureBackend> HEOS(new HelmholtzEOSMixtureBackend(strsplit("n-Propane&n-Butane&n-Pentane&n-Hexane",'&')));
@@ -142,6 +142,22 @@ public:
     /// @param Tmax The higher temperature limit [K]
     /// @param phase The phase of the fluid that we should get back
     static void HSU_P_flash_singlephase_Brent(HelmholtzEOSMixtureBackend &HEOS, parameters other, CoolPropDbl value, CoolPropDbl Tmin, CoolPropDbl Tmax, phases phase);
+
+    /** \brief The direct single-phase flash routine for the pairs (P,H), (P,S), and (P,U) of pure and pseudo-pure fluids
+     *
+     * Newton's method is applied to p and the other variable in (tau, delta), with the Jacobian built from one evaluation of
+     * the residual and ideal-gas Helmholtz energy derivatives per iteration.  The state of HEOS is not updated and none of its
+     * cached values are touched during the iterations; only _T and _rhomolar are set when the solver has converged.
+     * @param HEOS The HelmholtzEOSMixtureBackend to be used, with _p already set
+     * @param other The index for the other input from CoolProp::parameters; allowed values are iHmolar, iSmolar, iUmolar
+     * @param value The value of the other input
+     * @param T0 The initial guess value for the temperature [K]
+     * @param rhomolar0 The initial guess value for the density [mol/m^3]
+     * @param Tmin The lower temperature limit of the solution [K]
+     * @param Tmax The higher temperature limit of the solution [K]
+     * @returns true if a mechanically stable solution between Tmin and Tmax was found, false otherwise
+     */
+    static bool HSU_P_flash_singlephase_direct(HelmholtzEOSMixtureBackend &HEOS, parameters other, CoolPropDbl value, CoolPropDbl T0, CoolPropDbl rhomolar0, CoolPropDbl Tmin, CoolPropDbl Tmax);
     
 	/// A generic flash routine for the pairs (D,H), (D,S), and (D,U) for twophase state.  Similar analysis is needed
     /// @param HEOS The HelmholtzEOSMixtureBackend to be used
@@ -176,6 +192,26 @@ public:
         HS_flash_twophaseOptions(){omega = 1.0;}
     };
     static void HS_flash_twophase(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl hmolar_spec, CoolPropDbl smolar_spec, HS_flash_twophaseOptions &options);
+
+    /** \brief Flash a pure or pseudo-pure fluid starting from the converged state of the previous update
+     *
+     * If the previous state is single-phase, any pair of T, p, rho, h, s and u is found with a Newton iteration in (T, rho); the
+     * solution is only accepted if its pressure is far enough from the ancillary vapor pressure to be sure of its phase.  If the
+     * previous state is two-phase, the saturation solver of a pure fluid is started from its saturated densities for the QT, PQ,
+     * DT, HP, PS and PU pairs, and for the pairs of rho, h, s and u (DH, DS, DU, HS and SU) with a secant iteration in T along
+     * the saturation curve.
+     * @param HEOS The HelmholtzEOSMixtureBackend to be used, after pre_update
+     * @param input_pair The molar input pair
+     * @param value1 The first input value
+     * @param value2 The second input value
+     * @param previous The converged state of the previous update
+     * @returns True if the state was found; false if the step from the previous state is too large, the solver did not converge or the phase is not certain, in which case the usual flash routines must be used
+     */
+    static bool warm_start_flash(HelmholtzEOSMixtureBackend &HEOS, input_pairs input_pair, CoolPropDbl value1, CoolPropDbl value2, const WarmStartState &previous);
+    /// The single-phase part of warm_start_flash
+    static bool warm_start_singlephase(HelmholtzEOSMixtureBackend &HEOS, parameters key1, CoolPropDbl value1, parameters key2, CoolPropDbl value2, const WarmStartState &previous);
+    /// The two-phase part of warm_start_flash
+    static bool warm_start_twophase(HelmholtzEOSMixtureBackend &HEOS, parameters key1, CoolPropDbl value1, parameters key2, CoolPropDbl value2, const WarmStartState &previous);
 };
 
 
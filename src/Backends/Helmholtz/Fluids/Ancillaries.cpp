@@ -1,11 +1,17 @@
 #include "Ancillaries.h"
 #include "DataStructures.h"
 #include "AbstractState.h"
+#include <algorithm>
 
 #if defined(ENABLE_CATCH)
 
 #include "crossplatform_shared_ptr.h"
+#include "Configuration.h"
 #include "catch.hpp"
+#include "TestObjects.h"
+#include "Backends/Helmholtz/Fluids/FluidLibrary.h"
+#include "Backends/Helmholtz/HelmholtzEOSBackend.h"
+#include <sstream>
 
 #endif
 
@@ -280,9 +286,319 @@ CoolPropDbl MeltingLineVariables::evaluate(int OF, int GIVEN, CoolPropDbl value)
     }
 }
 
+ChebyshevExpansion::ChebyshevExpansion(double xmin, double xmax, const std::vector<double> &values) : xmin(xmin), xmax(xmax)
+{
+    if (values.size() < 2){ throw ValueError(format("At least two values are needed for a Chebyshev expansion")); }
+    std::size_t N = values.size() - 1;
+    // The values are at the nodes in increasing order, so values[N-k] is the value at cos(pi*k/N)
+    c.resize(N + 1);
+    for (std::size_t j = 0; j <= N; ++j){
+        double summer = 0;
+        for (std::size_t k = 0; k <= N; ++k){
+            double term = values[N-k]*cos(M_PI*static_cast<double>(j*k)/static_cast<double>(N));
+            summer += (k == 0 || k == N) ? 0.5*term : term;
+        }
+        c[j] = ((j == 0 || j == N) ? 1.0 : 2.0)/static_cast<double>(N)*summer;
+    }
+    calc_derivative_coeffs();
+}
+ChebyshevExpansion ChebyshevExpansion::from_coeffs(double xmin, double xmax, const std::vector<double> &c)
+{
+    if (c.size() < 2){ throw ValueError(format("At least two coefficients are needed for a Chebyshev expansion")); }
+    if (!(xmax > xmin)){ throw ValueError(format("The interval [%g, %g] of a Chebyshev expansion is empty", xmin, xmax)); }
+    ChebyshevExpansion e;
+    e.xmin = xmin; e.xmax = xmax; e.c = c;
+    e.calc_derivative_coeffs();
+    return e;
+}
+void ChebyshevExpansion::calc_derivative_coeffs()
+{
+    std::size_t N = c.size() - 1;
+    // Coefficients of the derivative from the usual recurrence
+    dc.assign(N + 1, 0.0);
+    if (N >= 1){ dc[N-1] = 2*static_cast<double>(N)*c[N]; }
+    for (std::size_t j = N - 1; j >= 1; --j){
+        dc[j-1] = ((j + 1 <= N) ? dc[j+1] : 0.0) + 2*static_cast<double>(j)*c[j];
+    }
+    dc[0] /= 2;
+}
+std::vector<double> ChebyshevExpansion::nodes(double xmin, double xmax, std::size_t N)
+{
+    std::vector<double> x(N + 1);
+    for (std::size_t k = 0; k <= N; ++k){
+        double t = -cos(M_PI*static_cast<double>(k)/static_cast<double>(N));
+        x[k] = 0.5*(xmax - xmin)*t + 0.5*(xmax + xmin);
+    }
+    x[0] = xmin; x[N] = xmax;
+    return x;
+}
+bool ChebyshevExpansion::is_converged(double tolerance) const
+{
+    double cmax = 0;
+    for (std::size_t j = 0; j < c.size(); ++j){ cmax = std::max(cmax, std::abs(c[j])); }
+    std::size_t N = c.size() - 1;
+    return std::max(std::abs(c[N]), std::abs(c[N-1])) <= tolerance*cmax;
+}
+/// Evaluate a Chebyshev series with the Clenshaw recurrence
+static double Clenshaw(const std::vector<double> &c, double t)
+{
+    double b1 = 0, b2 = 0;
+    for (std::size_t j = c.size() - 1; j >= 1; --j){
+        double b0 = c[j] + 2*t*b1 - b2;
+        b2 = b1; b1 = b0;
+    }
+    return c[0] + t*b1 - b2;
+}
+double ChebyshevExpansion::evaluate(double x) const
+{
+    return Clenshaw(c, (2*x - (xmax + xmin))/(xmax - xmin));
+}
+double ChebyshevExpansion::derivative(double x) const
+{
+    return Clenshaw(dc, (2*x - (xmax + xmin))/(xmax - xmin))*2/(xmax - xmin);
+}
+double ChebyshevExpansion::solve(double y) const
+{
+    double xlo = xmin, xhi = xmax, flo = evaluate(xmin) - y, fhi = evaluate(xmax) - y;
+    if (flo == 0){ return xmin; }
+    if (fhi == 0){ return xmax; }
+    if (flo*fhi > 0){ throw ValueError(format("The value %g is not in the range of the Chebyshev expansion", y)); }
+    // Start from the linear interpolation between the ends
+    double x = xlo - flo*(xhi - xlo)/(fhi - flo);
+    for (int iter = 0; iter < 100; ++iter){
+        double f = evaluate(x) - y;
+        if (f == 0){ return x; }
+        if (f*flo > 0){ xlo = x; flo = f; } else { xhi = x; }
+        double xnew = x - f/derivative(x);
+        // Bisect if the Newton step leaves the bracket
+        if (!(xnew > xlo && xnew < xhi)){ xnew = 0.5*(xlo + xhi); }
+        if (std::abs(xnew - x) < 4*DBL_EPSILON*std::abs(x) || xhi - xlo < 4*DBL_EPSILON*std::abs(x)){ return xnew; }
+        x = xnew;
+    }
+    return x;
+}
+
+SuperAncillary::SuperAncillary(rapidjson::Value &json_code) : built(true), loaded(true)
+{
+    T_breaks = cpjson::get_double_array(json_code["T_breaks"]);
+    std::vector<std::vector<double> > c_lnp = cpjson::get_double_array2D(json_code["lnp"]),
+                                      c_rhoL = cpjson::get_double_array2D(json_code["rhoL"]),
+                                      c_lnrhoV = cpjson::get_double_array2D(json_code["lnrhoV"]);
+    if (T_breaks.size() < 2 || c_lnp.size() != T_breaks.size() - 1 || c_rhoL.size() != c_lnp.size() || c_lnrhoV.size() != c_lnp.size()){
+        throw ValueError(format("The superancillary equations need one expansion of each kind per interval of T_breaks"));
+    }
+    for (std::size_t i = 0; i < c_lnp.size(); ++i){
+        lnp.push_back(ChebyshevExpansion::from_coeffs(T_breaks[i], T_breaks[i+1], c_lnp[i]));
+        rhoL.push_back(ChebyshevExpansion::from_coeffs(T_breaks[i], T_breaks[i+1], c_rhoL[i]));
+        lnrhoV.push_back(ChebyshevExpansion::from_coeffs(T_breaks[i], T_breaks[i+1], c_lnrhoV[i]));
+        if (i == 0){ lnp_breaks.push_back(lnp[i].evaluate(T_breaks[i])); }
+        lnp_breaks.push_back(lnp[i].evaluate(T_breaks[i+1]));
+    }
+}
+std::size_t SuperAncillary::get_interval(double T) const
+{
+    std::size_t i = std::upper_bound(T_breaks.begin(), T_breaks.end(), T) - T_breaks.begin();
+    // The last interval includes its upper end, and temperatures out of range use the closest interval
+    return std::min(std::max(i, static_cast<std::size_t>(1)), lnp.size()) - 1;
+}
+bool SuperAncillary::contains_p(double p) const
+{
+    if (!is_available() || !(p > 0)){ return false; }
+    double lnp_ = log(p);
+    return lnp_ >= lnp_breaks.front() && lnp_ <= lnp_breaks.back();
+}
+double SuperAncillary::get_T_from_p(double p) const
+{
+    if (!contains_p(p)){ throw ValueError(format("The pressure %g Pa is outside the range of the superancillary equations", p)); }
+    double lnp_ = log(p);
+    std::size_t i = std::upper_bound(lnp_breaks.begin(), lnp_breaks.end(), lnp_) - lnp_breaks.begin();
+    i = std::min(std::max(i, static_cast<std::size_t>(1)), lnp.size()) - 1;
+    return lnp[i].solve(lnp_);
+}
+void SuperAncillary::build(SaturationSolver &solver, double Tmin, double Tmax)
+{
+    std::lock_guard<std::mutex> lock(build_mutex);
+    if (built){ return; }
+
+    const std::size_t N = 16; // The degree of the expansions
+    const double tolerance = 1e-12; // The relative magnitude of the last coefficients of a converged expansion
+    const double min_width = 1e-6*Tmax; // Intervals are not bisected further than this
+
+    // The intervals are fitted in increasing order of temperature, so the range can end at the first interval that fails
+    std::vector<std::pair<double, double> > stack(1, std::pair<double, double>(Tmin, Tmax));
+    while (!stack.empty() && Tmin < Tmax){
+        double a = stack.back().first, b = stack.back().second;
+        stack.pop_back();
+        std::vector<double> T = ChebyshevExpansion::nodes(a, b, N), y_lnp(N + 1), y_rhoL(N + 1), y_lnrhoV(N + 1);
+        bool solved = true;
+        for (std::size_t k = 0; k <= N && solved; ++k){
+            double p, rhoL_, rhoV_;
+            try{
+                solver.solve(T[k], p, rhoL_, rhoV_);
+                solved = ValidNumber(p) && ValidNumber(rhoL_) && ValidNumber(rhoV_) && p > 0 && rhoV_ > 0 && rhoL_ > rhoV_;
+            }
+            catch(std::exception &){
+                solved = false;
+            }
+            if (solved){ y_lnp[k] = log(p); y_rhoL[k] = rhoL_; y_lnrhoV[k] = log(rhoV_); }
+        }
+        ChebyshevExpansion e_lnp, e_rhoL, e_lnrhoV;
+        if (solved){
+            e_lnp = ChebyshevExpansion(a, b, y_lnp); e_rhoL = ChebyshevExpansion(a, b, y_rhoL); e_lnrhoV = ChebyshevExpansion(a, b, y_lnrhoV);
+        }
+        // An interval where the solver fails, as it can near the critical point, is bisected like one that does not converge
+        if (!solved || !e_lnp.is_converged(tolerance) || !e_rhoL.is_converged(tolerance) || !e_lnrhoV.is_converged(tolerance)){
+            if (b - a < min_width){ break; }
+            double mid = 0.5*(a + b);
+            stack.push_back(std::pair<double, double>(mid, b));
+            stack.push_back(std::pair<double, double>(a, mid));
+            continue;
+        }
+        if (T_breaks.empty()){ T_breaks.push_back(a); lnp_breaks.push_back(e_lnp.evaluate(a)); }
+        lnp.push_back(e_lnp); rhoL.push_back(e_rhoL); lnrhoV.push_back(e_lnrhoV);
+        T_breaks.push_back(b); lnp_breaks.push_back(e_lnp.evaluate(b));
+    }
+    built = true;
+}
+
 }; /* namespace CoolProp */
 
 #if defined(ENABLE_CATCH)
+TEST_CASE("Chebyshev expansions", "[superancillary]")
+{
+    std::vector<double> x = CoolProp::ChebyshevExpansion::nodes(1, 3, 16), y(x.size());
+    for (std::size_t i = 0; i < x.size(); ++i){ y[i] = exp(x[i]); }
+    CoolProp::ChebyshevExpansion e(1, 3, y);
+    CHECK(e.is_converged(1e-12));
+    for (double xx = 1; xx <= 3; xx += 0.1){
+        CAPTURE(xx);
+        CHECK(std::abs(e.evaluate(xx)/exp(xx) - 1) < 1e-14);
+        CHECK(std::abs(e.derivative(xx)/exp(xx) - 1) < 1e-12);
+        CHECK(std::abs(e.solve(exp(xx)) - xx) < 1e-14);
+    }
+}
+
+TEST_CASE("Superancillary equations are loaded with the fluids", "[superancillary]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    for (std::size_t i = 0; i < fluids.size(); ++i){
+        CAPTURE(fluids[i]);
+        CoolProp::CoolPropFluid fluid = CoolProp::get_fluid(fluids[i]);
+        // Built from the fluid file, so they are never fitted at run time
+        CHECK(fluid.ancillaries.superancillary->is_available());
+    }
+}
+
+TEST_CASE("Superancillary equations agree with the saturation solver", "[superancillary]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    for (std::size_t i = 0; i < fluids.size(); ++i){
+        shared_ptr<CoolProp::AbstractState> AS(CoolProp::AbstractState::factory("HEOS", fluids[i]));
+        double Tt = AS->Ttriple(), Tc = AS->T_critical();
+        for (double T = Tt + 0.01; T < 0.999*Tc; T += (Tc - Tt)/37){
+            std::ostringstream ss;
+            ss << "Superancillary of " << fluids[i] << " at T=" << T;
+            SECTION(ss.str(), "")
+            {
+                double p, rhoL, rhoV;
+                {
+                    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, false);
+                    AS->update(CoolProp::QT_INPUTS, 0.5, T);
+                    // The pressure of the liquid is too poorly conditioned at low temperature to be compared
+                    p = AS->saturated_vapor_keyed_output(CoolProp::iP); rhoL = AS->saturated_liquid_keyed_output(CoolProp::iDmolar); rhoV = AS->saturated_vapor_keyed_output(CoolProp::iDmolar);
+                }
+                CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, true);
+                AS->update(CoolProp::QT_INPUTS, 0.5, T);
+                CAPTURE(p);
+                CHECK(std::abs(AS->p()/p - 1) < 1e-9);
+                CHECK(std::abs(AS->saturated_liquid_keyed_output(CoolProp::iDmolar)/rhoL - 1) < 1e-9);
+                CHECK(std::abs(AS->saturated_vapor_keyed_output(CoolProp::iDmolar)/rhoV - 1) < 1e-9);
+                AS->update(CoolProp::PQ_INPUTS, p, 0.5);
+                CHECK(std::abs(AS->T()/T - 1) < 1e-9);
+            }
+        }
+    }
+}
+
+TEST_CASE("Superancillary equations of all the fluids agree with the saturation solver", "[superancillary]")
+{
+    std::vector<std::string> fluids = strsplit(CoolProp::get_fluid_list(), ',');
+    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, true);
+    for (std::size_t i = 0; i < fluids.size(); ++i){
+        CAPTURE(fluids[i]);
+        shared_ptr<CoolProp::HelmholtzEOSBackend> HEOS(new CoolProp::HelmholtzEOSBackend(fluids[i]));
+        CoolProp::SuperAncillary *superancillary = HEOS->get_superancillary();
+        if (superancillary == NULL){
+            // Only the pseudo-pure fluids have none
+            CHECK(HEOS->get_components()[0].EOS().pseudo_pure);
+            continue;
+        }
+        // Shipped with the fluid, and covering the range from the minimum saturation temperature
+        CHECK(superancillary->is_loaded());
+        CoolPropDbl Tmin_satL, Tmin_satV;
+        HEOS->calc_Tmin_sat(Tmin_satL, Tmin_satV);
+        CHECK(std::abs(superancillary->get_Tmin()/std::max(Tmin_satL, Tmin_satV) - 1) < 1e-12);
+        double Tmin = superancillary->get_Tmin(), Tmax = superancillary->get_Tmax(), Tc = HEOS->T_critical();
+        const int N = 50;
+        for (int k = 0; k <= N; ++k){
+            double T = Tmin + (Tmax - Tmin)*k/N;
+            CAPTURE(T);
+            double p, rhoL, rhoV;
+            {
+                CoolPropTesting::ConfigBoolScope iterative(SUPERANCILLARIES_ENABLED, false), splines(CRITICAL_SPLINES_ENABLED, false);
+                // There is nothing to compare with where the iterative solver fails
+                try{ HEOS->update(CoolProp::QT_INPUTS, 0.5, T); }
+                catch(std::exception &){ continue; }
+                p = HEOS->saturated_vapor_keyed_output(CoolProp::iP); rhoL = HEOS->saturated_liquid_keyed_output(CoolProp::iDmolar); rhoV = HEOS->saturated_vapor_keyed_output(CoolProp::iDmolar);
+            }
+            // The saturation solver is less accurate very close to the critical point
+            double tolerance = (T < 0.999*Tc) ? 1e-9 : 1e-6;
+            CHECK(std::abs(superancillary->eval_p(T)/p - 1) < tolerance);
+            CHECK(std::abs(superancillary->eval_rhoL(T)/rhoL - 1) < tolerance);
+            CHECK(std::abs(superancillary->eval_rhoV(T)/rhoV - 1) < tolerance);
+        }
+    }
+}
+
+TEST_CASE("Superancillary equations are fitted at run time for a fluid without them", "[superancillary]")
+{
+    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, true);
+    std::vector<CoolProp::CoolPropFluid> components(1, CoolProp::get_fluid("R134a"));
+    CoolProp::HelmholtzEOSMixtureBackend loaded(components);
+    CoolProp::SuperAncillary *shipped = loaded.get_superancillary();
+    REQUIRE(shipped != NULL);
+    CHECK(shipped->is_loaded());
+
+    SECTION("fluid without coefficients"){
+        // Like a fluid added by the user, whose file has no superancillary entry; the copies of the library are not affected
+        components[0].ancillaries.superancillary.reset(new CoolProp::SuperAncillary());
+        CoolProp::HelmholtzEOSMixtureBackend HEOS(components);
+        CoolProp::SuperAncillary *fitted = HEOS.get_superancillary();
+        REQUIRE(fitted != NULL);
+        CHECK(!fitted->is_loaded());
+        CHECK(fitted != shipped);
+        CHECK(CoolProp::get_fluid("R134a").ancillaries.superancillary->is_loaded());
+        // Both are fitted to the same equation of state from the same minimum temperature
+        CHECK(std::abs(fitted->get_Tmin()/shipped->get_Tmin() - 1) < 1e-12);
+        double Tmin = fitted->get_Tmin(), Tmax = std::min(fitted->get_Tmax(), shipped->get_Tmax());
+        for (double T = Tmin; T <= Tmax; T += (Tmax - Tmin)/20){
+            CAPTURE(T);
+            CHECK(std::abs(fitted->eval_p(T)/shipped->eval_p(T) - 1) < 1e-9);
+            CHECK(std::abs(fitted->eval_rhoL(T)/shipped->eval_rhoL(T) - 1) < 1e-9);
+            CHECK(std::abs(fitted->eval_rhoV(T)/shipped->eval_rhoV(T) - 1) < 1e-9);
+        }
+        // And used by the flash routines
+        HEOS.update(CoolProp::QT_INPUTS, 0.5, 250);
+        CHECK(HEOS.p() == fitted->eval_p(250));
+    }
+    SECTION("changed equation of state"){
+        loaded.change_EOS(0, "SRK");
+        // The coefficients of the fluid file do not apply any more; they are fitted again when they are needed
+        CHECK(!loaded.get_components()[0].ancillaries.superancillary->is_built());
+        CHECK(CoolProp::get_fluid("R134a").ancillaries.superancillary->is_loaded());
+    }
+}
+
 TEST_CASE("Water melting line", "[melting]")
 {
     shared_ptr<CoolProp::AbstractState> AS(CoolProp::AbstractState::factory("HEOS","water"));
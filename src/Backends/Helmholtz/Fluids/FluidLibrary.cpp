@@ -2,10 +2,15 @@
 #include "FluidLibrary.h"
 #include "all_fluids_JSON.h" // Makes a std::string variable called all_fluids_JSON
 #include "Backends/Helmholtz/HelmholtzEOSBackend.h"
+#include "CoolProp.h"
+#include <atomic>
+#include <mutex>
 
 namespace CoolProp{
 
 static JSONFluidLibrary library;
+static std::mutex library_load_mutex;
+static std::atomic<bool> library_loaded(false);
 
 void load()
 {
@@ -19,6 +24,15 @@ void load()
     }
 }
 
+/// Load the fluids the first time they are needed; the backends of several threads can need them at the same time
+static void load_if_empty()
+{
+    if (library_loaded){ return; }
+    std::lock_guard<std::mutex> guard(library_load_mutex);
+    if (library.is_empty()){ load(); }
+    library_loaded = true;
+}
+
 void JSONFluidLibrary::set_fluid_enthalpy_entropy_offset(const std::string &fluid, double delta_a1, double delta_a2, const std::string &ref)
 {
     // Try to find it
@@ -82,12 +96,13 @@ void JSONFluidLibrary::set_fluid_enthalpy_entropy_offset(const std::string &flui
 void JSONFluidLibrary::add_many(const std::string &JSON_string){
     
     // First load all the baseline fluids
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     
     // Then, load the fluids we would like to add
     rapidjson::Document doc;
     cpjson::JSON_string_to_rapidjson(JSON_string, doc);
     library.add_many(doc);
+    clear_PropsSI_state_cache();
 };
     
 void JSONFluidLibrary::add_many(rapidjson::Value &listing)
@@ -319,28 +334,30 @@ void JSONFluidLibrary::add_one(rapidjson::Value &fluid_json)
 
 
 JSONFluidLibrary & get_library(void){
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     return library;
 }
 
 CoolPropFluid get_fluid(const std::string &fluid_string){
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     return library.get(fluid_string);
 }
     
 std::string get_fluid_as_JSONstring(const std::string &identifier){
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     return library.get_JSONstring(identifier);
 }
 
 std::string get_fluid_list(void){
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     return library.get_fluid_list();
 };
 
 void set_fluid_enthalpy_entropy_offset(const std::string &fluid, double delta_a1, double delta_a2, const std::string &ref){
-    if (library.is_empty()){ load(); }
+    load_if_empty();
     library.set_fluid_enthalpy_entropy_offset(fluid, delta_a1, delta_a2, ref);
+    // The states kept by PropsSI hold a copy of the old offsets
+    clear_PropsSI_state_cache();
 }
 
 } /* namespace CoolProp */
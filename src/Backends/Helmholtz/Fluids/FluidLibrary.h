@@ -1173,6 +1173,11 @@ protected:
             throw ValueError("Pressure ancillary curves are missing or invalid");
         }
         
+        // The superancillary equations, if the fluid file has them; otherwise they are fitted when they are first needed
+        if (ancillaries.HasMember("superancillary")){
+            fluid.ancillaries.superancillary.reset(new SuperAncillary(ancillaries["superancillary"]));
+        }
+        
         if (ancillaries.HasMember("hL")){
             fluid.ancillaries.hL = SaturationAncillaryFunction(ancillaries["hL"]);
         }
@@ -12,6 +12,7 @@
 #include "HelmholtzEOSMixtureBackend.h"
 #include "Fluids/FluidLibrary.h"
 #include "MixtureParameters.h"
+#include "SpecializedAlpharKernels.h"
 #include "DataStructures.h"
 
 namespace CoolProp {
@@ -30,7 +31,7 @@ inline std::string vecstring_to_string(const std::vector<std::string> &a) {
 class HelmholtzEOSBackend : public HelmholtzEOSMixtureBackend  {
 public:
     HelmholtzEOSBackend(){};
-    HelmholtzEOSBackend(CoolPropFluid Fluid){set_components(std::vector<CoolPropFluid>(1,Fluid));};
+    HelmholtzEOSBackend(CoolPropFluid Fluid){attach_specialized_alphar_kernel(Fluid); set_components(std::vector<CoolPropFluid>(1,Fluid));};
     HelmholtzEOSBackend(const std::string &name) : HelmholtzEOSMixtureBackend() {
         Dictionary dict;
         std::vector<double> mole_fractions;
@@ -51,6 +52,10 @@ public:
             components.push_back(library.get(name)); // Until now it's empty
             mole_fractions.push_back(1.);
         }
+        // Use the generated kernels for the residual Helmholtz energy where there are some
+        for (std::size_t i = 0; i < components.size(); ++i){
+            attach_specialized_alphar_kernel(components[i]);
+        }
         // Set the components
         set_components(components);
         // Set the mole fractions
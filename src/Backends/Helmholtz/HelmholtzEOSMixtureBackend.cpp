@@ -37,8 +37,6 @@
 #include "MixtureParameters.h"
 #include <stdlib.h>
 
-static int deriv_counter = 0;
-
 namespace CoolProp {
     
 class HEOSGenerator : public AbstractStateGenerator{
@@ -55,6 +53,10 @@ public:
 // This static initialization will cause the generator to register
 static CoolProp::GeneratorInitializer<HEOSGenerator> heos_gen(CoolProp::HEOS_BACKEND_FAMILY);
 
+/// The relative uncertainty of the saturation pressure and temperature of the superancillary equations in the phase
+/// determination; closer to the saturation curve than this, the saturation state is solved for
+static const CoolPropDbl superancillary_guard_band = 1e-8;
+
 HelmholtzEOSMixtureBackend::HelmholtzEOSMixtureBackend(){
     imposed_phase_index = iphase_not_imposed;
     is_pure_or_pseudopure = false;
@@ -346,6 +348,8 @@ void HelmholtzEOSMixtureBackend::calc_change_EOS(const std::size_t i, const std:
     if (i < components.size()){
         CoolPropFluid &fluid = components[i];
         EquationOfState &EOS = fluid.EOSVector[0];
+        // The superancillary equations of the new equation of state are built again when they are needed
+        fluid.ancillaries.superancillary.reset(new SuperAncillary());
 
         if (EOS_name == "SRK" || EOS_name == "Peng-Robinson"){
 
@@ -1110,6 +1114,40 @@ CoolPropDbl HelmholtzEOSMixtureBackend::calc_pmax_sat(void)
         throw ValueError("calc_pmax_sat not yet defined for mixtures");
     }
 }
+SuperAncillary * HelmholtzEOSMixtureBackend::get_superancillary(void)
+{
+    class SaturationSolver : public SuperAncillary::SaturationSolver
+    {
+    public:
+        HelmholtzEOSMixtureBackend &HEOS;
+        SaturationSolver(HelmholtzEOSMixtureBackend &HEOS) : HEOS(HEOS){};
+        void solve(double T, double &p, double &rhoL, double &rhoV){
+            SaturationSolvers::saturation_T_pure_Akasaka_options options(false);
+            SaturationSolvers::saturation_T_pure_Maxwell(HEOS, T, options);
+            SaturationSolvers::saturation_T_pure_polish(HEOS, T);
+            // The vapor pressure is much better conditioned than the liquid one at low temperature
+            p = HEOS.SatV->p();
+            rhoL = HEOS.SatL->rhomolar();
+            rhoV = HEOS.SatV->rhomolar();
+        }
+    };
+    if (!get_config_bool(SUPERANCILLARIES_ENABLED) || !is_pure_or_pseudopure || components[0].EOS().pseudo_pure){ return NULL; }
+    SuperAncillary *superancillary = components[0].ancillaries.superancillary.get();
+    if (superancillary == NULL){ return NULL; }
+    if (!superancillary->is_built()){
+        // Fallback for a fluid without stored coefficients, such as one added by the user or one whose equation of state has been
+        // changed: fit the expansions now, once for all the copies of the fluid
+        if (get_debug_level() > 0){ std::cout << format("Fitting the superancillary equations of %s at run time", components[0].name.c_str()) << std::endl; }
+        // Use a separate state, so that the saturation states of this one are not modified
+        HelmholtzEOSMixtureBackend HEOS(components);
+        SaturationSolver solver(HEOS);
+        CoolPropDbl Tmin_satL, Tmin_satV;
+        calc_Tmin_sat(Tmin_satL, Tmin_satV);
+        // Very close to the critical point the expansions converge too slowly; the critical splines or the usual solvers are used there
+        superancillary->build(solver, std::max(Tmin_satL, Tmin_satV), 0.9999*T_critical());
+    }
+    return superancillary->is_available() ? superancillary : NULL;
+}
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_Tmax_sat(void)
 {
     if (is_pure_or_pseudopure)
@@ -1286,6 +1324,19 @@ void HelmholtzEOSMixtureBackend::update(CoolProp::input_pairs input_pair, double
     pre_update(input_pair, ld_value1, ld_value2);
     value1 = ld_value1; value2 = ld_value2;
 
+    // The previous state is forgotten until this update has converged, so that a failed update never seeds the next one
+    WarmStartState previous = warm_start_state;
+    warm_start_state.valid = false;
+    if (previous.enabled && previous.valid && is_pure_or_pseudopure && imposed_phase_index == iphase_not_imposed){
+        if (FlashRoutines::warm_start_flash(*this, input_pair, value1, value2, previous)){
+            post_update();
+            store_warm_start_state();
+            return;
+        }
+        // Start again from a clean state with the usual flash routines; the inputs are already molar
+        pre_update(input_pair, ld_value1, ld_value2);
+    }
+
     switch(input_pair)
     {
         case PT_INPUTS:
@@ -1344,7 +1395,23 @@ void HelmholtzEOSMixtureBackend::update(CoolProp::input_pairs input_pair, double
     }
     
     post_update();
-    
+    store_warm_start_state();
+}
+void HelmholtzEOSMixtureBackend::store_warm_start_state()
+{
+    if (!warm_start_state.enabled || !is_pure_or_pseudopure){ return; }
+    warm_start_state.T = _T;
+    warm_start_state.rhomolar = _rhomolar;
+    warm_start_state.phase = _phase;
+    if (_phase == iphase_twophase && SatL.get() != NULL && SatV.get() != NULL){
+        warm_start_state.rhomolar_liq = SatL->rhomolar();
+        warm_start_state.rhomolar_vap = SatV->rhomolar();
+    }
+    else{
+        warm_start_state.rhomolar_liq = _HUGE;
+        warm_start_state.rhomolar_vap = _HUGE;
+    }
+    warm_start_state.valid = ValidNumber(_T) && ValidNumber(_rhomolar);
 }
 const std::vector<CoolPropDbl> HelmholtzEOSMixtureBackend::calc_mass_fractions()
 {
@@ -1516,7 +1583,7 @@ void HelmholtzEOSMixtureBackend::p_phase_determination_pure_or_pseudopure(int ot
 
                 if (has_melting_line()){
                     double Tm = melting_line(iT, iP, _p);
-                    if (get_config_bool(DONT_CHECK_PROPERTY_LIMITS)){
+                    if (skip_property_limits()){
                         _phase = iphase_liquid;
                     }
                     else{
@@ -1526,7 +1593,7 @@ void HelmholtzEOSMixtureBackend::p_phase_determination_pure_or_pseudopure(int ot
                     }
                 }
                 else{
-                    if (get_config_bool(DONT_CHECK_PROPERTY_LIMITS)){
+                    if (skip_property_limits()){
                         _phase = iphase_liquid;
                     }
                     else{
@@ -1545,6 +1612,18 @@ void HelmholtzEOSMixtureBackend::p_phase_determination_pure_or_pseudopure(int ot
                 else if (value < T_liq){
                     this->_phase = iphase_liquid; _Q = 1000; return;
                 }
+                // Near the saturation curve, the superancillary saturation temperature decides the phase, unless T is
+                // within a guard band around it in which the saturation state is solved for below
+                SuperAncillary *superancillary = get_superancillary();
+                if (superancillary != NULL && superancillary->contains_p(_p)){
+                    CoolPropDbl Tsat = superancillary->get_T_from_p(_p);
+                    if (value < Tsat*(1 - superancillary_guard_band)){
+                        this->_phase = iphase_liquid; _Q = -1000; return;
+                    }
+                    else if (value > Tsat*(1 + superancillary_guard_band)){
+                        this->_phase = iphase_gas; _Q = 1000; return;
+                    }
+                }
                 break;
             }
             case iHmolar:
@@ -1721,7 +1800,7 @@ void HelmholtzEOSMixtureBackend::p_phase_determination_pure_or_pseudopure(int ot
                 _phase = iphase_gas;
             }
             else{
-                if (get_config_bool(DONT_CHECK_PROPERTY_LIMITS)){
+                if (skip_property_limits()){
                     _phase = iphase_gas;
                 }
                 else{
@@ -1876,6 +1955,18 @@ void HelmholtzEOSMixtureBackend::T_phase_determination_pure_or_pseudopure(int ot
                         throw ValueError("Two-phase inputs not supported for pseudo-pure for now");
                     }
                 }
+                // Near the saturation curve, the superancillary vapor pressure decides the phase, unless p is
+                // within a guard band around it in which the saturation state is solved for below
+                SuperAncillary *superancillary = get_superancillary();
+                if (superancillary != NULL && superancillary->contains_T(_T)){
+                    CoolPropDbl psat = superancillary->eval_p(_T);
+                    if (value > psat*(1 + 1e-6 + superancillary_guard_band)){
+                        this->_phase = iphase_liquid; _Q = -1000; return;
+                    }
+                    else if (value < psat*(1 - 1e-6 - superancillary_guard_band)){
+                        this->_phase = iphase_gas; _Q = 1000; return;
+                    }
+                }
                 break;
             }
             default:
@@ -2991,21 +3082,36 @@ void HelmholtzEOSMixtureBackend::calc_reducing_state(void)
     _reducing = calc_reducing_state_nocache(mole_fractions);
     _crit = _reducing;
 }
-void HelmholtzEOSMixtureBackend::calc_all_alphar_deriv_cache(const std::vector<CoolPropDbl> &mole_fractions, const CoolPropDbl &tau, const CoolPropDbl &delta)
+void HelmholtzEOSMixtureBackend::calc_all_alphar_deriv_cache(const std::vector<CoolPropDbl> &mole_fractions, const CoolPropDbl &tau, const CoolPropDbl &delta, std::size_t max_order)
 {
-    deriv_counter++;
     bool cache_values = true;
-    HelmholtzDerivatives derivs = residual_helmholtz->all(*this, get_mole_fractions_ref(), tau, delta, cache_values);
+    // The lower orders can have been cached at another point (the last iterate of the density solver, for instance);
+    // calculate the higher orders at that point so that all the cached derivatives are those of the same state
+    CoolPropDbl tau_eval = tau, delta_eval = delta;
+    if (max_order > 2 && _alphar){
+        tau_eval = _alphar_cache_tau; delta_eval = _alphar_cache_delta;
+    }
+    HelmholtzDerivatives derivs = residual_helmholtz->all(*this, get_mole_fractions_ref(), tau_eval, delta_eval, cache_values, max_order);
+    _alphar_cache_tau = tau_eval; _alphar_cache_delta = delta_eval;
     _alphar = derivs.alphar;
     _dalphar_dDelta = derivs.dalphar_ddelta;
     _dalphar_dTau = derivs.dalphar_dtau;
     _d2alphar_dDelta2 = derivs.d2alphar_ddelta2;
     _d2alphar_dDelta_dTau = derivs.d2alphar_ddelta_dtau;
     _d2alphar_dTau2 = derivs.d2alphar_dtau2;
+    // The higher derivatives were not calculated, make sure that they are calculated when they are requested
+    if (max_order < 3){
+        _d3alphar_dDelta3.clear(); _d3alphar_dDelta2_dTau.clear(); _d3alphar_dDelta_dTau2.clear(); _d3alphar_dTau3.clear();
+    }
+    if (max_order < 4){
+        _d4alphar_dDelta4.clear(); _d4alphar_dDelta3_dTau.clear(); _d4alphar_dDelta2_dTau2.clear(); _d4alphar_dDelta_dTau3.clear(); _d4alphar_dTau4.clear();
+    }
+    if (max_order < 3){ return; }
     _d3alphar_dDelta3 = derivs.d3alphar_ddelta3;
     _d3alphar_dDelta2_dTau = derivs.d3alphar_ddelta2_dtau;
     _d3alphar_dDelta_dTau2 = derivs.d3alphar_ddelta_dtau2;
     _d3alphar_dTau3 = derivs.d3alphar_dtau3;
+    if (max_order < 4){ return; }
     _d4alphar_dDelta4 = derivs.d4alphar_ddelta4;
     _d4alphar_dDelta3_dTau = derivs.d4alphar_ddelta3_dtau;
     _d4alphar_dDelta2_dTau2 = derivs.d4alphar_ddelta2_dtau2;
@@ -3128,52 +3234,52 @@ CoolPropDbl HelmholtzEOSMixtureBackend::calc_alpha0_deriv_nocache(const int nTau
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_alphar(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_alphar);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_dalphar_dDelta(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_dalphar_dDelta);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_dalphar_dTau(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_dalphar_dTau);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d2alphar_dTau2(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_d2alphar_dTau2);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d2alphar_dDelta_dTau(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_d2alphar_dDelta_dTau);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d2alphar_dDelta2(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 2);
     return static_cast<CoolPropDbl>(_d2alphar_dDelta2);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d3alphar_dDelta3(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 3);
     return static_cast<CoolPropDbl>(_d3alphar_dDelta3);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d3alphar_dDelta2_dTau(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 3);
     return static_cast<CoolPropDbl>(_d3alphar_dDelta2_dTau);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d3alphar_dDelta_dTau2(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 3);
     return static_cast<CoolPropDbl>(_d3alphar_dDelta_dTau2);
 }
 CoolPropDbl HelmholtzEOSMixtureBackend::calc_d3alphar_dTau3(void)
 {
-    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta);
+    calc_all_alphar_deriv_cache(mole_fractions, _tau, _delta, 3);
     return static_cast<CoolPropDbl>(_d3alphar_dTau3);
 }
 
@@ -17,6 +17,15 @@ namespace CoolProp {
 
 class FlashRoutines;
 
+/// The converged state of the previous update of a pure or pseudo-pure fluid, used to seed the next flash in the warm-start mode
+struct WarmStartState{
+    bool enabled, ///< True if the warm-start mode is on
+         valid; ///< True if the values below are those of the previous update
+    CoolPropDbl T, rhomolar, rhomolar_liq, rhomolar_vap; ///< Temperature and density of the state, and the saturated densities if it is two-phase
+    phases phase;
+    WarmStartState() : enabled(false), valid(false), T(_HUGE), rhomolar(_HUGE), rhomolar_liq(_HUGE), rhomolar_vap(_HUGE), phase(iphase_unknown) {};
+};
+
 class ResidualHelmholtz;
 
 class HelmholtzEOSMixtureBackend : public AbstractState {
@@ -59,6 +68,12 @@ protected:
 
     static void set_fluid_enthalpy_entropy_offset(CoolPropFluid& component, double delta_a1, double delta_a2, const std::string &ref);
 
+    CoolPropDbl _alphar_cache_tau, _alphar_cache_delta; ///< The (tau, delta) at which the cached derivatives of alphar were calculated
+
+    WarmStartState warm_start_state; ///< The previous converged state, if the warm-start mode is on
+    /// Keep the state that has just been converged to seed the next update
+    void store_warm_start_state();
+
 public:
     HelmholtzEOSMixtureBackend();
     HelmholtzEOSMixtureBackend(const std::vector<CoolPropFluid> &components, bool generate_SatL_and_SatV = true);
@@ -234,6 +249,14 @@ public:
 	 */
 	void update_with_guesses(CoolProp::input_pairs input_pair, double Value1, double Value2, const GuessesStructure &guesses);
 
+    /** \brief Turn the warm-start mode on or off
+     *
+     * In the warm-start mode, update() starts each flash of a pure or pseudo-pure fluid from the converged state of the previous
+     * update, see FlashRoutines::warm_start_flash.  Mixtures and imposed phases always use the usual flash routines.
+     */
+    void set_warm_start(bool enabled){ warm_start_state = WarmStartState(); warm_start_state.enabled = enabled; };
+    bool get_warm_start(void){ return warm_start_state.enabled; };
+
     /** \brief Update all the internal variables for a state by copying from another state
      */
     void update_internal(HelmholtzEOSMixtureBackend &HEOS);
@@ -403,6 +426,8 @@ public:
     CoolPropDbl calc_Tmax_sat(void);
     void calc_Tmin_sat(CoolPropDbl &Tmin_satL, CoolPropDbl &Tmin_satV);
     void calc_pmin_sat(CoolPropDbl &pmin_satL, CoolPropDbl &pmin_satV);
+    /// The superancillary equations of the saturation curve of the pure fluid, loaded with the fluid or else built the first time they are needed; NULL if SUPERANCILLARIES_ENABLED is false, for pseudo-pure fluids and mixtures, and if they could not be built
+    SuperAncillary * get_superancillary(void);
 
     virtual CoolPropDbl calc_T_critical(void);
     virtual CoolPropDbl calc_p_critical(void);
@@ -418,7 +443,9 @@ public:
     std::string calc_name(void);
 	std::vector<std::string> calc_fluid_names(void);
 
-    void calc_all_alphar_deriv_cache(const std::vector<CoolPropDbl> &mole_fractions, const CoolPropDbl &tau, const CoolPropDbl &delta);
+    /// Calculate and cache the derivatives of alphar of total order up to max_order (2 to 4); the cached derivatives of higher orders are cleared.
+    /// If the lower orders are already cached, the higher orders are calculated at the (tau, delta) of the cached ones
+    void calc_all_alphar_deriv_cache(const std::vector<CoolPropDbl> &mole_fractions, const CoolPropDbl &tau, const CoolPropDbl &delta, std::size_t max_order = 4);
     virtual CoolPropDbl calc_alphar_deriv_nocache(const int nTau, const int nDelta, const std::vector<CoolPropDbl> & mole_fractions, const CoolPropDbl &tau, const CoolPropDbl &delta);
 
     /**
@@ -487,13 +514,13 @@ public:
 class CorrespondingStatesTerm
 {
 public:
-    /// Calculate all the derivatives that do not involve any composition derivatives
-    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, double tau, double delta, const std::vector<CoolPropDbl> &x, bool cache_values = false)
+    /// Calculate all the derivatives that do not involve any composition derivatives, up to the total order max_order (2 to 4)
+    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, double tau, double delta, const std::vector<CoolPropDbl> &x, bool cache_values = false, std::size_t max_order = 4)
     {
         HelmholtzDerivatives summer;
         std::size_t N = x.size();
         for (std::size_t i = 0; i < N; ++i){
-            HelmholtzDerivatives derivs = HEOS.components[i].EOS().alphar.all(tau, delta, cache_values);
+            HelmholtzDerivatives derivs = HEOS.components[i].EOS().alphar.all_upto(tau, delta, max_order, cache_values);
             summer = summer + derivs*x[i];
         }
         return summer;
@@ -681,9 +708,11 @@ public:
     }
 
 
-    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, const std::vector<CoolPropDbl> &mole_fractions, double tau, double delta, bool cache_values = false)
+    /// Calculate the derivatives that do not involve any composition derivatives; the derivatives of total order higher
+    /// than max_order (2 to 4) are not needed by the caller, and may be zero
+    virtual HelmholtzDerivatives all(HelmholtzEOSMixtureBackend &HEOS, const std::vector<CoolPropDbl> &mole_fractions, double tau, double delta, bool cache_values = false, std::size_t max_order = 4)
     {
-        HelmholtzDerivatives a = CS.all(HEOS, tau, delta, mole_fractions, cache_values) + Excess.all(tau, delta, mole_fractions, cache_values);
+        HelmholtzDerivatives a = CS.all(HEOS, tau, delta, mole_fractions, cache_values, max_order) + Excess.all(tau, delta, mole_fractions, cache_values);
         a.delta_x_dalphar_ddelta = delta*a.dalphar_ddelta;
         a.tau_x_dalphar_dtau = tau*a.dalphar_dtau;
 
@@ -1,5 +1,6 @@
 #include "MixtureParameters.h"
 #include "CPstrings.h"
+#include "CoolProp.h"
 #include "mixture_departure_functions_JSON.h" // Creates the variable mixture_departure_functions_JSON
 #include "mixture_binary_pairs_JSON.h" // Creates the variable mixture_binary_pairs_JSON
 #include "predefined_mixtures_JSON.h" // Makes a std::string variable called predefined_mixtures_JSON
@@ -275,6 +276,7 @@ static MixtureBinaryPairLibrary mixturebinarypairlibrary_default;
 /// Add a simple mixing rule
 void apply_simple_mixing_rule(const std::string &identifier1, const std::string &identifier2, const std::string &rule){
     mixturebinarypairlibrary.add_simple_mixing_rule(identifier1, identifier2, rule);
+    clear_PropsSI_state_cache();
 }
 
 std::string get_csv_mixture_binary_pairs()
@@ -339,6 +341,7 @@ void set_mixture_binary_pair_data(const std::string &CAS1, const std::string &CA
         std::vector<Dictionary> &v = mixturebinarypairlibrary.binary_pair_map()[CAS];
         if (v[0].has_number(key)){
             v[0].add_number(key, value);
+            clear_PropsSI_state_cache();
         }
         else{
             throw ValueError(format("Could not set the parameter [%s] for the binary pair [%s,%s] - for now this is an error", 
@@ -380,6 +383,7 @@ void set_interaction_parameters(const std::string &string_data)
 {
     // JSON-encoded string for binary interaction parameters
     mixturebinarypairlibrary.load_from_string(string_data);
+    clear_PropsSI_state_cache();
 }
 
 
@@ -848,6 +852,7 @@ void set_departure_functions(const std::string &string_data)
         // JSON-encoded string for departure functions
         mixturedeparturefunctionslibrary.load_from_string(string_data);
     }
+    clear_PropsSI_state_cache();
 }
 
 
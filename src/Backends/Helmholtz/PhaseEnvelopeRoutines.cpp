@@ -618,35 +618,48 @@ void PhaseEnvelopeRoutines::finalize(HelmholtzEOSMixtureBackend &HEOS)
     env.ipsat_max = std::distance(env.p.begin(), std::max_element(env.p.begin(), env.p.end()));
 }
 
-std::vector<std::pair<std::size_t, std::size_t> > PhaseEnvelopeRoutines::find_intersections(const PhaseEnvelopeData &env, parameters iInput, double value)
+/// Return true if the segment [i, i+1] of the phase envelope contains the value of iInput
+static bool segment_contains(const PhaseEnvelopeData &env, parameters iInput, double value, std::size_t i)
+{
+    switch(iInput){
+        case iP:
+            return is_in_closed_range(env.p[i], env.p[i+1], value);
+        case iT:
+            return is_in_closed_range(env.T[i], env.T[i+1], value);
+        case iHmolar:
+            return is_in_closed_range(env.hmolar_vap[i], env.hmolar_vap[i+1], value);
+        case iSmolar:
+            return is_in_closed_range(env.smolar_vap[i], env.smolar_vap[i+1], value);
+        default:
+            throw ValueError(format("bad index to find_intersections"));
+    }
+}
+
+std::vector<std::pair<std::size_t, std::size_t> > PhaseEnvelopeRoutines::find_intersections(const PhaseEnvelopeData &env, parameters iInput, double value, const SegmentBucketIndex *index)
 {
     std::vector<std::pair<std::size_t, std::size_t> > intersections;
     
-    for (std::size_t i = 0; i < env.p.size()-1; ++i){
-        bool matched = false;
-        switch(iInput){
-            case iP:
-                if (is_in_closed_range(env.p[i], env.p[i+1], value)){ matched = true; } break;
-            case iT:
-                if (is_in_closed_range(env.T[i], env.T[i+1], value)){ matched = true; } break;
-            case iHmolar:
-                if (is_in_closed_range(env.hmolar_vap[i], env.hmolar_vap[i+1], value)){ matched = true; } break;
-            case iSmolar:
-                if (is_in_closed_range(env.smolar_vap[i], env.smolar_vap[i+1], value)){ matched = true; } break;
-            default:
-                throw ValueError(format("bad index to find_intersections"));
+    if (index != NULL && !index->empty()){
+        // Only the segments that overlap the bucket of the value are checked; they are in increasing order
+        std::pair<const std::size_t *, const std::size_t *> range = index->candidates(value);
+        for (const std::size_t *segment = range.first; segment != range.second; ++segment){
+            if (segment_contains(env, iInput, value, *segment)){
+                intersections.push_back(std::pair<std::size_t, std::size_t>(*segment, *segment+1));
+            }
         }
-        
-        if (matched){
+        return intersections;
+    }
+    for (std::size_t i = 0; i < env.p.size()-1; ++i){
+        if (segment_contains(env, iInput, value, i)){
             intersections.push_back(std::pair<std::size_t, std::size_t>(i, i+1)); 
         }
     }
     return intersections;
 }
-bool PhaseEnvelopeRoutines::is_inside(const PhaseEnvelopeData &env, parameters iInput1, CoolPropDbl value1, parameters iInput2, CoolPropDbl value2, std::size_t &iclosest, SimpleState &closest_state)
+bool PhaseEnvelopeRoutines::is_inside(const PhaseEnvelopeData &env, parameters iInput1, CoolPropDbl value1, parameters iInput2, CoolPropDbl value2, std::size_t &iclosest, SimpleState &closest_state, const SegmentBucketIndex *index1)
 {
     // Find the indices that bound the solution(s)
-    std::vector<std::pair<std::size_t, std::size_t> > intersections = find_intersections(env, iInput1, value1);
+    std::vector<std::pair<std::size_t, std::size_t> > intersections = find_intersections(env, iInput1, value1, index1);
 
     if (get_debug_level() > 5){ std::cout << format("is_inside(%Lg,%Lg); iTsat_max=%d; ipsat_max=%d\n", value1, value2,env.iTsat_max, env.ipsat_max); }
     // Check whether input is above max value
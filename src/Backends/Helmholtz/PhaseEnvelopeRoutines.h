@@ -35,8 +35,9 @@ class PhaseEnvelopeRoutines{
      * @param env The PhaseEnvelopeData instance to be used
      * @param iInput The key for the variable type that is to be checked
      * @param value The value associated with iInput
+     * @param index If provided and built from the vector of env for iInput, only the segments it gives for value are checked rather than all of them
      */
-    static std::vector<std::pair<std::size_t, std::size_t> > find_intersections(const PhaseEnvelopeData &env, parameters iInput, double value);
+    static std::vector<std::pair<std::size_t, std::size_t> > find_intersections(const PhaseEnvelopeData &env, parameters iInput, double value, const SegmentBucketIndex *index = NULL);
     
     /** \brief Determine whether a pair of inputs is inside or outside the phase envelope
      * 
@@ -47,8 +48,9 @@ class PhaseEnvelopeRoutines{
      * @param value2 The value of the second input
      * @param iclosest The index of the phase envelope for the closest point
      * @param closest_state A SimpleState corresponding to the closest point found on the phase envelope
+     * @param index1 If provided, the index of the vector of env for iInput1; see find_intersections()
      */
-    static bool is_inside(const PhaseEnvelopeData &env, parameters iInput1, CoolPropDbl value1, parameters iInput2, CoolPropDbl value2, std::size_t &iclosest, SimpleState &closest_state);
+    static bool is_inside(const PhaseEnvelopeData &env, parameters iInput1, CoolPropDbl value1, parameters iInput2, CoolPropDbl value2, std::size_t &iclosest, SimpleState &closest_state, const SegmentBucketIndex *index1 = NULL);
 
     static double evaluate(const PhaseEnvelopeData &env, parameters output, parameters iInput1, double value1, std::size_t &i);
 };
@@ -0,0 +1,44 @@
+#include "SpecializedAlpharKernels.h"
+
+#if defined(COOLPROP_SPECIALIZED_KERNELS)
+// Generated by dev/generate_alphar_kernels.py
+#include "specialized_alphar_kernels.h"
+#endif
+
+namespace CoolProp{
+
+#if defined(COOLPROP_SPECIALIZED_KERNELS)
+/// The JSON parser does not always round to the nearest double, so allow for a difference in the last bit
+static bool same_coefficient(double loaded, double generated){
+    return std::abs(loaded - generated) <= 1e-15*std::abs(generated);
+}
+#endif
+
+bool attach_specialized_alphar_kernel(CoolPropFluid &fluid)
+{
+#if defined(COOLPROP_SPECIALIZED_KERNELS)
+    ResidualHelmholtzGeneralizedExponential &GenExp = fluid.EOS().alphar.GenExp;
+    for (std::size_t k = 0; k < sizeof(specialized_alphar_kernels)/sizeof(specialized_alphar_kernels[0]); ++k){
+        const SpecializedAlpharKernel &K = specialized_alphar_kernels[k];
+        if (fluid.name != K.name){ continue; }
+        // The coefficients may have been replaced since the kernel was generated, in which case the generic loops are used
+        if (!GenExp.finished || GenExp.elements.size() != K.N){ return false; }
+        bool in_u[6] = {GenExp.delta_li_in_u, GenExp.tau_mi_in_u, GenExp.eta1_in_u, GenExp.eta2_in_u, GenExp.beta1_in_u, GenExp.beta2_in_u};
+        for (std::size_t j = 0; j < 6; ++j){
+            if (in_u[j] != K.in_u[j]){ return false; }
+        }
+        for (std::size_t i = 0; i < K.N; ++i){
+            const ResidualHelmholtzGeneralizedExponentialElement &el = GenExp.elements[i];
+            double loaded[15] = {el.n, el.d, el.t, el.c, el.l_double, el.omega, el.m_double, el.eta1, el.epsilon1, el.eta2, el.epsilon2, el.beta1, el.gamma1, el.beta2, el.gamma2};
+            for (std::size_t j = 0; j < 15; ++j){
+                if (!same_coefficient(loaded[j], K.elements[i][j])){ return false; }
+            }
+        }
+        GenExp.kernel = K.kernel;
+        return true;
+    }
+#endif
+    return false;
+}
+
+} /* namespace CoolProp */
@@ -0,0 +1,29 @@
+/** \brief Specialized kernels for the generalized exponential terms of the residual Helmholtz energy
+ *
+ * The kernels are generated by dev/generate_alphar_kernels.py from the coefficients in dev/fluids/*.json, and are
+ * only compiled in if COOLPROP_SPECIALIZED_KERNELS is defined (CMake option of the same name)
+ */
+
+#ifndef SPECIALIZED_ALPHAR_KERNELS_H
+#define SPECIALIZED_ALPHAR_KERNELS_H
+
+#include "CoolPropFluid.h"
+
+namespace CoolProp{
+
+/// A generated kernel together with the coefficients it was generated from
+struct SpecializedAlpharKernel
+{
+    const char *name; ///< The name of the fluid
+    std::size_t N; ///< The number of elements
+    const double (*elements)[15]; ///< n, d, t, c, l, omega, m, eta1, epsilon1, eta2, epsilon2, beta1, gamma1, beta2, gamma2 of each element
+    bool in_u[6]; ///< delta_li_in_u, tau_mi_in_u, eta1_in_u, eta2_in_u, beta1_in_u, beta2_in_u
+    ResidualHelmholtzGeneralizedExponentialKernel kernel;
+};
+
+/// Attach the specialized kernel of this fluid to its generalized exponential terms, if there is one and it was generated
+/// from the same coefficients as the ones that were loaded; returns true if a kernel was attached
+bool attach_specialized_alphar_kernel(CoolPropFluid &fluid);
+
+} /* namespace CoolProp */
+#endif
@@ -948,7 +948,7 @@ void SaturationSolvers::saturation_T_pure_Maxwell(HelmholtzEOSMixtureBackend &HE
                 if ((rhoL < crit.rhomolar*0.8 || rhoL > tripleL.rhomolar*1.2 || 
 					rhoV > crit.rhomolar*1.2 || rhoV < tripleV.rhomolar*0.8) 
 					&& 
-					!get_config_bool(DONT_CHECK_PROPERTY_LIMITS)
+					!HEOS.skip_property_limits()
 					)
                 {
                     // Lets assume that liquid density is more or less linear with T
@@ -1090,6 +1090,29 @@ void SaturationSolvers::saturation_T_pure_Maxwell(HelmholtzEOSMixtureBackend &HE
     if (get_debug_level() > 5){ std::cout << format("[Maxwell] pL: %g pV: %g\n", SatL->p(), SatV->p());}
 }
 
+void SaturationSolvers::saturation_T_pure_polish(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T)
+{
+    shared_ptr<HelmholtzEOSMixtureBackend> SatL = HEOS.SatL,
+                                           SatV = HEOS.SatV;
+    CoolPropDbl rhoL = SatL->rhomolar(), rhoV = SatV->rhomolar();
+    for (int iter = 0; iter < 5; ++iter){
+        SatL->update_DmolarT_direct(rhoL, T);
+        SatV->update_DmolarT_direct(rhoV, T);
+        // Residuals are the differences of pressure and of Gibbs energy; at constant T, dg/drho = (dp/drho)/rho
+        CoolPropDbl r1 = SatL->p() - SatV->p(), r2 = SatL->gibbsmolar() - SatV->gibbsmolar();
+        CoolPropDbl dpdrhoL = SatL->first_partial_deriv(iP, iDmolar, iT), dpdrhoV = SatV->first_partial_deriv(iP, iDmolar, iT);
+        CoolPropDbl det = dpdrhoL*dpdrhoV*(1/rhoL - 1/rhoV);
+        CoolPropDbl DeltarhoL = (r1*dpdrhoV/rhoV - r2*dpdrhoV)/det, DeltarhoV = (r1*dpdrhoL/rhoL - r2*dpdrhoL)/det;
+        if (!ValidNumber(DeltarhoL) || !ValidNumber(DeltarhoV)){
+            throw SolutionError(format("Polishing of the saturation states failed at T = %0.16Lg K", T));
+        }
+        rhoL += DeltarhoL; rhoV += DeltarhoV;
+        if (std::abs(DeltarhoL/rhoL) < 4*DBL_EPSILON && std::abs(DeltarhoV/rhoV) < 4*DBL_EPSILON){ break; }
+    }
+    SatL->update_DmolarT_direct(rhoL, T);
+    SatV->update_DmolarT_direct(rhoV, T);
+}
+
 void SaturationSolvers::x_and_y_from_K(CoolPropDbl beta, const std::vector<CoolPropDbl> &K, const std::vector<CoolPropDbl> &z, std::vector<CoolPropDbl> &x, std::vector<CoolPropDbl> &y)
 {
     for (unsigned int i=0; i < K.size(); i++)
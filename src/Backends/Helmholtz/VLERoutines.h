@@ -57,6 +57,14 @@ namespace SaturationSolvers
     void saturation_T_pure(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T, saturation_T_pure_options &options);
     void saturation_T_pure_Akasaka(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T, saturation_T_pure_Akasaka_options &options);
     void saturation_T_pure_Maxwell(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T, saturation_T_pure_Akasaka_options &options);
+    /** \brief Polish the saturated densities in HEOS.SatL and HEOS.SatV at T to machine precision
+     *
+     * A few Newton steps in the liquid and vapor densities on the equality of pressure and Gibbs energy of the two phases; the
+     * saturated states must already be close to the solution, for instance from saturation_T_pure_Maxwell
+     * @param HEOS The Helmholtz EOS backend instance to be used
+     * @param T Imposed temperature in K
+     */
+    void saturation_T_pure_polish(HelmholtzEOSMixtureBackend &HEOS, CoolPropDbl T);
     
     /**
     */
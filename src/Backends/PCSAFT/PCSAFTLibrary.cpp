@@ -19,6 +19,8 @@ std::string get_mixture_binary_pair_pcsaft(const std::string &CAS1, const std::s
 
 void set_mixture_binary_pair_pcsaft(const std::string &CAS1, const std::string &CAS2, const std::string &key, const double value) {
     PCSAFTLibrary::get_library().set_binary_interaction_pcsaft(CAS1, CAS2, key, value);
+    // The states kept by PropsSI hold a copy of the old interaction parameters
+    clear_PropsSI_state_cache();
 }
 
 namespace PCSAFTLibrary {
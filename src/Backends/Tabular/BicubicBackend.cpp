@@ -4,11 +4,12 @@
 #include "MatrixMath.h"
 #include "DataStructures.h"
 #include "Backends/Helmholtz/PhaseEnvelopeRoutines.h"
+#include <algorithm>
 
-void CoolProp::BicubicBackend::find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, double x, double y, std::size_t &i, std::size_t &j)
+void CoolProp::BicubicBackend::find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, double x, double y, std::size_t &i, std::size_t &j)
 {
     table.find_native_nearest_good_cell(x, y, i, j);
-    const CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     if (!cell.valid()){
         if (cell.has_valid_neighbor()){
             // Get new good neighbor
@@ -22,7 +23,7 @@ void CoolProp::BicubicBackend::find_native_nearest_good_indices(SinglePhaseGridd
 
 /// Ask the derived class to find the nearest neighbor (pure virtual)
 void CoolProp::BicubicBackend::find_nearest_neighbor(SinglePhaseGriddedTableData &table,
-    const std::vector<std::vector<CellCoeffs> > &coeffs,
+    const CellCoeffsMatrix &coeffs,
     const parameters variable1,
     const double value1,
     const parameters otherkey,
@@ -30,7 +31,7 @@ void CoolProp::BicubicBackend::find_nearest_neighbor(SinglePhaseGriddedTableData
     std::size_t &i,
     std::size_t &j){
     table.find_nearest_neighbor(variable1, value1, otherkey, otherval, i, j);
-    const CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     if (!cell.valid()){
         if (cell.has_valid_neighbor()){
             // Get new good neighbor
@@ -52,7 +53,7 @@ void CoolProp::BicubicBackend::find_nearest_neighbor(SinglePhaseGriddedTableData
 double CoolProp::BicubicBackend::evaluate_single_phase_transport(SinglePhaseGriddedTableData &table, parameters output, double x, double y, std::size_t i, std::size_t j)
 {
     // By definition i,i+1,j,j+1 are all in range and valid
-    std::vector<std::vector<double> > *f = NULL;
+    const TableMatrix *f = NULL;
     switch(output){
         case iconductivity:
             f = &table.cond; break;
@@ -77,13 +78,13 @@ double CoolProp::BicubicBackend::evaluate_single_phase_transport(SinglePhaseGrid
     return val;
 }
 // Use the single_phase table to evaluate an output
-double CoolProp::BicubicBackend::evaluate_single_phase(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, const parameters output, const double x, const double y, const std::size_t i, const std::size_t j)
+double CoolProp::BicubicBackend::evaluate_single_phase(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, const parameters output, const double x, const double y, const std::size_t i, const std::size_t j)
 {
     // Get the cell
-    const CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     
 	// Get the alpha coefficients
-    const std::vector<double> &alpha = cell.get(output);
+    const double *alpha = cell.get(output);
     
     // Normalized value in the range (0, 1)
 	double xhat = (x - table.xvec[i])/(table.xvec[i+1] - table.xvec[i]);
@@ -104,6 +105,7 @@ double CoolProp::BicubicBackend::evaluate_single_phase(const SinglePhaseGriddedT
     // Cache the output value calculated
     switch(output){
         case iT:  _T = val; break;
+        case iP: _p = val; break;
         case iDmolar: _rhomolar = val; break;
         case iSmolar: _smolar = val; break;
 		case iHmolar: _hmolar = val; break;
@@ -113,14 +115,20 @@ double CoolProp::BicubicBackend::evaluate_single_phase(const SinglePhaseGriddedT
     return val;
 }
 /// Use the single_phase table to evaluate an output
-double CoolProp::BicubicBackend::evaluate_single_phase_derivative(SinglePhaseGriddedTableData &table, std::vector<std::vector<CellCoeffs> > &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny)
+double CoolProp::BicubicBackend::evaluate_single_phase_derivative(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny)
 {
 
+    if ((Nx == 1 && Ny == 0) || (Ny == 1 && Nx == 0)){
+        // The input variables have no coefficients in the cells
+        if (output == table.xkey) { return static_cast<double>(Nx); }
+        if (output == table.ykey) { return static_cast<double>(Ny); }
+    }
+
     // Get the cell
-    CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     
 	// Get the alpha coefficients
-    const std::vector<double> &alpha = cell.get(output);
+    const double *alpha = cell.get(output);
     
     // Normalized value in the range (0, 1)
 	double xhat = (x - table.xvec[i])/(table.xvec[i+1] - table.xvec[i]);
@@ -131,8 +139,6 @@ double CoolProp::BicubicBackend::evaluate_single_phase_derivative(SinglePhaseGri
     // Calculate the output value desired
 	double val = 0;
     if (Nx == 1 && Ny == 0){
-		if (output == table.xkey) { return 1.0; }
-		if (output == table.ykey) { return 0.0; }
         for (std::size_t l = 1; l < 4; ++l)
         {
             for(std::size_t m = 0; m < 4; ++m)
@@ -144,8 +150,6 @@ double CoolProp::BicubicBackend::evaluate_single_phase_derivative(SinglePhaseGri
         return val*dxhatdx;
     }
     else if (Ny == 1 && Nx == 0){
-		if (output == table.ykey) { return 1.0; }
-		if (output == table.xkey) { return 0.0; }
         for (std::size_t l = 0; l < 4; ++l)
         {
             for(std::size_t m = 1; m < 4; ++m)
@@ -162,13 +166,13 @@ double CoolProp::BicubicBackend::evaluate_single_phase_derivative(SinglePhaseGri
 }
 
 /// Use the single_phase table to invert for x given a y
-void CoolProp::BicubicBackend::invert_single_phase_x(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters other_key, double other, double y, std::size_t i, std::size_t j)
+void CoolProp::BicubicBackend::invert_single_phase_x(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters other_key, double other, double y, std::size_t i, std::size_t j)
 {
     // Get the cell
-    const CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     
 	// Get the alpha coefficients
-    const std::vector<double> &alpha = cell.get(other_key);
+    const double *alpha = cell.get(other_key);
     
     // Normalized value in the range (0, 1)
     double yhat = (y - table.yvec[j])/(table.yvec[j+1] - table.yvec[j]);
@@ -217,13 +221,13 @@ void CoolProp::BicubicBackend::invert_single_phase_x(const SinglePhaseGriddedTab
 }
 
 /// Use the single_phase table to solve for y given an x
-void CoolProp::BicubicBackend::invert_single_phase_y(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters other_key, double other, double x, std::size_t i, std::size_t j)
+void CoolProp::BicubicBackend::invert_single_phase_y(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters other_key, double other, double x, std::size_t i, std::size_t j)
 {
     // Get the cell
-    const CellCoeffs &cell = coeffs[i][j];
+    const CellCoeffs cell = coeffs(i, j);
     
 	// Get the alpha coefficients
-    const std::vector<double> &alpha = cell.get(other_key);
+    const double *alpha = cell.get(other_key);
     
     // Normalized value in the range (0, 1)
     double xhat = (x - table.xvec[i])/(table.xvec[i+1] - table.xvec[i]);
@@ -270,4 +274,169 @@ void CoolProp::BicubicBackend::invert_single_phase_y(const SinglePhaseGriddedTab
     }
 }
 
+namespace CoolProp{
+
+/// Evaluate the bicubic polynomial with the coefficients alpha at n points of its cell; the loop over the points is vectorized by the compiler
+static void evaluate_bicubic_points(const double *alpha, const double *xhat, const double *yhat, std::size_t n, double *out)
+{
+    const double a00 = alpha[0*4+0], a10 = alpha[1*4+0], a20 = alpha[2*4+0], a30 = alpha[3*4+0];
+    const double a01 = alpha[0*4+1], a11 = alpha[1*4+1], a21 = alpha[2*4+1], a31 = alpha[3*4+1];
+    const double a02 = alpha[0*4+2], a12 = alpha[1*4+2], a22 = alpha[2*4+2], a32 = alpha[3*4+2];
+    const double a03 = alpha[0*4+3], a13 = alpha[1*4+3], a23 = alpha[2*4+3], a33 = alpha[3*4+3];
+    for (std::size_t k = 0; k < n; ++k){
+        const double x = xhat[k], y = yhat[k];
+        // The same operations as in BicubicBackend::evaluate_single_phase, so that the results are the same
+        double B0 = ((a30*y + a20)*y + a10)*y + a00;
+        double B1 = ((a31*y + a21)*y + a11)*y + a01;
+        double B2 = ((a32*y + a22)*y + a12)*y + a02;
+        double B3 = ((a33*y + a23)*y + a13)*y + a03;
+        out[k] = ((B3*x + B2)*x + B1)*x + B0;
+    }
+}
+
+/// The molar parameter that is interpolated for an output of a batch, and whether the output is mass-based; false if the output cannot be interpolated in a batch
+static bool batch_molar_output(parameters output, parameters &molar, bool &mass_based)
+{
+    mass_based = false;
+    switch(output){
+        case iT: case iP: case iDmolar: case iHmolar: case iSmolar: case iUmolar: case iviscosity: case iconductivity:
+            molar = output; return true;
+        case iDmass: molar = iDmolar; mass_based = true; return true;
+        case iHmass: molar = iHmolar; mass_based = true; return true;
+        case iSmass: molar = iSmolar; mass_based = true; return true;
+        case iUmass: molar = iUmolar; mass_based = true; return true;
+        default:
+            return false;
+    }
+}
+
+} /* namespace CoolProp */
+
+void CoolProp::BicubicBackend::update_batch(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, const std::vector<parameters> &outputs, double *out_soa)
+{
+    // Check the tables, build if necessary
+    check_tables();
+
+    bool native_ph = (input_pair == HmolarP_INPUTS || input_pair == HmassP_INPUTS), native_pT = (input_pair == PT_INPUTS);
+    bool batchable = (native_ph || native_pT) && !is_mixture && imposed_phase_index == iphase_not_imposed;
+    std::vector<std::size_t> state_outputs;
+    std::vector<parameters> molar_outputs;
+    std::vector<bool> mass_based_outputs;
+    for (std::size_t j = 0; j < outputs.size() && batchable; ++j){
+        parameters molar; bool mass_based;
+        if (is_trivial_parameter(outputs[j])){ continue; }
+        batchable = batch_molar_output(outputs[j], molar, mass_based);
+        state_outputs.push_back(j); molar_outputs.push_back(molar); mass_based_outputs.push_back(mass_based);
+    }
+    if (!batchable){
+        AbstractState::update_batch(input_pair, Value1, Value2, n, outputs, out_soa);
+        return;
+    }
+    // Trivial outputs do not depend on the state; evaluate them once and broadcast them
+    for (std::size_t j = 0; j < outputs.size(); ++j){
+        if (!is_trivial_parameter(outputs[j])){ continue; }
+        double val;
+        try{ val = trivial_keyed_output(outputs[j]); }
+        catch(...){ val = _HUGE; }
+        std::fill(out_soa + j*n, out_soa + (j+1)*n, val);
+    }
+    if (state_outputs.empty() || n == 0){ return; }
+
+    SinglePhaseGriddedTableData &table = native_ph ? static_cast<SinglePhaseGriddedTableData &>(dataset->single_phase_logph) : static_cast<SinglePhaseGriddedTableData &>(dataset->single_phase_logpT);
+    const CellCoeffsMatrix &coeffs = native_ph ? dataset->coeffs_ph : dataset->coeffs_pT;
+    PureFluidSaturationTableData &pure_saturation = dataset->pure_saturation;
+    CoolPropDbl molar_mass = AS->molar_mass();
+
+    // Find the cells of all the state points; the state points that are not in the single-phase table are updated one at a time
+    std::vector<double> x(n), y(n);
+    std::vector<std::pair<std::size_t, std::size_t> > cells; // (index of the cell, index of the state point)
+    std::vector<std::size_t> scalar_points;
+    cells.reserve(n);
+    for (std::size_t i = 0; i < n; ++i){
+        CoolProp::input_pairs pair = input_pair;
+        CoolPropDbl v1 = Value1[i], v2 = Value2[i];
+        mass_to_molar_inputs(pair, v1, v2);
+        // The x variable of the pressure-temperature table is the temperature, the second input
+        x[i] = static_cast<double>(native_ph ? v1 : v2);
+        y[i] = static_cast<double>(native_ph ? v2 : v1);
+        bool single_phase = table.native_inputs_are_in_range(x[i], y[i]);
+        if (single_phase){
+            std::size_t iL, iV;
+            CoolPropDbl yL, yV;
+            single_phase = !pure_saturation.is_inside(iP, y[i], native_ph ? iHmolar : iT, x[i], iL, iV, yL, yV);
+        }
+        if (single_phase){
+            std::size_t icell, jcell;
+            try{
+                find_native_nearest_good_indices(table, coeffs, x[i], y[i], icell, jcell);
+                cells.push_back(std::pair<std::size_t, std::size_t>(icell*coeffs.Ny + jcell, i));
+            }
+            catch(...){
+                single_phase = false;
+            }
+        }
+        if (!single_phase){ scalar_points.push_back(i); }
+    }
+    // Group the state points by cell, so that the coefficients of a cell are read once for all of its state points
+    std::sort(cells.begin(), cells.end());
+    std::size_t Ncells = cells.size();
+    std::vector<double> xhat(Ncells), yhat(Ncells), val(Ncells);
+    for (std::size_t k = 0; k < Ncells; ++k){
+        std::size_t icell = cells[k].first/coeffs.Ny, jcell = cells[k].first % coeffs.Ny, i = cells[k].second;
+        xhat[k] = (x[i] - table.xvec[icell])/(table.xvec[icell+1] - table.xvec[icell]);
+        yhat[k] = (y[i] - table.yvec[jcell])/(table.yvec[jcell+1] - table.yvec[jcell]);
+    }
+
+    for (std::size_t m = 0; m < state_outputs.size(); ++m){
+        double *out = out_soa + state_outputs[m]*n;
+        parameters molar = molar_outputs[m];
+        if (molar == table.xkey || molar == table.ykey){
+            // One of the inputs of the table
+            const std::vector<double> &native = (molar == table.xkey) ? x : y;
+            for (std::size_t k = 0; k < Ncells; ++k){ val[k] = native[cells[k].second]; }
+        }
+        else if (molar == iviscosity || molar == iconductivity){
+            for (std::size_t k = 0; k < Ncells; ++k){
+                std::size_t i = cells[k].second;
+                val[k] = evaluate_single_phase_transport(table, molar, x[i], y[i], cells[k].first/coeffs.Ny, cells[k].first % coeffs.Ny);
+            }
+        }
+        else{
+            for (std::size_t kbegin = 0; kbegin < Ncells; ){
+                std::size_t kend = kbegin + 1;
+                while (kend < Ncells && cells[kend].first == cells[kbegin].first){ ++kend; }
+                const CellCoeffs cell = coeffs(cells[kbegin].first/coeffs.Ny, cells[kbegin].first % coeffs.Ny);
+                evaluate_bicubic_points(cell.get(molar), &(xhat[kbegin]), &(yhat[kbegin]), kend - kbegin, &(val[kbegin]));
+                kbegin = kend;
+            }
+        }
+        // Scatter the values back to the order of the state points, in the same units as keyed_output()
+        for (std::size_t k = 0; k < Ncells; ++k){
+            double v = val[k];
+            if (mass_based_outputs[m]){
+                v = static_cast<double>((molar == iDmolar) ? v*molar_mass : v/molar_mass);
+            }
+            out[cells[k].second] = v;
+        }
+    }
+
+    // The other state points, and the last one so that the backend is left in its state
+    if (scalar_points.empty() || scalar_points.back() != n-1){ scalar_points.push_back(n-1); }
+    for (std::size_t k = 0; k < scalar_points.size(); ++k){
+        std::size_t i = scalar_points[k];
+        try{
+            update(input_pair, Value1[i], Value2[i]);
+        }
+        catch(...){
+            for (std::size_t m = 0; m < state_outputs.size(); ++m){ out_soa[state_outputs[m]*n + i] = _HUGE; }
+            continue;
+        }
+        for (std::size_t m = 0; m < state_outputs.size(); ++m){
+            std::size_t j = state_outputs[m];
+            try{ out_soa[j*n + i] = keyed_output(outputs[j]); }
+            catch(...){ out_soa[j*n + i] = _HUGE; }
+        }
+    }
+}
+
 #endif // !defined(NO_TABULAR_BACKENDS)
@@ -66,31 +66,33 @@ class BicubicBackend : public TabularBackend
 {
     public:
         /// Instantiator; base class loads or makes tables
-        BicubicBackend(shared_ptr<CoolProp::AbstractState> AS) : TabularBackend(AS){
+        BicubicBackend(shared_ptr<CoolProp::AbstractState> AS, const TableSpecification &spec = TableSpecification()) : TabularBackend(AS, spec){
             imposed_phase_index = iphase_not_imposed;
             // If a pure fluid or a predefined mixture, don't need to set fractions, go ahead and build
             if (!this->AS->get_mole_fractions().empty()){
                 check_tables();
-                SinglePhaseGriddedTableData &single_phase_logph = dataset->single_phase_logph;
-                SinglePhaseGriddedTableData &single_phase_logpT = dataset->single_phase_logpT;
-                dataset->build_coeffs(single_phase_logph, dataset->coeffs_ph);
-                dataset->build_coeffs(single_phase_logpT, dataset->coeffs_pT);
                 is_mixture = (this->AS->get_mole_fractions().size() > 1);
             }
 		};
         void set_mole_fractions(const std::vector<CoolPropDbl> &mole_fractions){ 
             this->AS->set_mole_fractions(mole_fractions); 
             is_mixture = true;
-            // Check the tables and build if necessary
+            // Check the tables and build if necessary; for mixtures, the tables and their coefficients
+            // are only built once the mole fractions are known
             check_tables();
-            // For mixtures, the construction of the coefficients is delayed until this 
-            // function so that the set_mole_fractions function can be called
-            SinglePhaseGriddedTableData &single_phase_logph = dataset->single_phase_logph;
-            SinglePhaseGriddedTableData &single_phase_logpT = dataset->single_phase_logpT;
-            dataset->build_coeffs(single_phase_logph, dataset->coeffs_ph);
-            dataset->build_coeffs(single_phase_logpT, dataset->coeffs_pT);
         };
         std::string backend_name(void){return get_backend_string(BICUBIC_BACKEND);}
+        /**
+         * @brief Update the state for a batch of state points and collect keyed outputs for all of them; see AbstractState::update_batch
+         *
+         * For the native inputs of the tables of a pure fluid (HmolarP, HmassP and PT), the cells of all the state points are found first,
+         * the state points are grouped by cell, and the bicubic polynomial of each cell is evaluated for all of its state points at once, in
+         * a loop that the compiler can vectorize.  The two-phase state points, the ones that are out of range, the other input pairs and the
+         * outputs that are not T, P, the density, the enthalpy, the entropy, the internal energy and the transport properties go through
+         * update() and keyed_output().  The results are the same as with update() and keyed_output(), and the state of the backend is
+         * the one of the last state point.
+         */
+        void update_batch(CoolProp::input_pairs input_pair, const double *Value1, const double *Value2, std::size_t n, const std::vector<parameters> &outputs, double *out_soa);
         
         /**
          * @brief Evaluate a derivative in terms of the native inputs of the table
@@ -105,13 +107,16 @@ class BicubicBackend : public TabularBackend
          * @param Ny The number of derivatives with respect to y with x held constant
          * @return 
          */
-        double evaluate_single_phase_derivative(SinglePhaseGriddedTableData &table, std::vector<std::vector<CellCoeffs> > &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny);
+        double evaluate_single_phase_derivative(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny);
 		double evaluate_single_phase_phmolar_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny){
             return evaluate_single_phase_derivative(dataset->single_phase_logph, dataset->coeffs_ph, output, _hmolar, _p, i, j, Nx, Ny);
         };
         double evaluate_single_phase_pT_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny){
             return evaluate_single_phase_derivative(dataset->single_phase_logpT, dataset->coeffs_pT, output, _T, _p, i, j, Nx, Ny);
         };
+        double evaluate_single_phase_Du_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny){
+            return evaluate_single_phase_derivative(dataset->single_phase_logDu, dataset->coeffs_Du, output, _umolar, _rhomolar, i, j, Nx, Ny);
+        };
         
         /**
          * @brief 
@@ -124,19 +129,22 @@ class BicubicBackend : public TabularBackend
          * @param j
          * @return 
          */
-		double evaluate_single_phase(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, const parameters output, const double x, const double y, const std::size_t i, const std::size_t j);
+		double evaluate_single_phase(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, const parameters output, const double x, const double y, const std::size_t i, const std::size_t j);
         double evaluate_single_phase_phmolar(parameters output, std::size_t i, std::size_t j){
 			return evaluate_single_phase(dataset->single_phase_logph, dataset->coeffs_ph, output, _hmolar, _p, i, j);
 		};
         double evaluate_single_phase_pT(parameters output, std::size_t i, std::size_t j){
 			return evaluate_single_phase(dataset->single_phase_logpT, dataset->coeffs_pT, output, _T, _p, i, j);
 		};
+        double evaluate_single_phase_Du(parameters output, std::size_t i, std::size_t j){
+            return evaluate_single_phase(dataset->single_phase_logDu, dataset->coeffs_Du, output, _umolar, _rhomolar, i, j);
+        };
 
-        virtual void find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, double x, double y, std::size_t &i, std::size_t &j);
+        virtual void find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, double x, double y, std::size_t &i, std::size_t &j);
         
         /// Ask the derived class to find the nearest neighbor (pure virtual)
         virtual void find_nearest_neighbor(SinglePhaseGriddedTableData &table,
-            const std::vector<std::vector<CellCoeffs> > &coeffs,
+            const CellCoeffsMatrix &coeffs,
             const parameters variable1,
             const double value1,
             const parameters otherkey,
@@ -160,6 +168,9 @@ class BicubicBackend : public TabularBackend
 		double evaluate_single_phase_pT_transport(parameters output, std::size_t i, std::size_t j){
             return evaluate_single_phase_transport(dataset->single_phase_logpT, output, _T, _p, i, j);
         };
+        double evaluate_single_phase_Du_transport(parameters output, std::size_t i, std::size_t j){
+            return evaluate_single_phase_transport(dataset->single_phase_logDu, output, _umolar, _rhomolar, i, j);
+        };
 
         /**
          * @brief Use the table to solve for the x variable of the table given the y coordinate of the table and a variable that can yield a unique solution for x
@@ -170,8 +181,8 @@ class BicubicBackend : public TabularBackend
          * @param i The x-coordinate of the cell
          * @param j The y-coordinate of the cell
          */
-        void invert_single_phase_x(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters other_key, double other, double y, std::size_t i, std::size_t j);
-        void invert_single_phase_y(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters other_key, double other, double x, std::size_t i, std::size_t j);
+        void invert_single_phase_x(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters other_key, double other, double y, std::size_t i, std::size_t j);
+        void invert_single_phase_y(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters other_key, double other, double x, std::size_t i, std::size_t j);
 };
 
 }
@@ -0,0 +1,271 @@
+#if !defined(NO_TABULAR_BACKENDS)
+
+#include "FlatTables.h"
+#include "Exceptions.h"
+#include "CoolPropTools.h"
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+namespace CoolProp{
+
+static const char flat_table_magic[8] = {'C','P','T','A','B','L','E','\0'};
+static const uint32_t flat_table_byte_order = 0x01020304;
+/// The arrays start on cache-line boundaries
+static const std::size_t flat_table_alignment = 64;
+
+static std::size_t align_offset(std::size_t offset){
+    return (offset + flat_table_alignment - 1)/flat_table_alignment*flat_table_alignment;
+}
+
+void TableMatrix::allocate(std::size_t rows, std::size_t cols)
+{
+    file.reset();
+    Nrows = rows; Ncols = cols;
+    if (rows*cols == 0){
+        storage.clear();
+        values = NULL;
+        return;
+    }
+    // Over-allocate by a cache line, and start the values on the first cache-line boundary of the storage
+    const std::size_t doubles_per_line = flat_table_alignment/sizeof(double);
+    storage.assign(rows*cols + doubles_per_line, 0.0);
+    std::size_t misalignment = (reinterpret_cast<std::size_t>(&(storage[0])) % flat_table_alignment)/sizeof(double);
+    values = &(storage[0]) + (misalignment == 0 ? 0 : doubles_per_line - misalignment);
+}
+TableMatrix & TableMatrix::operator=(const TableMatrix &other)
+{
+    if (this == &other){ return *this; }
+    if (other.is_mapped()){
+        storage.clear();
+        file = other.file;
+        values = other.values;
+        Nrows = other.Nrows; Ncols = other.Ncols;
+    }
+    else{
+        allocate(other.Nrows, other.Ncols);
+        if (values != NULL){ std::memcpy(const_cast<double *>(values), other.values, Nrows*Ncols*sizeof(double)); }
+    }
+    return *this;
+}
+double * TableMatrix::mutable_row(std::size_t i)
+{
+    if (is_mapped()){
+        const double *mapped = values;
+        shared_ptr<MappedFile> keep_alive = file;
+        allocate(Nrows, Ncols);
+        std::memcpy(const_cast<double *>(values), mapped, Nrows*Ncols*sizeof(double));
+    }
+    return const_cast<double *>(values) + i*Ncols;
+}
+void TableMatrix::resize(std::size_t rows, std::size_t cols, double value)
+{
+    allocate(rows, cols);
+    std::fill(const_cast<double *>(values), const_cast<double *>(values) + rows*cols, value);
+}
+void TableMatrix::clear()
+{
+    allocate(0, 0);
+}
+void TableMatrix::assign(const std::vector<std::vector<double> > &mat)
+{
+    std::size_t rows = mat.size(), cols = mat.empty() ? 0 : mat[0].size();
+    for (std::size_t i = 0; i < rows; ++i){
+        if (mat[i].size() != cols){
+            throw ValueError("Rows of the matrix do not all have the same length");
+        }
+    }
+    allocate(rows, cols);
+    for (std::size_t i = 0; i < rows; ++i){
+        std::copy(mat[i].begin(), mat[i].end(), const_cast<double *>(values) + i*cols);
+    }
+}
+std::vector<std::vector<double> > TableMatrix::to_vectors() const
+{
+    std::vector<std::vector<double> > mat(Nrows);
+    for (std::size_t i = 0; i < Nrows; ++i){
+        mat[i].assign(values + i*Ncols, values + (i+1)*Ncols);
+    }
+    return mat;
+}
+void TableMatrix::map(const FlatTableReader &reader, const std::string &name, std::size_t rows, std::size_t cols)
+{
+    std::size_t file_rows, file_cols;
+    const double *data = reader.get(name, file_rows, file_cols);
+    if (file_rows != rows || file_cols != cols){
+        throw UnableToLoadError(format("array %s is [%dx%d] rather than [%dx%d]", name.c_str(), file_rows, file_cols, rows, cols));
+    }
+    storage.clear();
+    file = reader.get_file();
+    values = data;
+    Nrows = rows; Ncols = cols;
+}
+
+FlatTableWriter::FlatTableWriter(int revision, std::size_t Nx, std::size_t Ny, double xmin, double xmax, double ymin, double ymax)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, flat_table_magic, sizeof(flat_table_magic));
+    header.version = FLAT_TABLE_FORMAT_VERSION;
+    header.byte_order = flat_table_byte_order;
+    header.revision = revision;
+    header.Nx = Nx; header.Ny = Ny;
+    header.xmin = xmin; header.xmax = xmax; header.ymin = ymin; header.ymax = ymax;
+}
+void FlatTableWriter::add(const std::string &name, const double *data, std::size_t Nrows, std::size_t Ncols)
+{
+    if (name.size() >= sizeof(FlatTableEntry().name)){
+        throw ValueError(format("Name of array [%s] is too long for a flat table", name.c_str()));
+    }
+    names.push_back(name);
+    arrays.push_back(std::vector<double>(data, data + Nrows*Ncols));
+    rows.push_back(Nrows);
+    cols.push_back(Ncols);
+}
+void FlatTableWriter::add(const std::string &name, const std::vector<double> &vec)
+{
+    add(name, vec.empty() ? NULL : &(vec[0]), vec.empty() ? 0 : 1, vec.size());
+}
+void FlatTableWriter::add(const std::string &name, const std::vector<std::vector<double> > &mat)
+{
+    std::size_t Nrows = mat.size(), Ncols = mat.empty() ? 0 : mat[0].size();
+    std::vector<double> flat;
+    flat.reserve(Nrows*Ncols);
+    for (std::size_t i = 0; i < Nrows; ++i){
+        if (mat[i].size() != Ncols){
+            throw ValueError(format("Matrix [%s] cannot be written to a flat table, its rows do not all have the same length", name.c_str()));
+        }
+        flat.insert(flat.end(), mat[i].begin(), mat[i].end());
+    }
+    add(name, flat.empty() ? NULL : &(flat[0]), Nrows, Ncols);
+}
+void FlatTableWriter::write(const std::string &path)
+{
+    header.Narrays = static_cast<uint32_t>(arrays.size());
+
+    // Lay out the arrays after the header and the entries
+    std::vector<FlatTableEntry> entries(arrays.size());
+    std::size_t offset = align_offset(sizeof(FlatTableHeader) + entries.size()*sizeof(FlatTableEntry));
+    for (std::size_t k = 0; k < arrays.size(); ++k){
+        std::memset(&(entries[k]), 0, sizeof(FlatTableEntry));
+        std::strncpy(entries[k].name, names[k].c_str(), sizeof(entries[k].name) - 1);
+        entries[k].offset = offset;
+        entries[k].rows = rows[k];
+        entries[k].cols = cols[k];
+        offset = align_offset(offset + arrays[k].size()*sizeof(double));
+    }
+
+    // Several processes may write the same table at the same time, each one writes its own temporary file
+    std::string tmp_path = format("%s.%u.tmp", path.c_str(), static_cast<unsigned int>(std::random_device()()));
+    {
+        std::ofstream ofs(tmp_path.c_str(), std::ofstream::binary);
+        if (!ofs){ throw ValueError(format("Unable to open file %s to write it", tmp_path.c_str())); }
+        ofs.write(reinterpret_cast<const char *>(&header), sizeof(FlatTableHeader));
+        if (!entries.empty()){
+            ofs.write(reinterpret_cast<const char *>(&(entries[0])), entries.size()*sizeof(FlatTableEntry));
+        }
+        std::size_t position = sizeof(FlatTableHeader) + entries.size()*sizeof(FlatTableEntry);
+        const std::vector<char> padding(flat_table_alignment, 0);
+        for (std::size_t k = 0; k < arrays.size(); ++k){
+            ofs.write(&(padding[0]), entries[k].offset - position);
+            if (!arrays[k].empty()){
+                ofs.write(reinterpret_cast<const char *>(&(arrays[k][0])), arrays[k].size()*sizeof(double));
+            }
+            position = entries[k].offset + arrays[k].size()*sizeof(double);
+        }
+        if (!ofs){ throw ValueError(format("Unable to write file %s", tmp_path.c_str())); }
+    }
+#if defined(__ISWINDOWS__)
+    // rename does not replace an existing file on Windows, and the existing file cannot be removed while another process
+    // has it mapped; keep the file in use, its revision is checked again when it is loaded
+    if (path_exists(path) && std::remove(path.c_str()) != 0){
+        std::remove(tmp_path.c_str());
+        return;
+    }
+#endif
+    // On POSIX systems, rename replaces the file in one step, so a reader sees either the old or the new file
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0){
+        std::remove(tmp_path.c_str());
+#if defined(__ISWINDOWS__)
+        // Another process wrote the file between the removal and the renaming
+        if (path_exists(path)){ return; }
+#endif
+        throw ValueError(format("Unable to rename %s to %s", tmp_path.c_str(), path.c_str()));
+    }
+}
+
+FlatTableReader::FlatTableReader(const std::string &path) : header(NULL)
+{
+    try{
+        file.reset(new MappedFile(path));
+    }
+    catch(std::exception &e){
+        throw UnableToLoadError(e.what());
+    }
+    const char *data = file->data();
+    std::size_t size = file->size();
+    if (size < sizeof(FlatTableHeader)){
+        throw UnableToLoadError(format("File %s is too small to be a flat table", path.c_str()));
+    }
+    header = reinterpret_cast<const FlatTableHeader *>(data);
+    if (std::memcmp(header->magic, flat_table_magic, sizeof(flat_table_magic)) != 0){
+        throw UnableToLoadError(format("File %s is not a flat table", path.c_str()));
+    }
+    if (header->byte_order != flat_table_byte_order){
+        throw UnableToLoadError(format("Flat table %s was written on a machine with another byte order", path.c_str()));
+    }
+    if (header->version != FLAT_TABLE_FORMAT_VERSION){
+        throw UnableToLoadError(format("Flat table %s is version %d, the current version is %d", path.c_str(), header->version, FLAT_TABLE_FORMAT_VERSION));
+    }
+    if (sizeof(FlatTableHeader) + header->Narrays*sizeof(FlatTableEntry) > size){
+        throw UnableToLoadError(format("Flat table %s is truncated", path.c_str()));
+    }
+    const FlatTableEntry *first = reinterpret_cast<const FlatTableEntry *>(data + sizeof(FlatTableHeader));
+    for (std::size_t k = 0; k < header->Narrays; ++k){
+        const FlatTableEntry &entry = first[k];
+        bool in_file = entry.offset <= size && entry.rows <= size && entry.cols <= size && entry.rows*entry.cols <= (size - entry.offset)/sizeof(double);
+        if (entry.name[sizeof(entry.name) - 1] != '\0' || entry.offset % sizeof(double) != 0 || !in_file){
+            throw UnableToLoadError(format("Array %d of flat table %s is not valid", static_cast<int>(k), path.c_str()));
+        }
+        entries[std::string(entry.name)] = &entry;
+    }
+}
+const double * FlatTableReader::get(const std::string &name, std::size_t &rows, std::size_t &cols) const
+{
+    std::map<std::string, const FlatTableEntry *>::const_iterator it = entries.find(name);
+    if (it == entries.end()){
+        throw UnableToLoadError(format("could not find array %s", name.c_str()));
+    }
+    rows = static_cast<std::size_t>(it->second->rows);
+    cols = static_cast<std::size_t>(it->second->cols);
+    return reinterpret_cast<const double *>(file->data() + it->second->offset);
+}
+void FlatTableReader::get(const std::string &name, std::vector<double> &vec) const
+{
+    std::size_t rows, cols;
+    const double *data = get(name, rows, cols);
+    vec.assign(data, data + rows*cols);
+}
+void FlatTableReader::get(const std::string &name, std::vector<std::vector<double> > &mat) const
+{
+    std::size_t rows, cols;
+    const double *data = get(name, rows, cols);
+    mat.resize(rows);
+    for (std::size_t i = 0; i < rows; ++i){
+        mat[i].assign(data + i*cols, data + (i+1)*cols);
+    }
+}
+void FlatTableReader::get(const std::string &name, std::vector<std::vector<double> > &mat, std::size_t rows, std::size_t cols) const
+{
+    std::size_t file_rows, file_cols;
+    get(name, file_rows, file_cols);
+    if (file_rows != rows || file_cols != cols){
+        throw UnableToLoadError(format("array %s is [%dx%d] rather than [%dx%d]", name.c_str(), file_rows, file_cols, rows, cols));
+    }
+    get(name, mat);
+}
+
+} /* namespace CoolProp */
+
+#endif // !defined(NO_TABULAR_BACKENDS)
@@ -0,0 +1,138 @@
+#ifndef FLAT_TABLES_H
+#define FLAT_TABLES_H
+
+#include "CPfilepaths.h"
+#include "crossplatform_shared_ptr.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace CoolProp{
+
+class FlatTableReader;
+
+/** \brief A matrix of doubles stored contiguously in row-major order
+ *
+ * The values are either owned by the matrix, in which case the first one is on a cache-line boundary, or they are
+ * the pages of a memory-mapped flat table file, which are then shared between all the processes that use the same
+ * table.  Reading an element with m[i][j] never copies anything; a mapped matrix is copied once before it is modified.
+ */
+class TableMatrix
+{
+private:
+    std::size_t Nrows, Ncols;
+    std::vector<double> storage; ///< The values, if they are owned by the matrix, with room to align them
+    const double *values; ///< The first value, in storage or in the mapped file
+    shared_ptr<MappedFile> file; ///< The mapped file, if the values are in it
+    /// Allocate owned storage for rows x cols values
+    void allocate(std::size_t rows, std::size_t cols);
+public:
+    TableMatrix() : Nrows(0), Ncols(0), values(NULL) {};
+    TableMatrix(const TableMatrix &other) : Nrows(0), Ncols(0), values(NULL) { *this = other; };
+    TableMatrix & operator=(const TableMatrix &other);
+    /// The number of rows, so that the matrix can be used like a vector of rows
+    std::size_t size() const { return Nrows; };
+    std::size_t rows() const { return Nrows; };
+    std::size_t cols() const { return Ncols; };
+    bool empty() const { return Nrows*Ncols == 0; };
+    /// True if the values are in a memory-mapped file
+    bool is_mapped() const { return file.get() != NULL; };
+    /// A pointer to the first value
+    const double * data() const { return values; };
+    /// A pointer to the first value of row i
+    const double * operator[](std::size_t i) const { return values + i*Ncols; };
+    /// A pointer to the first value of row i that can be written through; a mapped matrix is copied first
+    double * mutable_row(std::size_t i);
+    /// Set an element
+    void set(std::size_t i, std::size_t j, double value){ mutable_row(i)[j] = value; };
+    /// Resize to rows x cols and set all the elements to value
+    void resize(std::size_t rows, std::size_t cols, double value);
+    void clear();
+    /// Copy the values from a matrix stored as a vector of rows; all the rows must have the same length
+    void assign(const std::vector<std::vector<double> > &mat);
+    /// Copy the values to a matrix stored as a vector of rows
+    std::vector<std::vector<double> > to_vectors() const;
+    /// Use an array of a flat table file in place and check its dimensions; throws UnableToLoadError if they are not rows x cols
+    void map(const FlatTableReader &reader, const std::string &name, std::size_t rows, std::size_t cols);
+};
+
+/** \brief The version of the layout of the flat table files
+ *
+ * Increment it whenever the layout of FlatTableHeader or FlatTableEntry, or the meaning of the arrays, changes;
+ * files with another version are not loaded and the tables are loaded from the compressed files instead
+ */
+const uint32_t FLAT_TABLE_FORMAT_VERSION = 2;
+
+/** \brief The header at the start of a flat table file
+ *
+ * A flat table file is made of this header, then Narrays FlatTableEntry, and then the arrays of doubles, each one stored
+ * contiguously in row-major order and starting on a 64-byte boundary.  The doubles are stored in the byte order of the
+ * machine that wrote the file, which is checked with byte_order.  A file can therefore be memory-mapped and used in place.
+ */
+struct FlatTableHeader{
+    char magic[8]; ///< "CPTABLE" and a null character
+    uint32_t version; ///< FLAT_TABLE_FORMAT_VERSION when the file was written
+    uint32_t byte_order; ///< 0x01020304 in the byte order of the machine that wrote the file
+    int32_t revision; ///< The revision of the table
+    uint32_t Narrays; ///< The number of arrays in the file
+    uint64_t Nx, Ny; ///< The dimensions of the table (Ny is zero for one-dimensional tables)
+    double xmin, xmax, ymin, ymax; ///< The limits of the table
+};
+
+/// The description of one of the arrays of a flat table file
+struct FlatTableEntry{
+    char name[48]; ///< The name of the array, null-terminated
+    uint64_t offset; ///< The offset of the first double of the array from the start of the file in bytes
+    uint64_t rows, cols; ///< The dimensions of the array; vectors have one row
+};
+
+/// Collects the arrays of a table and writes them to a flat table file
+class FlatTableWriter
+{
+private:
+    std::vector<std::string> names;
+    std::vector<std::vector<double> > arrays;
+    std::vector<std::size_t> rows, cols;
+public:
+    FlatTableHeader header;
+    FlatTableWriter(int revision, std::size_t Nx, std::size_t Ny, double xmin, double xmax, double ymin, double ymax);
+    /// Add a vector
+    void add(const std::string &name, const std::vector<double> &vec);
+    /// Add a matrix; all its rows must have the same length
+    void add(const std::string &name, const std::vector<std::vector<double> > &mat);
+    /// Add a matrix
+    void add(const std::string &name, const TableMatrix &mat){ add(name, mat.data(), mat.rows(), mat.cols()); };
+    /// Add a rows x cols array, stored in row-major order
+    void add(const std::string &name, const double *data, std::size_t rows, std::size_t cols);
+    /// Write the file; it is written to a temporary file first and then renamed, so that a file that is being written is never loaded
+    void write(const std::string &path);
+};
+
+/// Gives access to the arrays of a memory-mapped flat table file
+class FlatTableReader
+{
+private:
+    shared_ptr<MappedFile> file;
+    std::map<std::string, const FlatTableEntry *> entries;
+public:
+    const FlatTableHeader *header;
+    /// Map and check the file; throws UnableToLoadError if it cannot be mapped or is not a valid flat table file of the current version
+    explicit FlatTableReader(const std::string &path);
+    /// The mapped file, to keep it alive as long as its arrays are used in place
+    shared_ptr<MappedFile> get_file() const { return file; };
+    /// Return true if the file contains the array
+    bool has(const std::string &name) const { return entries.find(name) != entries.end(); };
+    /// Return a pointer to the first double of an array in the mapped file and its dimensions
+    const double * get(const std::string &name, std::size_t &rows, std::size_t &cols) const;
+    /// Copy a vector
+    void get(const std::string &name, std::vector<double> &vec) const;
+    /// Copy a matrix
+    void get(const std::string &name, std::vector<std::vector<double> > &mat) const;
+    /// Copy a matrix and check its dimensions
+    void get(const std::string &name, std::vector<std::vector<double> > &mat, std::size_t rows, std::size_t cols) const;
+};
+
+} /* namespace CoolProp */
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "TabularBackends.h"
 #include "CoolProp.h"
+#include "CPthreads.h"
+#include "Backends/Helmholtz/HelmholtzEOSMixtureBackend.h"
 #include <sstream>
 #include "time.h"
 #include "miniz.h"
@@ -110,6 +112,160 @@ template <typename T> void write_table(const T &table, const std::string &path_t
 
 } // namespace CoolProp
 
+namespace CoolProp{
+
+/// Get one state per worker thread to build a table with N work items, the first one being AS itself
+///
+/// Only the backends based on HelmholtzEOSMixtureBackend can be copied; the other ones (REFPROP, ...) build the tables
+/// serially with AS.  The flash routines do not depend on the previous state, so the tables are the same whatever the
+/// number of threads.
+static std::vector<shared_ptr<AbstractState> > get_table_build_states(shared_ptr<AbstractState> &AS, std::size_t N)
+{
+    std::vector<shared_ptr<AbstractState> > states(1, AS);
+    HelmholtzEOSMixtureBackend *HEOS = dynamic_cast<HelmholtzEOSMixtureBackend *>(AS.get());
+    if (HEOS == NULL){ return states; }
+    std::size_t Nthreads = get_thread_count(get_config_int(TABULAR_BUILD_NUM_THREADS), N);
+    // The copies are made here rather than in the worker threads since the fluid libraries are populated lazily
+    for (std::size_t k = 1; k < Nthreads; ++k){
+        shared_ptr<AbstractState> copy(HEOS->get_copy());
+        copy->set_mole_fractions(AS->get_mole_fractions());
+        states.push_back(copy);
+    }
+    return states;
+}
+
+/// Builds a contiguous range of points of a saturation table, each worker thread with its own state
+class SaturationTablePointBuilder{
+public:
+    PureFluidSaturationTableData &table;
+    std::vector<shared_ptr<AbstractState> > &states;
+    std::size_t ioffset;
+    CoolPropDbl pmin, pmax;
+    SaturationTablePointBuilder(PureFluidSaturationTableData &table, std::vector<shared_ptr<AbstractState> > &states, std::size_t ioffset, CoolPropDbl pmin, CoolPropDbl pmax)
+        : table(table), states(states), ioffset(ioffset), pmin(pmin), pmax(pmax){};
+    void operator()(std::size_t ithread, std::size_t ibegin, std::size_t iend){
+        for (std::size_t i = ibegin + ioffset; i < iend + ioffset; ++i){
+            table.build_point(states[ithread], i, pmin, pmax);
+        }
+    }
+};
+
+/// Builds a contiguous range of rows of a single-phase table, each worker thread with its own state
+class SinglePhaseTableRowBuilder{
+public:
+    SinglePhaseGriddedTableData &table;
+    std::vector<shared_ptr<AbstractState> > &states;
+    SinglePhaseTableRowBuilder(SinglePhaseGriddedTableData &table, std::vector<shared_ptr<AbstractState> > &states) : table(table), states(states){};
+    void operator()(std::size_t ithread, std::size_t ibegin, std::size_t iend){
+        for (std::size_t i = ibegin; i < iend; ++i){
+            table.build_row(states[ithread], i);
+        }
+    }
+};
+
+/// The values and the derivatives along the refined axis of the checked parameters at one point of a sampling line
+struct GridSample{
+    bool valid;
+    std::vector<double> f, df;
+};
+
+/// Samples the checked parameters on all the sampling lines at a set of values of the refined axis, each worker thread with its own state
+class GridAxisSampler{
+public:
+    const SinglePhaseGriddedTableData &table;
+    std::vector<shared_ptr<AbstractState> > &states;
+    bool along_x;
+    const std::vector<double> &lines, &values;
+    const std::vector<parameters> &params;
+    std::vector<std::vector<GridSample> > &samples; ///< samples[k][l] is the sample at values[k] on line l
+    GridAxisSampler(const SinglePhaseGriddedTableData &table, std::vector<shared_ptr<AbstractState> > &states, bool along_x,
+                    const std::vector<double> &lines, const std::vector<double> &values, const std::vector<parameters> &params,
+                    std::vector<std::vector<GridSample> > &samples)
+        : table(table), states(states), along_x(along_x), lines(lines), values(values), params(params), samples(samples){};
+    void operator()(std::size_t ithread, std::size_t ibegin, std::size_t iend){
+        AbstractState &AS = *(states[ithread]);
+        parameters axis_key = along_x ? table.xkey : table.ykey, other_key = along_x ? table.ykey : table.xkey;
+        for (std::size_t k = ibegin; k < iend; ++k){
+            samples[k].resize(lines.size());
+            for (std::size_t l = 0; l < lines.size(); ++l){
+                GridSample &sample = samples[k][l];
+                sample.valid = false;
+                double x = along_x ? values[k] : lines[l], y = along_x ? lines[l] : values[k];
+                CoolPropDbl v1, v2;
+                input_pairs input_pair = generate_update_pair(table.xkey, x, table.ykey, y, v1, v2);
+                try{
+                    AS.update(input_pair, v1, v2);
+                    // Same as the nodes of the table, two-phase states are holes
+                    if (!ValidNumber(AS.rhomolar()) || is_in_closed_range(0.0, 1.0, AS.Q())){ continue; }
+                    sample.f.resize(params.size()); sample.df.resize(params.size());
+                    for (std::size_t m = 0; m < params.size(); ++m){
+                        sample.f[m] = AS.keyed_output(params[m]);
+                        sample.df[m] = AS.first_partial_deriv(params[m], axis_key, other_key);
+                    }
+                    sample.valid = true;
+                }
+                catch(std::exception &){
+                    sample.valid = false;
+                }
+            }
+        }
+    }
+};
+
+} // namespace CoolProp
+
+void CoolProp::PureFluidSaturationTableData::build_point(shared_ptr<CoolProp::AbstractState> &AS, std::size_t i, CoolPropDbl pmin, CoolPropDbl pmax){
+    const bool debug = get_debug_level() > 5 || false;
+    // Log spaced
+    CoolPropDbl p = exp(log(pmin) + (log(pmax) - log(pmin))/(N-1)*i);
+    // Saturated liquid
+    try{
+        AS->update(PQ_INPUTS, p, 0);
+        pL[i] = p; TL[i] = AS->T();  rhomolarL[i] = AS->rhomolar(); 
+        hmolarL[i] = AS->hmolar(); smolarL[i] = AS->smolar(); umolarL[i] = AS->umolar();
+        logpL[i] = log(p); logrhomolarL[i] = log(rhomolarL[i]);
+        cpmolarL[i] = AS->cpmolar(); cvmolarL[i] = AS->cvmolar(); speed_soundL[i] = AS->speed_sound();
+    }
+    catch(std::exception &e){
+        // That failed for some reason, go to the next pair
+        if (debug){std::cout << " " << e.what() << std::endl;}
+        return;
+    }
+    // Transport properties - if no transport properties, just keep going
+    try{
+        if (store_transport){
+            viscL[i] = AS->viscosity(); condL[i] = AS->conductivity();
+            logviscL[i] = log(viscL[i]);
+        }
+    }
+    catch(std::exception &e){
+        if (debug){std::cout << " " << e.what() << std::endl;}
+    }
+    // Saturated vapor
+    try{
+        AS->update(PQ_INPUTS, p, 1);
+        pV[i] = p; TV[i] = AS->T(); rhomolarV[i] = AS->rhomolar();
+        hmolarV[i] = AS->hmolar(); smolarV[i] = AS->smolar(); umolarV[i] = AS->umolar();
+        logpV[i] = log(p); logrhomolarV[i] = log(rhomolarV[i]);
+        cpmolarV[i] = AS->cpmolar(); cvmolarV[i] = AS->cvmolar(); speed_soundV[i] = AS->speed_sound();
+    }
+    catch(std::exception &e){
+        // That failed for some reason, go to the next pair
+        if (debug){std::cout << " " << e.what() << std::endl;}
+        return;
+    }
+    // Transport properties - if no transport properties, just keep going
+    try{
+        if (store_transport){
+            viscV[i] = AS->viscosity(); condV[i] = AS->conductivity();
+            logviscV[i] = log(viscV[i]);
+        }
+    }
+    catch(std::exception &e){
+        if (debug){std::cout << " " << e.what() << std::endl;}
+    }
+}
+
 void CoolProp::PureFluidSaturationTableData::build(shared_ptr<CoolProp::AbstractState> &AS){
     const bool debug = get_debug_level() > 5 || false;
     if (debug){
@@ -124,61 +280,25 @@ void CoolProp::PureFluidSaturationTableData::build(shared_ptr<CoolProp::Abstract
     CoolPropDbl Tmin = std::max(AS->Ttriple(), AS->Tmin());
     AS->update(QT_INPUTS, 0, Tmin);
     CoolPropDbl p_triple = AS->p();
-    CoolPropDbl p, pmin = p_triple, pmax = 0.9999*AS->p_critical();
-    for (std::size_t i = 0; i < N-1; ++i)
-    {
-        if (i==0){
-            CoolProp::set_config_bool(DONT_CHECK_PROPERTY_LIMITS, true);
-        }
-        // Log spaced
-        p = exp(log(pmin) + (log(pmax) - log(pmin))/(N-1)*i);
-        
-        // Saturated liquid
-        try{
-            AS->update(PQ_INPUTS, p, 0);
-            pL[i] = p; TL[i] = AS->T();  rhomolarL[i] = AS->rhomolar(); 
-            hmolarL[i] = AS->hmolar(); smolarL[i] = AS->smolar(); umolarL[i] = AS->umolar();
-            logpL[i] = log(p); logrhomolarL[i] = log(rhomolarL[i]);
-            cpmolarL[i] = AS->cpmolar(); cvmolarL[i] = AS->cvmolar(); speed_soundL[i] = AS->speed_sound();
-        }
-        catch(std::exception &e){
-            // That failed for some reason, go to the next pair
-            if (debug){std::cout << " " << e.what() << std::endl;}
-            continue;
-        }
-        // Transport properties - if no transport properties, just keep going
-        try{
-            viscL[i] = AS->viscosity(); condL[i] = AS->conductivity();
-            logviscL[i] = log(viscL[i]);
-        }
-        catch(std::exception &e){
-            if (debug){std::cout << " " << e.what() << std::endl;}
-        }
-        // Saturated vapor
-        try{
-            AS->update(PQ_INPUTS, p, 1);
-            pV[i] = p; TV[i] = AS->T(); rhomolarV[i] = AS->rhomolar();
-            hmolarV[i] = AS->hmolar(); smolarV[i] = AS->smolar(); umolarV[i] = AS->umolar();
-            logpV[i] = log(p); logrhomolarV[i] = log(rhomolarV[i]);
-            cpmolarV[i] = AS->cpmolar(); cvmolarV[i] = AS->cvmolar(); speed_soundV[i] = AS->speed_sound();
-        }
-        catch(std::exception &e){
-            // That failed for some reason, go to the next pair
-            if (debug){std::cout << " " << e.what() << std::endl;}
-            continue;
-        }
-        // Transport properties - if no transport properties, just keep going
-        try{
-            viscV[i] = AS->viscosity(); condV[i] = AS->conductivity();
-            logviscV[i] = log(viscV[i]);
-        }
-        catch(std::exception &e){
-            if (debug){std::cout << " " << e.what() << std::endl;}
-        }
-        if (i==0){
-            CoolProp::set_config_bool(DONT_CHECK_PROPERTY_LIMITS, false);
-        }
+    CoolPropDbl pmin = p_triple, pmax = 0.9999*AS->p_critical();
+
+    // The first point is at the triple point, which can be just outside of the limits of the EOS, so the limits
+    // are not checked for it; only this state is affected, the threads building the other points keep checking them
+    AS->set_skip_property_limits(true);
+    try{
+        build_point(AS, 0, pmin, pmax);
+    }
+    catch(...){
+        AS->set_skip_property_limits(false);
+        throw;
     }
+    AS->set_skip_property_limits(false);
+
+    // Points 1 to N-2
+    std::vector<shared_ptr<AbstractState> > states = get_table_build_states(AS, N-2);
+    SaturationTablePointBuilder builder(*this, states, 1, pmin, pmax);
+    parallel_for_chunks(N-2, states.size(), builder);
+
     // Last point is at the critical point
     AS->update(PQ_INPUTS, AS->p_critical(), 1);
     std::size_t i = N-1;
@@ -203,6 +323,95 @@ void CoolProp::PureFluidSaturationTableData::build(shared_ptr<CoolProp::Abstract
     logpL[i] = log(AS->p()); 
 	logrhomolarL[i] = log(rhomolarL[i]);
 }
+
+namespace CoolProp{
+
+/// Positive on one side of the tie line between the saturated liquid (vL, uL) and vapor (vV, uV), negative on the other side
+static double tie_line_side(double vL, double uL, double vV, double uV, double v, double u){
+    return (vV - vL)*(u - uL) - (uV - uL)*(v - vL);
+}
+
+/// The side of the tie line of the point k of the saturation table; throws ValueError if the point could not be calculated when the table was built
+static double tie_line_side_at(const PureFluidSaturationTableData &table, std::size_t k, double v, double u){
+    double g = tie_line_side(1/table.rhomolarL[k], table.umolarL[k], 1/table.rhomolarV[k], table.umolarV[k], v, u);
+    if (!ValidNumber(g)){
+        throw ValueError(format("The point %d of the saturation table is not valid, so the phase of the DmolarUmolar inputs cannot be determined", static_cast<int>(k)));
+    }
+    return g;
+}
+
+/// The side of the tie line at log(p) of a state, with the saturated states interpolated with the four points around index i
+class TieLineAtLogp{
+public:
+    const PureFluidSaturationTableData &table;
+    std::size_t i;
+    double v, u;
+    TieLineAtLogp(const PureFluidSaturationTableData &table, std::size_t i, double v, double u) : table(table), i(i), v(v), u(u){};
+    double uL(double logp) const { return CubicInterp(table.logpL, table.umolarL, i-2, i-1, i, i+1, logp); };
+    double uV(double logp) const { return CubicInterp(table.logpV, table.umolarV, i-2, i-1, i, i+1, logp); };
+    double side(double logp) const {
+        double vL = exp(-CubicInterp(table.logpL, table.logrhomolarL, i-2, i-1, i, i+1, logp));
+        double vV = exp(-CubicInterp(table.logpV, table.logrhomolarV, i-2, i-1, i, i+1, logp));
+        return tie_line_side(vL, uL(logp), vV, uV(logp), v, u);
+    };
+};
+
+} // namespace CoolProp
+
+bool CoolProp::PureFluidSaturationTableData::is_inside_Du(double rhomolar, double umolar, CoolPropDbl &p, CoolPropDbl &Q, std::size_t &iL, std::size_t &iV) const
+{
+    if (N < 4 || umolarL.size() != N || !(rhomolar > 0)){ return false; }
+    const double v = 1/rhomolar;
+    // The tie lines do not cross inside the saturation dome, so the side of the state changes once between the lowest
+    // pressure of the table and the highest one
+    std::size_t klow = 0, khigh = N - 2;
+    double glow = tie_line_side_at(*this, klow, v, umolar);
+    double ghigh = tie_line_side_at(*this, khigh, v, umolar);
+    if (glow*ghigh > 0){
+        // The last point is at the critical point, where the tie line is a point; the tie lines between the point N-2
+        // and the critical point cover the top of the dome, which is between the saturated volumes of the point N-2.
+        // The whole dome is on the same side of the tangent at the critical point as the lowest tie line, so the side
+        // of the state changes there if it is inside
+        if (!is_in_closed_range(1/rhomolarL[N-2], 1/rhomolarV[N-2], v)){ return false; }
+        klow = N - 2; khigh = N - 1;
+        glow = ghigh; ghigh = -glow;
+    }
+    else{
+        while (khigh - klow > 1){
+            std::size_t kmid = (klow + khigh)/2;
+            double gmid = tie_line_side_at(*this, kmid, v, umolar);
+            if (gmid*glow > 0){ klow = kmid; glow = gmid; }
+            else{ khigh = kmid; ghigh = gmid; }
+        }
+    }
+    // Refine in log(p) with the same cubic interpolation as evaluate(), which passes through the points klow and khigh
+    std::size_t i = std::min(std::max(khigh, static_cast<std::size_t>(2)), N - 2);
+    TieLineAtLogp tie_line(*this, i, v, umolar);
+    double a = logpL[klow], b = logpL[khigh], ga = glow, gb = ghigh, logp = a;
+    // Regula falsi with the Illinois modification, the interval always brackets the tie line of the state
+    int side = 0;
+    for (int iter = 0; iter < 50; ++iter){
+        logp = (a*gb - b*ga)/(gb - ga);
+        double g = tie_line.side(logp);
+        if (g == 0 || std::abs(b - a) < 1e-12*std::abs(logp)){ break; }
+        if (g*gb > 0){
+            b = logp; gb = g;
+            if (side == -1){ ga /= 2; }
+            side = -1;
+        }
+        else{
+            a = logp; ga = g;
+            if (side == 1){ gb /= 2; }
+            side = 1;
+        }
+    }
+    double uL = tie_line.uL(logp), uV = tie_line.uV(logp);
+    Q = (umolar - uL)/(uV - uL);
+    if (!ValidNumber(Q) || !is_in_closed_range(0.0, 1.0, static_cast<double>(Q))){ return false; }
+    p = exp(logp);
+    iL = i; iV = i;
+    return true;
+}
     
 void CoolProp::SinglePhaseGriddedTableData::build(shared_ptr<CoolProp::AbstractState> &AS)
 {
@@ -231,127 +440,221 @@ void CoolProp::SinglePhaseGriddedTableData::build(shared_ptr<CoolProp::AbstractS
             x = xmin + (xmax - xmin)/(Nx-1)*i;
         }
         xvec[i] = x;
-        for (std::size_t j = 0; j < Ny; ++j)
-        {
-            // Calculate the x value
-            if (logy){
-                // Log spaced
-                y = exp(log(ymin) + (log(ymax/ymin))/(Ny-1)*j);
-            }
-            else{
-                // Linearly spaced
-                y = ymin + (ymax - ymin)/(Ny-1)*j;
+    }
+    for (std::size_t j = 0; j < Ny; ++j)
+    {
+        // Calculate the y value
+        if (logy){
+            // Log spaced
+            y = exp(log(ymin) + (log(ymax/ymin))/(Ny-1)*j);
+        }
+        else{
+            // Linearly spaced
+            y = ymin + (ymax - ymin)/(Ny-1)*j;
+        }
+        yvec[j] = y;
+    }
+    // Each row only writes its own nodes, so the rows can be built in any order
+    std::vector<shared_ptr<AbstractState> > states = get_table_build_states(AS, Nx);
+    if (grid_tolerance > 0){
+        // Adaptive grid, the number of knots of each axis depends on the tolerance
+        std::size_t Nmax = static_cast<std::size_t>(std::max(get_config_int(TABULAR_GRID_MAX_NODES), 17));
+        std::vector<double> xknots = refine_axis(states, true, Nmax), yknots = refine_axis(states, false, Nmax);
+        Nx = xknots.size(); Ny = yknots.size();
+        resize(Nx, Ny);
+        xvec = xknots; yvec = yknots;
+        if (debug){
+            std::cout << format("Adaptive grid with tolerance %g has [%dx%d] nodes\n", grid_tolerance, Nx, Ny);
+        }
+    }
+    SinglePhaseTableRowBuilder builder(*this, states);
+    parallel_for_chunks(Nx, std::min(states.size(), Nx), builder);
+}
+std::vector<double> CoolProp::SinglePhaseGriddedTableData::refine_axis(std::vector<shared_ptr<CoolProp::AbstractState> > &states, bool along_x, std::size_t Nmax)
+{
+    const std::size_t Ninitial = 16, max_levels = 12;
+    bool log_axis = along_x ? logx : logy, log_other = along_x ? logy : logx;
+    double axis_min = along_x ? xmin : ymin, axis_max = along_x ? xmax : ymax;
+    double other_min = along_x ? ymin : xmin, other_max = along_x ? ymax : xmax;
+    parameters other_key = along_x ? ykey : xkey;
+
+    // The interpolated density and temperature are checked, unless they are inputs of the table
+    std::vector<parameters> params;
+    if (xkey != iDmolar && ykey != iDmolar){ params.push_back(iDmolar); }
+    if (xkey != iT && ykey != iT){ params.push_back(iT); }
+
+    // The lines along which the error is estimated are evenly spaced on the other axis, and the one through the critical
+    // point is added since that is where the properties change the fastest
+    std::vector<double> lines = log_other ? logspace(other_min, other_max, Ninitial+1) : linspace(other_min, other_max, Ninitial+1);
+    try{
+        AbstractState &AS = *(states[0]);
+        AS.update(DmolarT_INPUTS, AS.rhomolar_critical(), AS.T_critical());
+        double critical = AS.keyed_output(other_key);
+        if (other_min < critical && critical < other_max){ lines.push_back(critical); }
+    }
+    catch(std::exception &){
+        // No critical point (mixtures, ...)
+    }
+
+    std::vector<double> knots = log_axis ? logspace(axis_min, axis_max, Ninitial+1) : linspace(axis_min, axis_max, Ninitial+1);
+    std::map<double, std::vector<GridSample> > cache;
+    // The intervals that can still be split
+    std::vector<std::pair<double, double> > active;
+    for (std::size_t i = 0; i+1 < knots.size(); ++i){ active.push_back(std::make_pair(knots[i], knots[i+1])); }
+
+    for (std::size_t level = 0; level < max_levels && !active.empty(); ++level)
+    {
+        // Find the midpoints of the active intervals, and sample the values that are not in the cache yet
+        std::vector<double> left(active.size()), right(active.size()), middle(active.size()), values;
+        for (std::size_t k = 0; k < active.size(); ++k){
+            left[k] = active[k].first; right[k] = active[k].second;
+            middle[k] = log_axis ? sqrt(left[k]*right[k]) : 0.5*(left[k] + right[k]);
+            double x[3] = {left[k], middle[k], right[k]};
+            for (std::size_t m = 0; m < 3; ++m){
+                if (cache.find(x[m]) == cache.end()){ cache[x[m]]; values.push_back(x[m]); }
             }
-            yvec[j] = y;
-            
-            if (debug){std::cout << "x: " << x << " y: " << y << std::endl;}
-            
-            // Generate the input pair
-            CoolPropDbl v1, v2;
-            input_pairs input_pair = generate_update_pair(xkey, x, ykey, y, v1, v2);
-            
-            // --------------------
-            //   Update the state
-            // --------------------
-            try{
-                AS->update(input_pair, v1, v2);
-                if (!ValidNumber(AS->rhomolar())){
-                    throw ValueError("rhomolar is invalid");
+        }
+        std::vector<std::vector<GridSample> > samples(values.size());
+        GridAxisSampler sampler(*this, states, along_x, lines, values, params, samples);
+        parallel_for_chunks(values.size(), std::min(states.size(), values.size()), sampler);
+        for (std::size_t k = 0; k < values.size(); ++k){ std::swap(cache[values[k]], samples[k]); }
+
+        // The error of the cubic Hermite interpolation at the midpoint, the highest one on all the lines
+        std::vector<std::pair<double, std::size_t> > errors;
+        for (std::size_t k = 0; k < active.size(); ++k){
+            const std::vector<GridSample> &s0 = cache[left[k]], &sm = cache[middle[k]], &s1 = cache[right[k]];
+            double h = right[k] - left[k], t = (middle[k] - left[k])/h, max_error = 0;
+            double h00 = (1 + 2*t)*(1 - t)*(1 - t), h10 = t*(1 - t)*(1 - t), h01 = t*t*(3 - 2*t), h11 = t*t*(t - 1);
+            for (std::size_t l = 0; l < lines.size(); ++l){
+                // Intervals that are partly two-phase or out of range are not refined, they have holes anyway
+                if (!s0[l].valid || !sm[l].valid || !s1[l].valid){ continue; }
+                for (std::size_t m = 0; m < params.size(); ++m){
+                    double f = h00*s0[l].f[m] + h10*h*s0[l].df[m] + h01*s1[l].f[m] + h11*h*s1[l].df[m];
+                    max_error = std::max(max_error, std::abs(f - sm[l].f[m])/std::abs(sm[l].f[m]));
                 }
             }
-            catch(std::exception &e){
-                // That failed for some reason, go to the next pair
-                if (debug){std::cout << " " << e.what() << std::endl;}
-                continue;
-            }
-            
-            // Skip two-phase states - they will remain as _HUGE holes in the table
-            if (is_in_closed_range(0.0, 1.0, AS->Q())){ 
-                if (debug){std::cout << " 2Phase" << std::endl;}
-                continue;
-            };
-            
-            // --------------------
-            //   State variables
-            // --------------------
-            T[i][j] = AS->T();
-            p[i][j] = AS->p();
-            rhomolar[i][j] = AS->rhomolar();
-            hmolar[i][j] = AS->hmolar();
-            smolar[i][j] = AS->smolar();
-			umolar[i][j] = AS->umolar();
-            
-            // -------------------------
-            //   Transport properties
-            // -------------------------
-            try{
-                visc[i][j] = AS->viscosity();
-                cond[i][j] = AS->conductivity();
+            if (max_error > grid_tolerance){ errors.push_back(std::make_pair(-max_error, k)); }
+        }
+        // If there are too many intervals to split, split the ones with the highest errors
+        std::sort(errors.begin(), errors.end());
+        std::size_t Nsplit = std::min(errors.size(), Nmax > knots.size() ? Nmax - knots.size() : 0);
+
+        std::vector<std::pair<double, double> > next;
+        for (std::size_t k = 0; k < Nsplit; ++k){
+            std::size_t i = errors[k].second;
+            knots.push_back(middle[i]);
+            next.push_back(std::make_pair(left[i], middle[i])); next.push_back(std::make_pair(middle[i], right[i]));
+        }
+        std::sort(knots.begin(), knots.end());
+        std::sort(next.begin(), next.end());
+        std::swap(active, next);
+    }
+    return knots;
+}
+void CoolProp::SinglePhaseGriddedTableData::build_row(shared_ptr<CoolProp::AbstractState> &AS, std::size_t i)
+{
+    const bool debug = get_debug_level() > 5 || false;
+    const CoolPropDbl x = xvec[i];
+    for (std::size_t j = 0; j < Ny; ++j)
+    {
+        const CoolPropDbl y = yvec[j];
+
+        if (debug){std::cout << "x: " << x << " y: " << y << std::endl;}
+        
+        // Generate the input pair
+        CoolPropDbl v1, v2;
+        input_pairs input_pair = generate_update_pair(xkey, x, ykey, y, v1, v2);
+        
+        // --------------------
+        //   Update the state
+        // --------------------
+        try{
+            AS->update(input_pair, v1, v2);
+            if (!ValidNumber(AS->rhomolar())){
+                throw ValueError("rhomolar is invalid");
             }
-            catch(std::exception &){
-                // Failures will remain as holes in table
+        }
+        catch(std::exception &e){
+            // That failed for some reason, go to the next pair
+            if (debug){std::cout << " " << e.what() << std::endl;}
+            continue;
+        }
+        
+        // Skip two-phase states - they will remain as _HUGE holes in the table
+        if (is_in_closed_range(0.0, 1.0, AS->Q())){ 
+            if (debug){std::cout << " 2Phase" << std::endl;}
+            continue;
+        };
+        
+        // --------------------
+        //   State variables
+        // --------------------
+        T.set(i, j, AS->T());
+        p.set(i, j, AS->p());
+        rhomolar.set(i, j, AS->rhomolar());
+        hmolar.set(i, j, AS->hmolar());
+        smolar.set(i, j, AS->smolar());
+        umolar.set(i, j, AS->umolar());
+        
+        // -------------------------
+        //   Transport properties
+        // -------------------------
+        try{
+            if (store_transport){
+                visc.set(i, j, AS->viscosity());
+                cond.set(i, j, AS->conductivity());
             }
-            
-            // ----------------------------------------
-            //   First derivatives of state variables
-            // ----------------------------------------
-            dTdx[i][j] = AS->first_partial_deriv(iT, xkey, ykey);
-            dTdy[i][j] = AS->first_partial_deriv(iT, ykey, xkey);
-            dpdx[i][j] = AS->first_partial_deriv(iP, xkey, ykey);
-            dpdy[i][j] = AS->first_partial_deriv(iP, ykey, xkey);
-            drhomolardx[i][j] = AS->first_partial_deriv(iDmolar, xkey, ykey);
-            drhomolardy[i][j] = AS->first_partial_deriv(iDmolar, ykey, xkey);
-            dhmolardx[i][j] = AS->first_partial_deriv(iHmolar, xkey, ykey);
-            dhmolardy[i][j] = AS->first_partial_deriv(iHmolar, ykey, xkey);
-            dsmolardx[i][j] = AS->first_partial_deriv(iSmolar, xkey, ykey);
-            dsmolardy[i][j] = AS->first_partial_deriv(iSmolar, ykey, xkey);
-			dumolardx[i][j] = AS->first_partial_deriv(iUmolar, xkey, ykey);
-            dumolardy[i][j] = AS->first_partial_deriv(iUmolar, ykey, xkey);
-            
-            // ----------------------------------------
-            //   Second derivatives of state variables
-            // ----------------------------------------
-            d2Tdx2[i][j] = AS->second_partial_deriv(iT, xkey, ykey, xkey, ykey);
-            d2Tdxdy[i][j] = AS->second_partial_deriv(iT, xkey, ykey, ykey, xkey);
-            d2Tdy2[i][j] = AS->second_partial_deriv(iT, ykey, xkey, ykey, xkey);
-            d2pdx2[i][j] = AS->second_partial_deriv(iP, xkey, ykey, xkey, ykey);
-            d2pdxdy[i][j] = AS->second_partial_deriv(iP, xkey, ykey, ykey, xkey);
-            d2pdy2[i][j] = AS->second_partial_deriv(iP, ykey, xkey, ykey, xkey);
-            d2rhomolardx2[i][j] = AS->second_partial_deriv(iDmolar, xkey, ykey, xkey, ykey);
-            d2rhomolardxdy[i][j] = AS->second_partial_deriv(iDmolar, xkey, ykey, ykey, xkey);
-            d2rhomolardy2[i][j] = AS->second_partial_deriv(iDmolar, ykey, xkey, ykey, xkey);
-            d2hmolardx2[i][j] = AS->second_partial_deriv(iHmolar, xkey, ykey, xkey, ykey);
-            d2hmolardxdy[i][j] = AS->second_partial_deriv(iHmolar, xkey, ykey, ykey, xkey);
-            d2hmolardy2[i][j] = AS->second_partial_deriv(iHmolar, ykey, xkey, ykey, xkey);
-            d2smolardx2[i][j] = AS->second_partial_deriv(iSmolar, xkey, ykey, xkey, ykey);
-            d2smolardxdy[i][j] = AS->second_partial_deriv(iSmolar, xkey, ykey, ykey, xkey);
-            d2smolardy2[i][j] = AS->second_partial_deriv(iSmolar, ykey, xkey, ykey, xkey);
-			d2umolardx2[i][j] = AS->second_partial_deriv(iUmolar, xkey, ykey, xkey, ykey);
-            d2umolardxdy[i][j] = AS->second_partial_deriv(iUmolar, xkey, ykey, ykey, xkey);
-            d2umolardy2[i][j] = AS->second_partial_deriv(iUmolar, ykey, xkey, ykey, xkey);
         }
+        catch(std::exception &){
+            // Failures will remain as holes in table
+        }
+        
+        // ----------------------------------------
+        //   First derivatives of state variables
+        // ----------------------------------------
+        dTdx.set(i, j, AS->first_partial_deriv(iT, xkey, ykey));
+        dTdy.set(i, j, AS->first_partial_deriv(iT, ykey, xkey));
+        dpdx.set(i, j, AS->first_partial_deriv(iP, xkey, ykey));
+        dpdy.set(i, j, AS->first_partial_deriv(iP, ykey, xkey));
+        drhomolardx.set(i, j, AS->first_partial_deriv(iDmolar, xkey, ykey));
+        drhomolardy.set(i, j, AS->first_partial_deriv(iDmolar, ykey, xkey));
+        dhmolardx.set(i, j, AS->first_partial_deriv(iHmolar, xkey, ykey));
+        dhmolardy.set(i, j, AS->first_partial_deriv(iHmolar, ykey, xkey));
+        dsmolardx.set(i, j, AS->first_partial_deriv(iSmolar, xkey, ykey));
+        dsmolardy.set(i, j, AS->first_partial_deriv(iSmolar, ykey, xkey));
+        dumolardx.set(i, j, AS->first_partial_deriv(iUmolar, xkey, ykey));
+        dumolardy.set(i, j, AS->first_partial_deriv(iUmolar, ykey, xkey));
+        
+        // ----------------------------------------
+        //   Second derivatives of state variables
+        // ----------------------------------------
+        d2Tdx2.set(i, j, AS->second_partial_deriv(iT, xkey, ykey, xkey, ykey));
+        d2Tdxdy.set(i, j, AS->second_partial_deriv(iT, xkey, ykey, ykey, xkey));
+        d2Tdy2.set(i, j, AS->second_partial_deriv(iT, ykey, xkey, ykey, xkey));
+        d2pdx2.set(i, j, AS->second_partial_deriv(iP, xkey, ykey, xkey, ykey));
+        d2pdxdy.set(i, j, AS->second_partial_deriv(iP, xkey, ykey, ykey, xkey));
+        d2pdy2.set(i, j, AS->second_partial_deriv(iP, ykey, xkey, ykey, xkey));
+        d2rhomolardx2.set(i, j, AS->second_partial_deriv(iDmolar, xkey, ykey, xkey, ykey));
+        d2rhomolardxdy.set(i, j, AS->second_partial_deriv(iDmolar, xkey, ykey, ykey, xkey));
+        d2rhomolardy2.set(i, j, AS->second_partial_deriv(iDmolar, ykey, xkey, ykey, xkey));
+        d2hmolardx2.set(i, j, AS->second_partial_deriv(iHmolar, xkey, ykey, xkey, ykey));
+        d2hmolardxdy.set(i, j, AS->second_partial_deriv(iHmolar, xkey, ykey, ykey, xkey));
+        d2hmolardy2.set(i, j, AS->second_partial_deriv(iHmolar, ykey, xkey, ykey, xkey));
+        d2smolardx2.set(i, j, AS->second_partial_deriv(iSmolar, xkey, ykey, xkey, ykey));
+        d2smolardxdy.set(i, j, AS->second_partial_deriv(iSmolar, xkey, ykey, ykey, xkey));
+        d2smolardy2.set(i, j, AS->second_partial_deriv(iSmolar, ykey, xkey, ykey, xkey));
+        d2umolardx2.set(i, j, AS->second_partial_deriv(iUmolar, xkey, ykey, xkey, ykey));
+        d2umolardxdy.set(i, j, AS->second_partial_deriv(iUmolar, xkey, ykey, ykey, xkey));
+        d2umolardy2.set(i, j, AS->second_partial_deriv(iUmolar, ykey, xkey, ykey, xkey));
     }
 }
 std::string CoolProp::TabularBackend::path_to_tables(void){
-    std::vector<std::string> fluids = AS->fluid_names();
-    std::vector<CoolPropDbl> fractions = AS->get_mole_fractions();
-    std::vector<std::string> components;
-    for (std::size_t i = 0; i < fluids.size(); ++i){
-        components.push_back(format("%s[%0.10Lf]", fluids[i].c_str(), fractions[i]));
-    }
-    std::string table_directory = get_home_dir() + "/.CoolProp/Tables/";
-    std::string alt_table_directory = get_config_string(ALTERNATIVE_TABLES_DIRECTORY);
-    if (!alt_table_directory.empty()){
-        table_directory = alt_table_directory;
-    }
-    return table_directory + AS->backend_name() + "(" + strjoin(components, "&") + ")";
+    return library.path_to_tables(this->AS, spec);
 }
 
 void CoolProp::TabularBackend::write_tables(){
     std::string path_to_tables = this->path_to_tables();
     make_dirs(path_to_tables);
-    bool loaded = false;
-    dataset = library.get_set_of_tables(this->AS, loaded);
     PackablePhaseEnvelopeData & phase_envelope = dataset->phase_envelope;
     PureFluidSaturationTableData &pure_saturation = dataset->pure_saturation;
     SinglePhaseGriddedTableData &single_phase_logph = dataset->single_phase_logph;
@@ -360,14 +663,32 @@ void CoolProp::TabularBackend::write_tables(){
     write_table(single_phase_logpT, path_to_tables, "single_phase_logpT");
     write_table(pure_saturation, path_to_tables, "pure_saturation");
     write_table(phase_envelope, path_to_tables, "phase_envelope");
+    if (get_config_bool(USE_FLAT_TABLES)){
+        dataset->write_flat_tables(path_to_tables);
+    }
 }
-void CoolProp::TabularBackend::load_tables(){
-    bool loaded = false;
-    dataset = library.get_set_of_tables(this->AS, loaded); 
-    if (loaded == false){
-        throw UnableToLoadError("Could not load tables");
+void CoolProp::TabularBackend::check_tables(){
+    if (!tables_loaded){
+        dataset = library.get_set_of_tables(*this);
+        // Set the flag saying tables have been successfully loaded
+        tables_loaded = true;
     }
-    if (get_debug_level() > 0){ std::cout << "Tables loaded" << std::endl; }
+}
+void CoolProp::TabularBackend::build_and_write_tables(){
+    /// Make room for the new tables, and check directory size
+    double directory_size_in_GB = library.enforce_disk_limit()/POW3(1024.0);
+    double allowed_size_in_GB = get_config_double(MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB);
+    if (get_debug_level() > 0){std::cout << "Tabular directory size is " << directory_size_in_GB << " GB\n";}
+    if (directory_size_in_GB > 1.5*allowed_size_in_GB){
+        throw DirectorySizeError(format("Maximum allowed tabular directory size is %g GB, you have exceeded 1.5 times this limit", allowed_size_in_GB));
+    }
+    else if (directory_size_in_GB > allowed_size_in_GB){
+        set_warning_string(format("Maximum allowed tabular directory size is %g GB, you have exceeded this limit", allowed_size_in_GB));
+    }
+    /// If you cannot load the tables, build them and then write them to file
+    dataset->build_tables(this->AS);
+    pack_matrices();
+    write_tables();
 }
 
 CoolPropDbl CoolProp::TabularBackend::calc_saturated_vapor_keyed_output(parameters key){
@@ -416,6 +737,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_T(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar(iT, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return _T;
+        case SELECTED_DU_TABLE: return evaluate_single_phase_Du(iT, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -441,6 +763,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_rhomolar(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar(iDmolar, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT(iDmolar, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return _rhomolar;
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -461,6 +784,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_hmolar(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return _hmolar;
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT(iHmolar, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return evaluate_single_phase_Du(iHmolar, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -481,6 +805,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_smolar(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar(iSmolar, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT(iSmolar, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return evaluate_single_phase_Du(iSmolar, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -501,6 +826,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_umolar(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar(iUmolar, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT(iUmolar, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return _umolar;
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -555,6 +881,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_viscosity(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar_transport(iviscosity, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT_transport(iviscosity, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return evaluate_single_phase_Du_transport(iviscosity, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -575,6 +902,7 @@ CoolPropDbl CoolProp::TabularBackend::calc_conductivity(void){
         switch (selected_table){
         case SELECTED_PH_TABLE: return evaluate_single_phase_phmolar_transport(iconductivity, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_PT_TABLE: return evaluate_single_phase_pT_transport(iconductivity, cached_single_phase_i, cached_single_phase_j);
+        case SELECTED_DU_TABLE: return evaluate_single_phase_Du_transport(iconductivity, cached_single_phase_i, cached_single_phase_j);
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         return _HUGE; // not needed, will never be hit, just to make compiler happy
@@ -632,6 +960,15 @@ CoolPropDbl CoolProp::TabularBackend::calc_first_partial_deriv(parameters Of, pa
             dConstant_dy = evaluate_single_phase_pT_derivative(Constant, cached_single_phase_i, cached_single_phase_j, 0, 1);
             break;
         }
+        case SELECTED_DU_TABLE:{
+            dOf_dx = evaluate_single_phase_Du_derivative(Of, cached_single_phase_i, cached_single_phase_j, 1, 0);
+            dOf_dy = evaluate_single_phase_Du_derivative(Of, cached_single_phase_i, cached_single_phase_j, 0, 1);
+            dWrt_dx = evaluate_single_phase_Du_derivative(Wrt, cached_single_phase_i, cached_single_phase_j, 1, 0);
+            dWrt_dy = evaluate_single_phase_Du_derivative(Wrt, cached_single_phase_i, cached_single_phase_j, 0, 1);
+            dConstant_dx = evaluate_single_phase_Du_derivative(Constant, cached_single_phase_i, cached_single_phase_j, 1, 0);
+            dConstant_dy = evaluate_single_phase_Du_derivative(Constant, cached_single_phase_i, cached_single_phase_j, 0, 1);
+            break;
+        }
         case SELECTED_NO_TABLE: throw ValueError("table not selected");
         }
         double val = (dOf_dx*dConstant_dy-dOf_dy*dConstant_dx)/(dWrt_dx*dConstant_dy-dWrt_dy*dConstant_dx);
@@ -879,7 +1216,7 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
             //   - There's no speed increase to be gained by imposing two phase.
             if ((imposed_phase_index == iphase_not_imposed) || (imposed_phase_index == iphase_twophase)) {
                 if (is_mixture){
-                    is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, iHmolar, _hmolar, iclosest, closest_state);
+                    is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, iHmolar, _hmolar, iclosest, closest_state, &dataset->phase_envelope_p_index);
                 }
                 else{
                     is_two_phase = pure_saturation.is_inside(iP, _p, iHmolar, _hmolar, iL, iV, hL, hV);
@@ -927,7 +1264,7 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
             }
             else{
                 if (is_mixture){
-                    is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, iT, _T, iclosest, closest_state);
+                    is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, iT, _T, iclosest, closest_state, &dataset->phase_envelope_p_index);
                 }
                 else{
                     is_two_phase = pure_saturation.is_inside(iP, _p, iT, _T, iL, iV, TL, TV);
@@ -1044,7 +1381,7 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
         //   - There's no speed increase to be gained by imposing two phase.
         if ((imposed_phase_index == iphase_not_imposed) || (imposed_phase_index == iphase_twophase)) {
             if (is_mixture){
-                is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, otherkey, otherval, iclosest, closest_state);
+                is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iP, _p, otherkey, otherval, iclosest, closest_state, &dataset->phase_envelope_p_index);
                 if (is_two_phase){
                     std::vector<std::pair<std::size_t, std::size_t> > intersect = PhaseEnvelopeRoutines::find_intersections(phase_envelope, iP, _p);
                     if (intersect.size() < 2){ throw ValueError(format("p [%g Pa] is not within phase envelope", _p)); }
@@ -1106,7 +1443,7 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
         //   - There's no speed increase to be gained by imposing two phase.
         if ((imposed_phase_index == iphase_not_imposed) || (imposed_phase_index == iphase_twophase)) {
             if (is_mixture){
-                is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iT, _T, otherkey, otherval, iclosest, closest_state);
+                is_two_phase = PhaseEnvelopeRoutines::is_inside(phase_envelope, iT, _T, otherkey, otherval, iclosest, closest_state, &dataset->phase_envelope_T_index);
                 if (is_two_phase){
                     std::vector<std::pair<std::size_t, std::size_t> > intersect = PhaseEnvelopeRoutines::find_intersections(phase_envelope, iT, _T);
                     if (intersect.size() < 2){ throw ValueError(format("T [%g K] is not within phase envelope", _T)); }
@@ -1155,6 +1492,42 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
         }
         break;
     }
+    case DmolarUmolar_INPUTS:{
+        _rhomolar = val1; _umolar = val2;
+        if (is_mixture){
+            throw ValueError("DmolarUmolar inputs are not supported for mixtures in the Tabular backends");
+        }
+        if (!dataset->Du_table_loaded){ dataset->load_or_build_Du_table(path_to_tables(), AS); }
+        SinglePhaseGriddedTableData &single_phase_logDu = dataset->single_phase_logDu;
+        if (!single_phase_logDu.native_inputs_are_in_range(_umolar, _rhomolar)){
+            using_single_phase_table = false;
+            throw ValueError(format("inputs are not in range, rhomolar=%Lg, umolar=%Lg", static_cast<CoolPropDbl>(_rhomolar), static_cast<CoolPropDbl>(_umolar)));
+        }
+        std::size_t iL = 0, iV = 0;
+        CoolPropDbl p_sat = _HUGE, Q = _HUGE;
+        bool is_two_phase = false;
+        // As for HmolarP inputs, an imposed single phase skips the search of the saturation table
+        if ((imposed_phase_index == iphase_not_imposed) || (imposed_phase_index == iphase_twophase)){
+            is_two_phase = pure_saturation.is_inside_Du(_rhomolar, _umolar, p_sat, Q, iL, iV);
+        }
+        if (is_two_phase){
+            using_single_phase_table = false;
+            _p = p_sat; _Q = Q;
+            cached_saturation_iL = iL; cached_saturation_iV = iV;
+            _phase = iphase_twophase;
+        }
+        else{
+            using_single_phase_table = true;
+            selected_table = SELECTED_DU_TABLE;
+            // Find and cache the indices i, j
+            find_native_nearest_good_indices(single_phase_logDu, dataset->coeffs_Du, _umolar, _rhomolar, cached_single_phase_i, cached_single_phase_j);
+            // The pressure is not an input, but it is returned directly by calc_p
+            evaluate_single_phase_Du(iP, cached_single_phase_i, cached_single_phase_j);
+            // Recalculate the phase
+            recalculate_singlephase_phase();
+        }
+        break;
+    }
     case PQ_INPUTS:{
         std::size_t iL = 0, iV = 0;
         _p = val1; _Q = val2;
@@ -1212,6 +1585,106 @@ void CoolProp::TabularBackend::update(CoolProp::input_pairs input_pair, double v
     }
 }
 
+CoolProp::TableSpecification::TableSpecification(const std::string &spec)
+{
+    *this = TableSpecification();
+    std::vector<std::string> items = strsplit(spec, ',');
+    for (std::size_t k = 0; k < items.size(); ++k){
+        std::string item = items[k];
+        if (strstrip(item).empty()){ continue; }
+        std::size_t iequal = item.find('=');
+        if (iequal == std::string::npos){
+            throw ValueError(format("Table specification [%s] is not of the form key=value", item.c_str()));
+        }
+        std::string key = item.substr(0, iequal), value = item.substr(iequal + 1);
+        strstrip(key); strstrip(value);
+        double val = string2double(value);
+        if (key == "Nx" || key == "Ny" || key == "Nsat"){
+            std::size_t Nmin = (key == "Nsat") ? 3 : 2;
+            if (val < Nmin || val != static_cast<double>(static_cast<std::size_t>(val))){
+                throw ValueError(format("%s must be an integer of at least %d, not %s", key.c_str(), static_cast<int>(Nmin), value.c_str()));
+            }
+            std::size_t N = static_cast<std::size_t>(val);
+            if (key == "Nx"){ Nx = N; } else if (key == "Ny"){ Ny = N; } else{ Nsat = N; }
+        }
+        else if (key == "pmin"){ pmin = val; }
+        else if (key == "pmax"){ pmax = val; }
+        else if (key == "hmin"){ hmin = val; }
+        else if (key == "hmax"){ hmax = val; }
+        else if (key == "Tmin"){ Tmin = val; }
+        else if (key == "Tmax"){ Tmax = val; }
+        else if (key == "tol"){
+            if (val < 0){ throw ValueError(format("tol cannot be negative: %s", value.c_str())); }
+            grid_tolerance = val;
+        }
+        else if (key == "transport"){
+            if (val != 0 && val != 1){ throw ValueError(format("transport must be 0 or 1, not %s", value.c_str())); }
+            transport = (val == 1);
+        }
+        else{
+            throw ValueError(format("Table specification key [%s] is not valid; valid keys are Nx, Ny, Nsat, pmin, pmax, hmin, hmax, Tmin, Tmax, tol and transport", key.c_str()));
+        }
+    }
+    if (pmin != _HUGE && pmax != _HUGE && pmin >= pmax){ throw ValueError(format("pmin [%g] must be less than pmax [%g]", pmin, pmax)); }
+    if (hmin != _HUGE && hmax != _HUGE && hmin >= hmax){ throw ValueError(format("hmin [%g] must be less than hmax [%g]", hmin, hmax)); }
+    if (Tmin != _HUGE && Tmax != _HUGE && Tmin >= Tmax){ throw ValueError(format("Tmin [%g] must be less than Tmax [%g]", Tmin, Tmax)); }
+    if ((pmin != _HUGE && pmin <= 0) || (pmax != _HUGE && pmax <= 0)){ throw ValueError("The pressures of the table must be positive"); }
+}
+double CoolProp::TableSpecification::get_grid_tolerance() const
+{
+    return (grid_tolerance < 0) ? get_config_double(TABULAR_GRID_TOLERANCE) : grid_tolerance;
+}
+std::string CoolProp::TableSpecification::to_string() const
+{
+    // Always in the same order and with all the digits, so that the same tables always have the same path
+    std::vector<std::string> items;
+    if (Nx > 0){ items.push_back(format("Nx=%d", Nx)); }
+    if (Ny > 0){ items.push_back(format("Ny=%d", Ny)); }
+    if (Nsat > 0){ items.push_back(format("Nsat=%d", Nsat)); }
+    if (pmin != _HUGE){ items.push_back(format("pmin=%0.17g", pmin)); }
+    if (pmax != _HUGE){ items.push_back(format("pmax=%0.17g", pmax)); }
+    if (hmin != _HUGE){ items.push_back(format("hmin=%0.17g", hmin)); }
+    if (hmax != _HUGE){ items.push_back(format("hmax=%0.17g", hmax)); }
+    if (Tmin != _HUGE){ items.push_back(format("Tmin=%0.17g", Tmin)); }
+    if (Tmax != _HUGE){ items.push_back(format("Tmax=%0.17g", Tmax)); }
+    // Tables with evenly spaced knots are the default ones, whatever the way the tolerance was set
+    if (get_grid_tolerance() > 0){ items.push_back(format("tol=%0.17g", get_grid_tolerance())); }
+    if (!transport){ items.push_back("transport=0"); }
+    return strjoin(items, ",");
+}
+void CoolProp::TableSpecification::apply(SinglePhaseGriddedTableData &table, AbstractState &AS) const
+{
+    if (Nx > 0){ table.Nx = Nx; }
+    if (Ny > 0){ table.Ny = Ny; }
+    table.grid_tolerance = get_grid_tolerance();
+    table.store_transport = transport;
+    for (int axis = 0; axis < 2; ++axis){
+        parameters key = (axis == 0) ? table.xkey : table.ykey;
+        double &axis_min = (axis == 0) ? table.xmin : table.ymin, &axis_max = (axis == 0) ? table.xmax : table.ymax;
+        double lower = _HUGE, upper = _HUGE;
+        switch (key){
+            case iP: lower = pmin; upper = pmax; break;
+            // The tables are molar, the enthalpies are given per unit mass
+            case iHmolar:
+                if (hmin != _HUGE){ lower = hmin*AS.molar_mass(); }
+                if (hmax != _HUGE){ upper = hmax*AS.molar_mass(); }
+                break;
+            case iT: lower = Tmin; upper = Tmax; break;
+            default: break;
+        }
+        if (lower != _HUGE){ axis_min = lower; }
+        if (upper != _HUGE){ axis_max = upper; }
+        if (axis_min >= axis_max){
+            throw ValueError(format("The range [%g,%g] of %s of the table is empty", axis_min, axis_max, get_parameter_information(key, "short").c_str()));
+        }
+    }
+}
+void CoolProp::TableSpecification::apply(PureFluidSaturationTableData &table) const
+{
+    if (Nsat > 0){ table.N = Nsat; }
+    table.store_transport = transport;
+}
+
 void CoolProp::TabularDataSet::write_tables(const std::string &path_to_tables)
 {
     make_dirs(path_to_tables);
@@ -1219,6 +1692,9 @@ void CoolProp::TabularDataSet::write_tables(const std::string &path_to_tables)
     write_table(single_phase_logpT, path_to_tables, "single_phase_logpT");
     write_table(pure_saturation, path_to_tables, "pure_saturation");
     write_table(phase_envelope, path_to_tables, "phase_envelope");
+    if (get_config_bool(USE_FLAT_TABLES)){
+        write_flat_tables(path_to_tables);
+    }
 }
 
 void CoolProp::TabularDataSet::load_tables(const std::string &path_to_tables, shared_ptr<CoolProp::AbstractState> &AS)
@@ -1228,14 +1704,85 @@ void CoolProp::TabularDataSet::load_tables(const std::string &path_to_tables, sh
     pure_saturation.AS = AS;
     single_phase_logph.set_limits();
     single_phase_logpT.set_limits();
+    spec.apply(single_phase_logph, *AS);
+    spec.apply(single_phase_logpT, *AS);
+    spec.apply(pure_saturation);
+    if (get_config_bool(USE_FLAT_TABLES)){
+        try{
+            load_flat_tables(path_to_tables);
+            if (get_debug_level() > 0){ std::cout << "Tables loaded" << std::endl; }
+            return;
+        }
+        catch(std::exception &e){
+            // Use the compressed tables instead
+            if (get_debug_level() > 0){ std::cout << format("Unable to load flat tables: %s", e.what()) << std::endl; }
+            coeffs_ph.clear(); coeffs_pT.clear();
+        }
+    }
     load_table(single_phase_logph, path_to_tables, "single_phase_logph.bin.z");
     load_table(single_phase_logpT, path_to_tables, "single_phase_logpT.bin.z");
     load_table(pure_saturation, path_to_tables, "pure_saturation.bin.z");
     load_table(phase_envelope, path_to_tables, "phase_envelope.bin.z");
-    tables_loaded = true;
     if (get_debug_level() > 0){ std::cout << "Tables loaded" << std::endl; }
+    if (get_config_bool(USE_FLAT_TABLES)){
+        // The compressed tables were written by a version that did not write the flat tables, or the flat tables
+        // are out of date; write them so that they are used the next time
+        try{
+            write_flat_tables(path_to_tables);
+        }
+        catch(std::exception &e){
+            if (get_debug_level() > 0){ std::cout << format("Unable to write flat tables: %s", e.what()) << std::endl; }
+        }
+    }
 };
 
+void CoolProp::TabularDataSet::write_flat_tables(const std::string &path_to_tables)
+{
+    make_dirs(path_to_tables);
+    // The coefficients are stored with the tables so that they do not need to be calculated when the tables are loaded
+    build_coeffs(single_phase_logph, coeffs_ph);
+    build_coeffs(single_phase_logpT, coeffs_pT);
+    write_flat_table(single_phase_logph, coeffs_ph, path_to_tables + "/single_phase_logph.flat");
+    write_flat_table(single_phase_logpT, coeffs_pT, path_to_tables + "/single_phase_logpT.flat");
+    pure_saturation.write_flat(path_to_tables + "/pure_saturation.flat");
+    phase_envelope.write_flat(path_to_tables + "/phase_envelope.flat");
+}
+
+void CoolProp::TabularDataSet::load_flat_tables(const std::string &path_to_tables)
+{
+    double tic = clock();
+    load_flat_table(single_phase_logph, coeffs_ph, path_to_tables + "/single_phase_logph.flat");
+    load_flat_table(single_phase_logpT, coeffs_pT, path_to_tables + "/single_phase_logpT.flat");
+    pure_saturation.load_flat(FlatTableReader(path_to_tables + "/pure_saturation.flat"));
+    phase_envelope.load_flat(FlatTableReader(path_to_tables + "/phase_envelope.flat"));
+    double toc = clock();
+    if (get_debug_level() > 0){ std::cout << format("Loaded flat tables from %s in %g sec.", path_to_tables.c_str(), (toc-tic)/CLOCKS_PER_SEC) << std::endl; }
+}
+
+void CoolProp::TabularDataSet::write_flat_table(SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, const std::string &path)
+{
+    FlatTableWriter writer(table.revision, table.Nx, table.Ny, table.xmin, table.xmax, table.ymin, table.ymax);
+    table.write_flat(writer);
+    if (!coeffs.empty()){
+        writer.add("coeffs", coeffs.records);
+    }
+    writer.write(path);
+}
+
+void CoolProp::TabularDataSet::load_flat_table(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs, const std::string &path)
+{
+    FlatTableReader reader(path);
+    table.load_flat(reader);
+    coeffs.clear();
+    // Without the coefficients, they will be calculated by build_coeffs
+    if (!reader.has("coeffs")){ return; }
+
+    CellCoeffsMatrix temp;
+    temp.set_layout(table.Nx - 1, table.Ny - 1, table.xkey, table.ykey); // One fewer cells than nodes
+    temp.records.map(reader, "coeffs", temp.Nx*temp.Ny, CellCoeffsMatrix::record_size);
+    coeffs = temp;
+}
+
 void CoolProp::TabularDataSet::build_tables(shared_ptr<CoolProp::AbstractState> &AS)
 {
     // Pure or pseudo-pure fluid
@@ -1254,148 +1801,456 @@ void CoolProp::TabularDataSet::build_tables(shared_ptr<CoolProp::AbstractState>
     }
     single_phase_logph.build(AS);
     single_phase_logpT.build(AS);
-    tables_loaded = true;
 }
 
-/// Return the set of tabular datasets
-CoolProp::TabularDataSet * CoolProp::TabularDataLibrary::get_set_of_tables(shared_ptr<AbstractState> &AS, bool &loaded)
+void CoolProp::TabularDataSet::load_or_build_Du_table(const std::string &path_to_tables, shared_ptr<CoolProp::AbstractState> &AS)
 {
-    const std::string path = path_to_tables(AS);
-    // Try to find tabular set if it is already loaded
-    std::map<std::string, TabularDataSet>::iterator it = data.find(path);
-    // It is already in the map, return it
-    if (it != data.end()){
-        loaded = it->second.tables_loaded;
-        return &(it->second);
-    }
-    // It is not in the map, build it
-    else{
-        TabularDataSet set;
-        data.insert(std::pair<std::string, TabularDataSet>(path, set));
-        TabularDataSet &dataset = data[path];
+    std::lock_guard<std::mutex> lock(Du_mutex);
+    if (Du_table_loaded){ return; } // Loaded or built by another thread in the meantime
+    single_phase_logDu.AS = AS;
+    single_phase_logDu.set_limits();
+    spec.apply(single_phase_logDu, *AS);
+    bool loaded = false, flat_loaded = false;
+    if (get_config_bool(USE_FLAT_TABLES)){
         try{
-            if (!dataset.tables_loaded){
-                dataset.load_tables(path, AS);
-            }
+            load_flat_table(single_phase_logDu, coeffs_Du, path_to_tables + "/single_phase_logDu.flat");
+            loaded = true; flat_loaded = true;
+        }
+        catch(std::exception &e){
+            if (get_debug_level() > 0){ std::cout << format("Unable to load flat DU table: %s", e.what()) << std::endl; }
+            coeffs_Du.clear();
+        }
+    }
+    if (!loaded){
+        try{
+            load_table(single_phase_logDu, path_to_tables, "single_phase_logDu.bin.z");
             loaded = true;
         }
-        catch (std::exception &){
-            loaded = false;
+        catch(std::exception &e){
+            if (get_debug_level() > 0){ std::cout << format("DU table loading failed with error: %s\n", e.what()); }
+        }
+    }
+    if (!loaded){
+        single_phase_logDu.build(AS);
+        single_phase_logDu.pack();
+        write_table(single_phase_logDu, path_to_tables, "single_phase_logDu");
+    }
+    build_coeffs(single_phase_logDu, coeffs_Du);
+    if (get_config_bool(USE_FLAT_TABLES) && !flat_loaded){
+        try{
+            write_flat_table(single_phase_logDu, coeffs_Du, path_to_tables + "/single_phase_logDu.flat");
+        }
+        catch(std::exception &e){
+            if (get_debug_level() > 0){ std::cout << format("Unable to write flat DU table: %s", e.what()) << std::endl; }
         }
-        return &(dataset);
     }
+    Du_table_loaded = true;
 }
 
-void CoolProp::TabularDataSet::build_coeffs(SinglePhaseGriddedTableData &table, std::vector<std::vector<CellCoeffs> > &coeffs)
+/// Return the set of tabular datasets
+shared_ptr<CoolProp::TabularDataSet> CoolProp::TabularDataLibrary::get_set_of_tables(TabularBackend &backend)
 {
-    if (!coeffs.empty()){ return; }
-    const bool debug = get_debug_level() > 5 || false;
-    const int param_count = 6;
-    parameters param_list[param_count] = { iDmolar, iT, iSmolar, iHmolar, iP, iUmolar };
-    std::vector<std::vector<double> > *f = NULL, *fx = NULL, *fy = NULL, *fxy = NULL;
+    const std::string path = backend.path_to_tables();
+    shared_ptr<TabularDataSet> dataset;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_used[path] = ++requests;
+        // Try to find tabular set if it is already loaded, otherwise add an empty one that is loaded below
+        std::map<std::string, shared_ptr<TabularDataSet> >::iterator it = data.find(path);
+        if (it != data.end()){
+            dataset = it->second;
+        }
+        else{
+            dataset.reset(new TabularDataSet());
+            dataset->spec = backend.spec;
+            data[path] = dataset;
+        }
+    }
+    if (dataset->tables_loaded){ return dataset; }
 
-    clock_t t1 = clock();
+    // Only the threads that request this set wait here; if a build fails, the next request tries again
+    {
+        std::lock_guard<std::mutex> build_lock(dataset->build_mutex);
+        if (dataset->tables_loaded){ return dataset; } // Loaded or built by another thread in the meantime
+        try{
+            dataset->load_tables(path, backend.AS);
+            // Record when the tables were last used, for the eviction of the least recently used tables from disk
+            std::ofstream((path + "/last_used").c_str());
+        }
+        catch(std::exception &e){
+            if (get_debug_level() > 0){ std::cout << format("Table loading failed with error: %s\n", e.what()); }
+            backend.dataset = dataset;
+            backend.build_and_write_tables();
+        }
+        // The coefficients are only calculated if they were not loaded with the tables
+        dataset->build_coeffs(dataset->single_phase_logph, dataset->coeffs_ph);
+        dataset->build_coeffs(dataset->single_phase_logpT, dataset->coeffs_pT);
+        dataset->build_indices();
+        dataset->tables_loaded = true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    enforce_memory_limit();
+    return dataset;
+}
 
-    // Resize the coefficient structures
-    coeffs.resize(table.Nx - 1, std::vector<CellCoeffs>(table.Ny - 1));
+namespace CoolProp{
 
-    int valid_cell_count = 0;
-    for (std::size_t k = 0; k < param_count; ++k){
-        parameters param = param_list[k];
-        if (param == table.xkey || param == table.ykey){ continue; } // Skip tables that match either of the input variables
+static std::size_t owned_size(const TableMatrix &m){ return m.is_mapped() ? 0 : m.rows()*m.cols()*sizeof(double); }
+static std::size_t packed_size(const std::map<std::string, std::vector<std::vector<double> > > &matrices){
+    std::size_t size = 0;
+    for (std::map<std::string, std::vector<std::vector<double> > >::const_iterator it = matrices.begin(); it != matrices.end(); ++it){
+        for (std::size_t i = 0; i < it->second.size(); ++i){ size += it->second[i].size()*sizeof(double); }
+    }
+    return size;
+}
+static unsigned long long directory_size(const std::string &path){
+    #if defined(__ISWINDOWS__)
+        return CalculateDirSize(std::wstring(path.begin(), path.end()));
+    #else
+        return CalculateDirSize(path);
+    #endif
+}
+/// The time the tables in a directory were last loaded or written
+static double table_last_used(const std::string &path){
+    return std::max(get_modification_time(path + "/last_used"), get_modification_time(path));
+}
+/// Only the directories that contain tables are ever removed, ALTERNATIVE_TABLES_DIRECTORY can also contain other files
+static bool is_table_directory(const std::string &path){
+    return path_exists(path + "/single_phase_logph.bin.z") || path_exists(path + "/pure_saturation.bin.z");
+}
 
-        switch (param){
-        case iT:
-            f = &(table.T); fx = &(table.dTdx); fy = &(table.dTdy); fxy = &(table.d2Tdxdy);
-            break;
-        case iP:
-            f = &(table.p); fx = &(table.dpdx); fy = &(table.dpdy); fxy = &(table.d2pdxdy);
-            break;
-        case iDmolar:
-            f = &(table.rhomolar); fx = &(table.drhomolardx); fy = &(table.drhomolardy); fxy = &(table.d2rhomolardxdy);
-            break;
-        case iSmolar:
-            f = &(table.smolar); fx = &(table.dsmolardx); fy = &(table.dsmolardy); fxy = &(table.d2smolardxdy);
-            break;
-        case iHmolar:
-            f = &(table.hmolar); fx = &(table.dhmolardx); fy = &(table.dhmolardy); fxy = &(table.d2hmolardxdy);
-            break;
-        case iUmolar:
-            f = &(table.umolar); fx = &(table.dumolardx); fy = &(table.dumolardy); fxy = &(table.d2umolardxdy);
-            break;
-        default:
-            throw ValueError("Invalid variable type to build_coeffs");
+} // namespace CoolProp
+
+std::size_t CoolProp::TabularDataSet::memory_size() const
+{
+    std::size_t size = owned_size(coeffs_ph.records) + owned_size(coeffs_pT.records);
+    size += packed_size(single_phase_logph.matrices) + packed_size(single_phase_logpT.matrices);
+    /* Use X macros to auto-generate the code; each will look something like: size += owned_size(single_phase_logph.T) + owned_size(single_phase_logpT.T); */
+    #define X(name) size += owned_size(single_phase_logph.name) + owned_size(single_phase_logpT.name);
+    LIST_OF_MATRICES
+    #undef X
+    // The DU table can be being built in another thread until it is loaded
+    if (Du_table_loaded){
+        size += owned_size(coeffs_Du.records) + packed_size(single_phase_logDu.matrices);
+        #define X(name) size += owned_size(single_phase_logDu.name);
+        LIST_OF_MATRICES
+        #undef X
+    }
+    for (std::map<std::string, std::vector<double> >::const_iterator it = pure_saturation.vectors.begin(); it != pure_saturation.vectors.end(); ++it){
+        size += it->second.size()*sizeof(double);
+    }
+    /* Use X macros to auto-generate the code; each will look something like: size += pure_saturation.TL.size()*sizeof(double); */
+    #define X(name) size += pure_saturation.name.size()*sizeof(double);
+    LIST_OF_SATURATION_VECTORS
+    #undef X
+    return size;
+}
+
+std::vector<CoolProp::TabularDataSetInfo> CoolProp::TabularDataLibrary::list()
+{
+    std::map<std::string, TabularDataSetInfo> sets;
+    std::set<std::string> pinned_sets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::map<std::string, shared_ptr<TabularDataSet> >::iterator it = data.begin(); it != data.end(); ++it){
+            TabularDataSetInfo &info = sets[it->first];
+            info.in_memory = true;
+            info.in_use = it->second.use_count() > 1; // The library holds one reference, the backends the other ones
+            // The tables of a set that is being built are still changing
+            info.memory_size = it->second->tables_loaded ? it->second->memory_size() : 0;
+        }
+        pinned_sets = pinned;
+    }
+    // The directory is read without holding the lock
+    const std::string directory = table_directory();
+    std::vector<std::string> names = get_subdirectories(directory);
+    for (std::size_t k = 0; k < names.size(); ++k){
+        const std::string path = directory + names[k];
+        if (!is_table_directory(path)){ continue; }
+        TabularDataSetInfo &info = sets[path];
+        info.on_disk = true;
+        info.disk_size = directory_size(path);
+        info.last_used = table_last_used(path);
+    }
+    std::vector<TabularDataSetInfo> infos;
+    for (std::map<std::string, TabularDataSetInfo>::iterator it = sets.begin(); it != sets.end(); ++it){
+        it->second.path = it->first;
+        it->second.pinned = (pinned_sets.find(it->first) != pinned_sets.end());
+        infos.push_back(it->second);
+    }
+    return infos;
+}
+
+void CoolProp::TabularDataLibrary::pin(const std::string &path, bool pin)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pin){ pinned.insert(path); } else{ pinned.erase(path); }
+}
+
+void CoolProp::TabularDataLibrary::evict(const std::string &path, bool from_disk)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pinned.find(path) != pinned.end()){
+            throw ValueError(format("The tables in %s are pinned, unpin them before evicting them", path.c_str()));
+        }
+        data.erase(path);
+        last_used.erase(path);
+    }
+    if (from_disk && path_exists(path)){
+        // Never remove anything else than the tables
+        const std::string directory = table_directory();
+        std::vector<std::string> names = get_subdirectories(directory);
+        bool is_set = path.find(directory) == 0 && std::find(names.begin(), names.end(), path.substr(directory.size())) != names.end();
+        if (!is_set || !is_table_directory(path)){
+            throw ValueError(format("%s is not a directory of tables in %s", path.c_str(), directory.c_str()));
+        }
+        remove_dirs(path);
+    }
+}
+
+void CoolProp::TabularDataLibrary::enforce_memory_limit()
+{
+    double allowed_size = get_config_double(MAXIMUM_TABLE_MEMORY_IN_GB)*POW3(1024.0);
+    if (allowed_size <= 0){ return; }
+    double total_size = 0;
+    std::vector<std::pair<unsigned long long, std::string> > candidates;
+    for (std::map<std::string, shared_ptr<TabularDataSet> >::iterator it = data.begin(); it != data.end(); ++it){
+        // A set that is being built is in use
+        if (!it->second->tables_loaded){ continue; }
+        total_size += it->second->memory_size();
+        // Evicting a set that a backend uses would not free its memory
+        if (pinned.find(it->first) == pinned.end() && it->second.use_count() == 1){
+            candidates.push_back(std::make_pair(last_used[it->first], it->first));
+        }
+    }
+    // Least recently used first
+    std::sort(candidates.begin(), candidates.end());
+    for (std::size_t k = 0; k < candidates.size() && total_size > allowed_size; ++k){
+        total_size -= data[candidates[k].second]->memory_size();
+        data.erase(candidates[k].second);
+        last_used.erase(candidates[k].second);
+    }
+}
+
+unsigned long long CoolProp::TabularDataLibrary::enforce_disk_limit()
+{
+    double allowed_size = get_config_double(MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB)*POW3(1024.0);
+    const std::string directory = table_directory();
+    unsigned long long total_size = directory_size(directory);
+    if (total_size <= allowed_size){ return total_size; }
+    // The sets of this process are not removed, one of them is being built
+    std::set<std::string> kept;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        kept = pinned;
+        for (std::map<std::string, shared_ptr<TabularDataSet> >::iterator it = data.begin(); it != data.end(); ++it){ kept.insert(it->first); }
+    }
+    std::vector<std::pair<double, std::string> > candidates;
+    std::vector<std::string> names = get_subdirectories(directory);
+    for (std::size_t k = 0; k < names.size(); ++k){
+        const std::string path = directory + names[k];
+        if (is_table_directory(path) && kept.find(path) == kept.end()){
+            candidates.push_back(std::make_pair(table_last_used(path), path));
+        }
+    }
+    // Least recently used first
+    std::sort(candidates.begin(), candidates.end());
+    for (std::size_t k = 0; k < candidates.size() && total_size > allowed_size; ++k){
+        if (get_debug_level() > 0){ std::cout << format("Removing the least recently used tables in %s\n", candidates[k].second.c_str()); }
+        remove_dirs(candidates[k].second);
+        total_size = directory_size(directory);
+    }
+    return total_size;
+}
+
+std::vector<CoolProp::TabularDataSetInfo> CoolProp::list_tabular_data_sets()
+{
+    return library.list();
+}
+std::string CoolProp::preload_tabular_data_set(const std::string &backend, const std::string &fluid_names)
+{
+    shared_ptr<AbstractState> AS(AbstractState::factory(backend, fluid_names));
+    TabularBackend *TB = dynamic_cast<TabularBackend *>(AS.get());
+    if (TB == NULL){
+        throw ValueError(format("Backend [%s] is not a tabular backend", backend.c_str()));
+    }
+    return TB->path_to_tables();
+}
+void CoolProp::pin_tabular_data_set(const std::string &path, bool pin)
+{
+    library.pin(path, pin);
+}
+void CoolProp::evict_tabular_data_set(const std::string &path, bool from_disk)
+{
+    library.evict(path, from_disk);
+}
+
+const std::size_t CoolProp::CellCoeffsMatrix::header_size;
+const std::size_t CoolProp::CellCoeffsMatrix::max_params;
+const std::size_t CoolProp::CellCoeffsMatrix::record_size;
+
+void CoolProp::CellCoeffsMatrix::set_layout(std::size_t Nx, std::size_t Ny, parameters xkey, parameters ykey)
+{
+    const parameters param_list[] = { iT, iP, iDmolar, iHmolar, iSmolar, iUmolar };
+    Nparams = 0;
+    for (std::size_t k = 0; k < sizeof(param_list)/sizeof(param_list[0]); ++k){
+        if (param_list[k] == xkey || param_list[k] == ykey){ continue; } // Skip the parameters that are the input variables
+        if (Nparams == max_params){ throw ValueError("Too many parameters for the bicubic coefficients"); }
+        params[Nparams++] = param_list[k];
+    }
+    this->Nx = Nx; this->Ny = Ny;
+}
+
+void CoolProp::CellCoeffsMatrix::resize(std::size_t Nx, std::size_t Ny, parameters xkey, parameters ykey)
+{
+    set_layout(Nx, Ny, xkey, ykey);
+    records.resize(Nx*Ny, record_size, _HUGE);
+    for (std::size_t i = 0; i < Nx; ++i){
+        for (std::size_t j = 0; j < Ny; ++j){
+            double *record = records.mutable_row(i*Ny + j);
+            record[0] = 0; record[1] = -1; record[2] = -1; record[5] = 0; record[6] = 0; record[7] = 0;
         }
-        for (std::size_t i = 0; i < table.Nx-1; ++i) // -1 since we have one fewer cells than nodes
+    }
+}
+
+namespace CoolProp{
+
+/// Calculates the bicubic coefficients of the cells of a contiguous range of rows of a table
+class BicubicCoeffsRowBuilder{
+public:
+    const SinglePhaseGriddedTableData &table;
+    CellCoeffsMatrix &coeffs;
+    const TableMatrix *f[CellCoeffsMatrix::max_params], *fx[CellCoeffsMatrix::max_params], *fy[CellCoeffsMatrix::max_params], *fxy[CellCoeffsMatrix::max_params];
+    BicubicCoeffsRowBuilder(const SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs) : table(table), coeffs(coeffs)
+    {
+        for (std::size_t k = 0; k < coeffs.Nparams; ++k){
+            switch (coeffs.params[k]){
+            case iT:
+                f[k] = &(table.T); fx[k] = &(table.dTdx); fy[k] = &(table.dTdy); fxy[k] = &(table.d2Tdxdy);
+                break;
+            case iP:
+                f[k] = &(table.p); fx[k] = &(table.dpdx); fy[k] = &(table.dpdy); fxy[k] = &(table.d2pdxdy);
+                break;
+            case iDmolar:
+                f[k] = &(table.rhomolar); fx[k] = &(table.drhomolardx); fy[k] = &(table.drhomolardy); fxy[k] = &(table.d2rhomolardxdy);
+                break;
+            case iSmolar:
+                f[k] = &(table.smolar); fx[k] = &(table.dsmolardx); fy[k] = &(table.dsmolardy); fxy[k] = &(table.d2smolardxdy);
+                break;
+            case iHmolar:
+                f[k] = &(table.hmolar); fx[k] = &(table.dhmolardx); fy[k] = &(table.dhmolardy); fxy[k] = &(table.d2hmolardxdy);
+                break;
+            case iUmolar:
+                f[k] = &(table.umolar); fx[k] = &(table.dumolardx); fy[k] = &(table.dumolardy); fxy[k] = &(table.d2umolardxdy);
+                break;
+            default:
+                throw ValueError("Invalid variable type to build_coeffs");
+            }
+        }
+    };
+    void operator()(std::size_t ithread, std::size_t ibegin, std::size_t iend){
+        for (std::size_t i = ibegin; i < iend; ++i)
         {
-            for (std::size_t j = 0; j < table.Ny-1; ++j) // -1 since we have one fewer cells than nodes
+            for (std::size_t j = 0; j < coeffs.Ny; ++j)
             {
-                if (ValidNumber((*f)[i][j]) && ValidNumber((*f)[i+1][j]) && ValidNumber((*f)[i][j+1]) && ValidNumber((*f)[i+1][j+1])){
-
-                    // This will hold the scaled f values for the cell
-                    Eigen::Matrix<double, 16, 1> F;
-                    // The output values (do not require scaling
-                    F(0) = (*f)[i][j]; F(1) = (*f)[i+1][j]; F(2) = (*f)[i][j+1]; F(3) = (*f)[i+1][j+1];
-                    // Scaling parameter
-                    // d(f)/dxhat = df/dx * dx/dxhat, where xhat = (x-x_i)/(x_{i+1}-x_i)
-                    coeffs[i][j].dx_dxhat = table.xvec[i+1]-table.xvec[i];
-                    double dx_dxhat = coeffs[i][j].dx_dxhat;
-                    F(4) = (*fx)[i][j]*dx_dxhat; F(5) = (*fx)[i+1][j]*dx_dxhat;
-                    F(6) = (*fx)[i][j+1]*dx_dxhat; F(7) = (*fx)[i+1][j+1]*dx_dxhat;
-                    // Scaling parameter
-                    // d(f)/dyhat = df/dy * dy/dyhat, where yhat = (y-y_j)/(y_{j+1}-y_j)
-                    coeffs[i][j].dy_dyhat = table.yvec[j+1]-table.yvec[j];
-                    double dy_dyhat = coeffs[i][j].dy_dyhat;
-                    F(8) = (*fy)[i][j]*dy_dyhat; F(9) = (*fy)[i+1][j]*dy_dyhat;
-                    F(10) = (*fy)[i][j+1]*dy_dyhat; F(11) = (*fy)[i+1][j+1]*dy_dyhat;
-                    // Cross derivatives are doubly scaled following the examples above
-                    F(12) = (*fxy)[i][j]*dy_dyhat*dx_dxhat; F(13) = (*fxy)[i+1][j]*dy_dyhat*dx_dxhat;
-                    F(14) = (*fxy)[i][j+1]*dy_dyhat*dx_dxhat; F(15) = (*fxy)[i+1][j+1]*dy_dyhat*dx_dxhat;
-                    // Calculate the alpha coefficients
-                    Eigen::MatrixXd alpha = Ainv.transpose()*F; // 16x1; Watch out for the transpose!
-                    std::vector<double> valpha = eigen_to_vec1D(alpha);
-                    coeffs[i][j].set(param, valpha);
-                    coeffs[i][j].set_valid();
-                    valid_cell_count++;
-                }
-                else{
-                    coeffs[i][j].set_invalid();
+                // Scaling parameters
+                // d(f)/dxhat = df/dx * dx/dxhat, where xhat = (x-x_i)/(x_{i+1}-x_i)
+                // d(f)/dyhat = df/dy * dy/dyhat, where yhat = (y-y_j)/(y_{j+1}-y_j)
+                double dx_dxhat = table.xvec[i+1]-table.xvec[i];
+                double dy_dyhat = table.yvec[j+1]-table.yvec[j];
+                // The cell is valid if the coefficients of all the parameters could be calculated
+                bool valid = true;
+                for (std::size_t k = 0; k < coeffs.Nparams; ++k){
+                    const TableMatrix &F_ = *(f[k]), &Fx = *(fx[k]), &Fy = *(fy[k]), &Fxy = *(fxy[k]);
+                    if (ValidNumber(F_[i][j]) && ValidNumber(F_[i+1][j]) && ValidNumber(F_[i][j+1]) && ValidNumber(F_[i+1][j+1])){
+
+                        // This will hold the scaled f values for the cell
+                        Eigen::Matrix<double, 16, 1> F;
+                        // The output values (do not require scaling
+                        F(0) = F_[i][j]; F(1) = F_[i+1][j]; F(2) = F_[i][j+1]; F(3) = F_[i+1][j+1];
+                        F(4) = Fx[i][j]*dx_dxhat; F(5) = Fx[i+1][j]*dx_dxhat;
+                        F(6) = Fx[i][j+1]*dx_dxhat; F(7) = Fx[i+1][j+1]*dx_dxhat;
+                        F(8) = Fy[i][j]*dy_dyhat; F(9) = Fy[i+1][j]*dy_dyhat;
+                        F(10) = Fy[i][j+1]*dy_dyhat; F(11) = Fy[i+1][j+1]*dy_dyhat;
+                        // Cross derivatives are doubly scaled following the examples above
+                        F(12) = Fxy[i][j]*dy_dyhat*dx_dxhat; F(13) = Fxy[i+1][j]*dy_dyhat*dx_dxhat;
+                        F(14) = Fxy[i][j+1]*dy_dyhat*dx_dxhat; F(15) = Fxy[i+1][j+1]*dy_dyhat*dx_dxhat;
+                        // Calculate the alpha coefficients
+                        Eigen::MatrixXd alpha = Ainv.transpose()*F; // 16x1; Watch out for the transpose!
+                        coeffs.set(i, j, k, alpha.data());
+                    }
+                    else{
+                        valid = false;
+                    }
                 }
+                coeffs.set_cell(i, j, valid, dx_dxhat, dy_dyhat);
             }
         }
-        double elapsed = (clock() - t1)/((double)CLOCKS_PER_SEC);
-        if (debug){
-            std::cout << format("Calculated bicubic coefficients for %d good cells in %g sec.\n", valid_cell_count, elapsed);
+    }
+};
+
+} // namespace CoolProp
+
+void CoolProp::TabularDataSet::build_indices()
+{
+    pure_saturation.build_index();
+    phase_envelope_p_index.build(phase_envelope.p, true);
+    phase_envelope_T_index.build(phase_envelope.T, false);
+}
+
+void CoolProp::TabularDataSet::build_coeffs(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs)
+{
+    if (!coeffs.empty()){ return; }
+    const bool debug = get_debug_level() > 5 || false;
+
+    clock_t t1 = clock();
+
+    // Resize the coefficient structures; -1 since we have one fewer cells than nodes
+    coeffs.resize(table.Nx - 1, table.Ny - 1, table.xkey, table.ykey);
+
+    // Each cell only depends on the nodes of the table, so the rows of cells can be calculated by several threads
+    BicubicCoeffsRowBuilder builder(table, coeffs);
+    parallel_for_chunks(coeffs.Nx, get_thread_count(get_config_int(TABULAR_BUILD_NUM_THREADS), coeffs.Nx), builder);
+
+    if (debug){
+        int valid_cell_count = 0;
+        for (std::size_t i = 0; i < coeffs.Nx; ++i){
+            for (std::size_t j = 0; j < coeffs.Ny; ++j){
+                if (coeffs(i, j).valid()){ valid_cell_count++; }
+            }
         }
-        std::size_t remap_count = 0;
-        // Now find invalid cells and give them pointers to a neighboring cell that works
-        for (std::size_t i = 0; i < table.Nx-1; ++i) // -1 since we have one fewer cells than nodes
+        double elapsed = (clock() - t1)/((double)CLOCKS_PER_SEC);
+        std::cout << format("Calculated bicubic coefficients for %d good cells in %g sec.\n", valid_cell_count, elapsed);
+    }
+    std::size_t remap_count = 0;
+    // Now find invalid cells and give them pointers to a neighboring cell that works
+    for (std::size_t i = 0; i < coeffs.Nx; ++i)
+    {
+        for (std::size_t j = 0; j < coeffs.Ny; ++j)
         {
-            for (std::size_t j = 0; j < table.Ny-1; ++j) // -1 since we have one fewer cells than nodes
-            {
-                // Not a valid cell
-                if (!coeffs[i][j].valid()){
-                    // Offsets that we are going to try in order (left, right, top, bottom, diagonals)
-                    int xoffsets[] = { -1, 1, 0, 0, -1, 1, 1, -1 };
-                    int yoffsets[] = { 0, 0, 1, -1, -1, -1, 1, 1 };
-                    // Length of offset
-                    std::size_t N = sizeof(xoffsets)/sizeof(xoffsets[0]);
-                    for (std::size_t k = 0; k < N; ++k){
-                        std::size_t iplus = i + xoffsets[k];
-                        std::size_t jplus = j + yoffsets[k];
-                        if (0 < iplus && iplus < table.Nx-1 && 0 < jplus && jplus < table.Ny-1 && coeffs[iplus][jplus].valid()){
-                            coeffs[i][j].set_alternate(iplus, jplus);
-                            remap_count++;
-                            if (debug){ std::cout << format("Mapping %d,%d to %d,%d\n", i, j, iplus, jplus); }
-                            break;
-                        }
+            // Not a valid cell
+            if (!coeffs(i, j).valid()){
+                // Offsets that we are going to try in order (left, right, top, bottom, diagonals)
+                int xoffsets[] = { -1, 1, 0, 0, -1, 1, 1, -1 };
+                int yoffsets[] = { 0, 0, 1, -1, -1, -1, 1, 1 };
+                // Length of offset
+                std::size_t N = sizeof(xoffsets)/sizeof(xoffsets[0]);
+                for (std::size_t k = 0; k < N; ++k){
+                    std::size_t iplus = i + xoffsets[k];
+                    std::size_t jplus = j + yoffsets[k];
+                    if (0 < iplus && iplus < coeffs.Nx && 0 < jplus && jplus < coeffs.Ny && coeffs(iplus, jplus).valid()){
+                        coeffs.set_alternate(i, j, iplus, jplus);
+                        remap_count++;
+                        if (debug){ std::cout << format("Mapping %d,%d to %d,%d\n", i, j, iplus, jplus); }
+                        break;
                     }
                 }
             }
         }
-        if (debug){
-            std::cout << format("Remapped %d cells\n", remap_count);
-        }
+    }
+    if (debug){
+        std::cout << format("Remapped %d cells\n", remap_count);
     }
 }
 
@@ -1416,6 +2271,87 @@ public:
         if (ASBICUBIC.get() == NULL){ ASBICUBIC.reset(CoolProp::AbstractState::factory("BICUBIC&HEOS", "Water")); }
     }
 };
+TEST_CASE("Table specifications", "[Tabular]")
+{
+    SECTION("parse"){
+        CoolProp::TableSpecification spec(" Nx=400, pmax=30e6,transport=0");
+        CHECK(spec.Nx == 400);
+        CHECK(spec.Ny == 0);
+        CHECK(spec.pmax == 30e6);
+        CHECK(spec.pmin == _HUGE);
+        CHECK(!spec.transport);
+    }
+    SECTION("canonical form does not depend on the order of the keys"){
+        CHECK(CoolProp::TableSpecification("pmax=3e7,Nx=400").to_string() == CoolProp::TableSpecification("Nx=400,pmax=30000000").to_string());
+        CHECK(CoolProp::TableSpecification("").to_string() == CoolProp::TableSpecification().to_string());
+    }
+    SECTION("invalid specifications"){
+        CHECK_THROWS(CoolProp::TableSpecification("Nz=400"));
+        CHECK_THROWS(CoolProp::TableSpecification("Nx=1"));
+        CHECK_THROWS(CoolProp::TableSpecification("Nx=10.5"));
+        CHECK_THROWS(CoolProp::TableSpecification("pmin=2e6,pmax=1e6"));
+        CHECK_THROWS(CoolProp::TableSpecification("pmax"));
+    }
+    SECTION("only for tabular backends"){
+        CHECK_THROWS(CoolProp::AbstractState::factory("HEOS[Nx=10]", "Water"));
+    }
+}
+
+/// Constructs a tabular backend in its own thread
+class TabularBackendConstructor{
+public:
+    std::string backend;
+    shared_ptr<CoolProp::AbstractState> AS;
+    std::string error;
+    TabularBackendConstructor(const std::string &backend) : backend(backend){};
+    void operator()(){
+        try{ AS.reset(CoolProp::AbstractState::factory(backend, "Water")); }
+        catch(std::exception &e){ error = e.what(); }
+    }
+};
+
+TEST_CASE("Concurrent construction of tabular backends", "[Tabular]")
+{
+    // Small tables so that they are quickly built
+    const std::string backends[] = {"BICUBIC&HEOS[Nx=40,Ny=40,Nsat=100]", "TTSE&HEOS[Nx=40,Ny=40,Nsat=100]"};
+    // Remove the tables from memory and disk, so that they are built by the threads
+    std::string path = CoolProp::preload_tabular_data_set(backends[0], "Water");
+    CoolProp::evict_tabular_data_set(path, true);
+    std::vector<TabularBackendConstructor> constructors;
+    for (std::size_t k = 0; k < 8; ++k){ constructors.push_back(TabularBackendConstructor(backends[k % 2])); }
+    std::vector<std::thread> threads;
+    for (std::size_t k = 0; k < constructors.size(); ++k){ threads.push_back(std::thread(std::ref(constructors[k]))); }
+    for (std::size_t k = 0; k < threads.size(); ++k){ threads[k].join(); }
+    for (std::size_t k = 0; k < constructors.size(); ++k){
+        CAPTURE(constructors[k].error);
+        REQUIRE(constructors[k].AS.get() != NULL);
+    }
+    // All the backends share the same tables, which were built or loaded once
+    CoolProp::TabularBackend *first = dynamic_cast<CoolProp::TabularBackend *>(constructors[0].AS.get());
+    for (std::size_t k = 1; k < constructors.size(); ++k){
+        CoolProp::TabularBackend *TB = dynamic_cast<CoolProp::TabularBackend *>(constructors[k].AS.get());
+        CHECK(TB->dataset.get() == first->dataset.get());
+    }
+    CHECK(!first->dataset->coeffs_ph.empty());
+    // The same tables built serially in a fresh dataset
+    CoolProp::evict_tabular_data_set(path, true);
+    int Nthreads = CoolProp::get_config_int(TABULAR_BUILD_NUM_THREADS);
+    CoolProp::set_config_int(TABULAR_BUILD_NUM_THREADS, 1);
+    shared_ptr<CoolProp::AbstractState> serial[2];
+    for (std::size_t k = 0; k < 2; ++k){ serial[k].reset(CoolProp::AbstractState::factory(backends[k], "Water")); }
+    CoolProp::set_config_int(TABULAR_BUILD_NUM_THREADS, Nthreads);
+    CHECK(dynamic_cast<CoolProp::TabularBackend *>(serial[0].get())->dataset.get() != first->dataset.get());
+    // A vapor state, since the cells of the liquid at atmospheric pressure are not valid in such coarse tables
+    for (std::size_t k = 0; k < 2; ++k){ serial[k]->update(CoolProp::HmassP_INPUTS, 3e6, 101325); }
+    for (std::size_t k = 0; k < constructors.size(); ++k){
+        CAPTURE(constructors[k].backend);
+        constructors[k].AS->update(CoolProp::HmassP_INPUTS, 3e6, 101325);
+        // The tables do not depend on the number of threads that built them
+        CHECK(constructors[k].AS->T() == serial[k % 2]->T());
+        CHECK(constructors[k].AS->rhomolar() == serial[k % 2]->rhomolar());
+    }
+}
+
 TEST_CASE_METHOD(TabularFixture, "Tests for tabular backends with water", "[Tabular]")
 {
     SECTION("first_saturation_deriv invalid quality"){
@@ -1585,6 +2521,239 @@ TEST_CASE_METHOD(TabularFixture, "Tests for tabular backends with water", "[Tabu
         CHECK(std::abs((expected-actual_TTSE)/expected) < 1e-2);
         CHECK(std::abs((expected-actual_BICUBIC)/expected) < 1e-2);
     }
+    SECTION("flat table round trip"){
+        setup();
+        CoolProp::TabularBackend *TB = dynamic_cast<CoolProp::TabularBackend*>(ASBICUBIC.get());
+        REQUIRE(TB != NULL);
+        CoolProp::TabularDataSet &dataset = *(TB->dataset);
+        std::string path = TB->path_to_tables() + "/test_single_phase_logph.flat";
+        dataset.write_flat_table(dataset.single_phase_logph, dataset.coeffs_ph, path);
+
+        {
+            CoolProp::TabularDataSet loaded;
+            loaded.single_phase_logph.AS = TB->AS;
+            loaded.single_phase_logph.set_limits();
+            loaded.load_flat_table(loaded.single_phase_logph, loaded.coeffs_ph, path);
+            // The matrices and the coefficients are used in place in the mapped file
+            CHECK(loaded.single_phase_logph.T.is_mapped());
+            CHECK(loaded.coeffs_ph.records.is_mapped());
+            CHECK(loaded.single_phase_logph.T.to_vectors() == dataset.single_phase_logph.T.to_vectors());
+            CHECK(loaded.single_phase_logph.d2smolardxdy.to_vectors() == dataset.single_phase_logph.d2smolardxdy.to_vectors());
+            CHECK(loaded.single_phase_logph.xvec == dataset.single_phase_logph.xvec);
+            REQUIRE(loaded.coeffs_ph.Nx == dataset.coeffs_ph.Nx);
+            REQUIRE(loaded.coeffs_ph.Ny == dataset.coeffs_ph.Ny);
+            CHECK(loaded.coeffs_ph.records.to_vectors() == dataset.coeffs_ph.records.to_vectors());
+            const CoolProp::CellCoeffs cell = loaded.coeffs_ph(dataset.coeffs_ph.Nx/2, dataset.coeffs_ph.Ny/2);
+            CHECK(cell.valid());
+            CHECK(std::equal(cell.get(CoolProp::iT), cell.get(CoolProp::iT) + 16, dataset.coeffs_ph(dataset.coeffs_ph.Nx/2, dataset.coeffs_ph.Ny/2).get(CoolProp::iT)));
+            CHECK_THROWS(cell.get(CoolProp::iHmolar));
+        }
+        std::remove(path.c_str());
+    }
+    SECTION("parallel build does not depend on the number of threads"){
+        setup();
+        int Nthreads = CoolProp::get_config_int(TABULAR_BUILD_NUM_THREADS);
+        CoolProp::LogPHTable serial, parallel;
+        serial.AS = ASHEOS; serial.set_limits(); serial.Nx = 20; serial.Ny = 20;
+        parallel.AS = ASHEOS; parallel.set_limits(); parallel.Nx = 20; parallel.Ny = 20;
+        CoolProp::set_config_int(TABULAR_BUILD_NUM_THREADS, 1);
+        serial.build(ASHEOS);
+        CoolProp::set_config_int(TABULAR_BUILD_NUM_THREADS, 4);
+        parallel.build(ASHEOS);
+        CoolProp::set_config_int(TABULAR_BUILD_NUM_THREADS, Nthreads);
+        CHECK(serial.T.to_vectors() == parallel.T.to_vectors());
+        CHECK(serial.rhomolar.to_vectors() == parallel.rhomolar.to_vectors());
+        CHECK(serial.d2smolardxdy.to_vectors() == parallel.d2smolardxdy.to_vectors());
+        CHECK(serial.visc.to_vectors() == parallel.visc.to_vectors());
+    }
+    SECTION("cache management"){
+        setup();
+        CoolProp::TabularBackend *TB = dynamic_cast<CoolProp::TabularBackend *>(ASBICUBIC.get());
+        std::string path = TB->path_to_tables();
+        std::vector<CoolProp::TabularDataSetInfo> infos = CoolProp::list_tabular_data_sets();
+        bool found = false;
+        for (std::size_t k = 0; k < infos.size(); ++k){
+            if (infos[k].path != path){ continue; }
+            found = true;
+            CHECK(infos[k].in_memory);
+            CHECK(infos[k].in_use);
+            CHECK(infos[k].on_disk);
+            CHECK(infos[k].memory_size > 0);
+        }
+        CHECK(found);
+        CoolProp::pin_tabular_data_set(path);
+        CHECK_THROWS(CoolProp::evict_tabular_data_set(path));
+        CoolProp::pin_tabular_data_set(path, false);
+        CHECK_NOTHROW(CoolProp::evict_tabular_data_set(path));
+        // The backends that use the tables can still use them
+        CHECK_NOTHROW(ASBICUBIC->update(CoolProp::HmassP_INPUTS, 300000, 101325));
+        infos = CoolProp::list_tabular_data_sets();
+        for (std::size_t k = 0; k < infos.size(); ++k){
+            if (infos[k].path == path){ CHECK(!infos[k].in_memory); CHECK(infos[k].on_disk); }
+        }
+        CHECK_THROWS(CoolProp::evict_tabular_data_set(get_home_dir(), true));
+    }
+    SECTION("adaptive grid"){
+        setup();
+        CoolProp::LogPHTable adaptive;
+        adaptive.AS = ASHEOS; adaptive.set_limits(); adaptive.grid_tolerance = 1e-3;
+        int Nmax = CoolProp::get_config_int(TABULAR_GRID_MAX_NODES);
+        CoolProp::set_config_int(TABULAR_GRID_MAX_NODES, 100);
+        adaptive.build(ASHEOS);
+        CoolProp::set_config_int(TABULAR_GRID_MAX_NODES, Nmax);
+        CHECK(adaptive.Nx <= 100);
+        CHECK(adaptive.Ny <= 100);
+        CHECK(adaptive.xvec.size() == adaptive.Nx);
+        CHECK(adaptive.T.rows() == adaptive.Nx);
+        CHECK(adaptive.T.cols() == adaptive.Ny);
+        CHECK(std::abs(adaptive.xvec.front() - adaptive.xmin) < 1e-10*std::abs(adaptive.xmin));
+        CHECK(std::abs(adaptive.yvec.back() - adaptive.ymax) < 1e-10*adaptive.ymax);
+        bool increasing = true;
+        for (std::size_t i = 1; i < adaptive.xvec.size(); ++i){ increasing = increasing && adaptive.xvec[i] > adaptive.xvec[i-1]; }
+        for (std::size_t j = 1; j < adaptive.yvec.size(); ++j){ increasing = increasing && adaptive.yvec[j] > adaptive.yvec[j-1]; }
+        CHECK(increasing);
+        // The knots are written with the table
+        adaptive.pack();
+        msgpack::sbuffer sbuf;
+        msgpack::pack(sbuf, adaptive);
+        msgpack::unpacked msg;
+        msgpack::unpack(msg, sbuf.data(), sbuf.size());
+        msgpack::object deserialized = msg.get();
+        CoolProp::LogPHTable loaded;
+        loaded.AS = ASHEOS; loaded.set_limits(); loaded.grid_tolerance = 1e-3;
+        CHECK_NOTHROW(loaded.deserialize(deserialized));
+        CHECK(loaded.xvec == adaptive.xvec);
+        CHECK(loaded.yvec == adaptive.yvec);
+    }
+    SECTION("saturation index"){
+        setup();
+        CoolProp::TabularBackend *TB = dynamic_cast<CoolProp::TabularBackend *>(ASBICUBIC.get());
+        ASBICUBIC->update(CoolProp::PT_INPUTS, 101325, 300);
+        CoolProp::PureFluidSaturationTableData &sat = TB->dataset->pure_saturation;
+        REQUIRE(!sat.pV_index.empty());
+        REQUIRE(!sat.TL_index.empty());
+        // The index gives points that bound the value, as bisection does
+        std::vector<double> ps = logspace(sat.pV.front(), sat.pV.back(), 257);
+        ps.front() = sat.pV.front(); ps.back() = sat.pV.back(); // Without the round-off error of logspace
+        for (std::size_t k = 0; k < ps.size(); ++k){
+            std::size_t i = 0;
+            CAPTURE(ps[k]);
+            REQUIRE(sat.pV_index.find(sat.pV, ps[k], i));
+            CHECK(sat.pV[i] <= ps[k]);
+            CHECK(ps[k] <= sat.pV[i+1]);
+        }
+        std::vector<double> Ts = linspace(sat.TL.front(), sat.TL.back(), 257);
+        for (std::size_t k = 0; k < Ts.size(); ++k){
+            std::size_t i = 0, ibisect = 0;
+            REQUIRE(sat.TL_index.find(sat.TL, Ts[k], i));
+            bisect_vector(sat.TL, Ts[k], ibisect);
+            CHECK(is_in_closed_range(sat.TL[i], sat.TL[i+1], Ts[k]));
+            CHECK((i == ibisect || sat.TL[i] == Ts[k] || sat.TL[i+1] == Ts[k]));
+        }
+        std::size_t iout = 0;
+        CHECK(!sat.pV_index.find(sat.pV, 0.5*sat.pV.front(), iout));
+        // Saturated states are still found to be two-phase, and the others single-phase
+        ASHEOS->update(CoolProp::PQ_INPUTS, 101325, 0.3);
+        CHECK_NOTHROW(ASBICUBIC->update(CoolProp::HmassP_INPUTS, ASHEOS->hmass(), 101325));
+        CHECK(ASBICUBIC->phase() == CoolProp::iphase_twophase);
+        CHECK(std::abs(ASBICUBIC->Q() - 0.3) < 1e-3);
+        CHECK_NOTHROW(ASBICUBIC->update(CoolProp::HmassP_INPUTS, 300000, 101325));
+        CHECK(ASBICUBIC->phase() != CoolProp::iphase_twophase);
+    }
+    SECTION("batch update"){
+        setup();
+        // Single-phase points, several of them in the same cell, a two-phase point and a point that is out of range
+        std::vector<double> h, p;
+        h.push_back(300000); p.push_back(101325);
+        h.push_back(300001); p.push_back(101325);
+        h.push_back(3000000); p.push_back(1e6);
+        h.push_back(1000000); p.push_back(101325);
+        h.push_back(400000); p.push_back(5e6);
+        h.push_back(-1e10); p.push_back(101325);
+        h.push_back(300002); p.push_back(101326);
+        std::vector<CoolProp::parameters> outputs;
+        outputs.push_back(CoolProp::iT);
+        outputs.push_back(CoolProp::iDmass);
+        outputs.push_back(CoolProp::iHmass);
+        outputs.push_back(CoolProp::iSmolar);
+        outputs.push_back(CoolProp::imolar_mass);
+        outputs.push_back(CoolProp::iviscosity);
+        std::size_t n = h.size();
+        std::vector<double> out(n*outputs.size());
+        ASBICUBIC->update_batch(CoolProp::HmassP_INPUTS, &(h[0]), &(p[0]), n, outputs, &(out[0]));
+        for (std::size_t i = 0; i < n; ++i){
+            CAPTURE(h[i]);
+            CAPTURE(p[i]);
+            bool ok = true;
+            try{ ASBICUBIC->update(CoolProp::HmassP_INPUTS, h[i], p[i]); }
+            catch(...){ ok = false; }
+            for (std::size_t j = 0; j < outputs.size(); ++j){
+                CAPTURE(j);
+                double expected = _HUGE;
+                if (ok){
+                    try{ expected = ASBICUBIC->keyed_output(outputs[j]); }
+                    catch(...){ }
+                }
+                if (outputs[j] == CoolProp::imolar_mass){ expected = ASBICUBIC->molar_mass(); }
+                CHECK((out[j*n + i] == expected || (!ValidNumber(out[j*n + i]) && !ValidNumber(expected))));
+            }
+        }
+        CHECK(!ValidNumber(out[0*n + 5]));
+        // The backend is left in the state of the last point
+        ASBICUBIC->update_batch(CoolProp::HmassP_INPUTS, &(h[0]), &(p[0]), n, outputs, &(out[0]));
+        CHECK(ASBICUBIC->hmass() == out[2*n + n-1]);
+    }
+    SECTION("DmassUmass inputs"){
+        setup();
+        // Liquid, vapor, supercritical and two-phase states; the last one is above the last point of the saturation
+        // table before the critical point
+        double Ts[] = { 300, 500, 700, 400, 646 }, ps[] = { 1e6, 1e5, 3e7, 0, 0 };
+        // The DU table is only built when these inputs are first used
+        CoolProp::TabularBackend *TB = dynamic_cast<CoolProp::TabularBackend *>(ASBICUBIC.get());
+        CHECK(!TB->dataset->Du_table_loaded);
+        for (std::size_t k = 0; k < 5; ++k){
+            if (ps[k] > 0){ ASHEOS->update(CoolProp::PT_INPUTS, ps[k], Ts[k]); }
+            else{ ASHEOS->update(CoolProp::QT_INPUTS, 0.3, Ts[k]); }
+            double rho = ASHEOS->rhomass(), u = ASHEOS->umass();
+            CAPTURE(rho);
+            CAPTURE(u);
+            CHECK_NOTHROW(ASTTSE->update(CoolProp::DmassUmass_INPUTS, rho, u));
+            CHECK_NOTHROW(ASBICUBIC->update(CoolProp::DmassUmass_INPUTS, rho, u));
+            CHECK((ASTTSE->phase() == CoolProp::iphase_twophase) == (ASHEOS->phase() == CoolProp::iphase_twophase));
+            CHECK((ASBICUBIC->phase() == CoolProp::iphase_twophase) == (ASHEOS->phase() == CoolProp::iphase_twophase));
+            CHECK(std::abs((ASHEOS->T()-ASTTSE->T())/ASHEOS->T()) < 1e-3);
+            CHECK(std::abs((ASHEOS->T()-ASBICUBIC->T())/ASHEOS->T()) < 1e-3);
+            CHECK(std::abs((ASHEOS->p()-ASTTSE->p())/ASHEOS->p()) < 1e-3);
+            CHECK(std::abs((ASHEOS->p()-ASBICUBIC->p())/ASHEOS->p()) < 1e-3);
+            CHECK(std::abs((ASHEOS->hmass()-ASBICUBIC->hmass())/ASHEOS->hmass()) < 1e-3);
+            if (ps[k] > 0){
+                // The inputs are returned as they are
+                CHECK(std::abs(ASBICUBIC->rhomass()/rho - 1) < 1e-12);
+                CHECK(std::abs(ASBICUBIC->umass()/u - 1) < 1e-12);
+            }
+            else{
+                // Close to the critical point, the quality is sensitive to the interpolation of the saturated states
+                CHECK(std::abs(ASBICUBIC->Q() - 0.3) < (k == 4 ? 5e-3 : 1e-3));
+            }
+        }
+        CHECK(TB->dataset->Du_table_loaded);
+    }
+    SECTION("segment index of a curve that is not monotonic"){
+        // Goes up and comes back down, like a phase envelope
+        std::vector<double> x = linspace(1.0, 10.0, 10), x2 = linspace(9.5, 0.5, 10);
+        x.insert(x.end(), x2.begin(), x2.end());
+        SegmentBucketIndex index;
+        index.build(x, true);
+        std::pair<const std::size_t *, const std::size_t *> range = index.candidates(3.2);
+        std::vector<std::size_t> found;
+        for (const std::size_t *s = range.first; s != range.second; ++s){
+            if (is_in_closed_range(x[*s], x[*s+1], 3.2)){ found.push_back(*s); }
+        }
+        REQUIRE(found.size() == 2);
+        CHECK(found[0] == 2);
+        CHECK(found[1] == 16);
+        CHECK(index.candidates(0.1).first == index.candidates(0.1).second);
+    }
     SECTION("check D=1 mol/m3, T=500 K inputs"){
         setup();
         double d = 1;
@@ -8,8 +8,13 @@
 #include "Exceptions.h"
 #include "CoolProp.h"
 #include <sstream>
+#include <set>
+#include <atomic>
+#include <mutex>
 #include "Configuration.h"
 #include "Backends/Helmholtz/PhaseEnvelopeRoutines.h"
+#include "FlatTables.h"
+#include "TabularDataSets.h"
 
 /** ***MAGIC WARNING***!! X Macros in use
  * See http://stackoverflow.com/a/148610
@@ -102,6 +107,32 @@ public:
         }
         std::swap(*this, temp); // Swap if successful
     };
+    /// Write all the vectors and matrices to a flat table file
+    void write_flat(const std::string &path){
+        FlatTableWriter writer(revision, T.size(), 0, _HUGE, _HUGE, _HUGE, _HUGE);
+        /* Use X macros to auto-generate the code; each will look something like: writer.add("T", T); */
+        #define X(name) writer.add(#name, name);
+        PHASE_ENVELOPE_VECTORS
+        PHASE_ENVELOPE_MATRICES
+        #undef X
+        writer.write(path);
+    };
+    /// Load all the vectors and matrices from a flat table file
+    void load_flat(const FlatTableReader &reader){
+        PackablePhaseEnvelopeData temp;
+        temp.revision = reader.header->revision;
+        /* Use X macros to auto-generate the code; each will look something like: reader.get("T", temp.T); */
+        #define X(name) reader.get(#name, temp.name);
+        PHASE_ENVELOPE_VECTORS
+        PHASE_ENVELOPE_MATRICES
+        #undef X
+        if (revision > temp.revision){
+            throw ValueError(format("loaded revision [%d] is older than current revision [%d]", temp.revision, revision));
+        }
+        temp.iTsat_max = std::distance(temp.T.begin(), std::max_element(temp.T.begin(), temp.T.end()));
+        temp.ipsat_max = std::distance(temp.p.begin(), std::max_element(temp.p.begin(), temp.p.end()));
+        std::swap(*this, temp);
+    };
 };
 
 /// Get a conversion factor from mass to molar if needed
@@ -142,10 +173,15 @@ class PureFluidSaturationTableData{
 		std::size_t N;
 		shared_ptr<CoolProp::AbstractState> AS;
 
-		PureFluidSaturationTableData(){N = 1000; revision = 1;}
+        /// If false, the viscosity and the conductivity are not calculated when the table is built
+        bool store_transport;
 
-        /// Build this table
+		PureFluidSaturationTableData(){N = 1000; revision = 1; store_transport = true;}
+
+        /// Build this table; the points are split between TABULAR_BUILD_NUM_THREADS threads
         void build(shared_ptr<CoolProp::AbstractState> &AS);
+        /// Calculate the saturated liquid and vapor at point i of the table, log spaced in pressure between pmin and pmax
+        void build_point(shared_ptr<CoolProp::AbstractState> &AS, std::size_t i, CoolPropDbl pmin, CoolPropDbl pmax);
 
 		/* Use X macros to auto-generate the variables; each will look something like: std::vector<double> T; */
 		#define X(name) std::vector<double> name;
@@ -157,6 +193,33 @@ class PureFluidSaturationTableData{
 
 		MSGPACK_DEFINE(revision, vectors); // write the member variables that you want to pack
 
+        /// Indices of the saturation curves, to find the points that bound a pressure or a temperature in constant time; they are not stored with the table
+        SegmentBucketIndex pL_index, pV_index, TL_index, TV_index;
+        /// Build the indices once the table has been built or loaded
+        void build_index(){
+            pL_index.build(pL, true); pV_index.build(pV, true);
+            TL_index.build(TL, false); TV_index.build(TV, false);
+        };
+        /// Find the points that bound a value with an index, or by bisection if it is not built; f is log(val) for the pressures and val for the temperatures
+        static void bracket(const SegmentBucketIndex &index, const std::vector<double> &vec, double val, double f, std::size_t &i){
+            if (!index.find_scaled(vec, val, f, i)){ bisect_vector(vec, val, i); }
+        };
+
+        /** \brief Determine if a state given by its molar density and molar internal energy is inside the saturation table
+         *
+         * The saturated liquid, the saturated vapor and all the two-phase states in between lie on a straight tie line in
+         * the plane of molar volume and internal energy.  The tie line that passes through the state is found by bisection
+         * over the points of the table and then refined in log(p).  Above the last point before the critical point, the
+         * tie line is searched up to the critical point, where it shrinks to a point.  Throws ValueError if the table has
+         * no valid entries where they are needed.
+         * @param rhomolar The molar density
+         * @param umolar The molar internal energy
+         * @param p The saturation pressure, if the state is inside
+         * @param Q The vapor quality, if the state is inside
+         * @param iL The index associated with the nearest point for the liquid
+         * @param iV The index associated with the nearest point for the vapor
+         */
+        bool is_inside_Du(double rhomolar, double umolar, CoolPropDbl &p, CoolPropDbl &Q, std::size_t &iL, std::size_t &iV) const;
         /***
          * \brief Determine if a set of inputs are single-phase or inside the saturation table
          * @param main The main variable that is being provided (currently T or P)
@@ -202,13 +265,15 @@ class PureFluidSaturationTableData{
             // Find the indices (iL,iL+1) & (iV,iV+1) that bound the given pressure
             // In general iV and iL will be the same, but if pseudo-pure, they might
             // be different
+            // The indices are used to find them in constant time
+            double logp = (main == iP) ? log(mainval) : 0;
             if (main ==iP){
-                bisect_vector(pV, mainval, iV);
-                bisect_vector(pL, mainval, iL);
+                bracket(pV_index, pV, mainval, logp, iV);
+                bracket(pL_index, pL, mainval, logp, iL);
             }
             else if (main == iT){
-                bisect_vector(TV, mainval, iV);
-                bisect_vector(TL, mainval, iL);
+                bracket(TV_index, TV, mainval, mainval, iV);
+                bracket(TL_index, TL, mainval, mainval, iL);
             }
             else{
                 throw ValueError(format("For now, main input in is_inside must be T or p"));
@@ -221,7 +286,6 @@ class PureFluidSaturationTableData{
                 if (iVplus < 3){ iVplus = 3;}
                 if (iLplus < 3){ iLplus = 3;}
                 if (main==iP){
-                    double logp = log(mainval);
                     // Calculate temperature
                     yV = CubicInterp(logpV, TV, iVplus-3, iVplus-2, iVplus-1, iVplus, logp);
                     yL = CubicInterp(logpL, TL, iLplus-3, iLplus-2, iLplus-1, iLplus, logp);
@@ -241,7 +305,6 @@ class PureFluidSaturationTableData{
             if (iVplus < 3){ iVplus = 3;}
             if (iLplus < 3){ iLplus = 3;}
             if (main==iP){
-                double logp = log(mainval);
                 yV = CubicInterp(logpV, *yvecV, iVplus-3, iVplus-2, iVplus-1, iVplus, logp);
                 yL = CubicInterp(logpL, *yvecL, iLplus-3, iLplus-2, iLplus-1, iLplus, logp);
             }
@@ -303,6 +366,35 @@ class PureFluidSaturationTableData{
             std::swap(*this, temp); // Swap
             this->AS = temp.AS; // Reconnect the AbstractState pointer
         };
+        /// Write all the vectors to a flat table file
+        void write_flat(const std::string &path){
+            FlatTableWriter writer(revision, N, 0, _HUGE, _HUGE, _HUGE, _HUGE);
+            /* Use X macros to auto-generate the code; each will look something like: writer.add("TL", TL); */
+            #define X(name) writer.add(#name, name);
+            LIST_OF_SATURATION_VECTORS
+            #undef X
+            writer.write(path);
+        };
+        /// Load all the vectors from a flat table file, with the same checks as deserialize()
+        void load_flat(const FlatTableReader &reader){
+            PureFluidSaturationTableData temp;
+            temp.revision = reader.header->revision;
+            /* Use X macros to auto-generate the code; each will look something like: reader.get("TL", temp.TL); */
+            #define X(name) reader.get(#name, temp.name);
+            LIST_OF_SATURATION_VECTORS
+            #undef X
+            temp.N = temp.TL.size();
+            if (N != temp.N)
+            {
+                throw ValueError(format("old [%d] and new [%d] sizes don't agree", temp.N, N));
+            }
+            else if (revision > temp.revision)
+            {
+                throw ValueError(format("loaded revision [%d] is older than current revision [%d]", temp.revision, revision));
+            }
+            std::swap(*this, temp); // Swap
+            this->AS = temp.AS; // Reconnect the AbstractState pointer
+        };
         double evaluate(parameters output, double p_or_T, double Q, std::size_t iL, std::size_t iV)
         {
             if (iL <= 2){ iL = 2; }
@@ -446,30 +538,39 @@ class SinglePhaseGriddedTableData{
         std::vector<std::vector<std::size_t> > nearest_neighbor_i, nearest_neighbor_j;
 		bool logx, logy;
 		double xmin, ymin, xmax, ymax;
+        /// If greater than zero, the knots of the axes are not evenly spaced but chosen so that the relative error of the
+        /// interpolated density and temperature is below this value, and Nx and Ny are the resulting numbers of knots
+        double grid_tolerance;
+        /// If false, the viscosity and the conductivity are not calculated when the table is built and remain holes
+        bool store_transport;
 
         virtual void set_limits() = 0;
 
 		SinglePhaseGriddedTableData(){
-            Nx = 200; Ny = 200; revision = 0;
+            Nx = 200; Ny = 200; revision = 0; grid_tolerance = 0; store_transport = true;
             xkey = INVALID_PARAMETER; ykey = INVALID_PARAMETER;
             logx = false; logy = false;
             xmin = _HUGE; xmax = _HUGE; ymin = _HUGE; ymax = _HUGE;
         }
 
-		/* Use X macros to auto-generate the variables; each will look something like: std::vector< std::vector<double> > T; */
-		#define X(name) std::vector< std::vector<double> > name;
+		/* Use X macros to auto-generate the variables; each will look something like: TableMatrix T; */
+		#define X(name) TableMatrix name;
 		LIST_OF_MATRICES
 		#undef X
 		int revision;
 		std::map<std::string, std::vector<std::vector<double> > > matrices;
-        /// Build this table
+        /// Build this table; the rows are split between TABULAR_BUILD_NUM_THREADS threads
         void build(shared_ptr<CoolProp::AbstractState> &AS);
+        /// Calculate the nodes of row i of the table; xvec and yvec must have been set
+        void build_row(shared_ptr<CoolProp::AbstractState> &AS, std::size_t i);
+        /// Choose the knots of the x axis (or the y axis) so that the interpolation error is below grid_tolerance, with at most Nmax knots
+        std::vector<double> refine_axis(std::vector<shared_ptr<CoolProp::AbstractState> > &states, bool along_x, std::size_t Nmax);
 
-		MSGPACK_DEFINE(revision, matrices, xmin, xmax, ymin, ymax); // write the member variables that you want to pack
+		MSGPACK_DEFINE(revision, matrices, xmin, xmax, ymin, ymax, xvec, yvec, grid_tolerance); // write the member variables that you want to pack
 		/// Resize all the matrices
 		void resize(std::size_t Nx, std::size_t Ny){
-			/* Use X macros to auto-generate the code; each will look something like: T.resize(Nx, std::vector<double>(Ny, _HUGE)); */
-			#define X(name) name.resize(Nx, std::vector<double>(Ny, _HUGE));
+			/* Use X macros to auto-generate the code; each will look something like: T.resize(Nx, Ny, _HUGE); */
+			#define X(name) name.resize(Nx, Ny, _HUGE);
 			LIST_OF_MATRICES
 			#undef X
 			make_axis_vectors();
@@ -491,8 +592,8 @@ class SinglePhaseGriddedTableData{
 		};
         /// Make matrices of good neighbors if the current value for i,j corresponds to a bad node
 		void make_good_neighbors(void){
-            nearest_neighbor_i.resize(Nx, std::vector<std::size_t>(Ny, std::numeric_limits<std::size_t>::max()));
-            nearest_neighbor_j.resize(Nx, std::vector<std::size_t>(Ny, std::numeric_limits<std::size_t>::max()));
+            nearest_neighbor_i.assign(Nx, std::vector<std::size_t>(Ny, std::numeric_limits<std::size_t>::max()));
+            nearest_neighbor_j.assign(Nx, std::vector<std::size_t>(Ny, std::numeric_limits<std::size_t>::max()));
             for (std::size_t i = 0; i < xvec.size(); ++i){
                 for (std::size_t j = 0; j < yvec.size(); ++j){
                     nearest_neighbor_i[i][j] = i;
@@ -518,7 +619,7 @@ class SinglePhaseGriddedTableData{
 		/// Take all the matrices that are in the class and pack them into the matrices map for easy unpacking using msgpack
 		void pack(){
 			/* Use X macros to auto-generate the packing code; each will look something like: matrices.insert(std::pair<std::vector<std::vector<double> > >("T", T)); */
-			#define X(name) matrices.insert(std::pair<std::string, std::vector<std::vector<double> > >(#name, name));
+			#define X(name) matrices.insert(std::pair<std::string, std::vector<std::vector<double> > >(#name, name.to_vectors()));
 			LIST_OF_MATRICES
 			#undef X
 		};
@@ -531,14 +632,73 @@ class SinglePhaseGriddedTableData{
         }
 		/// Take all the matrices that are in the class and pack them into the matrices map for easy unpacking using msgpack
 		void unpack(){
-			/* Use X macros to auto-generate the unpacking code; each will look something like: T = *(matrices.find("T")).second */
-			#define X(name) name = get_matrices_iterator(#name)->second;
+			/* Use X macros to auto-generate the unpacking code; each will look something like: T.assign(matrices.find("T")->second) */
+			#define X(name) name.assign(get_matrices_iterator(#name)->second);
 			LIST_OF_MATRICES
 			#undef X
-			Nx = T.size(); Ny = T[0].size();
-			make_axis_vectors();
+			Nx = T.rows(); Ny = T.cols();
+            // Tables written before the knots were stored have evenly spaced knots
+            if (xvec.size() != Nx || yvec.size() != Ny){
+                make_axis_vectors();
+            }
             make_good_neighbors();
 		};
+        /// Add all the matrices to the writer of a flat table file
+        void write_flat(FlatTableWriter &writer){
+            /* Use X macros to auto-generate the code; each will look something like: writer.add("T", T); */
+            #define X(name) writer.add(#name, name);
+            LIST_OF_MATRICES
+            #undef X
+            writer.add("xvec", xvec);
+            writer.add("yvec", yvec);
+            writer.add("grid_tolerance", std::vector<double>(1, grid_tolerance));
+        };
+        /// Load all the matrices from a flat table file, with the same checks as deserialize()
+        void load_flat(const FlatTableReader &reader){
+            const FlatTableHeader &h = *(reader.header);
+            std::vector<double> loaded_grid_tolerance(1, 0.0);
+            if (reader.has("grid_tolerance")){ reader.get("grid_tolerance", loaded_grid_tolerance); }
+            if (grid_tolerance == 0 && (Nx != h.Nx || Ny != h.Ny))
+            {
+                throw ValueError(format("old [%dx%d] and new [%dx%d] dimensions don't agree", static_cast<std::size_t>(h.Nx), static_cast<std::size_t>(h.Ny), Nx, Ny));
+            }
+            else if (loaded_grid_tolerance.size() != 1 || grid_tolerance != loaded_grid_tolerance[0])
+            {
+                throw ValueError(format("Current grid tolerance [%g] does not agree with loaded grid tolerance", grid_tolerance));
+            }
+            else if (revision > h.revision)
+            {
+                throw ValueError(format("loaded revision [%d] is older than current revision [%d]", h.revision, revision));
+            }
+            else if ((std::abs(xmin) > 1e-10 && std::abs(xmax) > 1e-10) && (std::abs(h.xmin - xmin)/xmin > 1e-6 || std::abs(h.xmax - xmax)/xmax > 1e-6)){
+                throw ValueError(format("Current limits for x [%g,%g] do not agree with loaded limits [%g,%g]", xmin, xmax, h.xmin, h.xmax));
+            }
+            else if ((std::abs(ymin) > 1e-10 && std::abs(ymax) > 1e-10) && (std::abs(h.ymin - ymin)/ymin > 1e-6 || std::abs(h.ymax - ymax)/ymax > 1e-6)){
+                throw ValueError(format("Current limits for y [%g,%g] do not agree with loaded limits [%g,%g]", ymin, ymax, h.ymin, h.ymax));
+            }
+            std::size_t Nx_flat = static_cast<std::size_t>(h.Nx), Ny_flat = static_cast<std::size_t>(h.Ny);
+            /* Use X macros to auto-generate the code; each will look something like: T_flat.map(reader, "T", Nx_flat, Ny_flat); */
+            #define X(name) TableMatrix name##_flat; name##_flat.map(reader, #name, Nx_flat, Ny_flat);
+            LIST_OF_MATRICES
+            #undef X
+            std::vector<double> xvec_flat, yvec_flat;
+            if (reader.has("xvec")){ reader.get("xvec", xvec_flat); }
+            if (reader.has("yvec")){ reader.get("yvec", yvec_flat); }
+            // All the matrices could be found, use them in place in the mapped file
+            #define X(name) name = name##_flat;
+            LIST_OF_MATRICES
+            #undef X
+            Nx = Nx_flat; Ny = Ny_flat;
+            revision = h.revision;
+            xmin = h.xmin; xmax = h.xmax; ymin = h.ymin; ymax = h.ymax;
+            if (xvec_flat.size() == Nx && yvec_flat.size() == Ny){
+                std::swap(xvec, xvec_flat); std::swap(yvec, yvec_flat);
+            }
+            else{
+                make_axis_vectors();
+            }
+            make_good_neighbors();
+        };
 		/// Check that the native inputs (the inputs the table is based on) are in range
 		bool native_inputs_are_in_range(double x, double y){
             double e = 10*DBL_EPSILON;
@@ -578,7 +738,7 @@ class SinglePhaseGriddedTableData{
                 }
                 catch(...){
                     // Now we go for a less intelligent solution, we simply try to find the one that is the closest
-                    const std::vector<std::vector<double> > & mat = get(otherkey);
+                    const TableMatrix & mat = get(otherkey);
                     double closest_diff = 1e20;
                     std::size_t closest_i = 0;
                     for (std::size_t index = 0; index < mat.size(); ++index){
@@ -593,8 +753,8 @@ class SinglePhaseGriddedTableData{
             else if (givenkey == xkey){
                 bisect_vector(xvec, givenval, i);
                 // This one is fine because we now end up with a vector<double> in the other variable
-                const std::vector<std::vector<double> > & v = get(otherkey);
-                bisect_vector(v[i], otherval, j);
+                const TableMatrix & v = get(otherkey);
+                bisect_array(v[i], v.cols(), otherval, j);
             }
 		}
 		/// Find the nearest good neighbor node for inputs that are the same as the grid inputs
@@ -617,7 +777,7 @@ class SinglePhaseGriddedTableData{
 			bisect_vector(xvec, x, i);
 			bisect_vector(yvec, y, j);
 		}
-        const std::vector<std::vector<double> > & get(parameters key){
+        const TableMatrix & get(parameters key){
             switch(key){
                 case iDmolar: return rhomolar;
                 case iT: return T;
@@ -661,10 +821,14 @@ class LogPHTable : public SinglePhaseGriddedTableData
             LogPHTable temp;
             deserialized.convert(temp);
             temp.unpack();
-            if (Nx != temp.Nx || Ny != temp.Ny)
+            if (grid_tolerance == 0 && (Nx != temp.Nx || Ny != temp.Ny))
             {
                 throw ValueError(format("old [%dx%d] and new [%dx%d] dimensions don't agree", temp.Nx, temp.Ny, Nx, Ny));
             }
+            else if (grid_tolerance != temp.grid_tolerance)
+            {
+                throw ValueError(format("Current grid tolerance [%g] does not agree with loaded grid tolerance [%g]", grid_tolerance, temp.grid_tolerance));
+            }
             else if (revision > temp.revision)
             {
                 throw ValueError(format("loaded revision [%d] is older than current revision [%d]", temp.revision, revision));
@@ -701,10 +865,14 @@ class LogPTTable : public SinglePhaseGriddedTableData
             LogPTTable temp;
             deserialized.convert(temp);
             temp.unpack();
-            if (Nx != temp.Nx || Ny != temp.Ny)
+            if (grid_tolerance == 0 && (Nx != temp.Nx || Ny != temp.Ny))
             {
                 throw ValueError(format("old [%dx%d] and new [%dx%d] dimensions don't agree",temp.Nx, temp.Ny, Nx, Ny));
             }
+            else if (grid_tolerance != temp.grid_tolerance)
+            {
+                throw ValueError(format("Current grid tolerance [%g] does not agree with loaded grid tolerance [%g]", grid_tolerance, temp.grid_tolerance));
+            }
             else if (revision > temp.revision)
             {
                 throw ValueError(format("loaded revision [%d] is older than current revision [%d]", temp.revision, revision));
@@ -720,57 +888,80 @@ class LogPTTable : public SinglePhaseGriddedTableData
         };
 };
 
-/// This structure holds the coefficients for one cell, the coefficients are stored in matrices
-/// and can be obtained by the get() function.
+/// This class holds the single-phase data for a u-log(rho) gridded table, so that states given by their density and internal energy are not iterated
+class LogDUTable : public SinglePhaseGriddedTableData
+{
+    public:
+        LogDUTable(){
+            xkey = iUmolar; ykey = iDmolar; logy = true; logx = false; xmin = _HUGE; ymin = _HUGE; xmax=_HUGE; ymax=_HUGE;
+        };
+        void set_limits(){
+            if (this->AS.get() == NULL){
+                throw ValueError("AS is not yet set");
+            }
+            CoolPropDbl Tmin = std::max(AS->Ttriple(), AS->Tmin());
+            // Minimum internal energy is the saturated liquid internal energy
+            AS->update(QT_INPUTS, 0, Tmin);
+            xmin = AS->umolar();
+            CoolPropDbl rhomax1 = AS->rhomolar(), pmin = AS->p();
+
+            // Same range as the log(p)-h table: the lowest density is along the Tmax isotherm at the lowest pressure, the
+            // highest one is the compressed liquid at the highest pressure
+            AS->update(PT_INPUTS, pmin, 1.499*AS->Tmax());
+            ymin = AS->rhomolar();
+            CoolPropDbl xmax1 = AS->umolar();
+            AS->update(PT_INPUTS, AS->pmax(), 1.499*AS->Tmax());
+            CoolPropDbl xmax2 = AS->umolar();
+            xmax = std::max(xmax1, xmax2);
+            AS->update(PT_INPUTS, AS->pmax(), Tmin);
+            ymax = std::max(rhomax1, static_cast<CoolPropDbl>(AS->rhomolar()));
+        }
+        void deserialize(msgpack::object &deserialized){
+            LogDUTable temp;
+            deserialized.convert(temp);
+            temp.unpack();
+            if (grid_tolerance == 0 && (Nx != temp.Nx || Ny != temp.Ny))
+            {
+                throw ValueError(format("old [%dx%d] and new [%dx%d] dimensions don't agree", temp.Nx, temp.Ny, Nx, Ny));
+            }
+            else if (grid_tolerance != temp.grid_tolerance)
+            {
+                throw ValueError(format("Current grid tolerance [%g] does not agree with loaded grid tolerance [%g]", grid_tolerance, temp.grid_tolerance));
+            }
+            else if (revision > temp.revision)
+            {
+                throw ValueError(format("loaded revision [%d] is older than current revision [%d]", temp.revision, revision));
+            }
+            else if ((std::abs(xmin) > 1e-10 && std::abs(xmax) > 1e-10) && (std::abs(temp.xmin - xmin)/std::abs(xmin) > 1e-6 || std::abs(temp.xmax - xmax)/std::abs(xmax) > 1e-6)){
+                throw ValueError(format("Current limits for x [%g,%g] do not agree with loaded limits [%g,%g]", xmin, xmax, temp.xmin, temp.xmax));
+            }
+            else if ((std::abs(ymin) > 1e-10 && std::abs(ymax) > 1e-10) && (std::abs(temp.ymin - ymin)/ymin > 1e-6 || std::abs(temp.ymax - ymax)/ymax > 1e-6)){
+                throw ValueError(format("Current limits for y [%g,%g] do not agree with loaded limits [%g,%g]", ymin, ymax, temp.ymin, temp.ymax));
+            }
+            std::swap(*this, temp); // Swap
+            this->AS = temp.AS; // Reconnect the AbstractState pointer
+        };
+};
+
+/** \brief A view of the bicubic coefficients of one cell, which are stored in a CellCoeffsMatrix
+ *
+ * The 16 coefficients of a parameter are obtained with the get() function.
+ */
 class CellCoeffs{
 private:
-    std::size_t alt_i, alt_j;
-    bool _valid, _has_valid_neighbor;
+    const double *record;
+    const parameters *params;
+    std::size_t Nparams;
 public:
-    double dx_dxhat, dy_dyhat;
-    CellCoeffs(){
-        _valid = false; _has_valid_neighbor = false;
-        dx_dxhat = _HUGE; dy_dyhat = _HUGE;
-        alt_i = 9999999; alt_j = 9999999;
-    }
-    std::vector<double> T, rhomolar, hmolar, p, smolar, umolar;
-    /// Return a const reference to the desired matrix
-    const std::vector<double> & get(const parameters params) const
-    {
-        switch (params){
-        case iT: return T;
-        case iP: return p;
-        case iDmolar: return rhomolar;
-        case iHmolar: return hmolar;
-        case iSmolar: return smolar;
-        case iUmolar: return umolar;
-        default: throw KeyError(format("Invalid key to get() function of CellCoeffs"));
-        }
-    };
-    /// Set one of the matrices in this class
-    void set(parameters params, const std::vector<double> &mat){
-        switch (params){
-        case iT: T = mat; break;
-        case iP: p = mat; break;
-        case iDmolar: rhomolar = mat; break;
-        case iHmolar: hmolar = mat; break;
-        case iSmolar: smolar = mat; break;
-        case iUmolar: umolar = mat; break;
-        default: throw KeyError(format("Invalid key to set() function of CellCoeffs"));
-        }
-    };
+    CellCoeffs(const double *record, const parameters *params, std::size_t Nparams) : record(record), params(params), Nparams(Nparams) {};
+    /// Return a pointer to the 16 coefficients of a parameter
+    const double * get(const parameters param) const;
     /// Returns true if the cell coefficients seem to have been calculated properly
-    bool valid() const { return _valid; };
-    /// Call this function to set the valid flag to true
-    void set_valid(){ _valid = true; };
-    /// Call this function to set the valid flag to false
-    void set_invalid(){ _valid = false; };
-    /// Set the neighboring (alternate) cell to be used if the cell is invalid
-    void set_alternate(std::size_t i, std::size_t j){ alt_i = i; alt_j = j; _has_valid_neighbor = true; }
+    bool valid() const { return record[0] != 0; };
     /// Get neighboring(alternate) cell to be used if this cell is invalid
     void get_alternate(std::size_t &i, std::size_t &j) const {
-        if (_has_valid_neighbor){
-            i = alt_i; j = alt_j;
+        if (has_valid_neighbor()){
+            i = static_cast<std::size_t>(record[1]); j = static_cast<std::size_t>(record[2]);
         }
         else{
             throw ValueError("No valid neighbor");
@@ -778,54 +969,205 @@ public:
     }
     /// Returns true if cell is invalid and it has valid neighbor
     bool has_valid_neighbor() const{
-        return _has_valid_neighbor;
+        return record[1] >= 0;
     }
+    /// The scaling factors of the cell, dx/dxhat and dy/dyhat, where xhat = (x-x_i)/(x_{i+1}-x_i)
+    double dx_dxhat() const { return record[3]; };
+    double dy_dyhat() const { return record[4]; };
+};
+
+/** \brief The bicubic coefficients of all the cells of a single-phase table
+ *
+ * The coefficients are stored cell by cell in one contiguous matrix with one row (record) of record_size doubles
+ * per cell, in the order of the cells (i,j) with j changing fastest.  A record holds:
+ *
+ * - [0] 1 if the cell is valid, 0 otherwise
+ * - [1], [2] the indices (i,j) of the alternate cell, or -1 if there is none
+ * - [3], [4] dx/dxhat and dy/dyhat
+ * - [5], [6], [7] unused, so that the coefficients start on a cache-line boundary
+ * - then the 16 coefficients of each of the parameters in params
+ *
+ * Since the matrix and its records are aligned on cache lines, the coefficients of one parameter of one cell are in
+ * two cache lines.  The parameters are T, P, Dmolar, Hmolar, Smolar and Umolar, except for the two inputs of the table.
+ */
+class CellCoeffsMatrix{
+public:
+    static const std::size_t header_size = 8, max_params = 4, record_size = header_size + 16*max_params;
+    std::size_t Nx, Ny; ///< The number of cells in each direction, one fewer than the number of nodes of the table
+    parameters params[max_params]; ///< The parameters whose coefficients are stored, in the order of the records
+    std::size_t Nparams;
+    TableMatrix records;
+
+    CellCoeffsMatrix() : Nx(0), Ny(0), Nparams(0) {};
+    bool empty() const { return records.empty(); };
+    void clear(){ records.clear(); Nx = 0; Ny = 0; Nparams = 0; };
+    /// Set the dimensions and the parameters, without allocating the records
+    void set_layout(std::size_t Nx, std::size_t Ny, parameters xkey, parameters ykey);
+    /// Set the dimensions and the parameters, and make all the cells invalid
+    void resize(std::size_t Nx, std::size_t Ny, parameters xkey, parameters ykey);
+    /// Get the coefficients of cell (i,j)
+    CellCoeffs operator()(std::size_t i, std::size_t j) const { return CellCoeffs(records[i*Ny + j], params, Nparams); };
+    /// Set the 16 coefficients of the parameter with index k in cell (i,j)
+    void set(std::size_t i, std::size_t j, std::size_t k, const double *alpha){
+        std::copy(alpha, alpha + 16, records.mutable_row(i*Ny + j) + header_size + 16*k);
+    };
+    /// Set the validity and the scaling factors of cell (i,j)
+    void set_cell(std::size_t i, std::size_t j, bool valid, double dx_dxhat, double dy_dyhat){
+        double *record = records.mutable_row(i*Ny + j);
+        record[0] = valid ? 1 : 0; record[3] = dx_dxhat; record[4] = dy_dyhat;
+    };
+    /// Set the neighboring (alternate) cell to be used if cell (i,j) is invalid
+    void set_alternate(std::size_t i, std::size_t j, std::size_t alt_i, std::size_t alt_j){
+        double *record = records.mutable_row(i*Ny + j);
+        record[1] = static_cast<double>(alt_i); record[2] = static_cast<double>(alt_j);
+    };
 };
 
-/// This class contains the data for one set of Tabular data including single-phase and two-phase data
+inline const double * CellCoeffs::get(const parameters param) const
+{
+    for (std::size_t k = 0; k < Nparams; ++k){
+        if (params[k] == param){ return record + CellCoeffsMatrix::header_size + 16*k; }
+    }
+    throw KeyError(format("Invalid key to get() function of CellCoeffs"));
+}
+
+/** \brief The resolution and the ranges of the tables of a tabular backend
+ *
+ * The specification can be given in brackets after the backend string, for instance BICUBIC&HEOS[Nx=400,pmax=30e6].  The keys are
+ * - Nx and Ny: the number of knots of the axes of the single-phase tables (200 by default)
+ * - Nsat: the number of points of the saturation table (1000 by default)
+ * - pmin and pmax [Pa]: the range of pressures of the single-phase tables
+ * - hmin and hmax [J/kg]: the range of enthalpies of the pressure-enthalpy table
+ * - Tmin and Tmax [K]: the range of temperatures of the pressure-temperature table
+ * - tol: the tolerance of the adaptive grids, TABULAR_GRID_TOLERANCE by default
+ * - transport: 0 to not calculate the viscosity and the conductivity
+ *
+ * The values that are not given keep their defaults, and the ranges default to the range of the equation of state.
+ */
+class TableSpecification
+{
+public:
+    std::size_t Nx, Ny, Nsat; ///< Zero if not given
+    double pmin, pmax, hmin, hmax, Tmin, Tmax; ///< _HUGE if not given
+    double grid_tolerance; ///< Negative if not given
+    bool transport;
+
+    TableSpecification() : Nx(0), Ny(0), Nsat(0), pmin(_HUGE), pmax(_HUGE), hmin(_HUGE), hmax(_HUGE), Tmin(_HUGE), Tmax(_HUGE), grid_tolerance(-1), transport(true){};
+    /// Parse a specification like "Nx=400,pmax=30e6"; throws ValueError if a key is not known or a value is not valid
+    explicit TableSpecification(const std::string &spec);
+    /// The tolerance of the adaptive grids, from TABULAR_GRID_TOLERANCE if it is not given
+    double get_grid_tolerance() const;
+    /// The canonical form of the specification, which is a part of the path of the tables; empty for the default tables
+    std::string to_string() const;
+    /// Set the resolution and the ranges of a single-phase table whose default limits have already been set
+    void apply(SinglePhaseGriddedTableData &table, AbstractState &AS) const;
+    /// Set the resolution of a saturation table
+    void apply(PureFluidSaturationTableData &table) const;
+};
+
+/** \brief A set of tables and their bicubic coefficients
+ *
+ * This class contains the data for one set of Tabular data including single-phase and two-phase data.  The set is shared by all the backends for the same fluid and table specification, possibly in several threads.  It is
+ * only modified while build_mutex is held, until tables_loaded is set; the tables are then never modified again.  The
+ * DU table is only needed for the DmolarUmolar inputs, so it is loaded or built when these inputs are first used, while
+ * Du_mutex is held, and it is never modified again once Du_table_loaded is set.
+ */
 class TabularDataSet
 {
 public:
-    bool tables_loaded;
+    std::atomic<bool> tables_loaded; ///< True once the tables and the bicubic coefficients are complete
+    std::mutex build_mutex; ///< Held while the tables are loaded or built
+    std::atomic<bool> Du_table_loaded; ///< True once the DU table and its bicubic coefficients are complete
+    std::mutex Du_mutex; ///< Held while the DU table is loaded or built
+    TableSpecification spec; ///< The resolution and the ranges of the tables
     LogPHTable single_phase_logph;
     LogPTTable single_phase_logpT;
+    LogDUTable single_phase_logDu;
     PureFluidSaturationTableData pure_saturation;
     PackablePhaseEnvelopeData phase_envelope;
-    std::vector<std::vector<CellCoeffs> > coeffs_ph, coeffs_pT;
+    CellCoeffsMatrix coeffs_ph, coeffs_pT, coeffs_Du;
+    /// Indices of the pressures and the temperatures of the phase envelope, for PhaseEnvelopeRoutines::is_inside
+    SegmentBucketIndex phase_envelope_p_index, phase_envelope_T_index;
 
-    TabularDataSet(){ tables_loaded = false; }
+    TabularDataSet(){ tables_loaded = false; Du_table_loaded = false; }
     /// Write the tables to files on the computer
     void write_tables(const std::string &path_to_tables);
     /// Load the tables from file
     void load_tables(const std::string &path_to_tables, shared_ptr<CoolProp::AbstractState> &AS);
     /// Build the tables (single-phase PH, single-phase PT, phase envelope, etc.)
     void build_tables(shared_ptr<CoolProp::AbstractState> &AS);
+    /// Load the single-phase DU table and its bicubic coefficients, or build them and write them next to the other tables
+    void load_or_build_Du_table(const std::string &path_to_tables, shared_ptr<CoolProp::AbstractState> &AS);
     /// Build the \f$a_{i,j}\f$ coefficients for bicubic interpolation
-    void build_coeffs(SinglePhaseGriddedTableData &table, std::vector<std::vector<CellCoeffs> > &coeffs);
+    void build_coeffs(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs);
+    /// Build the indices of the saturation table and of the phase envelope that are used to determine the phase
+    void build_indices();
+    /// Write the tables and the bicubic coefficients to flat table files that can be memory-mapped
+    void write_flat_tables(const std::string &path_to_tables);
+    /// Load the tables and the bicubic coefficients from the flat table files; throws UnableToLoadError if there is a problem
+    void load_flat_tables(const std::string &path_to_tables);
+    /// Write a single-phase table and its bicubic coefficients to a flat table file
+    void write_flat_table(SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, const std::string &path);
+    /// Load a single-phase table and its bicubic coefficients from a flat table file
+    void load_flat_table(SinglePhaseGriddedTableData &table, CellCoeffsMatrix &coeffs, const std::string &path);
+    /// The heap memory used by the tables in bytes; the arrays that are memory-mapped are not counted
+    std::size_t memory_size() const;
 };
 
+class TabularBackend;
+
+/** \brief The sets of tables that are loaded in memory, keyed by the directory of their files
+ *
+ * The least recently used sets are evicted from memory when MAXIMUM_TABLE_MEMORY_IN_GB is exceeded, and from disk when
+ * MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB is exceeded, except for the pinned sets and the sets that are in use.  The backends
+ * share the ownership of their set, so that a set that is evicted from memory stays valid for the backends that use it.
+ *
+ * The library can be used from several threads.  Its mutex is only held to look up and update the map, never while
+ * tables are loaded or built, so that the threads that use tables that are ready never wait for the ones that load or
+ * build other tables.  The threads that request the same tables while they are loaded or built wait for that load or
+ * build rather than doing it again.
+ */
 class TabularDataLibrary
 {
 private:
-    std::map<std::string, TabularDataSet> data;
+    std::mutex mutex; ///< Protects data, last_used, pinned and requests
+    std::map<std::string, shared_ptr<TabularDataSet> > data;
+    std::map<std::string, unsigned long long> last_used; ///< When each set in memory was last requested, in number of requests
+    std::set<std::string> pinned;
+    unsigned long long requests;
 public:
-    TabularDataLibrary(){};
-    std::string path_to_tables(shared_ptr<CoolProp::AbstractState> &AS){
+    TabularDataLibrary() : requests(0) {};
+    /// The directory in which the directories of the tables are
+    static std::string table_directory(){
+        std::string table_directory = get_home_dir() + "/.CoolProp/Tables/";
+        std::string alt_table_directory = get_config_string(ALTERNATIVE_TABLES_DIRECTORY);
+        if (!alt_table_directory.empty()){
+            table_directory = alt_table_directory;
+        }
+        return table_directory;
+    }
+    std::string path_to_tables(shared_ptr<CoolProp::AbstractState> &AS, const TableSpecification &spec){
         std::vector<std::string> fluids = AS->fluid_names();
         std::vector<CoolPropDbl> fractions = AS->get_mole_fractions();
         std::vector<std::string> components;
         for (std::size_t i = 0; i < fluids.size(); ++i){
             components.push_back(format("%s[%0.10Lf]", fluids[i].c_str(), fractions[i]));
         }
-        std::string table_directory = get_home_dir() + "/.CoolProp/Tables/";
-        std::string alt_table_directory = get_config_string(ALTERNATIVE_TABLES_DIRECTORY);
-        if (!alt_table_directory.empty()){
-            table_directory = alt_table_directory;
-        }
-        return table_directory + AS->backend_name() + "(" + strjoin(components, "&") + ")";
+        std::string spec_string = spec.to_string();
+        return table_directory() + AS->backend_name() + "(" + strjoin(components, "&") + ")" + (spec_string.empty() ? "" : "[" + spec_string + "]");
     }
-    /// Return a pointer to the set of tabular datasets
-    TabularDataSet * get_set_of_tables(shared_ptr<AbstractState> &AS, bool &loaded);
+    /// Return the set of tables of a backend, once it is complete; it is loaded, or built and written if it cannot be loaded
+    shared_ptr<TabularDataSet> get_set_of_tables(TabularBackend &backend);
+    /// List the sets of tables in memory and on disk
+    std::vector<TabularDataSetInfo> list();
+    /// Pin or unpin a set of tables, whether or not it is loaded
+    void pin(const std::string &path, bool pin);
+    /// Remove a set of tables from memory, and also from disk if from_disk is true; throws ValueError if it is pinned
+    void evict(const std::string &path, bool from_disk);
+    /// Evict the least recently used sets of tables from memory until MAXIMUM_TABLE_MEMORY_IN_GB is no longer exceeded; mutex must be held
+    void enforce_memory_limit();
+    /// Evict the least recently used sets of tables from disk until MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB is no longer exceeded, return the size of the directory in bytes
+    unsigned long long enforce_disk_limit();
 };
 
 /**
@@ -839,27 +1181,28 @@ class TabularBackend : public AbstractState
     protected:
         phases imposed_phase_index;
         bool tables_loaded, using_single_phase_table, is_mixture;
-        enum selected_table_options{SELECTED_NO_TABLE=0, SELECTED_PH_TABLE, SELECTED_PT_TABLE};
+        enum selected_table_options{SELECTED_NO_TABLE=0, SELECTED_PH_TABLE, SELECTED_PT_TABLE, SELECTED_DU_TABLE};
         selected_table_options selected_table;
         std::size_t cached_single_phase_i, cached_single_phase_j;
         std::size_t cached_saturation_iL, cached_saturation_iV;
-        std::vector<std::vector<double> > const *z;
-        std::vector<std::vector<double> > const *dzdx;
-        std::vector<std::vector<double> > const *dzdy;
-        std::vector<std::vector<double> > const *d2zdx2;
-        std::vector<std::vector<double> > const *d2zdxdy;
-        std::vector<std::vector<double> > const *d2zdy2;
+        TableMatrix const *z;
+        TableMatrix const *dzdx;
+        TableMatrix const *dzdy;
+        TableMatrix const *d2zdx2;
+        TableMatrix const *d2zdxdy;
+        TableMatrix const *d2zdy2;
         std::vector<CoolPropDbl> mole_fractions;
     public:
         shared_ptr<CoolProp::AbstractState> AS;
-        TabularBackend(shared_ptr<CoolProp::AbstractState> AS) : tables_loaded(false), using_single_phase_table(false), is_mixture(false), AS(AS) {
+        TableSpecification spec; ///< The resolution and the ranges of the tables
+        TabularBackend(shared_ptr<CoolProp::AbstractState> AS, const TableSpecification &spec = TableSpecification()) : tables_loaded(false), using_single_phase_table(false), is_mixture(false), AS(AS), spec(spec) {
             selected_table = SELECTED_NO_TABLE;
             // Flush the cached indices (set to large number)
             cached_single_phase_i = std::numeric_limits<std::size_t>::max();
             cached_single_phase_j = std::numeric_limits<std::size_t>::max();
             cached_saturation_iL = std::numeric_limits<std::size_t>::max();
             cached_saturation_iV = std::numeric_limits<std::size_t>::max();
-            z = NULL; dzdx = NULL; dzdy = NULL; d2zdx2 = NULL; d2zdxdy = NULL; d2zdy2 = NULL; dataset = NULL;
+            z = NULL; dzdx = NULL; dzdy = NULL; d2zdx2 = NULL; d2zdxdy = NULL; d2zdy2 = NULL;
             imposed_phase_index = iphase_not_imposed;
         };
 
@@ -877,6 +1220,10 @@ class TabularBackend : public AbstractState
 					z = &table.T; dzdx = &table.dTdx; dzdy = &table.dTdy;
 					d2zdxdy = &table.d2Tdxdy; d2zdx2 = &table.d2Tdx2; d2zdy2 = &table.d2Tdy2;
 					break;
+				case iP:
+					z = &table.p; dzdx = &table.dpdx; dzdy = &table.dpdy;
+					d2zdxdy = &table.d2pdxdy; d2zdx2 = &table.d2pdx2; d2zdy2 = &table.d2pdy2;
+					break;
 				case iDmolar:
 					z = &table.rhomolar; dzdx = &table.drhomolardx; dzdy = &table.drhomolardy;
 					d2zdxdy = &table.d2rhomolardxdy; d2zdx2 = &table.d2rhomolardx2; d2zdy2 = &table.d2rhomolardy2;
@@ -901,7 +1248,7 @@ class TabularBackend : public AbstractState
 					throw ValueError();
 			}
 		}
-        TabularDataSet * dataset;
+        shared_ptr<TabularDataSet> dataset;
 
         void recalculate_singlephase_phase()
         {
@@ -940,16 +1287,19 @@ class TabularBackend : public AbstractState
 
         virtual double evaluate_single_phase_phmolar(parameters output, std::size_t i, std::size_t j) = 0;
         virtual double evaluate_single_phase_pT(parameters output, std::size_t i, std::size_t j) = 0;
+        virtual double evaluate_single_phase_Du(parameters output, std::size_t i, std::size_t j) = 0;
         virtual double evaluate_single_phase_phmolar_transport(parameters output, std::size_t i, std::size_t j) = 0;
         virtual double evaluate_single_phase_pT_transport(parameters output, std::size_t i, std::size_t j) = 0;
+        virtual double evaluate_single_phase_Du_transport(parameters output, std::size_t i, std::size_t j) = 0;
         virtual double evaluate_single_phase_phmolar_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny) = 0;
         virtual double evaluate_single_phase_pT_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny) = 0;
+        virtual double evaluate_single_phase_Du_derivative(parameters output, std::size_t i, std::size_t j, std::size_t Nx, std::size_t Ny) = 0;
 
         /// Ask the derived class to find the nearest good set of i,j that it wants to use (pure virtual)
-        virtual void find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, double x, double y, std::size_t &i, std::size_t &j) = 0;
+        virtual void find_native_nearest_good_indices(SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, double x, double y, std::size_t &i, std::size_t &j) = 0;
         /// Ask the derived class to find the nearest neighbor (pure virtual)
         virtual void find_nearest_neighbor(SinglePhaseGriddedTableData &table,
-                                           const std::vector<std::vector<CellCoeffs> > &coeffs,
+                                           const CellCoeffsMatrix &coeffs,
                                            const parameters variable1,
                                            const double value1,
                                            const parameters other,
@@ -957,9 +1307,9 @@ class TabularBackend : public AbstractState
                                            std::size_t &i,
                                            std::size_t &j) = 0;
         ///
-        virtual void invert_single_phase_x(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j) = 0;
+        virtual void invert_single_phase_x(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j) = 0;
         ///
-        virtual void invert_single_phase_y(const SinglePhaseGriddedTableData &table, const std::vector<std::vector<CellCoeffs> > &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j) = 0;
+        virtual void invert_single_phase_y(const SinglePhaseGriddedTableData &table, const CellCoeffsMatrix &coeffs, parameters output, double x, double y, std::size_t i, std::size_t j) = 0;
 
 
         phases calc_phase(void){ return _phase; }
@@ -987,8 +1337,6 @@ class TabularBackend : public AbstractState
 
         /// Returns the path to the tables that shall be written
         std::string path_to_tables(void);
-        /// Load the tables from file; throws UnableToLoadException if there is a problem
-        void load_tables();
         void pack_matrices(){
             PackablePhaseEnvelopeData & phase_envelope = dataset->phase_envelope;
             PureFluidSaturationTableData &pure_saturation = dataset->pure_saturation;
@@ -1039,42 +1387,11 @@ class TabularBackend : public AbstractState
 		/// If you need all three values (drho_dh__p, drho_dp__h and rho_spline), you should calculate drho_dp__h first to avoid duplicate calculations.
 		CoolPropDbl calc_first_two_phase_deriv_splined(parameters Of, parameters Wrt, parameters Constant, CoolPropDbl x_end);
 
-        void check_tables(){
-            if (!tables_loaded){
-                try{
-                    /// Try to load the tables if you can.
-                    load_tables();
-                    // Set the flag saying tables have been successfully loaded
-                    tables_loaded = true;
-                }
-                catch(CoolProp::UnableToLoadError &e){
-                    if (get_debug_level() > 0){ std::cout << format("Table loading failed with error: %s\n", e.what()); }
-                    /// Check directory size
-                    std::string table_path = path_to_tables();
-                    #if defined(__ISWINDOWS__)
-                        double directory_size_in_GB = CalculateDirSize(std::wstring(table_path.begin(), table_path.end()))/POW3(1024.0);
-                    #else
-                        double directory_size_in_GB = CalculateDirSize(table_path)/POW3(1024.0);
-                    #endif
-                    double allowed_size_in_GB = get_config_double(MAXIMUM_TABLE_DIRECTORY_SIZE_IN_GB);
-                    if (get_debug_level() > 0){std::cout << "Tabular directory size is " << directory_size_in_GB << " GB\n";}
-                    if (directory_size_in_GB > 1.5*allowed_size_in_GB){
-                        throw DirectorySizeError(format("Maximum allowed tabular directory size is %g GB, you have exceeded 1.5 times this limit", allowed_size_in_GB));
-                    }
-                    else if (directory_size_in_GB > allowed_size_in_GB){
-                        set_warning_string(format("Maximum allowed tabular directory size is %g GB, you have exceeded this limit", allowed_size_in_GB));
-                    }
-                    /// If you cannot load the tables, build them and then write them to file
-                    dataset->build_tables(this->AS);
-                    pack_matrices();
-                    write_tables();
-                    /// Load the tables back into memory as a consistency check
-                    load_tables();
-                    // Set the flag saying tables have been successfully loaded
-                    tables_loaded = true;
-                }
-            }
-        };
+        /// Build the tables of dataset and write them to file; called by TabularDataLibrary when they cannot be loaded
+        void build_and_write_tables();
+
+        /// Load the tables, or build them if they cannot be loaded; if another thread is already loading or building them, wait for it
+        void check_tables();
 };
 
 
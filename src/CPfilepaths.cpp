@@ -22,6 +22,9 @@
     #include <windows.h> // for the CreateDirectory function
 #else
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <dirent.h>
+    #include <sys/mman.h>
     #if !defined(__powerpc__)
         #include <pwd.h>
     #endif
@@ -267,3 +270,130 @@ std::string get_file_contents(const char *filename)
     throw(errno);
 }
 
+
+#if defined(__ISWINDOWS__)
+std::vector<std::string> get_subdirectories(const std::string &path)
+{
+    std::vector<std::string> names;
+    WIN32_FIND_DATAA data;
+    HANDLE sh = FindFirstFileA((path + "\\*").c_str(), &data);
+    if (sh == INVALID_HANDLE_VALUE){ return names; }
+    do{
+        std::string name(data.cFileName);
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && name != "." && name != ".."){ names.push_back(name); }
+    } while (FindNextFileA(sh, &data));
+    FindClose(sh);
+    return names;
+}
+void remove_dirs(const std::string &path)
+{
+    WIN32_FIND_DATAA data;
+    HANDLE sh = FindFirstFileA((path + "\\*").c_str(), &data);
+    if (sh != INVALID_HANDLE_VALUE){
+        do{
+            std::string name(data.cFileName);
+            if (name == "." || name == ".."){ continue; }
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY){ remove_dirs(path + "\\" + name); }
+            else{ DeleteFileA((path + "\\" + name).c_str()); }
+        } while (FindNextFileA(sh, &data));
+        FindClose(sh);
+    }
+    RemoveDirectoryA(path.c_str());
+}
+double get_modification_time(const std::string &path)
+{
+    struct _stat buf;
+    if (_stat(path.c_str(), &buf) != 0){ return 0; }
+    return static_cast<double>(buf.st_mtime);
+}
+#else
+std::vector<std::string> get_subdirectories(const std::string &path)
+{
+    std::vector<std::string> names;
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL){ return names; }
+    for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir)){
+        std::string name(entry->d_name);
+        struct stat st;
+        if (name != "." && name != ".." && lstat((path + "/" + name).c_str(), &st) == 0 && S_ISDIR(st.st_mode)){ names.push_back(name); }
+    }
+    closedir(dir);
+    return names;
+}
+void remove_dirs(const std::string &path)
+{
+    DIR *dir = opendir(path.c_str());
+    if (dir != NULL){
+        for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir)){
+            std::string name(entry->d_name);
+            if (name == "." || name == ".."){ continue; }
+            std::string child = path + "/" + name;
+            struct stat st;
+            // Symbolic links are removed, not followed
+            if (lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)){ remove_dirs(child); }
+            else{ remove(child.c_str()); }
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
+double get_modification_time(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0){ return 0; }
+    return static_cast<double>(st.st_mtime);
+}
+#endif
+
+#if defined(__ISWINDOWS__)
+MappedFile::MappedFile(const std::string &path) : m_data(NULL), m_size(0), m_file_handle(NULL), m_mapping_handle(NULL)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE){ throw CoolProp::ValueError(format("Unable to open file %s to map it", path.c_str())); }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+        CloseHandle(file);
+        throw CoolProp::ValueError(format("Unable to map file %s, it is empty", path.c_str()));
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL){
+        CloseHandle(file);
+        throw CoolProp::ValueError(format("Unable to map file %s", path.c_str()));
+    }
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL){
+        CloseHandle(mapping); CloseHandle(file);
+        throw CoolProp::ValueError(format("Unable to map file %s", path.c_str()));
+    }
+    m_data = static_cast<const char *>(data);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    m_file_handle = file; m_mapping_handle = mapping;
+}
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapping_handle));
+    CloseHandle(static_cast<HANDLE>(m_file_handle));
+}
+#else
+MappedFile::MappedFile(const std::string &path) : m_data(NULL), m_size(0), m_file_handle(NULL), m_mapping_handle(NULL)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0){ throw CoolProp::ValueError(format("Unable to open file %s to map it", path.c_str())); }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0){
+        close(fd);
+        throw CoolProp::ValueError(format("Unable to map file %s, it is empty", path.c_str()));
+    }
+    void *data = mmap(NULL, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed
+    close(fd);
+    if (data == MAP_FAILED){ throw CoolProp::ValueError(format("Unable to map file %s", path.c_str())); }
+    m_data = static_cast<const char *>(data);
+    m_size = static_cast<std::size_t>(st.st_size);
+}
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<char *>(m_data), m_size);
+}
+#endif
@@ -218,3 +218,39 @@ double SplineClass::evaluate(double x)
 {
     return a*x*x*x+b*x*x+c*x+d;
 }
+
+void SegmentBucketIndex::build(const std::vector<double> &x, bool logscale)
+{
+    this->logscale = logscale;
+    clear();
+    if (x.size() < 2){ return; }
+    // The range of the indexed values
+    double xmin = _HUGE, xmax = -_HUGE;
+    for (std::size_t i = 0; i < x.size(); ++i){
+        if (indexed(x[i])){ xmin = std::min(xmin, x[i]); xmax = std::max(xmax, x[i]); }
+    }
+    if (!(xmax > xmin)){ return; }
+    std::size_t Nbuckets = x.size() - 1;
+    fmin = scaled(xmin);
+    inv_width = Nbuckets/(scaled(xmax) - fmin);
+    offsets.assign(Nbuckets + 1, 0);
+
+    // Count the segments of each bucket, then fill them in; bucket() is monotonic, so a segment overlaps
+    // all the buckets from the one of its smaller end to the one of its larger end
+    for (std::size_t pass = 0; pass < 2; ++pass){
+        std::vector<std::size_t> filled;
+        if (pass == 1){
+            for (std::size_t k = 0; k < Nbuckets; ++k){ offsets[k+1] += offsets[k]; }
+            segments.resize(offsets[Nbuckets]);
+            filled.assign(offsets.begin(), offsets.end() - 1);
+        }
+        for (std::size_t i = 0; i + 1 < x.size(); ++i){
+            if (!indexed(x[i]) || !indexed(x[i+1])){ continue; }
+            std::size_t kmin = bucket(std::min(x[i], x[i+1])), kmax = bucket(std::max(x[i], x[i+1]));
+            for (std::size_t k = kmin; k <= kmax; ++k){
+                if (pass == 0){ offsets[k+1]++; }
+                else{ segments[filled[k]++] = i; }
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "Configuration.h"
+#include "CoolProp.h"
 #include "src/Backends/REFPROP/REFPROPMixtureBackend.h"
 
 namespace CoolProp
@@ -65,17 +66,22 @@ configuration_keys config_string_to_key(const std::string &s)
 
 static Configuration config;
 
+// The states kept by PropsSI were built with the old configuration, so they are released whenever it changes
 void set_config_bool(configuration_keys key, bool val){
     config.get_item(key).set_bool(val);
+    CoolProp::clear_PropsSI_state_cache();
 }
 void set_config_int(configuration_keys key, int val){
     config.get_item(key).set_integer(val);
+    CoolProp::clear_PropsSI_state_cache();
 }
 void set_config_double(configuration_keys key, double val){
 	config.get_item(key).set_double(val);
+    CoolProp::clear_PropsSI_state_cache();
 }
 void set_config_string(configuration_keys key, const std::string &val){
     config.get_item(key).set_string(val);
+    CoolProp::clear_PropsSI_state_cache();
     if (key == ALTERNATIVE_REFPROP_PATH ||
         key == ALTERNATIVE_REFPROP_HMX_BNC_PATH ||
         key == ALTERNATIVE_REFPROP_LIBRARY_PATH) {
@@ -141,6 +147,7 @@ void set_config_as_json(rapidjson::Value &val){
             throw ValueError(format("Unable to parse json file with error: %s", e.what()));
         }
     }
+    CoolProp::clear_PropsSI_state_cache();
 }
 void set_config_as_json_string(const std::string &s){
     // Init the rapidjson doc
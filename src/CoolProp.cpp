@@ -29,6 +29,8 @@
 #include <memory>
 
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <stdlib.h>
 #include <vector>
 #include <exception>
@@ -36,6 +38,7 @@
 #include <string>
 #include <locale>
 #include "CoolPropTools.h"
+#include "CPthreads.h"
 #include "Solvers.h"
 #include "MatrixMath.h"
 #include "Backends/Helmholtz/Fluids/FluidLibrary.h"
@@ -50,6 +53,7 @@
 
 #if defined(ENABLE_CATCH)
     #include "catch.hpp"
+    #include "TestObjects.h"
 #endif
 
 namespace CoolProp
@@ -271,6 +275,86 @@ void _PropsSI_initialize(const std::string &backend,
     }
 }
 
+/// A size-bounded cache of initialized states for the high-level interface; the least recently used states are evicted first
+///
+/// A state is taken out of the cache while it is in use, so that two concurrent callers never share a state
+class PropsSIStateCache{
+private:
+    typedef std::list<std::pair<std::string, shared_ptr<AbstractState> > > entry_list;
+    entry_list entries; ///< The cached states, most recently used first
+    std::mutex entries_mutex;
+public:
+    /// Take a state out of the cache; the returned pointer is empty if there is no state for this key
+    shared_ptr<AbstractState> checkout(const std::string &key){
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        for (entry_list::iterator it = entries.begin(); it != entries.end(); ++it){
+            if (it->first == key){
+                shared_ptr<AbstractState> State = it->second;
+                entries.erase(it);
+                return State;
+            }
+        }
+        return shared_ptr<AbstractState>();
+    }
+    /// Give a state back to the cache and evict the least recently used states beyond the capacity
+    void checkin(const std::string &key, const shared_ptr<AbstractState> &State, std::size_t capacity){
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        entries.push_front(std::make_pair(key, State));
+        while (entries.size() > capacity){
+            entries.pop_back();
+        }
+    }
+    void clear(){
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        entries.clear();
+    }
+};
+static PropsSIStateCache PropsSI_state_cache;
+
+void clear_PropsSI_state_cache(){
+    PropsSI_state_cache.clear();
+}
+
+/// Build the key of the state cache from the backend, the fluid names and the fractions
+static std::string _PropsSI_state_key(const std::string &backend, const std::vector<std::string> &fluid_names, const std::vector<double> &z){
+    return backend + "|" + strjoin(fluid_names, "&") + "|" + vec_to_string(z, "%0.17g");
+}
+
+/// The states that are used by one call to the high-level interface; they are given back to the state cache when the call returns
+class PropsSIStateLease{
+private:
+    std::string key;
+    std::vector<shared_ptr<AbstractState> > states;
+public:
+    PropsSIStateLease(const std::string &backend, const std::vector<std::string> &fluid_names, const std::vector<double> &z)
+        : key(_PropsSI_state_key(backend, fluid_names, z)){};
+    ~PropsSIStateLease(){
+        int capacity = get_config_int(PROPSSI_STATE_CACHE_SIZE);
+        if (capacity <= 0){ return; }
+        for (std::size_t i = 0; i < states.size(); ++i){
+            PropsSI_state_cache.checkin(key, states[i], static_cast<std::size_t>(capacity));
+        }
+    }
+    /// Get an initialized state, taken from the state cache if possible
+    void acquire(const std::string &backend, const std::vector<std::string> &fluid_names, const std::vector<double> &z, shared_ptr<AbstractState> &State){
+        if (get_config_int(PROPSSI_STATE_CACHE_SIZE) > 0){
+            State = PropsSI_state_cache.checkout(key);
+        }
+        else{
+            State.reset();
+        }
+        if (State.get() != NULL){
+            // Clear the phase that might have been imposed by the previous user of the state; if that is not possible, start over
+            try{ State->unspecify_phase(); }
+            catch(NotImplementedError &){ State.reset(); }
+        }
+        if (State.get() == NULL){
+            _PropsSI_initialize(backend, fluid_names, z, State);
+        }
+        states.push_back(State);
+    }
+};
+
 struct output_parameter{
 	enum OutputParametersType {OUTPUT_TYPE_UNSET = 0, OUTPUT_TYPE_TRIVIAL, OUTPUT_TYPE_NORMAL, OUTPUT_TYPE_FIRST_DERIVATIVE, OUTPUT_TYPE_FIRST_SATURATION_DERIVATIVE, OUTPUT_TYPE_SECOND_DERIVATIVE};
 	CoolProp::parameters Of1, Wrt1, Constant1, Wrt2, Constant2;
@@ -305,6 +389,23 @@ struct output_parameter{
     };
 };
 
+/// Calculate one output from a state that has already been updated
+static double _PropsSI_output(AbstractState &State, const output_parameter &output){
+    switch (output.type){
+        case output_parameter::OUTPUT_TYPE_TRIVIAL:
+        case output_parameter::OUTPUT_TYPE_NORMAL:
+            return State.keyed_output(output.Of1);
+        case output_parameter::OUTPUT_TYPE_FIRST_DERIVATIVE:
+            return State.first_partial_deriv(output.Of1, output.Wrt1, output.Constant1);
+        case output_parameter::OUTPUT_TYPE_FIRST_SATURATION_DERIVATIVE:
+            return State.first_saturation_deriv(output.Of1, output.Wrt1);
+        case output_parameter::OUTPUT_TYPE_SECOND_DERIVATIVE:
+            return State.second_partial_deriv(output.Of1, output.Wrt1, output.Constant1, output.Wrt2, output.Constant2);
+        default:
+            throw ValueError(format(""));
+    }
+}
+
 void _PropsSI_outputs(shared_ptr<AbstractState> &State,
 	     			 const std::vector<output_parameter> &output_parameters,
 		    		 CoolProp::input_pairs input_pair,
@@ -407,29 +508,16 @@ void _PropsSI_outputs(shared_ptr<AbstractState> &State,
             }
             try{
                 const output_parameter &output = output_parameters[j];
-                switch (output.type){
-                    case output_parameter::OUTPUT_TYPE_TRIVIAL:
-                    case output_parameter::OUTPUT_TYPE_NORMAL:
-                        IO[i][j] = State->keyed_output(output.Of1);
-                        if (use_guesses) {
-                            switch (output.Of1) {
-                            case iDmolar: guesses.rhomolar = IO[i][j]; break;
-                            case iT: guesses.T = IO[i][j]; break;
-                            case iP: guesses.p = IO[i][j]; break;
-                            case iHmolar: guesses.hmolar = IO[i][j]; break;
-                            case iSmolar: guesses.smolar = IO[i][j]; break;
-                            default: throw ValueError("Don't understand this parameter");
-                            }
-                        }
-                        break;
-                    case output_parameter::OUTPUT_TYPE_FIRST_DERIVATIVE:
-                        IO[i][j] = State->first_partial_deriv(output.Of1, output.Wrt1, output.Constant1); break;
-                    case output_parameter::OUTPUT_TYPE_FIRST_SATURATION_DERIVATIVE:
-                        IO[i][j] = State->first_saturation_deriv(output.Of1, output.Wrt1); break;
-                    case output_parameter::OUTPUT_TYPE_SECOND_DERIVATIVE:
-                        IO[i][j] = State->second_partial_deriv(output.Of1, output.Wrt1, output.Constant1, output.Wrt2, output.Constant2); break;
-                    default:
-                        throw ValueError(format("")); break;
+                IO[i][j] = _PropsSI_output(*State, output);
+                if (use_guesses && (output.type == output_parameter::OUTPUT_TYPE_TRIVIAL || output.type == output_parameter::OUTPUT_TYPE_NORMAL)) {
+                    switch (output.Of1) {
+                    case iDmolar: guesses.rhomolar = IO[i][j]; break;
+                    case iT: guesses.T = IO[i][j]; break;
+                    case iP: guesses.p = IO[i][j]; break;
+                    case iHmolar: guesses.hmolar = IO[i][j]; break;
+                    case iSmolar: guesses.smolar = IO[i][j]; break;
+                    default: throw ValueError("Don't understand this parameter");
+                    }
                 }
                 // At least one has succeeded
                 success_inner = true;
@@ -457,6 +545,58 @@ void _PropsSI_outputs(shared_ptr<AbstractState> &State,
 }
 
 
+/// Evaluates one contiguous chunk of the input vectors of PropsSImulti, each chunk with its own state instance
+class PropsSIChunkEvaluator{
+public:
+    std::vector<shared_ptr<AbstractState> > &states;
+    const std::vector<output_parameter> &output_parameters;
+    CoolProp::input_pairs input_pair;
+    const std::vector<double> &in1, &in2;
+    std::vector<std::vector<double> > &IO;
+    std::vector<char> &chunk_success;
+    PropsSIChunkEvaluator(std::vector<shared_ptr<AbstractState> > &states, const std::vector<output_parameter> &output_parameters,
+                          CoolProp::input_pairs input_pair, const std::vector<double> &in1, const std::vector<double> &in2,
+                          std::vector<std::vector<double> > &IO, std::vector<char> &chunk_success)
+        : states(states), output_parameters(output_parameters), input_pair(input_pair), in1(in1), in2(in2), IO(IO), chunk_success(chunk_success){};
+    void operator()(std::size_t ithread, std::size_t ibegin, std::size_t iend){
+        std::vector<double> chunk1(in1.begin() + ibegin, in1.begin() + iend), chunk2(in2.begin() + ibegin, in2.begin() + iend);
+        std::vector<std::vector<double> > chunkIO;
+        try{
+            _PropsSI_outputs(states[ithread], output_parameters, input_pair, chunk1, chunk2, chunkIO);
+        }
+        catch(...){
+            // None of the points in this chunk could be calculated; their rows stay filled with _HUGE
+            return;
+        }
+        std::copy(chunkIO.begin(), chunkIO.end(), IO.begin() + ibegin);
+        chunk_success[ithread] = 1;
+    }
+};
+
+/// The parallel version of _PropsSI_outputs; the input vectors are split into one contiguous chunk per state in states
+///
+/// The states must all have been initialized identically (fluid, composition, imposed phase) so that the results are the
+/// same as those of the serial version
+void _PropsSI_outputs_parallel(std::vector<shared_ptr<AbstractState> > &states,
+                               const std::vector<output_parameter> &output_parameters,
+                               CoolProp::input_pairs input_pair,
+                               const std::vector<double> &in1,
+                               const std::vector<double> &in2,
+                               std::vector<std::vector<double> > &IO){
+
+    if (in1.size() != in2.size()){ throw ValueError(format("lengths of in1 [%d] and in2 [%d] are not the same", in1.size(), in2.size()));}
+    std::size_t N2 = std::max(static_cast<std::size_t>(1), output_parameters.size());
+    IO.assign(in1.size(), std::vector<double>(N2, _HUGE));
+    std::vector<char> chunk_success(states.size(), 0);
+
+    PropsSIChunkEvaluator evaluator(states, output_parameters, input_pair, in1, in2, IO, chunk_success);
+    parallel_for_chunks(in1.size(), states.size(), evaluator);
+
+    if (std::find(chunk_success.begin(), chunk_success.end(), 1) == chunk_success.end()){
+        IO.clear(); throw ValueError(format("No outputs were able to be calculated"));
+    }
+}
+
 bool StripPhase(std::string &Name, shared_ptr<AbstractState> &State)
 // Parses an imposed phase out of the Input Name string using the "|" delimiter
 {
@@ -509,14 +649,15 @@ void _PropsSImulti(const std::vector<std::string> &Outputs,
                    std::vector<std::vector<double> > &IO)
 {
     shared_ptr<AbstractState> State;
+    PropsSIStateLease lease(backend, fluids, fractions);
     CoolProp::parameters key1 = INVALID_PARAMETER, key2 = INVALID_PARAMETER;   // Initialize to invalid parameter values
     CoolProp::input_pairs input_pair = INPUT_PAIR_INVALID;                     // Initialize to invalid input pair
     std::vector<output_parameter> output_parameters;
     std::vector<double> v1, v2;
 
     try{
-        // Initialize the State class
-        _PropsSI_initialize(backend, fluids, fractions, State);
+        // Initialize the State class, or reuse one from an earlier call
+        lease.acquire(backend, fluids, fractions, State);
     }
     catch(std::exception &e){
         // Initialization failed.  Stop.
@@ -549,8 +690,64 @@ void _PropsSImulti(const std::vector<std::string> &Outputs,
         throw ValueError(format("Output parameter parsing failed; error: %s", e.what()));
     }
 
+    // Split long input vectors between threads; REFPROP is not thread-safe, and guesses chain the points together, so they stay serial
+    std::size_t Nthreads = get_thread_count(get_config_int(PROPSSI_NUM_THREADS), v1.size());
+    bool parallel = (Nthreads > 1
+                     && input_pair != INPUT_PAIR_INVALID
+                     && v1.size() >= static_cast<std::size_t>(std::max(get_config_int(PROPSSI_PARALLEL_MIN_POINTS), 1))
+                     && !get_config_bool(USE_GUESSES_IN_PROPSSI)
+                     && State->backend_name() != get_backend_string(REFPROP_BACKEND_PURE)
+                     && State->backend_name() != get_backend_string(REFPROP_BACKEND_MIX));
+
+    // Sort the points along a Hilbert curve so that each update can start from the state of the previous one
+    std::vector<std::size_t> order;
+    if (get_config_bool(SORT_BATCH_INPUTS)
+        && input_pair != INPUT_PAIR_INVALID
+        && v1.size() > 2
+        && !get_config_bool(USE_GUESSES_IN_PROPSSI)){
+        AbstractState::get_batch_order(input_pair, &(v1[0]), &(v2[0]), v1.size(), order);
+        std::vector<double> sorted1(v1.size()), sorted2(v2.size());
+        for (std::size_t k = 0; k < order.size(); ++k){
+            sorted1[k] = v1[order[k]];
+            sorted2[k] = v2[order[k]];
+        }
+        v1.swap(sorted1);
+        v2.swap(sorted2);
+    }
+
     // Calculate the output(s).  In the case of a failure, all values will be filled with _HUGE
-    _PropsSI_outputs(State, output_parameters, input_pair, v1, v2, IO);
+    if (parallel){
+        // Each worker thread owns a state; they are all built here since the fluid libraries are populated lazily
+        std::vector<shared_ptr<AbstractState> > states(1, State);
+        for (std::size_t k = 1; k < Nthreads; ++k){
+            shared_ptr<AbstractState> WorkerState;
+            lease.acquire(backend, fluids, fractions, WorkerState);
+            std::string WN1 = Name1, WN2 = Name2;
+            StripPhase(WN1, WorkerState);
+            StripPhase(WN2, WorkerState);
+            states.push_back(WorkerState);
+        }
+        std::vector<shared_ptr<WarmStartScope> > warm_starts;
+        for (std::size_t k = 0; k < states.size() && !order.empty(); ++k){
+            warm_starts.push_back(shared_ptr<WarmStartScope>(new WarmStartScope(*(states[k]))));
+        }
+        _PropsSI_outputs_parallel(states, output_parameters, input_pair, v1, v2, IO);
+    }
+    else{
+        shared_ptr<WarmStartScope> warm_start;
+        if (!order.empty()){ warm_start.reset(new WarmStartScope(*State)); }
+        _PropsSI_outputs(State, output_parameters, input_pair, v1, v2, IO);
+    }
+
+    // Put the results back in the order of the inputs
+    if (!order.empty()){
+        std::vector<std::vector<double> > sortedIO;
+        sortedIO.swap(IO);
+        IO.resize(sortedIO.size());
+        for (std::size_t k = 0; k < order.size(); ++k){
+            IO[order[k]].swap(sortedIO[k]);
+        }
+    }
 }
 
 std::vector<std::vector<double> > PropsSImulti(const std::vector<std::string> &Outputs,
@@ -629,23 +826,118 @@ double PropsSI(const std::string &Output, const std::string &Name1, double Prop1
     #endif
 }
 
+/// The parsed form of a PropsSI call, see PropsSI_plan
+class PropsSI_plan_data{
+public:
+    shared_ptr<AbstractState> State;
+    std::vector<output_parameter> outputs;
+    std::vector<parameters> keyed_outputs; ///< The keys of the outputs if they are all plain outputs, otherwise empty
+    CoolProp::input_pairs input_pair;
+    bool swap; ///< True if the inputs are given in the opposite order from the input pair
+    bool all_trivial_outputs;
+};
+
+PropsSI_plan::PropsSI_plan(const std::string &Outputs, const std::string &Name1, const std::string &Name2, const std::string &FluidName)
+    : data(new PropsSI_plan_data())
+{
+    std::string backend, fluid;
+    extract_backend(FluidName, backend, fluid);
+    std::vector<double> fractions(1, 1.0);
+    std::string fluid_string = extract_fractions(fluid, fractions);
+    _PropsSI_initialize(backend, strsplit(fluid_string, '&'), fractions, data->State);
+
+    std::string N1 = Name1, N2 = Name2;
+    bool HasPhase1 = StripPhase(N1, data->State), HasPhase2 = StripPhase(N2, data->State);
+    if (HasPhase1 && HasPhase2){ throw ValueError("Phase can only be specified on one of the input key strings"); }
+
+    data->outputs = output_parameter::get_output_parameters(strsplit(Outputs, '&'));
+    data->all_trivial_outputs = true;
+    bool all_keyed_outputs = true;
+    for (std::size_t j = 0; j < data->outputs.size(); ++j){
+        output_parameter::OutputParametersType type = data->outputs[j].type;
+        if (type != output_parameter::OUTPUT_TYPE_TRIVIAL){ data->all_trivial_outputs = false; }
+        if (type != output_parameter::OUTPUT_TYPE_TRIVIAL && type != output_parameter::OUTPUT_TYPE_NORMAL){ all_keyed_outputs = false; }
+    }
+    if (all_keyed_outputs){
+        for (std::size_t j = 0; j < data->outputs.size(); ++j){ data->keyed_outputs.push_back(data->outputs[j].Of1); }
+    }
+
+    // The input pair does not depend on the values, so dummy values are used to find out whether the inputs are swapped
+    parameters key1, key2;
+    data->input_pair = INPUT_PAIR_INVALID; data->swap = false;
+    if (is_valid_parameter(N1, key1) && is_valid_parameter(N2, key2)){
+        double out1, out2;
+        data->input_pair = generate_update_pair(key1, 0.0, key2, 1.0, out1, out2);
+        data->swap = (out1 == 1.0);
+    }
+    if (data->input_pair == INPUT_PAIR_INVALID && !data->all_trivial_outputs){
+        throw ValueError(format("Input pair variable is invalid and output(s) are non-trivial; cannot do state update"));
+    }
+}
+std::size_t PropsSI_plan::num_outputs() const{
+    return data->outputs.size();
+}
+void PropsSI_plan::evaluate(double Prop1, double Prop2, double *out){
+    if (data->input_pair != INPUT_PAIR_INVALID && !data->all_trivial_outputs){
+        if (data->swap){ std::swap(Prop1, Prop2); }
+        data->State->update(data->input_pair, Prop1, Prop2);
+    }
+    for (std::size_t j = 0; j < data->outputs.size(); ++j){
+        out[j] = _PropsSI_output(*(data->State), data->outputs[j]);
+    }
+}
+double PropsSI_plan::evaluate(double Prop1, double Prop2){
+    if (data->outputs.size() != 1){ throw ValueError(format("This plan has %d outputs, not one", data->outputs.size())); }
+    double out;
+    evaluate(Prop1, Prop2, &out);
+    return out;
+}
+void PropsSI_plan::evaluate(const double *Prop1, const double *Prop2, std::size_t N, double *out){
+    const double *v1 = (data->swap) ? Prop2 : Prop1, *v2 = (data->swap) ? Prop1 : Prop2;
+    if (!data->keyed_outputs.empty() && data->input_pair != INPUT_PAIR_INVALID){
+        data->State->update_batch(data->input_pair, v1, v2, N, data->keyed_outputs, out);
+        return;
+    }
+    std::size_t Nout = data->outputs.size();
+    for (std::size_t i = 0; i < N; ++i){
+        bool updated = true;
+        try{
+            if (data->input_pair != INPUT_PAIR_INVALID && !data->all_trivial_outputs){
+                data->State->update(data->input_pair, v1[i], v2[i]);
+            }
+        }
+        catch(...){
+            updated = false;
+        }
+        for (std::size_t j = 0; j < Nout; ++j){
+            out[j*N + i] = _HUGE;
+            if (!updated){ continue; }
+            try{ out[j*N + i] = _PropsSI_output(*(data->State), data->outputs[j]); }
+            catch(...){}
+        }
+    }
+}
+
 bool add_fluids_as_JSON(const std::string &backend, const std::string &fluidstring)
 {
     if (backend == "SRK" || backend == "PR")
     {
-        CubicLibrary::add_fluids_as_JSON(fluidstring); return true;
+        CubicLibrary::add_fluids_as_JSON(fluidstring);
     }
     else if (backend == "HEOS")
     {
-        JSONFluidLibrary::add_many(fluidstring); return true;
+        JSONFluidLibrary::add_many(fluidstring);
     }
     else if (backend == "PCSAFT")
     {
-        PCSAFTLibrary::add_fluids_as_JSON(fluidstring); return true;
+        PCSAFTLibrary::add_fluids_as_JSON(fluidstring);
     }
     else{
         throw ValueError(format("You have provided an invalid backend [%s] to add_fluids_as_JSON; valid options are SRK, PR, HEOS",backend.c_str()));
     }
+    // The states kept by PropsSI can be of fluids that were just replaced
+    clear_PropsSI_state_cache();
+    return true;
 }
 #if defined(ENABLE_CATCH)
 TEST_CASE("Check inputs to PropsSI","[PropsSI]")
@@ -770,6 +1062,76 @@ TEST_CASE("Check inputs to PropsSI","[PropsSI]")
         REQUIRE(IO.empty());
     };
 };
+TEST_CASE("Check that the parallel PropsSImulti gives the same results as the serial one","[PropsSImulti],[parallel]")
+{
+    std::vector<double> p, T, z(1, 1.0);
+    for (std::size_t i = 0; i < 2000; ++i){
+        p.push_back(1e5 + 1e3*static_cast<double>(i % 100));
+        T.push_back(250 + 0.2*static_cast<double>(i));
+    }
+    T[10] = -1; // An invalid point
+    std::vector<std::string> outputs(1, "Dmass"); outputs.push_back("Hmass"); outputs.push_back("d(Hmass)/d(T)|P");
+    std::vector<std::string> fluids(1, "Water");
+
+    int num_threads = get_config_int(PROPSSI_NUM_THREADS), min_points = get_config_int(PROPSSI_PARALLEL_MIN_POINTS);
+    set_config_int(PROPSSI_NUM_THREADS, 1);
+    std::vector<std::vector<double> > IOserial = CoolProp::PropsSImulti(outputs, "P", p, "T", T, "HEOS", fluids, z);
+    set_config_int(PROPSSI_NUM_THREADS, 4);
+    set_config_int(PROPSSI_PARALLEL_MIN_POINTS, 100);
+    std::vector<std::vector<double> > IOparallel = CoolProp::PropsSImulti(outputs, "P", p, "T", T, "HEOS", fluids, z);
+    set_config_int(PROPSSI_NUM_THREADS, num_threads);
+    set_config_int(PROPSSI_PARALLEL_MIN_POINTS, min_points);
+
+    REQUIRE(IOserial.size() == p.size());
+    REQUIRE(IOparallel.size() == IOserial.size());
+    CHECK(!ValidNumber(IOparallel[10][0]));
+    for (std::size_t i = 0; i < IOserial.size(); ++i){
+        for (std::size_t j = 0; j < outputs.size(); ++j){
+            if (ValidNumber(IOserial[i][j])){
+                CHECK(IOparallel[i][j] == IOserial[i][j]);
+            }
+            else{
+                CHECK(!ValidNumber(IOparallel[i][j]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Check that the sorted PropsSImulti gives the same results as the unsorted one","[PropsSImulti]")
+{
+    std::vector<double> h, p, z(1, 1.0);
+    for (std::size_t k = 0; k < 500; ++k){
+        std::size_t i = (k*211) % 500;
+        h.push_back(1e5 + 6e3*static_cast<double>(i % 50));
+        p.push_back(1e4*pow(10.0, static_cast<double>(i / 50)/4.0));
+    }
+    h[10] = -1e10; // An invalid point
+    std::vector<std::string> outputs(1, "T"); outputs.push_back("Dmass"); outputs.push_back("Q");
+    std::vector<std::string> fluids(1, "R134a");
+
+    bool sort_inputs = get_config_bool(SORT_BATCH_INPUTS);
+    set_config_bool(SORT_BATCH_INPUTS, false);
+    std::vector<std::vector<double> > IOunsorted = CoolProp::PropsSImulti(outputs, "H", h, "P", p, "HEOS", fluids, z);
+    set_config_bool(SORT_BATCH_INPUTS, true);
+    std::vector<std::vector<double> > IOsorted = CoolProp::PropsSImulti(outputs, "H", h, "P", p, "HEOS", fluids, z);
+    set_config_bool(SORT_BATCH_INPUTS, sort_inputs);
+
+    REQUIRE(IOunsorted.size() == h.size());
+    REQUIRE(IOsorted.size() == IOunsorted.size());
+    CHECK(!ValidNumber(IOsorted[10][0]));
+    for (std::size_t i = 0; i < IOunsorted.size(); ++i){
+        CAPTURE(h[i]);
+        CAPTURE(p[i]);
+        for (std::size_t j = 0; j < outputs.size(); ++j){
+            if (ValidNumber(IOunsorted[i][j])){
+                CHECK(std::abs(IOsorted[i][j] - IOunsorted[i][j]) <= 1e-8*std::abs(IOunsorted[i][j]));
+            }
+            else{
+                CHECK(!ValidNumber(IOsorted[i][j]));
+            }
+        }
+    }
+}
 #endif
 
 /****************************************************
@@ -804,6 +1166,95 @@ double Props1SI(std::string FluidName, std::string Output)
     }
 }
 #if defined(ENABLE_CATCH)
+TEST_CASE("Check that the states reused by PropsSI give the same results as new ones","[PropsSI],[state_cache]")
+{
+    int cache_size = get_config_int(PROPSSI_STATE_CACHE_SIZE);
+    set_config_int(PROPSSI_STATE_CACHE_SIZE, 0);
+    double h_nocache = PropsSI("Hmass", "P", 101325, "T", 300, "Water");
+    double rho_nocache = PropsSI("Dmass", "P", 101325, "T", 300, "R32[0.5]&R125[0.5]");
+    set_config_int(PROPSSI_STATE_CACHE_SIZE, 4);
+    SECTION("Repeated calls"){
+        for (int i = 0; i < 3; ++i){
+            CHECK(PropsSI("Hmass", "P", 101325, "T", 300, "Water") == h_nocache);
+            CHECK(PropsSI("Dmass", "P", 101325, "T", 300, "R32[0.5]&R125[0.5]") == rho_nocache);
+        }
+    }
+    SECTION("Imposed phase is not kept"){
+        CHECK(ValidNumber(PropsSI("Hmass", "P|gas", 101325, "T", 500, "Water")));
+        CHECK(PropsSI("Hmass", "P", 101325, "T", 300, "Water") == h_nocache);
+    }
+    SECTION("Reference state change"){
+        CHECK(PropsSI("Hmass", "P", 101325, "T", 300, "Water") == h_nocache);
+        set_reference_stateS("Water", "NBP");
+        double h_NBP = PropsSI("Hmass", "P", 101325, "T", 300, "Water");
+        set_reference_stateS("Water", "DEF");
+        CHECK(std::abs(h_NBP - h_nocache) > 1);
+        CHECK(PropsSI("Hmass", "P", 101325, "T", 300, "Water") == h_nocache);
+    }
+    SECTION("Binary interaction parameter change"){
+        const std::string fluid = "Methane[0.8]&Ethane[0.2]";
+        std::string CAS1 = get_fluid_param_string("Methane", "CAS"), CAS2 = get_fluid_param_string("Ethane", "CAS");
+        double betaT = atof(get_mixture_binary_pair_data(CAS1, CAS2, "betaT").c_str());
+        double rho = PropsSI("Dmass", "P", 5e6, "T", 300, fluid);
+        CHECK(PropsSI("Dmass", "P", 5e6, "T", 300, fluid) == rho);
+        set_mixture_binary_pair_data(CAS1, CAS2, "betaT", 1.05*betaT);
+        double rho_changed = PropsSI("Dmass", "P", 5e6, "T", 300, fluid);
+        set_mixture_binary_pair_data(CAS1, CAS2, "betaT", betaT);
+        CHECK(std::abs(rho_changed - rho) > 1e-6*rho);
+        CHECK(PropsSI("Dmass", "P", 5e6, "T", 300, fluid) == rho);
+    }
+    SECTION("PC-SAFT kij change"){
+        CoolPropTesting::ConfigBoolScope overwrite(OVERWRITE_BINARY_INTERACTION, true);
+        std::string CAS_water = get_fluid_param_string("WATER", "CAS"), CAS_aacid = "64-19-7";
+        const std::string fluid = "PCSAFT::WATER[0.9]&ACETIC ACID[0.1]";
+        set_mixture_binary_pair_pcsaft(CAS_water, CAS_aacid, "kij", -0.127);
+        double rho = PropsSI("Dmolar", "T", 300, "P", 101325, fluid);
+        CHECK(PropsSI("Dmolar", "T", 300, "P", 101325, fluid) == rho);
+        set_mixture_binary_pair_pcsaft(CAS_water, CAS_aacid, "kij", -0.077);
+        double rho_changed = PropsSI("Dmolar", "T", 300, "P", 101325, fluid);
+        set_mixture_binary_pair_pcsaft(CAS_water, CAS_aacid, "kij", -0.127);
+        CHECK(std::abs(rho_changed - rho) > 1e-6*rho);
+        CHECK(PropsSI("Dmolar", "T", 300, "P", 101325, fluid) == rho);
+    }
+    set_config_int(PROPSSI_STATE_CACHE_SIZE, cache_size);
+}
+
+TEST_CASE("Check that PropsSI_plan gives the same results as PropsSI","[PropsSI],[PropsSI_plan]")
+{
+    SECTION("Single output, swapped inputs"){
+        PropsSI_plan plan("Dmass", "T", "P", "Water");
+        CHECK(plan.num_outputs() == 1);
+        CHECK(plan.evaluate(300, 101325) == PropsSI("Dmass", "T", 300, "P", 101325, "Water"));
+        CHECK(plan.evaluate(400, 101325) == PropsSI("Dmass", "T", 400, "P", 101325, "Water"));
+    }
+    SECTION("Several outputs with a derivative and an imposed phase"){
+        PropsSI_plan plan("Hmass&d(Hmass)/d(T)|P", "P|liquid", "T", "HEOS::Water");
+        double out[2];
+        plan.evaluate(101325, 300, out);
+        CHECK(out[0] == PropsSI("Hmass", "P|liquid", 101325, "T", 300, "HEOS::Water"));
+        CHECK(out[1] == PropsSI("d(Hmass)/d(T)|P", "P|liquid", 101325, "T", 300, "HEOS::Water"));
+    }
+    SECTION("Vectors"){
+        PropsSI_plan plan("Dmass&Hmass", "P", "T", "R32[0.5]&R125[0.5]");
+        double p[3] = {101325, 2e5, 3e5}, T[3] = {300, -1, 350}, out[6];
+        plan.evaluate(p, T, 3, out);
+        for (std::size_t i = 0; i < 3; ++i){
+            if (i == 1){
+                CHECK(!ValidNumber(out[i])); CHECK(!ValidNumber(out[3+i]));
+            }
+            else{
+                CHECK(out[i] == PropsSI("Dmass", "P", p[i], "T", T[i], "R32[0.5]&R125[0.5]"));
+                CHECK(out[3+i] == PropsSI("Hmass", "P", p[i], "T", T[i], "R32[0.5]&R125[0.5]"));
+            }
+        }
+    }
+    SECTION("Invalid strings"){
+        CHECK_THROWS(PropsSI_plan("Dmass", "P", "T", "NotAFluid"));
+        CHECK_THROWS(PropsSI_plan("NotAnOutput", "P", "T", "Water"));
+        CHECK_THROWS(PropsSI_plan("Dmass", "P", "NotAnInput", "Water"));
+    }
+}
+
 TEST_CASE("Check inputs to Props1SI","[Props1SI],[PropsSI]")
 {
     SECTION("Good fluid, good parameter"){
@@ -16,9 +16,14 @@
 #include "AbstractState.h"
 #include "Exceptions.h"
 #include "Configuration.h"
+#include "TabularDataSets.h"
 #include "Backends/Helmholtz/MixtureParameters.h"
 
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 void str2buf(const std::string& str, char * buf, int n)
 {
@@ -378,34 +383,154 @@ EXPORT_CODE void CONVENTION haprops_(const char *Output, const char *Name1, cons
 {
     *output = HAProps(Output, Name1, *Prop1, Name2, *Prop2, Name3, *Prop3);
 }
-class AbstractStateLibrary{
+/// Maps the integer handles of the C interface to the objects that are held in memory
+///
+/// The objects are held in a table of slots that is split into shards, each with its own lock, so that threads that create,
+/// get and free handles at the same time seldom wait for each other.  A handle is made of the index of its slot and the
+/// generation of the slot, which is incremented each time the slot is freed, so that a handle that has already been freed
+/// is detected when it is used, also when its slot has been reused since (unless the generation has wrapped around in
+/// the meantime).  The handles fit in 31 bits, since long can be 32 bit.
+///
+/// Calling get() and remove() on the same handle from several threads is safe, but the objects themselves are not
+/// thread-safe, so one object must not be used by several threads at the same time.
+template<class T>
+class HandleLibrary{
 private:
-    std::map<std::size_t, shared_ptr<CoolProp::AbstractState> > ASlibrary;
-    long next_handle;
+    enum { index_bits = 20, generation_bits = 11, Nshards = 16 };
+    struct Slot{
+        shared_ptr<T> obj;
+        unsigned long generation;
+        Slot() : generation(0){};
+    };
+    struct Shard{
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::deque<std::size_t> free_slots; ///< Reused first in, first out, so that a slot is reused as late as possible
+    };
+    Shard shards[Nshards];
+    std::atomic<unsigned int> next_shard;
+
+    static long make_handle(std::size_t shard, std::size_t islot, unsigned long generation){
+        return static_cast<long>((generation << index_bits) | (islot*Nshards + shard));
+    }
+    /// Split a handle into shard, slot and generation; returns false if the handle can not have been returned by add()
+    static bool split_handle(long handle, std::size_t &shard, std::size_t &islot, unsigned long &generation){
+        if (handle < 0){ return false; }
+        unsigned long h = static_cast<unsigned long>(handle);
+        std::size_t index = h & ((1UL << index_bits) - 1);
+        generation = h >> index_bits;
+        shard = index % Nshards;
+        islot = index / Nshards;
+        return generation < (1UL << generation_bits);
+    }
 public:
-    AbstractStateLibrary(): next_handle(0){};
-    long add(shared_ptr<CoolProp::AbstractState> AS){
-        ASlibrary.insert(std::pair<std::size_t, shared_ptr<CoolProp::AbstractState> >(this->next_handle,  AS));
-        this->next_handle++;
-        return next_handle-1;
+    HandleLibrary(): next_shard(0){};
+    long add(shared_ptr<T> obj){
+        // Start from the next shard in turn, and fall through to the other ones if it is full
+        std::size_t first = next_shard++ % Nshards;
+        for (std::size_t k = 0; k < Nshards; ++k){
+            std::size_t shard = (first + k) % Nshards;
+            Shard &S = shards[shard];
+            std::lock_guard<std::mutex> lock(S.mutex);
+            std::size_t islot;
+            if (!S.free_slots.empty()){
+                islot = S.free_slots.front();
+                S.free_slots.pop_front();
+            }
+            else if ((S.slots.size() + 1)*Nshards <= (1UL << index_bits)){
+                islot = S.slots.size();
+                S.slots.push_back(Slot());
+            }
+            else{
+                continue;
+            }
+            S.slots[islot].obj = obj;
+            return make_handle(shard, islot, S.slots[islot].generation);
+        }
+        throw CoolProp::HandleError("too many handles are in use");
     }
     void remove(long handle){
-        std::size_t count_removed = ASlibrary.erase(handle);
-        if (count_removed != 1){
+        shared_ptr<T> obj; // Destroyed once the lock has been released
+        std::size_t shard, islot; unsigned long generation;
+        if (!split_handle(handle, shard, islot, generation)){
             throw CoolProp::HandleError("could not free handle");
         }
-    }
-    shared_ptr<CoolProp::AbstractState> & get(long handle){
-        std::map<std::size_t, shared_ptr<CoolProp::AbstractState> >::iterator it = ASlibrary.find(handle);
-        if (it != ASlibrary.end()){
-            return it->second;
+        Shard &S = shards[shard];
+        {
+            std::lock_guard<std::mutex> lock(S.mutex);
+            if (islot >= S.slots.size() || !S.slots[islot].obj || S.slots[islot].generation != generation){
+                throw CoolProp::HandleError("could not free handle");
+            }
+            Slot &slot = S.slots[islot];
+            obj.swap(slot.obj);
+            // A slot is retired rather than reused once its generation would wrap, so that a stale handle never becomes valid again
+            if (slot.generation + 1 < (1UL << generation_bits)){
+                slot.generation++;
+                S.free_slots.push_back(islot);
+            }
         }
-        else{
-            throw CoolProp::HandleError("could not get handle");
+    }
+    /// Get the object of a handle; the copy of the shared pointer keeps the object alive even if the handle is freed in the meantime
+    shared_ptr<T> get(long handle){
+        std::size_t shard, islot; unsigned long generation;
+        if (split_handle(handle, shard, islot, generation)){
+            Shard &S = shards[shard];
+            std::lock_guard<std::mutex> lock(S.mutex);
+            if (islot < S.slots.size() && S.slots[islot].obj && S.slots[islot].generation == generation){
+                return S.slots[islot].obj;
+            }
         }
+        throw CoolProp::HandleError("could not get handle");
     }
 };
-static AbstractStateLibrary handle_manager;
+static HandleLibrary<CoolProp::AbstractState> handle_manager;
+static HandleLibrary<CoolProp::PropsSI_plan> plan_handle_manager;
+
+/// Run AbstractState::update_batch and copy the results for output j of point i into outs[j][i*out_stride].
+/// The inputs are read from value1[i*stride1] and value2[i*stride2]. The points are passed to update_batch in blocks
+/// of 1024, and strided inputs are gathered block by block, so that the memory needed does not grow with the length
+/// of the arrays; the grouping and ordering of the points by the backend works within each block.
+/// Outputs that could not be calculated leave the output arrays untouched to keep the behavior of the array functions,
+/// unless fill_failed is true, in which case they are set to _HUGE. Returns the number of points that could not be calculated
+static std::size_t batch_update_and_scatter(shared_ptr<CoolProp::AbstractState> &AS, const long input_pair, const double* value1, const long stride1, const double* value2, const long stride2,
+                                            const long length, const std::vector<CoolProp::parameters> &outputs, double* const* outs, const long out_stride, bool fill_failed = false)
+{
+    if (length <= 0 || outputs.empty()){ return 0; }
+    if (stride1 < 0 || stride2 < 0){ throw CoolProp::ValueError(format("Input strides [%d,%d] may not be negative", stride1, stride2)); }
+    const std::size_t block = 1024;
+    std::size_t N = static_cast<std::size_t>(length), Nblock = std::min(N, block), Nfailed = 0;
+    std::vector<double> out_soa(Nblock*outputs.size()), v1, v2;
+    std::vector<char> failed(Nblock);
+    if (stride1 != 1){ v1.resize(Nblock); }
+    if (stride2 != 1){ v2.resize(Nblock); }
+    for (std::size_t ibegin = 0; ibegin < N; ibegin += Nblock){
+        std::size_t n = std::min(Nblock, N - ibegin);
+        const double *_value1 = value1 + ibegin*stride1, *_value2 = value2 + ibegin*stride2;
+        if (stride1 != 1){
+            for (std::size_t i = 0; i < n; ++i){ v1[i] = _value1[i*stride1]; }
+            _value1 = &(v1[0]);
+        }
+        if (stride2 != 1){
+            for (std::size_t i = 0; i < n; ++i){ v2[i] = _value2[i*stride2]; }
+            _value2 = &(v2[0]);
+        }
+        AS->update_batch(static_cast<CoolProp::input_pairs>(input_pair), _value1, _value2, n, outputs, &(out_soa[0]));
+        std::fill(failed.begin(), failed.begin() + n, 0);
+        for (std::size_t j = 0; j < outputs.size(); ++j){
+            double *out = outs[j] + ibegin*out_stride;
+            for (std::size_t i = 0; i < n; ++i){
+                double val = out_soa[j*n + i];
+                if (ValidNumber(val)){ out[i*out_stride] = val; }
+                else{
+                    failed[i] = 1;
+                    if (fill_failed){ out[i*out_stride] = _HUGE; }
+                }
+            }
+        }
+        Nfailed += static_cast<std::size_t>(std::count(failed.begin(), failed.begin() + n, 1));
+    }
+    return Nfailed;
+}
 
 EXPORT_CODE long CONVENTION AbstractState_factory(const char* backend, const char* fluids, long *errcode, char *message_buffer, const long buffer_length)
 {
@@ -424,7 +549,7 @@ EXPORT_CODE void CONVENTION AbstractState_fluid_names(const long handle, char* f
     *errcode = 0;
 
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         std::vector<std::string> _fluids = AS->fluid_names();
         std::string fluidsstring = strjoin(_fluids, CoolProp::get_config_string(LIST_STRING_DELIMITER));
         if (fluidsstring.size() < static_cast<std::size_t>(buffer_length)) {
@@ -454,7 +579,7 @@ EXPORT_CODE void CONVENTION AbstractState_set_fractions(const long handle, const
     *errcode = 0;
     std::vector<double> _fractions(fractions, fractions + N);
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         if (AS->using_mole_fractions()){
             AS->set_mole_fractions(_fractions);
         }
@@ -474,7 +599,7 @@ EXPORT_CODE void CONVENTION AbstractState_get_mole_fractions(const long handle,
     *errcode = 0;
 
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         std::vector<double> _fractions = AS->get_mole_fractions();
         *N = _fractions.size();
         if (*N <= maxN) {
@@ -493,7 +618,7 @@ EXPORT_CODE void CONVENTION AbstractState_update(const long handle, const long i
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->update(static_cast<CoolProp::input_pairs>(input_pair), value1, value2);
     }
     catch (...) {
@@ -504,7 +629,7 @@ EXPORT_CODE void CONVENTION AbstractState_specify_phase(const long handle,const
 {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         return AS->specify_phase(CoolProp::get_phase_index(std::string(phase)));
     }
     catch (...) {
@@ -515,7 +640,7 @@ EXPORT_CODE void CONVENTION AbstractState_unspecify_phase(const long handle, lon
 {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         return AS->unspecify_phase();
     }
     catch (...) {
@@ -526,7 +651,7 @@ EXPORT_CODE double CONVENTION AbstractState_keyed_output(const long handle, cons
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         return AS->keyed_output(static_cast<CoolProp::parameters>(param));
     }
     catch (...) {
@@ -539,7 +664,7 @@ EXPORT_CODE double CONVENTION AbstractState_first_saturation_deriv(const long ha
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         return AS->first_saturation_deriv(static_cast<CoolProp::parameters>(Of), static_cast<CoolProp::parameters>(Wrt));
     }
     catch (...) {
@@ -552,7 +677,7 @@ EXPORT_CODE double CONVENTION AbstractState_first_partial_deriv(const long handl
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         return AS->first_partial_deriv(static_cast<CoolProp::parameters>(Of), static_cast<CoolProp::parameters>(Wrt), static_cast<CoolProp::parameters>(Constant));
     }
     catch (...) {
@@ -565,21 +690,16 @@ EXPORT_CODE void CONVENTION AbstractState_update_and_common_out(const long handl
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
-
-        for (int i = 0; i<length; i++){
-            try{
-                AS->update(static_cast<CoolProp::input_pairs>(input_pair), *(value1+i), *(value2+i));
-                *(T+i) = AS->T();
-                *(p+i) = AS->p();
-                *(rhomolar+i) = AS->rhomolar();
-                *(hmolar+i) = AS->hmolar();
-                *(smolar+i) = AS->smolar();
-            }
-            catch (...){
-                
-            }
-        };
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
+
+        std::vector<CoolProp::parameters> outputs;
+        outputs.push_back(CoolProp::iT);
+        outputs.push_back(CoolProp::iP);
+        outputs.push_back(CoolProp::iDmolar);
+        outputs.push_back(CoolProp::iHmolar);
+        outputs.push_back(CoolProp::iSmolar);
+        double* outs[] = {T, p, rhomolar, hmolar, smolar};
+        batch_update_and_scatter(AS, input_pair, value1, 1, value2, 1, length, outputs, outs, 1);
     }
     catch (...) {
 		HandleException(errcode, message_buffer, buffer_length);
@@ -590,17 +710,11 @@ EXPORT_CODE void CONVENTION AbstractState_update_and_1_out(const long handle, co
 {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
 
-        for (int i = 0; i<length; i++) {
-            try {
-                AS->update(static_cast<CoolProp::input_pairs>(input_pair), *(value1 + i), *(value2 + i));
-                *(out + i) = AS->keyed_output(static_cast<CoolProp::parameters>(output));
-            }
-            catch (...) {
-
-            }
-        };
+        std::vector<CoolProp::parameters> outputs(1, static_cast<CoolProp::parameters>(output));
+        double* outs[] = {out};
+        batch_update_and_scatter(AS, input_pair, value1, 1, value2, 1, length, outputs, outs, 1);
     }
     catch (...) {
 		HandleException(errcode, message_buffer, buffer_length);
@@ -611,21 +725,38 @@ EXPORT_CODE void CONVENTION AbstractState_update_and_5_out(const long handle, co
 {
     *errcode = 0;
     try{
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
-
-        for (int i = 0; i<length; i++){
-            try{
-                AS->update(static_cast<CoolProp::input_pairs>(input_pair), *(value1+i), *(value2+i));
-                *(out1+i) = AS->keyed_output(static_cast<CoolProp::parameters>(outputs[0]));
-                *(out2+i) = AS->keyed_output(static_cast<CoolProp::parameters>(outputs[1]));
-                *(out3+i) = AS->keyed_output(static_cast<CoolProp::parameters>(outputs[2]));
-                *(out4+i) = AS->keyed_output(static_cast<CoolProp::parameters>(outputs[3]));
-                *(out5+i) = AS->keyed_output(static_cast<CoolProp::parameters>(outputs[4]));
-            }
-            catch (...){
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
 
-            }
-        };
+        std::vector<CoolProp::parameters> _outputs;
+        for (int j = 0; j < 5; j++){
+            _outputs.push_back(static_cast<CoolProp::parameters>(outputs[j]));
+        }
+        double* outs[] = {out1, out2, out3, out4, out5};
+        batch_update_and_scatter(AS, input_pair, value1, 1, value2, 1, length, _outputs, outs, 1);
+    }
+    catch (...) {
+		HandleException(errcode, message_buffer, buffer_length);
+	}
+}
+
+EXPORT_CODE void CONVENTION AbstractState_update_and_n_out(const long handle, const long input_pair, const double* value1, const long stride1, const double* value2, const long stride2, const long length, const long* outputs, const long nout, double* out, const long out_stride, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
+
+        if (nout <= 0){ throw CoolProp::ValueError(format("Number of outputs [%d] must be positive", nout)); }
+        if (out_stride < nout){ throw CoolProp::ValueError(format("Output stride [%d] must be at least the number of outputs [%d]", out_stride, nout)); }
+        std::vector<CoolProp::parameters> _outputs;
+        std::vector<double*> outs;
+        for (long j = 0; j < nout; j++){
+            _outputs.push_back(static_cast<CoolProp::parameters>(outputs[j]));
+            outs.push_back(out + j);
+        }
+        std::size_t Nfailed = batch_update_and_scatter(AS, input_pair, value1, stride1, value2, stride2, length, _outputs, &(outs[0]), out_stride, true);
+        if (Nfailed > 0){
+            throw CoolProp::ValueError(format("%d of the %d points could not be calculated; their outputs are set to _HUGE", static_cast<int>(Nfailed), static_cast<int>(length)));
+        }
     }
     catch (...) {
 		HandleException(errcode, message_buffer, buffer_length);
@@ -636,7 +767,7 @@ EXPORT_CODE void CONVENTION AbstractState_set_binary_interaction_double(const lo
 {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->set_binary_interaction_double(static_cast<std::size_t>(i), static_cast<std::size_t>(j), parameter, value);
     }
     catch (...) {
@@ -647,7 +778,7 @@ EXPORT_CODE void CONVENTION AbstractState_set_binary_interaction_double(const lo
 EXPORT_CODE void CONVENTION  AbstractState_set_cubic_alpha_C(const long handle, const long i, const char* parameter, const double c1, const double c2, const double c3 , long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->set_cubic_alpha_C(static_cast<std::size_t>(i),parameter, c1, c2, c3);
     }
     catch (...) {
@@ -658,7 +789,7 @@ EXPORT_CODE void CONVENTION  AbstractState_set_cubic_alpha_C(const long handle,
 EXPORT_CODE void CONVENTION  AbstractState_set_fluid_parameter_double(const long handle, const long i, const char* parameter, const double value , long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->set_fluid_parameter_double(static_cast<std::size_t>(i), parameter, value);
     }
     catch (...) {
@@ -669,7 +800,7 @@ EXPORT_CODE void CONVENTION  AbstractState_set_fluid_parameter_double(const long
 EXPORT_CODE void CONVENTION AbstractState_build_phase_envelope(const long handle, const char *level, long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->build_phase_envelope(level);
     }
     catch (...) {
@@ -680,7 +811,7 @@ EXPORT_CODE void CONVENTION AbstractState_build_phase_envelope(const long handle
 EXPORT_CODE void CONVENTION AbstractState_get_phase_envelope_data(const long handle, const long length, double* T, double* p, double* rhomolar_vap, double *rhomolar_liq, double *x, double *y, long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         CoolProp::PhaseEnvelopeData pe = AS->get_phase_envelope_data();
         if (pe.T.size() > static_cast<std::size_t>(length)){
             throw CoolProp::ValueError(format("Length of phase envelope vectors [%d] is greater than allocated buffer length [%d]", static_cast<int>(pe.T.size()), static_cast<int>(length)));
@@ -705,7 +836,7 @@ EXPORT_CODE void CONVENTION AbstractState_get_phase_envelope_data(const long han
 EXPORT_CODE void CONVENTION AbstractState_build_spinodal(const long handle, long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         AS->build_spinodal();
     }
     catch (...) {
@@ -716,7 +847,7 @@ EXPORT_CODE void CONVENTION AbstractState_build_spinodal(const long handle, long
 EXPORT_CODE void CONVENTION AbstractState_get_spinodal_data(const long handle, const long length, double* tau, double* delta, double* M1, long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         CoolProp::SpinodalData spin = AS->get_spinodal_data();
         if (spin.tau.size() > static_cast<std::size_t>(length)){
             throw CoolProp::ValueError(format("Length of spinodal vectors [%d] is greater than allocated buffer length [%d]", static_cast<int>(spin.tau.size()), static_cast<int>(length)));
@@ -735,7 +866,7 @@ EXPORT_CODE void CONVENTION AbstractState_get_spinodal_data(const long handle, c
 EXPORT_CODE void CONVENTION AbstractState_all_critical_points(const long handle, long length, double *T, double *p, double *rhomolar, long *stable, long *errcode, char *message_buffer, const long buffer_length) {
     *errcode = 0;
     try {
-        shared_ptr<CoolProp::AbstractState> &AS = handle_manager.get(handle);
+        shared_ptr<CoolProp::AbstractState> AS = handle_manager.get(handle);
         std::vector<CoolProp::CriticalState> pts = AS->all_critical_points();
         if (pts.size() > static_cast<std::size_t>(length)){
             throw CoolProp::ValueError(format("Length of critical point vector [%d] is greater than allocated buffer length [%d]", static_cast<int>(pts.size()), static_cast<int>(length)));
@@ -751,3 +882,273 @@ EXPORT_CODE void CONVENTION AbstractState_all_critical_points(const long handle,
         HandleException(errcode, message_buffer, buffer_length);
     }
 }
+
+EXPORT_CODE long CONVENTION PropsSI_plan_compile(const char *Output, const char *Name1, const char *Name2, const char *FluidName, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        shared_ptr<CoolProp::PropsSI_plan> plan(new CoolProp::PropsSI_plan(Output, Name1, Name2, FluidName));
+        return plan_handle_manager.add(plan);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+    return -1;
+}
+EXPORT_CODE double CONVENTION PropsSI_plan_evaluate(const long handle, const double Prop1, const double Prop2, long *errcode, char *message_buffer, const long buffer_length)
+{
+    fpu_reset_guard guard;
+    *errcode = 0;
+    try{
+        shared_ptr<CoolProp::PropsSI_plan> plan = plan_handle_manager.get(handle);
+        return plan->evaluate(Prop1, Prop2);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+    return _HUGE;
+}
+EXPORT_CODE void CONVENTION PropsSI_plan_evaluate_n(const long handle, const double *Prop1, const double *Prop2, const long length, double *out, long *errcode, char *message_buffer, const long buffer_length)
+{
+    fpu_reset_guard guard;
+    *errcode = 0;
+    try{
+        shared_ptr<CoolProp::PropsSI_plan> plan = plan_handle_manager.get(handle);
+        if (length > 0){
+            plan->evaluate(Prop1, Prop2, static_cast<std::size_t>(length), out);
+        }
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+}
+EXPORT_CODE void CONVENTION PropsSI_plan_free(const long handle, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        plan_handle_manager.remove(handle);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+}
+
+EXPORT_CODE long CONVENTION list_tabular_data_sets(char *paths, const long paths_length, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        std::vector<CoolProp::TabularDataSetInfo> infos = CoolProp::list_tabular_data_sets();
+        std::string s;
+        for (std::size_t k = 0; k < infos.size(); ++k){ s += infos[k].path + "\n"; }
+        str2buf(s, paths, paths_length);
+        return static_cast<long>(infos.size());
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+    return 0;
+}
+EXPORT_CODE void CONVENTION preload_tabular_data_set(const char *backend, const char *fluid_names, char *path, const long path_length, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        str2buf(CoolProp::preload_tabular_data_set(backend, fluid_names), path, path_length);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+}
+EXPORT_CODE void CONVENTION pin_tabular_data_set(const char *path, const long pin, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        CoolProp::pin_tabular_data_set(path, pin != 0);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+}
+EXPORT_CODE void CONVENTION evict_tabular_data_set(const char *path, const long from_disk, long *errcode, char *message_buffer, const long buffer_length)
+{
+    *errcode = 0;
+    try{
+        CoolProp::evict_tabular_data_set(path, from_disk != 0);
+    }
+    catch (...) {
+        HandleException(errcode, message_buffer, buffer_length);
+    }
+}
+
+#if defined(ENABLE_CATCH)
+#include "catch.hpp"
+#include <thread>
+
+/// Adds, checks and frees handles in a loop, for the test of the concurrent use of a HandleLibrary
+class HandleLibraryWorker{
+public:
+    HandleLibrary<long> &library;
+    long id;
+    std::size_t errors;
+    HandleLibraryWorker(HandleLibrary<long> &library, long id) : library(library), id(id), errors(0){};
+    void operator()(){
+        try{
+            run();
+        }
+        catch(...){
+            errors++;
+        }
+    }
+    void run(){
+        std::vector<long> handles;
+        for (long i = 0; i < 2000; ++i){
+            handles.push_back(library.add(shared_ptr<long>(new long(id*100000 + i))));
+            // Free every other handle as soon as it has been checked, so that the slots are reused by the other threads
+            if (i % 2 == 1){
+                long h = handles.back(); handles.pop_back();
+                if (*library.get(h) != id*100000 + i){ errors++; }
+                library.remove(h);
+            }
+        }
+        for (std::size_t k = 0; k < handles.size(); ++k){
+            if (*library.get(handles[k]) != id*100000 + 2*static_cast<long>(k)){ errors++; }
+            library.remove(handles[k]);
+        }
+    }
+};
+
+TEST_CASE("Check the handles of the C API", "[CoolPropLib],[handles]")
+{
+    HandleLibrary<long> library;
+    SECTION("stale handle is rejected after its slot is reused"){
+        long stale = library.add(shared_ptr<long>(new long(1)));
+        library.remove(stale);
+        CHECK_THROWS_AS(library.get(stale), CoolProp::HandleError);
+        // The handles are spread over the shards, so the slot of the freed handle is reused within a few handles
+        std::vector<long> handles;
+        long reused = -1;
+        for (long i = 0; i < 64 && reused < 0; ++i){
+            handles.push_back(library.add(shared_ptr<long>(new long(i + 2))));
+            // The lowest 20 bits are the index of the slot, the other ones its generation
+            if ((handles.back() & 0xFFFFF) == (stale & 0xFFFFF)){ reused = handles.back(); }
+        }
+        REQUIRE(reused >= 0);
+        CHECK(reused != stale);
+        CHECK_THROWS_AS(library.get(stale), CoolProp::HandleError);
+        CHECK_THROWS_AS(library.remove(stale), CoolProp::HandleError);
+        // The new handle of the slot is not affected
+        CHECK(*library.get(reused) == static_cast<long>(handles.size()) + 1);
+        CHECK_THROWS_AS(library.get(-1), CoolProp::HandleError);
+    }
+    SECTION("slot is retired when its generation would wrap"){
+        long first = library.add(shared_ptr<long>(new long(0)));
+        library.remove(first);
+        // Each shard only has one free slot, which is reused until its 11-bit generation is exhausted
+        for (long i = 1; i < 16*2048 + 64; ++i){
+            long h = library.add(shared_ptr<long>(new long(i)));
+            CHECK(h != first);
+            library.remove(h);
+        }
+        CHECK_THROWS_AS(library.get(first), CoolProp::HandleError);
+    }
+    SECTION("full shard falls through to the other ones"){
+        // The lowest 20 bits of a handle are the index of its slot, so there are 2^20 slots over all the shards
+        std::vector<long> handles;
+        for (long i = 0; i < (1L << 20); ++i){ handles.push_back(library.add(shared_ptr<long>(new long(i)))); }
+        CHECK_THROWS_AS(library.add(shared_ptr<long>(new long(-1))), CoolProp::HandleError);
+        // Free a slot of one shard; the next handle is given that slot, whichever shard is next in turn
+        long freed = handles[5];
+        library.remove(freed);
+        long h = -1;
+        CHECK_NOTHROW(h = library.add(shared_ptr<long>(new long(-2))));
+        CHECK((h & 0xFFFFF) == (freed & 0xFFFFF));
+        CHECK_THROWS_AS(library.add(shared_ptr<long>(new long(-3))), CoolProp::HandleError);
+    }
+    SECTION("concurrent creation and deletion"){
+        std::vector<HandleLibraryWorker> workers;
+        for (long id = 0; id < 8; ++id){ workers.push_back(HandleLibraryWorker(library, id)); }
+        std::vector<std::thread> threads;
+        for (std::size_t k = 0; k < workers.size(); ++k){ threads.push_back(std::thread(std::ref(workers[k]))); }
+        for (std::size_t k = 0; k < threads.size(); ++k){ threads[k].join(); }
+        for (std::size_t k = 0; k < workers.size(); ++k){
+            CAPTURE(k);
+            CHECK(workers[k].errors == 0);
+        }
+    }
+}
+
+TEST_CASE("Check the management of the tabular data sets through the C API", "[CoolPropLib],[Tabular]")
+{
+    long errcode = 0; char message[1000] = "", path[1000] = "";
+    // Small tables so that they are quickly built
+    preload_tabular_data_set("BICUBIC&HEOS[Nx=40,Ny=40,Nsat=100]", "Water", path, 1000, &errcode, message, 1000);
+    CAPTURE(message);
+    REQUIRE(errcode == 0);
+    std::vector<char> paths(100000);
+    long N = list_tabular_data_sets(&(paths[0]), static_cast<long>(paths.size()), &errcode, message, 1000);
+    REQUIRE(errcode == 0);
+    CHECK(N > 0);
+    CHECK(std::string(&(paths[0])).find(std::string(path) + "\n") != std::string::npos);
+    pin_tabular_data_set(path, 1, &errcode, message, 1000);
+    CHECK(errcode == 0);
+    // A pinned set cannot be evicted
+    evict_tabular_data_set(path, 0, &errcode, message, 1000);
+    CHECK(errcode != 0);
+    pin_tabular_data_set(path, 0, &errcode, message, 1000);
+    CHECK(errcode == 0);
+    evict_tabular_data_set(path, 0, &errcode, message, 1000);
+    CHECK(errcode == 0);
+    // The buffer is too small for the path
+    preload_tabular_data_set("BICUBIC&HEOS[Nx=40,Ny=40,Nsat=100]", "Water", path, 2, &errcode, message, 1000);
+    CHECK(errcode != 0);
+    preload_tabular_data_set("HEOS", "Water", path, 1000, &errcode, message, 1000);
+    CHECK(errcode != 0);
+}
+
+TEST_CASE("Check the strided batch update of the C API against AbstractState_update_and_common_out", "[CoolPropLib],[batch]")
+{
+    long errcode = 0; char message[1000] = "";
+    long handle = AbstractState_factory("HEOS", "Water", &errcode, message, 1000);
+    REQUIRE(errcode == 0);
+    // More points than the blocks of 1024 points the batches are split into; the temperatures are interleaved with another
+    // column, the pressure is the same for all the points and the outputs are padded
+    const long N = 2500, stride1 = 3, nout = 5, out_stride = 7;
+    std::vector<double> p(1, 101325), Tcolumns(N*stride1, -1), T(N), out(N*out_stride, -1);
+    for (long i = 0; i < N; ++i){ T[i] = 300 + 0.2*i; Tcolumns[i*stride1] = T[i]; }
+    long outputs[] = { CoolProp::iT, CoolProp::iP, CoolProp::iDmolar, CoolProp::iHmolar, CoolProp::iSmolar };
+    AbstractState_update_and_n_out(handle, CoolProp::PT_INPUTS, &(p[0]), 0, &(Tcolumns[0]), stride1, N, outputs, nout, &(out[0]), out_stride, &errcode, message, 1000);
+    CAPTURE(message);
+    REQUIRE(errcode == 0);
+
+    std::vector<double> pN(N, 101325), Tout(N), pout(N), rhomolar(N), hmolar(N), smolar(N);
+    AbstractState_update_and_common_out(handle, CoolProp::PT_INPUTS, &(pN[0]), &(T[0]), N, &(Tout[0]), &(pout[0]), &(rhomolar[0]), &(hmolar[0]), &(smolar[0]), &errcode, message, 1000);
+    REQUIRE(errcode == 0);
+    for (long i = 0; i < N; ++i){
+        CAPTURE(i);
+        CHECK(out[i*out_stride + 0] == Tout[i]);
+        CHECK(out[i*out_stride + 1] == pout[i]);
+        CHECK(out[i*out_stride + 2] == rhomolar[i]);
+        CHECK(out[i*out_stride + 3] == hmolar[i]);
+        CHECK(out[i*out_stride + 4] == smolar[i]);
+        // The padding is not written
+        CHECK(out[i*out_stride + 5] == -1);
+        CHECK(out[i*out_stride + 6] == -1);
+    }
+
+    // Points that cannot be calculated, in the first and in the last block, are set to _HUGE and counted in the error
+    Tcolumns[10*stride1] = -1; Tcolumns[(N - 3)*stride1] = -1;
+    std::fill(out.begin(), out.end(), -1);
+    AbstractState_update_and_n_out(handle, CoolProp::PT_INPUTS, &(p[0]), 0, &(Tcolumns[0]), stride1, N, outputs, nout, &(out[0]), out_stride, &errcode, message, 1000);
+    CHECK(errcode == 1);
+    CHECK(std::string(message).find("2 of the 2500 points could not be calculated") != std::string::npos);
+    for (long i = 0; i < N; ++i){
+        CAPTURE(i);
+        bool failed = (i == 10 || i == N - 3);
+        for (long j = 0; j < nout; ++j){
+            CHECK((out[i*out_stride + j] == _HUGE) == failed);
+        }
+        CHECK(out[i*out_stride + 5] == -1);
+    }
+    AbstractState_free(handle, &errcode, message, 1000);
+}
+
+#endif
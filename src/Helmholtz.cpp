@@ -1,6 +1,21 @@
 #include <numeric>
 #include "Helmholtz.h"
 
+#if defined(COOLPROP_GENEXP_SIMD)
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+    #if defined(__GNUC__) || defined(__clang__)
+        // Compile single functions for an instruction set; they are only called if the processor supports it
+        #define COOLPROP_GENEXP_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define COOLPROP_GENEXP_TARGET(isa)
+    #endif
+#endif
+
 #ifdef __ANDROID__
   #undef _A
   #undef _B
@@ -135,156 +150,619 @@ void ResidualHelmholtzGeneralizedExponential::allEigen(const CoolPropDbl &tau, c
     return;
 };
 */
-void ResidualHelmholtzGeneralizedExponential::all(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw()
+void ResidualHelmholtzGeneralizedExponential::add_element(std::size_t i, const CoolPropDbl tau, const CoolPropDbl delta, const CoolPropDbl log_tau, const CoolPropDbl log_delta,
+                                                          const CoolPropDbl one_over_tau, const CoolPropDbl one_over_delta, HelmholtzDerivatives &s, const std::size_t max_order) const
 {
-    CoolPropDbl log_tau = log(tau), log_delta = log(delta), ndteu, 
+    const ResidualHelmholtzGeneralizedExponentialElement &el = elements[i];
+    CoolPropDbl ni = el.n, di = el.d, ti = el.t;
+
+    // Set the u part of exp(u) to zero
+    CoolPropDbl u = 0;
+    CoolPropDbl du_ddelta = 0;
+    CoolPropDbl du_dtau = 0;
+    CoolPropDbl d2u_ddelta2 = 0;
+    CoolPropDbl d2u_dtau2 = 0;
+    CoolPropDbl d3u_ddelta3 = 0;
+    CoolPropDbl d3u_dtau3 = 0;
+    CoolPropDbl d4u_ddelta4 = 0;
+    CoolPropDbl d4u_dtau4 = 0;
+
+    if (delta_li_in_u){
+        CoolPropDbl  ci = el.c, l_double = el.l_double;
+        if (ValidNumber(l_double) && l_double > 0 && std::abs(ci) > DBL_EPSILON){
+            const CoolPropDbl u_increment = (el.l_is_int) ? -ci*powInt(delta, el.l_int) : -ci*pow(delta, l_double);
+            const CoolPropDbl du_ddelta_increment = l_double*u_increment*one_over_delta;
+            const CoolPropDbl d2u_ddelta2_increment = (l_double-1)*du_ddelta_increment*one_over_delta;
+            const CoolPropDbl d3u_ddelta3_increment = (l_double-2)*d2u_ddelta2_increment*one_over_delta;
+            const CoolPropDbl d4u_ddelta4_increment = (l_double-3)*d3u_ddelta3_increment*one_over_delta;
+            u += u_increment;
+            du_ddelta += du_ddelta_increment;
+            d2u_ddelta2 += d2u_ddelta2_increment;
+            d3u_ddelta3 += d3u_ddelta3_increment;
+            d4u_ddelta4 += d4u_ddelta4_increment;
+        }
+    }
+    if (tau_mi_in_u){
+        CoolPropDbl omegai = el.omega, m_double = el.m_double;
+        if (std::abs(m_double) > 0){
+            const CoolPropDbl u_increment = -omegai*pow(tau, m_double);
+            const CoolPropDbl du_dtau_increment = m_double*u_increment*one_over_tau;
+            const CoolPropDbl d2u_dtau2_increment = (m_double-1)*du_dtau_increment*one_over_tau;
+            const CoolPropDbl d3u_dtau3_increment = (m_double-2)*d2u_dtau2_increment*one_over_tau;
+            const CoolPropDbl d4u_dtau4_increment = (m_double-3)*d3u_dtau3_increment*one_over_tau;
+            u += u_increment;
+            du_dtau += du_dtau_increment;
+            d2u_dtau2 += d2u_dtau2_increment;
+            d3u_dtau3 += d3u_dtau3_increment;
+            d4u_dtau4 += d4u_dtau4_increment;
+        }
+    }
+    if (eta1_in_u){
+        CoolPropDbl eta1 = el.eta1, epsilon1 = el.epsilon1;
+        if (ValidNumber(eta1)){
+            u += -eta1*(delta-epsilon1);
+            du_ddelta += -eta1;
+        }
+    }
+    if (eta2_in_u){
+        CoolPropDbl eta2 = el.eta2, epsilon2 = el.epsilon2;
+        if (ValidNumber(eta2)){
+            u += -eta2*POW2(delta-epsilon2);
+            du_ddelta += -2*eta2*(delta-epsilon2);
+            d2u_ddelta2 += -2*eta2;
+        }
+    }
+    if (beta1_in_u){
+        CoolPropDbl beta1 = el.beta1, gamma1 = el.gamma1;
+        if (ValidNumber(beta1)){
+            u += -beta1*(tau-gamma1);
+            du_dtau += -beta1;
+        }
+    }
+    if (beta2_in_u){
+        CoolPropDbl beta2 = el.beta2, gamma2 = el.gamma2;
+        if (ValidNumber(beta2)){
+            u += -beta2*POW2(tau-gamma2);
+            du_dtau += -2*beta2*(tau-gamma2);
+            d2u_dtau2 += -2*beta2;
+        }
+    }
+
+    const CoolPropDbl ndteu = ni*exp(ti*log_tau + di*log_delta + u);
+    CoolPropDbl B_delta[4], B_tau[4];
+    generalized_exponential_B(delta, di, du_ddelta, d2u_ddelta2, d3u_ddelta3, d4u_ddelta4, B_delta, max_order);
+    generalized_exponential_B(tau, ti, du_dtau, d2u_dtau2, d3u_dtau3, d4u_dtau4, B_tau, max_order);
+    add_generalized_exponential_term(s, ndteu, B_delta, B_tau, max_order);
+}
+
+void ResidualHelmholtzGeneralizedExponential::all_term_by_term(const CoolPropDbl &tau, const CoolPropDbl &delta, HelmholtzDerivatives &derivs) throw()
+{
+    CoolPropDbl log_tau = log(tau), log_delta = log(delta),
                 one_over_delta = 1/delta, one_over_tau = 1/tau; // division is much slower than multiplication, so do one division here
     
-    // Maybe split the construction of u and other parts into two separate loops?  
-    // If both loops can get vectorized, could be worth it.
+    HelmholtzDerivatives s = derivs; // Sum in a local copy so that the sums can stay in registers
     const std::size_t N = elements.size();
     for (std::size_t i = 0; i < N; ++i)
     {
-        ResidualHelmholtzGeneralizedExponentialElement &el = elements[i];
-        CoolPropDbl ni = el.n, di = el.d, ti = el.t;
-        
-        // Set the u part of exp(u) to zero
-        CoolPropDbl u = 0;
-        CoolPropDbl du_ddelta = 0;
-        CoolPropDbl du_dtau = 0;
-        CoolPropDbl d2u_ddelta2 = 0;
-        CoolPropDbl d2u_dtau2 = 0;
-        CoolPropDbl d3u_ddelta3 = 0;
-        CoolPropDbl d3u_dtau3 = 0;
-        CoolPropDbl d4u_ddelta4 = 0;
-        CoolPropDbl d4u_dtau4 = 0;
-        
-        if (delta_li_in_u){
-            CoolPropDbl  ci = el.c, l_double = el.l_double;
-            if (ValidNumber(l_double) && l_double > 0 && std::abs(ci) > DBL_EPSILON){
-                const CoolPropDbl u_increment = (el.l_is_int) ? -ci*powInt(delta, el.l_int) : -ci*pow(delta, l_double);
-                const CoolPropDbl du_ddelta_increment = l_double*u_increment*one_over_delta;
-                const CoolPropDbl d2u_ddelta2_increment = (l_double-1)*du_ddelta_increment*one_over_delta;
-                const CoolPropDbl d3u_ddelta3_increment = (l_double-2)*d2u_ddelta2_increment*one_over_delta;
-                const CoolPropDbl d4u_ddelta4_increment = (l_double-3)*d3u_ddelta3_increment*one_over_delta;
-                u += u_increment;
-                du_ddelta += du_ddelta_increment;
-                d2u_ddelta2 += d2u_ddelta2_increment;
-                d3u_ddelta3 += d3u_ddelta3_increment;
-                d4u_ddelta4 += d4u_ddelta4_increment;
-            }
+        add_element(i, tau, delta, log_tau, log_delta, one_over_tau, one_over_delta, s);
+    }
+    scale_generalized_exponential_sums(s, one_over_delta, one_over_tau);
+    derivs = s;
+}
+
+#if defined(COOLPROP_GENEXP_SIMD)
+
+COOLPROP_GENEXP_TARGET("xsave") static generalized_exponential_simd_levels detect_generalized_exponential_simd_support()
+{
+    unsigned int leaf1[4] = {0, 0, 0, 0}, leaf7[4] = {0, 0, 0, 0}; // eax, ebx, ecx, edx of the cpuid leaves 1 and 7
+    unsigned long long xcr0 = 0;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7){ return GENEXP_SIMD_NONE; }
+    __cpuid(regs, 1);
+    for (int i = 0; i < 4; ++i){ leaf1[i] = static_cast<unsigned int>(regs[i]); }
+    __cpuidex(regs, 7, 0);
+    for (int i = 0; i < 4; ++i){ leaf7[i] = static_cast<unsigned int>(regs[i]); }
+    const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+    if (osxsave){ xcr0 = _xgetbv(0); }
+#else
+    if (__get_cpuid_max(0, NULL) < 7){ return GENEXP_SIMD_NONE; }
+    __cpuid(1, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+    __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+    const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+    if (osxsave){
+        unsigned int eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+    }
+#endif
+    const bool fma = (leaf1[2] & (1u << 12)) != 0, avx = (leaf1[2] & (1u << 28)) != 0;
+    const bool avx2 = (leaf7[1] & (1u << 5)) != 0, avx512f = (leaf7[1] & (1u << 16)) != 0;
+    // The operating system also has to save the YMM registers, and for AVX-512 the opmask and ZMM registers, on context switches
+    if (!osxsave || !avx || !fma || !avx2 || (xcr0 & 0x6) != 0x6){ return GENEXP_SIMD_NONE; }
+    if (avx512f && (xcr0 & 0xE6) == 0xE6){ return GENEXP_SIMD_AVX512; }
+    return GENEXP_SIMD_AVX2;
+}
+
+// 1/k! for k = 0..13, the coefficients of the Taylor series of exp(r) for |r| <= ln(2)/2
+static const double genexp_inv_factorial[14] = {1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040, 1.0/40320, 1.0/362880,
+                                                1.0/3628800, 1.0/39916800, 1.0/479001600, 1.0/6227020800.0};
+
+/// exp(x) for four doubles: x = k*ln(2) + r, exp(x) = 2^k*exp(r), with 2^k built in the exponent bits; 0 below -708 and inf above 709
+COOLPROP_GENEXP_TARGET("avx2,fma") static inline __m256d exp_avx2(const __m256d x)
+{
+    const __m256d lo = _mm256_set1_pd(-708.0), hi = _mm256_set1_pd(709.0);
+    const __m256d xc = _mm256_min_pd(_mm256_max_pd(x, lo), hi);
+    const __m256d k = _mm256_round_pd(_mm256_mul_pd(xc, _mm256_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    // ln(2) split in two parts so that the reduction is accurate
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.93147180369123816490e-01), xc);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.90821492927058770002e-10), r);
+    __m256d p = _mm256_set1_pd(genexp_inv_factorial[13]);
+    for (int j = 12; j >= 0; --j){ p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(genexp_inv_factorial[j])); }
+    // Adding 1.5*2^52 puts k + 1023 in the low bits of the mantissa, from where it is shifted into the exponent
+    const __m256i two_k = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(k, _mm256_set1_pd(6755399441055744.0 + 1023))), 52);
+    __m256d y = _mm256_mul_pd(p, _mm256_castsi256_pd(two_k));
+    y = _mm256_blendv_pd(y, _mm256_setzero_pd(), _mm256_cmp_pd(x, lo, _CMP_LT_OQ));
+    y = _mm256_blendv_pd(y, _mm256_set1_pd(HUGE_VAL), _mm256_cmp_pd(x, hi, _CMP_GT_OQ));
+    return _mm256_blendv_pd(y, x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+}
+
+/// The unscaled sums of the derivatives up to the order max_order of the polynomial and exponential groups, four terms at a time
+template<std::size_t max_order>
+COOLPROP_GENEXP_TARGET("avx2,fma") static void generalized_exponential_sums_avx2(const ResidualHelmholtzGeneralizedExponentialGroups &g, const double delta,
+                                                                               const double log_tau, const double log_delta, const double one_over_delta, double *sums)
+{
+    const std::size_t Nsums = (max_order < 3) ? 6 : ((max_order < 4) ? 10 : 15);
+    __m256d acc[15];
+    for (std::size_t j = 0; j < Nsums; ++j){ acc[j] = _mm256_setzero_pd(); }
+    const __m256d lt = _mm256_set1_pd(log_tau), ld = _mm256_set1_pd(log_delta);
+
+    // Polynomial terms; the products of the B factors are constant
+    const std::size_t Np = g.simd_Npoly;
+    for (std::size_t i = 0; i < Np; i += 4){
+        const __m256d e = _mm256_mul_pd(_mm256_loadu_pd(&g.simd_poly_n[i]),
+                                        exp_avx2(_mm256_fmadd_pd(_mm256_loadu_pd(&g.simd_poly_t[i]), lt, _mm256_mul_pd(_mm256_loadu_pd(&g.simd_poly_d[i]), ld))));
+        acc[0] = _mm256_add_pd(acc[0], e);
+        for (std::size_t j = 1; j < Nsums; ++j){ acc[j] = _mm256_fmadd_pd(e, _mm256_loadu_pd(&g.simd_poly_C[(j-1)*Np + i]), acc[j]); }
+    }
+
+    // Exponential terms with integer l; delta^l comes from a table, built by repeated multiplication as powInt() does
+    const std::size_t Ne = g.simd_Nexp;
+    double delta_l[32];
+    delta_l[0] = 1.0;
+    for (int k = 1; k < 32; ++k){ delta_l[k] = delta_l[k-1]*delta; }
+    const __m256d x = _mm256_set1_pd(delta), od = _mm256_set1_pd(one_over_delta), zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0), two = _mm256_set1_pd(2.0), three = _mm256_set1_pd(3.0);
+    for (std::size_t i = 0; i < Ne; i += 4){
+        const __m256d d = _mm256_loadu_pd(&g.simd_exp_d[i]), l = _mm256_loadu_pd(&g.simd_exp_l_double[i]);
+        const __m256d dl = _mm256_i32gather_pd(delta_l, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&g.simd_exp_l_int[i])), 8);
+        const __m256d u = _mm256_mul_pd(_mm256_sub_pd(zero, _mm256_loadu_pd(&g.simd_exp_c[i])), dl);
+        const __m256d du = _mm256_mul_pd(_mm256_mul_pd(l, u), od);
+        const __m256d d2u = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(l, one), du), od);
+        const __m256d e = _mm256_mul_pd(_mm256_loadu_pd(&g.simd_exp_n[i]),
+                                        exp_avx2(_mm256_add_pd(_mm256_fmadd_pd(_mm256_loadu_pd(&g.simd_exp_t[i]), lt, _mm256_mul_pd(d, ld)), u)));
+        // The B factors as in generalized_exponential_B()
+        const __m256d B0 = _mm256_fmadd_pd(x, du, d);
+        const __m256d dB_dx = _mm256_fmadd_pd(x, d2u, du);
+        const __m256d B1 = _mm256_fmadd_pd(x, dB_dx, _mm256_mul_pd(_mm256_sub_pd(B0, one), B0));
+        const __m256d Bt0 = _mm256_loadu_pd(&g.simd_exp_B_tau[i]), Bt1 = _mm256_loadu_pd(&g.simd_exp_B_tau[Ne + i]);
+        // Only explicit FMAs with the sums, so that the compiler cannot contract the products differently for each max_order
+        // and the sums up to max_order are the same as those of all()
+        const __m256d eB0 = _mm256_mul_pd(e, B0), eB1 = _mm256_mul_pd(e, B1);
+        acc[0] = _mm256_add_pd(acc[0], e);
+        acc[1] = _mm256_fmadd_pd(e, B0, acc[1]);
+        acc[2] = _mm256_fmadd_pd(e, Bt0, acc[2]);
+        acc[3] = _mm256_fmadd_pd(e, B1, acc[3]);
+        acc[4] = _mm256_fmadd_pd(eB0, Bt0, acc[4]);
+        acc[5] = _mm256_fmadd_pd(e, Bt1, acc[5]);
+        if (max_order < 3){ continue; }
+        const __m256d d3u = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(l, two), d2u), od);
+        const __m256d d2B_dx2 = _mm256_fmadd_pd(x, d3u, _mm256_mul_pd(two, d2u));
+        const __m256d dB2_dx = _mm256_fmadd_pd(x, d2B_dx2, _mm256_mul_pd(_mm256_mul_pd(two, B0), dB_dx));
+        const __m256d B2 = _mm256_fmadd_pd(x, dB2_dx, _mm256_mul_pd(_mm256_sub_pd(B0, two), B1));
+        const __m256d Bt2 = _mm256_loadu_pd(&g.simd_exp_B_tau[2*Ne + i]);
+        const __m256d eB2 = _mm256_mul_pd(e, B2);
+        acc[6] = _mm256_fmadd_pd(e, B2, acc[6]);
+        acc[7] = _mm256_fmadd_pd(eB1, Bt0, acc[7]);
+        acc[8] = _mm256_fmadd_pd(eB0, Bt1, acc[8]);
+        acc[9] = _mm256_fmadd_pd(e, Bt2, acc[9]);
+        if (max_order < 4){ continue; }
+        const __m256d d4u = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(l, three), d3u), od);
+        const __m256d d3B_dx3 = _mm256_fmadd_pd(x, d4u, _mm256_mul_pd(three, d3u));
+        const __m256d three_x = _mm256_mul_pd(three, x);
+        const __m256d dB3_dx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(x, x), d3B_dx3), _mm256_mul_pd(_mm256_mul_pd(three_x, B0), d2B_dx2)),
+                                             _mm256_add_pd(_mm256_mul_pd(three_x, _mm256_mul_pd(dB_dx, dB_dx)),
+                                                           _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(three, B0), _mm256_sub_pd(B0, one)), dB_dx)));
+        const __m256d B3 = _mm256_fmadd_pd(x, dB3_dx, _mm256_mul_pd(_mm256_sub_pd(B0, three), B2));
+        const __m256d Bt3 = _mm256_loadu_pd(&g.simd_exp_B_tau[3*Ne + i]);
+        acc[10] = _mm256_fmadd_pd(e, B3, acc[10]);
+        acc[11] = _mm256_fmadd_pd(eB2, Bt0, acc[11]);
+        acc[12] = _mm256_fmadd_pd(eB1, Bt1, acc[12]);
+        acc[13] = _mm256_fmadd_pd(eB0, Bt2, acc[13]);
+        acc[14] = _mm256_fmadd_pd(e, Bt3, acc[14]);
+    }
+
+    for (std::size_t j = 0; j < Nsums; ++j){
+        double lanes[4];
+        _mm256_storeu_pd(lanes, acc[j]);
+        sums[j] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+}
+
+/// The same as exp_avx2() for eight doubles
+COOLPROP_GENEXP_TARGET("avx512f,avx2,fma") static inline __m512d exp_avx512(const __m512d x)
+{
+    const __m512d lo = _mm512_set1_pd(-708.0), hi = _mm512_set1_pd(709.0);
+    const __m512d xc = _mm512_min_pd(_mm512_max_pd(x, lo), hi);
+    const __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(xc, _mm512_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(6.93147180369123816490e-01), xc);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(1.90821492927058770002e-10), r);
+    __m512d p = _mm512_set1_pd(genexp_inv_factorial[13]);
+    for (int j = 12; j >= 0; --j){ p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(genexp_inv_factorial[j])); }
+    const __m512i two_k = _mm512_slli_epi64(_mm512_castpd_si512(_mm512_add_pd(k, _mm512_set1_pd(6755399441055744.0 + 1023))), 52);
+    __m512d y = _mm512_mul_pd(p, _mm512_castsi512_pd(two_k));
+    y = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, lo, _CMP_LT_OQ), y, _mm512_setzero_pd());
+    y = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, hi, _CMP_GT_OQ), y, _mm512_set1_pd(HUGE_VAL));
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q), y, x);
+}
+
+/// The same as generalized_exponential_sums_avx2(), eight terms at a time
+template<std::size_t max_order>
+COOLPROP_GENEXP_TARGET("avx512f,avx2,fma") static void generalized_exponential_sums_avx512(const ResidualHelmholtzGeneralizedExponentialGroups &g, const double delta,
+                                                                                         const double log_tau, const double log_delta, const double one_over_delta, double *sums)
+{
+    const std::size_t Nsums = (max_order < 3) ? 6 : ((max_order < 4) ? 10 : 15);
+    __m512d acc[15];
+    for (std::size_t j = 0; j < Nsums; ++j){ acc[j] = _mm512_setzero_pd(); }
+    const __m512d lt = _mm512_set1_pd(log_tau), ld = _mm512_set1_pd(log_delta);
+
+    const std::size_t Np = g.simd_Npoly;
+    for (std::size_t i = 0; i < Np; i += 8){
+        const __m512d e = _mm512_mul_pd(_mm512_loadu_pd(&g.simd_poly_n[i]),
+                                        exp_avx512(_mm512_fmadd_pd(_mm512_loadu_pd(&g.simd_poly_t[i]), lt, _mm512_mul_pd(_mm512_loadu_pd(&g.simd_poly_d[i]), ld))));
+        acc[0] = _mm512_add_pd(acc[0], e);
+        for (std::size_t j = 1; j < Nsums; ++j){ acc[j] = _mm512_fmadd_pd(e, _mm512_loadu_pd(&g.simd_poly_C[(j-1)*Np + i]), acc[j]); }
+    }
+
+    const std::size_t Ne = g.simd_Nexp;
+    double delta_l[32];
+    delta_l[0] = 1.0;
+    for (int k = 1; k < 32; ++k){ delta_l[k] = delta_l[k-1]*delta; }
+    const __m512d x = _mm512_set1_pd(delta), od = _mm512_set1_pd(one_over_delta), zero = _mm512_setzero_pd();
+    const __m512d one = _mm512_set1_pd(1.0), two = _mm512_set1_pd(2.0), three = _mm512_set1_pd(3.0);
+    for (std::size_t i = 0; i < Ne; i += 8){
+        const __m512d d = _mm512_loadu_pd(&g.simd_exp_d[i]), l = _mm512_loadu_pd(&g.simd_exp_l_double[i]);
+        const __m512d dl = _mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&g.simd_exp_l_int[i])), delta_l, 8);
+        const __m512d u = _mm512_mul_pd(_mm512_sub_pd(zero, _mm512_loadu_pd(&g.simd_exp_c[i])), dl);
+        const __m512d du = _mm512_mul_pd(_mm512_mul_pd(l, u), od);
+        const __m512d d2u = _mm512_mul_pd(_mm512_mul_pd(_mm512_sub_pd(l, one), du), od);
+        const __m512d e = _mm512_mul_pd(_mm512_loadu_pd(&g.simd_exp_n[i]),
+                                        exp_avx512(_mm512_add_pd(_mm512_fmadd_pd(_mm512_loadu_pd(&g.simd_exp_t[i]), lt, _mm512_mul_pd(d, ld)), u)));
+        const __m512d B0 = _mm512_fmadd_pd(x, du, d);
+        const __m512d dB_dx = _mm512_fmadd_pd(x, d2u, du);
+        const __m512d B1 = _mm512_fmadd_pd(x, dB_dx, _mm512_mul_pd(_mm512_sub_pd(B0, one), B0));
+        const __m512d Bt0 = _mm512_loadu_pd(&g.simd_exp_B_tau[i]), Bt1 = _mm512_loadu_pd(&g.simd_exp_B_tau[Ne + i]);
+        const __m512d eB0 = _mm512_mul_pd(e, B0), eB1 = _mm512_mul_pd(e, B1);
+        acc[0] = _mm512_add_pd(acc[0], e);
+        acc[1] = _mm512_fmadd_pd(e, B0, acc[1]);
+        acc[2] = _mm512_fmadd_pd(e, Bt0, acc[2]);
+        acc[3] = _mm512_fmadd_pd(e, B1, acc[3]);
+        acc[4] = _mm512_fmadd_pd(eB0, Bt0, acc[4]);
+        acc[5] = _mm512_fmadd_pd(e, Bt1, acc[5]);
+        if (max_order < 3){ continue; }
+        const __m512d d3u = _mm512_mul_pd(_mm512_mul_pd(_mm512_sub_pd(l, two), d2u), od);
+        const __m512d d2B_dx2 = _mm512_fmadd_pd(x, d3u, _mm512_mul_pd(two, d2u));
+        const __m512d dB2_dx = _mm512_fmadd_pd(x, d2B_dx2, _mm512_mul_pd(_mm512_mul_pd(two, B0), dB_dx));
+        const __m512d B2 = _mm512_fmadd_pd(x, dB2_dx, _mm512_mul_pd(_mm512_sub_pd(B0, two), B1));
+        const __m512d Bt2 = _mm512_loadu_pd(&g.simd_exp_B_tau[2*Ne + i]);
+        const __m512d eB2 = _mm512_mul_pd(e, B2);
+        acc[6] = _mm512_fmadd_pd(e, B2, acc[6]);
+        acc[7] = _mm512_fmadd_pd(eB1, Bt0, acc[7]);
+        acc[8] = _mm512_fmadd_pd(eB0, Bt1, acc[8]);
+        acc[9] = _mm512_fmadd_pd(e, Bt2, acc[9]);
+        if (max_order < 4){ continue; }
+        const __m512d d4u = _mm512_mul_pd(_mm512_mul_pd(_mm512_sub_pd(l, three), d3u), od);
+        const __m512d d3B_dx3 = _mm512_fmadd_pd(x, d4u, _mm512_mul_pd(three, d3u));
+        const __m512d three_x = _mm512_mul_pd(three, x);
+        const __m512d dB3_dx = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(x, x), d3B_dx3), _mm512_mul_pd(_mm512_mul_pd(three_x, B0), d2B_dx2)),
+                                             _mm512_add_pd(_mm512_mul_pd(three_x, _mm512_mul_pd(dB_dx, dB_dx)),
+                                                           _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(three, B0), _mm512_sub_pd(B0, one)), dB_dx)));
+        const __m512d B3 = _mm512_fmadd_pd(x, dB3_dx, _mm512_mul_pd(_mm512_sub_pd(B0, three), B2));
+        const __m512d Bt3 = _mm512_loadu_pd(&g.simd_exp_B_tau[3*Ne + i]);
+        acc[10] = _mm512_fmadd_pd(e, B3, acc[10]);
+        acc[11] = _mm512_fmadd_pd(eB2, Bt0, acc[11]);
+        acc[12] = _mm512_fmadd_pd(eB1, Bt1, acc[12]);
+        acc[13] = _mm512_fmadd_pd(eB0, Bt2, acc[13]);
+        acc[14] = _mm512_fmadd_pd(e, Bt3, acc[14]);
+    }
+
+    for (std::size_t j = 0; j < Nsums; ++j){
+        double lanes[8];
+        _mm512_storeu_pd(lanes, acc[j]);
+        sums[j] = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+}
+
+#endif
+
+generalized_exponential_simd_levels get_generalized_exponential_simd_support()
+{
+#if defined(COOLPROP_GENEXP_SIMD)
+    static const generalized_exponential_simd_levels level = detect_generalized_exponential_simd_support();
+    return level;
+#else
+    return GENEXP_SIMD_NONE;
+#endif
+}
+
+/// Add the sums of the polynomial and exponential groups from the SIMD loops of the level simd to the (not yet scaled) sums s;
+/// false if there are no SIMD loops for this level, in which case the scalar loops have to be used
+static bool add_generalized_exponential_simd_sums(const ResidualHelmholtzGeneralizedExponentialGroups &groups, const generalized_exponential_simd_levels simd,
+                                                  const CoolPropDbl delta, const CoolPropDbl log_tau, const CoolPropDbl log_delta, const CoolPropDbl one_over_delta,
+                                                  const std::size_t max_order, HelmholtzDerivatives &s)
+{
+#if defined(COOLPROP_GENEXP_SIMD)
+    double sums[15];
+    if (simd == GENEXP_SIMD_AVX512){
+        if (max_order < 3){ generalized_exponential_sums_avx512<2>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+        else if (max_order < 4){ generalized_exponential_sums_avx512<3>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+        else{ generalized_exponential_sums_avx512<4>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+    }
+    else if (simd == GENEXP_SIMD_AVX2){
+        if (max_order < 3){ generalized_exponential_sums_avx2<2>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+        else if (max_order < 4){ generalized_exponential_sums_avx2<3>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+        else{ generalized_exponential_sums_avx2<4>(groups, delta, log_tau, log_delta, one_over_delta, sums); }
+    }
+    else{
+        return false;
+    }
+    s.alphar += sums[0];
+    s.dalphar_ddelta += sums[1];
+    s.dalphar_dtau += sums[2];
+    s.d2alphar_ddelta2 += sums[3];
+    s.d2alphar_ddelta_dtau += sums[4];
+    s.d2alphar_dtau2 += sums[5];
+    if (max_order < 3){ return true; }
+    s.d3alphar_ddelta3 += sums[6];
+    s.d3alphar_ddelta2_dtau += sums[7];
+    s.d3alphar_ddelta_dtau2 += sums[8];
+    s.d3alphar_dtau3 += sums[9];
+    if (max_order < 4){ return true; }
+    s.d4alphar_ddelta4 += sums[10];
+    s.d4alphar_ddelta3_dtau += sums[11];
+    s.d4alphar_ddelta2_dtau2 += sums[12];
+    s.d4alphar_ddelta_dtau3 += sums[13];
+    s.d4alphar_dtau4 += sums[14];
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ResidualHelmholtzGeneralizedExponential::group_elements()
+{
+    groups.clear();
+    for (std::size_t i = 0; i < elements.size(); ++i){
+        const ResidualHelmholtzGeneralizedExponentialElement &el = elements[i];
+        // Which parts of u are active for this element, with the same tests as in all_term_by_term()
+        bool has_l = delta_li_in_u && ValidNumber(el.l_double) && el.l_double > 0 && std::abs(el.c) > DBL_EPSILON;
+        bool has_m = tau_mi_in_u && std::abs(el.m_double) > 0;
+        bool has_eta1 = eta1_in_u && ValidNumber(el.eta1) && el.eta1 != 0;
+        bool has_eta2 = eta2_in_u && ValidNumber(el.eta2) && el.eta2 != 0;
+        bool has_beta1 = beta1_in_u && ValidNumber(el.beta1) && el.beta1 != 0;
+        bool has_beta2 = beta2_in_u && ValidNumber(el.beta2) && el.beta2 != 0;
+        bool has_gauss = has_eta1 || has_eta2 || has_beta1 || has_beta2;
+
+        // The tau part of the exponential is zero for the polynomial and exponential groups, so their B_tau are constant
+        CoolPropDbl B_tau[4];
+        generalized_exponential_B(1.0, el.t, 0, 0, 0, 0, B_tau);
+
+        if (!has_l && !has_m && !has_gauss){
+            CoolPropDbl B_delta[4];
+            generalized_exponential_B(1.0, el.d, 0, 0, 0, 0, B_delta);
+            groups.poly_n.push_back(el.n); groups.poly_d.push_back(el.d); groups.poly_t.push_back(el.t);
+            groups.poly_B_delta.insert(groups.poly_B_delta.end(), B_delta, B_delta + 4);
+            groups.poly_B_tau.insert(groups.poly_B_tau.end(), B_tau, B_tau + 4);
         }
-        if (tau_mi_in_u){
-            CoolPropDbl omegai = el.omega, m_double = el.m_double;
-            if (std::abs(m_double) > 0){
-                const CoolPropDbl u_increment = -omegai*pow(tau, m_double);
-                const CoolPropDbl du_dtau_increment = m_double*u_increment*one_over_tau;
-                const CoolPropDbl d2u_dtau2_increment = (m_double-1)*du_dtau_increment*one_over_tau;
-                const CoolPropDbl d3u_dtau3_increment = (m_double-2)*d2u_dtau2_increment*one_over_tau;
-                const CoolPropDbl d4u_dtau4_increment = (m_double-3)*d3u_dtau3_increment*one_over_tau;
-                u += u_increment;
-                du_dtau += du_dtau_increment;
-                d2u_dtau2 += d2u_dtau2_increment;
-                d3u_dtau3 += d3u_dtau3_increment;
-                d4u_dtau4 += d4u_dtau4_increment;
-            }
+        else if (has_l && el.l_is_int && el.l_int < 32 && !has_m && !has_gauss){
+            groups.exp_n.push_back(el.n); groups.exp_d.push_back(el.d); groups.exp_t.push_back(el.t);
+            groups.exp_c.push_back(el.c); groups.exp_l_int.push_back(el.l_int); groups.exp_l_double.push_back(el.l_double);
+            groups.exp_B_tau.insert(groups.exp_B_tau.end(), B_tau, B_tau + 4);
         }
-        if (eta1_in_u){
-            CoolPropDbl eta1 = el.eta1, epsilon1 = el.epsilon1;
-            if (ValidNumber(eta1)){
-                u += -eta1*(delta-epsilon1);
-                du_ddelta += -eta1;
-            }
+        else if (!has_l && !has_m){
+            groups.gauss_n.push_back(el.n); groups.gauss_d.push_back(el.d); groups.gauss_t.push_back(el.t);
+            groups.gauss_eta1.push_back(has_eta1 ? el.eta1 : 0); groups.gauss_epsilon1.push_back(has_eta1 ? el.epsilon1 : 0);
+            groups.gauss_eta2.push_back(has_eta2 ? el.eta2 : 0); groups.gauss_epsilon2.push_back(has_eta2 ? el.epsilon2 : 0);
+            groups.gauss_beta1.push_back(has_beta1 ? el.beta1 : 0); groups.gauss_gamma1.push_back(has_beta1 ? el.gamma1 : 0);
+            groups.gauss_beta2.push_back(has_beta2 ? el.beta2 : 0); groups.gauss_gamma2.push_back(has_beta2 ? el.gamma2 : 0);
+        }
+        else{
+            groups.other.push_back(i);
+        }
+    }
+#if defined(COOLPROP_GENEXP_SIMD)
+    // The polynomial and exponential groups again in the layout of the SIMD loops, padded with terms that add zero
+    const std::size_t Npoly = groups.poly_n.size(), Nexp = groups.exp_n.size();
+    const std::size_t Np = 8*((Npoly + 7)/8), Ne = 8*((Nexp + 7)/8);
+    groups.simd_Npoly = Np; groups.simd_Nexp = Ne;
+    groups.simd_poly_n.assign(Np, 0.0); groups.simd_poly_d.assign(Np, 0.0); groups.simd_poly_t.assign(Np, 0.0);
+    groups.simd_poly_C.assign(14*Np, 0.0);
+    for (std::size_t i = 0; i < Npoly; ++i){
+        const CoolPropDbl *Bd = &(groups.poly_B_delta[4*i]), *Bt = &(groups.poly_B_tau[4*i]);
+        const double C[14] = {Bd[0], Bt[0], Bd[1], Bd[0]*Bt[0], Bt[1], Bd[2], Bd[1]*Bt[0], Bd[0]*Bt[1], Bt[2],
+                              Bd[3], Bd[2]*Bt[0], Bd[1]*Bt[1], Bd[0]*Bt[2], Bt[3]};
+        groups.simd_poly_n[i] = groups.poly_n[i]; groups.simd_poly_d[i] = groups.poly_d[i]; groups.simd_poly_t[i] = groups.poly_t[i];
+        for (std::size_t j = 0; j < 14; ++j){ groups.simd_poly_C[j*Np + i] = C[j]; }
+    }
+    groups.simd_exp_n.assign(Ne, 0.0); groups.simd_exp_d.assign(Ne, 0.0); groups.simd_exp_t.assign(Ne, 0.0);
+    groups.simd_exp_c.assign(Ne, 0.0); groups.simd_exp_l_double.assign(Ne, 1.0); groups.simd_exp_l_int.assign(Ne, 1);
+    groups.simd_exp_B_tau.assign(4*Ne, 0.0);
+    for (std::size_t i = 0; i < Nexp; ++i){
+        groups.simd_exp_n[i] = groups.exp_n[i]; groups.simd_exp_d[i] = groups.exp_d[i]; groups.simd_exp_t[i] = groups.exp_t[i];
+        groups.simd_exp_c[i] = groups.exp_c[i]; groups.simd_exp_l_double[i] = groups.exp_l_double[i]; groups.simd_exp_l_int[i] = groups.exp_l_int[i];
+        for (std::size_t k = 0; k < 4; ++k){ groups.simd_exp_B_tau[k*Ne + i] = groups.exp_B_tau[4*i + k]; }
+    }
+#endif
+}
+
+void ResidualHelmholtzGeneralizedExponential::all_upto(const CoolPropDbl &tau, const CoolPropDbl &delta, std::size_t max_order, HelmholtzDerivatives &derivs) throw()
+{
+    if (kernel != NULL){
+        kernel(tau, delta, max_order, derivs);
+        return;
+    }
+    if (!finished){
+        all_term_by_term(tau, delta, derivs);
+        return;
+    }
+    CoolPropDbl log_tau = log(tau), log_delta = log(delta),
+                one_over_delta = 1/delta, one_over_tau = 1/tau; // division is much slower than multiplication, so do one division here
+
+    HelmholtzDerivatives s = derivs; // Sum in a local copy so that the sums can stay in registers
+
+    // The polynomial and exponential terms in the SIMD loops if the processor supports them, otherwise in the scalar loops below
+    const bool simd_done = add_generalized_exponential_simd_sums(groups, simd, delta, log_tau, log_delta, one_over_delta, max_order, s);
+
+    // Polynomial terms; all the B factors are constant
+    const std::size_t Npoly = simd_done ? 0 : groups.poly_n.size();
+    for (std::size_t i = 0; i < Npoly; ++i){
+        const CoolPropDbl ndteu = groups.poly_n[i]*exp(groups.poly_t[i]*log_tau + groups.poly_d[i]*log_delta);
+        add_generalized_exponential_term(s, ndteu, &(groups.poly_B_delta[4*i]), &(groups.poly_B_tau[4*i]), max_order);
+    }
+
+    // Exponential terms with integer l; the B_tau factors are constant
+    const std::size_t Nexp = simd_done ? 0 : groups.exp_n.size();
+    for (std::size_t i = 0; i < Nexp; ++i){
+        const CoolPropDbl l = groups.exp_l_double[i];
+        const CoolPropDbl u = -groups.exp_c[i]*powInt(delta, groups.exp_l_int[i]);
+        const CoolPropDbl du_ddelta = l*u*one_over_delta;
+        const CoolPropDbl d2u_ddelta2 = (l-1)*du_ddelta*one_over_delta;
+        const CoolPropDbl d3u_ddelta3 = (l-2)*d2u_ddelta2*one_over_delta;
+        const CoolPropDbl d4u_ddelta4 = (l-3)*d3u_ddelta3*one_over_delta;
+        const CoolPropDbl ndteu = groups.exp_n[i]*exp(groups.exp_t[i]*log_tau + groups.exp_d[i]*log_delta + u);
+        CoolPropDbl B_delta[4];
+        generalized_exponential_B(delta, groups.exp_d[i], du_ddelta, d2u_ddelta2, d3u_ddelta3, d4u_ddelta4, B_delta, max_order);
+        add_generalized_exponential_term(s, ndteu, B_delta, &(groups.exp_B_tau[4*i]), max_order);
+    }
+
+    // Gaussian and GERG-2008 terms; the inactive parts of u have zero coefficients
+    const std::size_t Ngauss = groups.gauss_n.size();
+    for (std::size_t i = 0; i < Ngauss; ++i){
+        const CoolPropDbl eta1 = groups.gauss_eta1[i], eta2 = groups.gauss_eta2[i], beta1 = groups.gauss_beta1[i], beta2 = groups.gauss_beta2[i];
+        const CoolPropDbl ddelta2 = delta - groups.gauss_epsilon2[i], dtau2 = tau - groups.gauss_gamma2[i];
+        CoolPropDbl u = 0;
+        u += -eta1*(delta - groups.gauss_epsilon1[i]);
+        u += -eta2*POW2(ddelta2);
+        u += -beta1*(tau - groups.gauss_gamma1[i]);
+        u += -beta2*POW2(dtau2);
+        const CoolPropDbl du_ddelta = -eta1 + -2*eta2*ddelta2, d2u_ddelta2 = -2*eta2;
+        const CoolPropDbl du_dtau = -beta1 + -2*beta2*dtau2, d2u_dtau2 = -2*beta2;
+        const CoolPropDbl ndteu = groups.gauss_n[i]*exp(groups.gauss_t[i]*log_tau + groups.gauss_d[i]*log_delta + u);
+        CoolPropDbl B_delta[4], B_tau[4];
+        generalized_exponential_B(delta, groups.gauss_d[i], du_ddelta, d2u_ddelta2, 0, 0, B_delta, max_order);
+        generalized_exponential_B(tau, groups.gauss_t[i], du_dtau, d2u_dtau2, 0, 0, B_tau, max_order);
+        add_generalized_exponential_term(s, ndteu, B_delta, B_tau, max_order);
+    }
+
+    // Everything else, in the general form
+    for (std::size_t k = 0; k < groups.other.size(); ++k){
+        add_element(groups.other[k], tau, delta, log_tau, log_delta, one_over_tau, one_over_delta, s, max_order);
+    }
+
+    scale_generalized_exponential_sums(s, one_over_delta, one_over_tau, max_order);
+    derivs = s;
+}
+    
+void ResidualHelmholtzGeneralizedExponential::all_batch(const CoolPropDbl *tau, const CoolPropDbl *delta, std::size_t N, HelmholtzDerivatives *derivs) throw()
+{
+    if (!finished){
+        for (std::size_t k = 0; k < N; ++k){ all_term_by_term(tau[k], delta[k], derivs[k]); }
+        return;
+    }
+    if (kernel != NULL){
+        for (std::size_t k = 0; k < N; ++k){ kernel(tau[k], delta[k], 4, derivs[k]); }
+        return;
+    }
+    if (simd != GENEXP_SIMD_NONE){
+        // The SIMD loops run over the terms, one point at a time
+        for (std::size_t k = 0; k < N; ++k){ all_upto(tau[k], delta[k], 4, derivs[k]); }
+        return;
+    }
+    // The points are processed in blocks, so that the sums of a block stay in the cache while the loops over the terms run
+    const std::size_t block_size = 64;
+    CoolPropDbl log_tau[block_size], log_delta[block_size], one_over_tau[block_size], one_over_delta[block_size];
+    HelmholtzDerivatives s[block_size];
+    for (std::size_t kbegin = 0; kbegin < N; kbegin += block_size){
+        const std::size_t Nblock = std::min(block_size, N - kbegin);
+        const CoolPropDbl *tau_ = tau + kbegin, *delta_ = delta + kbegin;
+        for (std::size_t k = 0; k < Nblock; ++k){
+            log_tau[k] = log(tau_[k]); log_delta[k] = log(delta_[k]);
+            one_over_tau[k] = 1/tau_[k]; one_over_delta[k] = 1/delta_[k];
+            s[k] = derivs[kbegin + k];
         }
-        if (eta2_in_u){
-            CoolPropDbl eta2 = el.eta2, epsilon2 = el.epsilon2;
-            if (ValidNumber(eta2)){
-                u += -eta2*POW2(delta-epsilon2);
-                du_ddelta += -2*eta2*(delta-epsilon2);
-                d2u_ddelta2 += -2*eta2;
+
+        // Polynomial terms; all the B factors are constant
+        for (std::size_t i = 0; i < groups.poly_n.size(); ++i){
+            const CoolPropDbl n = groups.poly_n[i], d = groups.poly_d[i], t = groups.poly_t[i];
+            const CoolPropDbl *B_delta = &(groups.poly_B_delta[4*i]), *B_tau = &(groups.poly_B_tau[4*i]);
+            for (std::size_t k = 0; k < Nblock; ++k){
+                add_generalized_exponential_term(s[k], n*exp(t*log_tau[k] + d*log_delta[k]), B_delta, B_tau);
             }
         }
-        if (beta1_in_u){
-            CoolPropDbl beta1 = el.beta1, gamma1 = el.gamma1;
-            if (ValidNumber(beta1)){
-                u += -beta1*(tau-gamma1);
-                du_dtau += -beta1;
+
+        // Exponential terms with integer l; the B_tau factors are constant
+        for (std::size_t i = 0; i < groups.exp_n.size(); ++i){
+            const CoolPropDbl n = groups.exp_n[i], d = groups.exp_d[i], t = groups.exp_t[i], c = groups.exp_c[i], l = groups.exp_l_double[i];
+            const int l_int = groups.exp_l_int[i];
+            const CoolPropDbl *B_tau = &(groups.exp_B_tau[4*i]);
+            for (std::size_t k = 0; k < Nblock; ++k){
+                const CoolPropDbl u = -c*powInt(delta_[k], l_int);
+                const CoolPropDbl du_ddelta = l*u*one_over_delta[k];
+                const CoolPropDbl d2u_ddelta2 = (l-1)*du_ddelta*one_over_delta[k];
+                const CoolPropDbl d3u_ddelta3 = (l-2)*d2u_ddelta2*one_over_delta[k];
+                const CoolPropDbl d4u_ddelta4 = (l-3)*d3u_ddelta3*one_over_delta[k];
+                CoolPropDbl B_delta[4];
+                generalized_exponential_B(delta_[k], d, du_ddelta, d2u_ddelta2, d3u_ddelta3, d4u_ddelta4, B_delta);
+                add_generalized_exponential_term(s[k], n*exp(t*log_tau[k] + d*log_delta[k] + u), B_delta, B_tau);
             }
         }
-        if (beta2_in_u){
-            CoolPropDbl beta2 = el.beta2, gamma2 = el.gamma2;
-            if (ValidNumber(beta2)){
-                u += -beta2*POW2(tau-gamma2);
-                du_dtau += -2*beta2*(tau-gamma2);
-                d2u_dtau2 += -2*beta2;
+
+        // Gaussian and GERG-2008 terms; the inactive parts of u have zero coefficients
+        for (std::size_t i = 0; i < groups.gauss_n.size(); ++i){
+            const CoolPropDbl n = groups.gauss_n[i], d = groups.gauss_d[i], t = groups.gauss_t[i];
+            const CoolPropDbl eta1 = groups.gauss_eta1[i], eta2 = groups.gauss_eta2[i], beta1 = groups.gauss_beta1[i], beta2 = groups.gauss_beta2[i];
+            const CoolPropDbl epsilon1 = groups.gauss_epsilon1[i], epsilon2 = groups.gauss_epsilon2[i], gamma1 = groups.gauss_gamma1[i], gamma2 = groups.gauss_gamma2[i];
+            for (std::size_t k = 0; k < Nblock; ++k){
+                const CoolPropDbl ddelta2 = delta_[k] - epsilon2, dtau2 = tau_[k] - gamma2;
+                CoolPropDbl u = 0;
+                u += -eta1*(delta_[k] - epsilon1);
+                u += -eta2*POW2(ddelta2);
+                u += -beta1*(tau_[k] - gamma1);
+                u += -beta2*POW2(dtau2);
+                const CoolPropDbl du_ddelta = -eta1 + -2*eta2*ddelta2, d2u_ddelta2 = -2*eta2;
+                const CoolPropDbl du_dtau = -beta1 + -2*beta2*dtau2, d2u_dtau2 = -2*beta2;
+                CoolPropDbl B_delta[4], B_tau[4];
+                generalized_exponential_B(delta_[k], d, du_ddelta, d2u_ddelta2, 0, 0, B_delta);
+                generalized_exponential_B(tau_[k], t, du_dtau, d2u_dtau2, 0, 0, B_tau);
+                add_generalized_exponential_term(s[k], n*exp(t*log_tau[k] + d*log_delta[k] + u), B_delta, B_tau);
             }
         }
-        
-        ndteu = ni*exp(ti*log_tau + di*log_delta + u);
-        
-        const CoolPropDbl dB_delta_ddelta = delta*d2u_ddelta2 + du_ddelta;
-        const CoolPropDbl d2B_delta_ddelta2 = delta*d3u_ddelta3 + 2*d2u_ddelta2;
-        const CoolPropDbl d3B_delta_ddelta3 = delta*d4u_ddelta4 + 3*d3u_ddelta3;
-		
-		const CoolPropDbl B_delta = (delta*du_ddelta + di);
-        const CoolPropDbl B_delta2 = delta*dB_delta_ddelta + (B_delta - 1)*B_delta;
-        const CoolPropDbl dB_delta2_ddelta = delta*d2B_delta_ddelta2 + 2*B_delta*dB_delta_ddelta;
-        const CoolPropDbl B_delta3 = delta*dB_delta2_ddelta + (B_delta -  2)*B_delta2;
-        const CoolPropDbl dB_delta3_ddelta = delta*delta*d3B_delta_ddelta3 + 3*delta*B_delta*d2B_delta_ddelta2 + 3*delta*POW2(dB_delta_ddelta)+3*B_delta*(B_delta-1)*dB_delta_ddelta;
-        const CoolPropDbl B_delta4 = delta*dB_delta3_ddelta + (B_delta -  3)*B_delta3;
-        
-		const CoolPropDbl dB_tau_dtau = tau*d2u_dtau2 + du_dtau;
-        const CoolPropDbl d2B_tau_dtau2 = tau*d3u_dtau3 + 2*d2u_dtau2;
-        const CoolPropDbl d3B_tau_dtau3 = tau*d4u_dtau4 + 3*d3u_dtau3;
-        
-		const CoolPropDbl B_tau = (tau*du_dtau + ti);
-		const CoolPropDbl B_tau2 = tau*dB_tau_dtau + (B_tau - 1)*B_tau;
-        const CoolPropDbl dB_tau2_dtau = tau*d2B_tau_dtau2 + 2*B_tau*dB_tau_dtau;
-        const CoolPropDbl B_tau3 = tau*dB_tau2_dtau + (B_tau -  2)*B_tau2;
-        const CoolPropDbl dB_tau3_dtau = tau*tau*d3B_tau_dtau3 + 3*tau*B_tau*d2B_tau_dtau2 + 3*tau*POW2(dB_tau_dtau)+3*B_tau*(B_tau-1)*dB_tau_dtau;
-        const CoolPropDbl B_tau4 = tau*dB_tau3_dtau + (B_tau -  3)*B_tau3;
-
-        derivs.alphar += ndteu;
-        
-        derivs.dalphar_ddelta += ndteu*B_delta;
-        derivs.dalphar_dtau += ndteu*B_tau;
-        
-        derivs.d2alphar_ddelta2 += ndteu*B_delta2;
-        derivs.d2alphar_ddelta_dtau += ndteu*B_delta*B_tau;
-        derivs.d2alphar_dtau2 += ndteu*B_tau2;
-        
-        derivs.d3alphar_ddelta3 += ndteu*B_delta3;
-        derivs.d3alphar_ddelta2_dtau += ndteu*B_delta2*B_tau;
-        derivs.d3alphar_ddelta_dtau2 += ndteu*B_delta*B_tau2;
-        derivs.d3alphar_dtau3 += ndteu*B_tau3;
 
-        derivs.d4alphar_ddelta4 += ndteu*B_delta4;
-        derivs.d4alphar_ddelta3_dtau += ndteu*B_delta3*B_tau;
-        derivs.d4alphar_ddelta2_dtau2 += ndteu*B_delta2*B_tau2;
-        derivs.d4alphar_ddelta_dtau3 += ndteu*B_delta*B_tau3;
-        derivs.d4alphar_dtau4 += ndteu*B_tau4;
+        // Everything else, in the general form
+        for (std::size_t j = 0; j < groups.other.size(); ++j){
+            for (std::size_t k = 0; k < Nblock; ++k){
+                add_element(groups.other[j], tau_[k], delta_[k], log_tau[k], log_delta[k], one_over_tau[k], one_over_delta[k], s[k]);
+            }
+        }
 
+        for (std::size_t k = 0; k < Nblock; ++k){
+            scale_generalized_exponential_sums(s[k], one_over_delta[k], one_over_tau[k]);
+            derivs[kbegin + k] = s[k];
+        }
     }
-    derivs.dalphar_ddelta         *= one_over_delta;
-    derivs.dalphar_dtau           *= one_over_tau;
-    derivs.d2alphar_ddelta2       *= POW2(one_over_delta);
-    derivs.d2alphar_dtau2         *= POW2(one_over_tau);
-    derivs.d2alphar_ddelta_dtau   *= one_over_delta*one_over_tau;
-    
-    derivs.d3alphar_ddelta3       *= POW3(one_over_delta);
-    derivs.d3alphar_dtau3         *= POW3(one_over_tau);
-    derivs.d3alphar_ddelta2_dtau  *= POW2(one_over_delta)*one_over_tau;
-    derivs.d3alphar_ddelta_dtau2  *= one_over_delta*POW2(one_over_tau);
-    
-    derivs.d4alphar_ddelta4       *= POW4(one_over_delta);
-    derivs.d4alphar_dtau4         *= POW4(one_over_tau);
-    derivs.d4alphar_ddelta3_dtau  *= POW3(one_over_delta)*one_over_tau;
-    derivs.d4alphar_ddelta2_dtau2 *= POW2(one_over_delta)*POW2(one_over_tau);
-    derivs.d4alphar_ddelta_dtau3  *= one_over_delta*POW3(one_over_tau);
-    
-    return;
-};
-    
+}
+
 void ResidualHelmholtzGeneralizedExponential::to_json(rapidjson::Value &el, rapidjson::Document &doc){
     el.AddMember("type","GeneralizedExponential",doc.GetAllocator());
     cpjson::set_double_array("n", n, el, doc);
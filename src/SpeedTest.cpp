@@ -3,6 +3,8 @@
 #include "AbstractState.h"
 #include "DataStructures.h"
 #include "crossplatform_shared_ptr.h"
+#include "Backends/Helmholtz/HelmholtzEOSMixtureBackend.h"
+#include "Backends/Helmholtz/FlashRoutines.h"
 
 #include <time.h>
 
@@ -39,4 +41,100 @@ void compare_REFPROP_and_CoolProp(const std::string &fluid, CoolProp::input_pair
     std::cout << format("Elapsed time for REFPROP is %g us/call\n",elap);
 }
 
+/// Time N calls of the term-by-term loop or of GenExp.all(), and return the time per call in us; the sum of d4alphar_dtau4 goes into check
+static double time_generalized_exponential_loop(ResidualHelmholtzGeneralizedExponential &GenExp, bool term_by_term, std::size_t N, double &check)
+{
+    time_t t1,t2;
+    HelmholtzDerivatives derivs;
+    double tau = 1.2, delta = 0.8, dtau = 1e-7;
+    check = 0;
+
+    t1 = clock();
+    for (std::size_t ii = 0; ii < N; ++ii)
+    {
+        derivs.reset(0.0);
+        if (term_by_term){
+            GenExp.all_term_by_term(tau + ii*dtau, delta, derivs);
+        }
+        else{
+            GenExp.all(tau + ii*dtau, delta, derivs);
+        }
+        check += derivs.d4alphar_dtau4;
+    }
+    t2 = clock();
+    return ((double)(t2-t1))/CLOCKS_PER_SEC/((double)N)*1e6;
+}
+
+void time_generalized_exponential(const std::string &fluid, std::size_t N)
+{
+    HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluid));
+    ResidualHelmholtzGeneralizedExponential GenExp = HEOS.get_components()[0].EOS().alphar.GenExp;
+    GenExp.kernel = NULL;
+    const generalized_exponential_simd_levels support = GenExp.simd;
+    double check_term_by_term, check;
+
+    double elap = time_generalized_exponential_loop(GenExp, true, N, check_term_by_term);
+    std::cout << format("%s: elapsed time for the term-by-term loop is %g us/call\n", fluid.c_str(), elap);
+
+    // Only the grouping of the terms, with the same scalar arithmetic per term
+    GenExp.simd = GENEXP_SIMD_NONE;
+    elap = time_generalized_exponential_loop(GenExp, false, N, check);
+    std::cout << format("%s: elapsed time for the scalar loops over the groups is %g us/call (difference of the sums: %g)\n", fluid.c_str(), elap, check - check_term_by_term);
+
+    // The SIMD loops over the polynomial and exponential groups on top of that, for each level the processor supports
+    const char *names[] = {"", "AVX2", "AVX-512"};
+    for (int level = GENEXP_SIMD_AVX2; level <= support; ++level){
+        GenExp.simd = static_cast<generalized_exponential_simd_levels>(level);
+        elap = time_generalized_exponential_loop(GenExp, false, N, check);
+        std::cout << format("%s: elapsed time for the %s loops over the groups is %g us/call (difference of the sums: %g)\n", fluid.c_str(), names[level], elap, check - check_term_by_term);
+    }
+    if (support == GENEXP_SIMD_NONE){
+        std::cout << format("%s: no SIMD loops for this build or processor\n", fluid.c_str());
+    }
+}
+
+void time_HP_flash_singlephase(const std::string &fluid, std::size_t N)
+{
+    time_t t1,t2;
+
+    HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluid));
+    double p = 0.3*HEOS.p_critical();
+    HEOS.update(PQ_INPUTS, p, 0);
+    double Tsat = HEOS.T(), rhoL = HEOS.rhomolar();
+    HEOS.update(PQ_INPUTS, p, 1);
+    double rhoV = HEOS.rhomolar();
+
+    const char *names[] = {"liquid", "vapor"};
+    double T[] = {0.5*(Tsat + HEOS.Ttriple()), Tsat + 30};
+    double Tmin[] = {HEOS.Tmin(), Tsat}, Tmax[] = {Tsat, 1.5*HEOS.Tmax()}, rho0[] = {rhoL, rhoV};
+    phases phase[] = {iphase_liquid, iphase_gas};
+    for (int k = 0; k < 2; ++k)
+    {
+        HEOS.update(PT_INPUTS, p, T[k]);
+        double h = HEOS.hmolar(), check_direct = 0, check_Brent = 0;
+
+        // Both solvers keep the pressure of this state
+        HEOS.update_DmolarT_direct(HEOS.rhomolar(), T[k]);
+        t1 = clock();
+        for (std::size_t ii = 0; ii < N; ++ii)
+        {
+            FlashRoutines::HSU_P_flash_singlephase_direct(HEOS, iHmolar, h, Tsat, rho0[k], Tmin[k], Tmax[k]);
+            check_direct += HEOS.T();
+        }
+        t2 = clock();
+        double elap_direct = ((double)(t2-t1))/CLOCKS_PER_SEC/((double)N)*1e6;
+
+        t1 = clock();
+        for (std::size_t ii = 0; ii < N; ++ii)
+        {
+            FlashRoutines::HSU_P_flash_singlephase_Brent(HEOS, iHmolar, h, Tmin[k], Tmax[k], phase[k]);
+            check_Brent += HEOS.T();
+        }
+        t2 = clock();
+        double elap_Brent = ((double)(t2-t1))/CLOCKS_PER_SEC/((double)N)*1e6;
+        std::cout << format("%s (%s): elapsed time for the direct solver is %g us/call, for the bounded solver %g us/call (difference of the temperatures: %g K)\n",
+                            fluid.c_str(), names[k], elap_direct, elap_Brent, (check_direct - check_Brent)/N);
+    }
+}
+
 } /* namespace CoolProp */
@@ -14,6 +14,7 @@
 #include "catch.hpp"
 #include "CoolPropTools.h"
 #include "CoolProp.h"
+#include "TestObjects.h"
 
 using namespace CoolProp;
 
@@ -879,6 +880,63 @@ TEST_CASE("Tests for solvers in P,T flash using Water", "[flash],[PT]")
 
 }
 
+TEST_CASE("Phase determination in P,T flash near the saturation curve with the superancillary equations", "[flash],[PT],[superancillary]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    for (std::size_t i = 0; i < fluids.size(); ++i){
+        shared_ptr<CoolProp::AbstractState> AS(CoolProp::AbstractState::factory("HEOS", fluids[i]));
+        double Tt = AS->Ttriple(), Tc = AS->T_critical();
+        // Some of the temperatures are low enough for the phase to be determined with the pressure
+        for (double T = Tt + 0.5; T < 0.99*Tc; T += (Tc - Tt)/11){
+            double psat;
+            {
+                // The phase is decided by the side of the vapor pressure, which is better conditioned than the pressure of the
+                // saturated liquid; the latter differs from it by up to 1e-3 near the triple point of n-Propane
+                CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, false);
+                AS->update(CoolProp::QT_INPUTS, 1, T);
+                psat = AS->p();
+            }
+            // Inside the band of the ancillaries, and for the last two, inside the guard band of the superancillaries
+            double offsets[] = {-1e-2, -1e-4, 1e-4, 1e-2, -5e-9, 5e-9};
+            for (std::size_t j = 0; j < 6; ++j){
+                double p = psat*(1 + offsets[j]);
+                CAPTURE(fluids[i]);
+                CAPTURE(T);
+                CAPTURE(p);
+                double rho_exact = _HUGE, rho_superancillary = _HUGE;
+                CoolProp::phases phase_exact = CoolProp::iphase_not_imposed, phase_superancillary = CoolProp::iphase_not_imposed;
+                if (j < 4){
+                    // Outside the guard band the phase is given, and the state is the one of the flash in that phase
+                    phase_exact = (offsets[j] > 0) ? CoolProp::iphase_liquid : CoolProp::iphase_gas;
+                    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, false);
+                    AS->specify_phase(phase_exact);
+                    try{ AS->update(CoolProp::PT_INPUTS, p, T); rho_exact = AS->rhomolar(); }
+                    catch(...){}
+                    AS->unspecify_phase();
+                }
+                else{
+                    // Inside it the saturation state is solved for, as without the superancillary equations
+                    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, false);
+                    try{ AS->update(CoolProp::PT_INPUTS, p, T); rho_exact = AS->rhomolar(); phase_exact = AS->phase(); }
+                    catch(...){}
+                }
+                {
+                    CoolPropTesting::ConfigBoolScope superancillaries(SUPERANCILLARIES_ENABLED, true);
+                    try{ AS->update(CoolProp::PT_INPUTS, p, T); rho_superancillary = AS->rhomolar(); phase_superancillary = AS->phase(); }
+                    catch(...){}
+                }
+                CHECK(phase_superancillary == phase_exact);
+                if (ValidNumber(rho_exact)){
+                    CHECK(std::abs(rho_superancillary/rho_exact - 1) < 1e-10);
+                }
+                else{
+                    CHECK(!ValidNumber(rho_superancillary));
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("Tests for solvers in P,Y flash using Water", "[flash],[PH],[PS],[PU]")
 {
     double Ts, y, T2;
@@ -1958,6 +2016,24 @@ TEST_CASE("Check the phase flags", "[phase]")
     }
 }
 
+TEST_CASE("Check that the property limits can be skipped for a single state", "[limits]")
+{
+    shared_ptr<CoolProp::AbstractState> AS(CoolProp::AbstractState::factory("HEOS", "Water"));
+    shared_ptr<CoolProp::AbstractState> other(CoolProp::AbstractState::factory("HEOS", "Water"));
+    // Below the melting line
+    CHECK_THROWS(AS->update(PT_INPUTS, 101325, 260));
+    AS->set_skip_property_limits(true);
+    CHECK(AS->skip_property_limits());
+    CHECK_NOTHROW(AS->update(PT_INPUTS, 101325, 260));
+    CHECK(AS->phase() == iphase_liquid);
+    // The other states and the configuration are not affected
+    CHECK(!other->skip_property_limits());
+    CHECK_THROWS(other->update(PT_INPUTS, 101325, 260));
+    CHECK(!CoolProp::get_config_bool(DONT_CHECK_PROPERTY_LIMITS));
+    AS->set_skip_property_limits(false);
+    CHECK_THROWS(AS->update(PT_INPUTS, 101325, 260));
+}
+
 TEST_CASE("Check the changing of reducing function constants", "[reducing]")
 {
     double z0 = 0.2;
@@ -1974,6 +2050,146 @@ TEST_CASE("Check the changing of reducing function constants", "[reducing]")
     CHECK(Tdiff > 1e-3); // Make sure that it actually got the change to the interaction parameters
 }
 
+TEST_CASE("Check the grouped generalized exponential terms against the term-by-term loop", "[Helmholtz],[GenExp]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    CoolPropTesting::TauDeltaGrid grid;
+    for (std::size_t k = 0; k < fluids.size(); ++k){
+        CoolProp::HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluids[k]));
+        // The scalar loops over the groups; the SIMD loops are checked against them below
+        CoolProp::ResidualHelmholtzGeneralizedExponential GenExp = HEOS.get_components()[0].EOS().alphar.GenExp;
+        GenExp.kernel = NULL;
+        GenExp.simd = CoolProp::GENEXP_SIMD_NONE;
+        for (std::size_t i = 0; i < grid.size(); ++i){
+            CoolProp::HelmholtzDerivatives grouped, term_by_term;
+            GenExp.all(grid.tau[i], grid.delta[i], grouped);
+            GenExp.all_term_by_term(grid.tau[i], grid.delta[i], term_by_term);
+            CAPTURE(fluids[k]); CAPTURE(grid.tau[i]); CAPTURE(grid.delta[i]);
+            CoolPropTesting::checkHelmholtzDerivatives(grouped, term_by_term, 1e-13, 1e-300);
+        }
+    }
+}
+
+TEST_CASE("Check the SIMD loops over the generalized exponential terms against the scalar loops", "[Helmholtz],[GenExp],[SIMD]")
+{
+    const CoolProp::generalized_exponential_simd_levels support = CoolProp::get_generalized_exponential_simd_support();
+#if !defined(COOLPROP_GENEXP_SIMD)
+    CHECK(support == CoolProp::GENEXP_SIMD_NONE);
+#endif
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    CoolPropTesting::TauDeltaGrid grid;
+    for (std::size_t k = 0; k < fluids.size(); ++k){
+        CoolProp::HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluids[k]));
+        CoolProp::ResidualHelmholtzGeneralizedExponential scalar = HEOS.get_components()[0].EOS().alphar.GenExp;
+        scalar.kernel = NULL;
+        CHECK(scalar.simd == support);
+        scalar.simd = CoolProp::GENEXP_SIMD_NONE;
+        // Every level that this processor supports, not only the best one
+        for (int level = CoolProp::GENEXP_SIMD_AVX2; level <= support; ++level){
+            CoolProp::ResidualHelmholtzGeneralizedExponential simd = scalar;
+            simd.simd = static_cast<CoolProp::generalized_exponential_simd_levels>(level);
+            for (std::size_t i = 0; i < grid.size(); ++i){
+                CAPTURE(fluids[k]); CAPTURE(level); CAPTURE(grid.tau[i]); CAPTURE(grid.delta[i]);
+                for (std::size_t max_order = 2; max_order <= 4; ++max_order){
+                    CoolProp::HelmholtzDerivatives vectorized, expected;
+                    simd.all_upto(grid.tau[i], grid.delta[i], max_order, vectorized);
+                    scalar.all_upto(grid.tau[i], grid.delta[i], max_order, expected);
+                    CAPTURE(max_order);
+                    // The SIMD loops have their own exponential function, use fused multiply-adds and sum in a different order,
+                    // which shows where the terms cancel, e.g. in the fourth derivatives at small delta
+                    CoolPropTesting::checkHelmholtzDerivatives(vectorized, expected, 1e-10, 1e-10, max_order);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Check that the batch evaluation of the Helmholtz containers matches the evaluation point by point", "[Helmholtz],[all_batch]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    // More points than the block size of all_batch
+    CoolPropTesting::TauDeltaGrid grid(0.05);
+    for (std::size_t k = 0; k < fluids.size(); ++k){
+        CoolProp::HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluids[k]));
+        CoolProp::EquationOfState &EOS = HEOS.get_components()[0].EOS();
+        std::vector<CoolProp::HelmholtzDerivatives> alphar(grid.size()), alpha0(grid.size());
+        EOS.alphar.all_batch(&(grid.tau[0]), &(grid.delta[0]), grid.size(), &(alphar[0]));
+        EOS.alpha0.all_batch(&(grid.tau[0]), &(grid.delta[0]), grid.size(), &(alpha0[0]));
+        for (std::size_t i = 0; i < grid.size(); ++i){
+            CAPTURE(fluids[k]); CAPTURE(grid.tau[i]); CAPTURE(grid.delta[i]);
+            CoolPropTesting::checkHelmholtzDerivatives(alphar[i], EOS.alphar.all(grid.tau[i], grid.delta[i]), 0, 0);
+            CoolPropTesting::checkHelmholtzDerivatives(alpha0[i], EOS.alpha0.all(grid.tau[i], grid.delta[i]), 0, 0);
+        }
+    }
+}
+
+TEST_CASE("Check that the derivatives up to a given order are the same as from the full evaluation", "[Helmholtz],[all_upto]")
+{
+    std::vector<std::string> fluids = CoolPropTesting::referenceFluids();
+    CoolPropTesting::TauDeltaGrid grid;
+    for (std::size_t k = 0; k < fluids.size(); ++k){
+        CoolProp::HelmholtzEOSMixtureBackend HEOS(std::vector<std::string>(1, fluids[k]));
+        CoolProp::ResidualHelmholtzContainer &alphar = HEOS.get_components()[0].EOS().alphar;
+        for (std::size_t i = 0; i < grid.size(); ++i){
+            CoolProp::HelmholtzDerivatives full = alphar.all(grid.tau[i], grid.delta[i]);
+            for (std::size_t max_order = 2; max_order <= 4; ++max_order){
+                CAPTURE(fluids[k]); CAPTURE(grid.tau[i]); CAPTURE(grid.delta[i]); CAPTURE(max_order);
+                CoolPropTesting::checkHelmholtzDerivatives(alphar.all_upto(grid.tau[i], grid.delta[i], max_order), full, 0, 0, max_order);
+            }
+        }
+    }
+}
+
+TEST_CASE("Check that the higher derivatives of alphar are calculated when they are requested", "[Helmholtz],[all_upto]")
+{
+    shared_ptr<CoolProp::AbstractState> AS1(CoolProp::AbstractState::factory("HEOS", "Water")), AS2(CoolProp::AbstractState::factory("HEOS", "Water"));
+    AS1->update(CoolProp::PT_INPUTS, 1e6, 400);
+    AS2->update(CoolProp::PT_INPUTS, 1e6, 400);
+    // Only the derivatives up to second order are calculated during the flash
+    double cp = AS2->cpmolar(), w = AS2->speed_sound();
+    double d3 = AS1->d3alphar_dDelta3(), d4 = AS1->d4alphar_dDelta4();
+    CHECK(AS2->d4alphar_dDelta4() == d4);
+    CHECK(AS2->d3alphar_dDelta3() == d3);
+    CHECK(AS2->p() == AS1->p());
+    // Asking for the higher derivatives first does not change the other outputs
+    CHECK(AS1->cpmolar() == cp);
+    CHECK(AS1->speed_sound() == w);
+    AS1->update(CoolProp::PT_INPUTS, 1e6, 300);
+    CHECK(AS1->d4alphar_dDelta4() != d4);
+}
+
+TEST_CASE("Check the specialized kernels of the residual Helmholtz energy against the generic evaluation", "[Helmholtz],[specialized_kernels]")
+{
+    // The fluids for which dev/generate_alphar_kernels.py generates kernels by default
+    const char* fluids[] = {"Water", "CarbonDioxide", "Nitrogen", "R1234yf", "n-Propane"};
+    CoolPropTesting::TauDeltaGrid grid;
+    for (std::size_t k = 0; k < sizeof(fluids)/sizeof(fluids[0]); ++k){
+        CoolProp::HelmholtzEOSBackend HEOS(fluids[k]);
+        CoolProp::ResidualHelmholtzGeneralizedExponential &GenExp = HEOS.get_components()[0].EOS().alphar.GenExp;
+        CAPTURE(fluids[k]);
+#if defined(COOLPROP_SPECIALIZED_KERNELS)
+        REQUIRE(GenExp.kernel != NULL);
+#else
+        CHECK(GenExp.kernel == NULL);
+#endif
+        if (GenExp.kernel == NULL){ continue; }
+        CoolProp::ResidualHelmholtzGeneralizedExponential generic = GenExp;
+        generic.kernel = NULL;
+        generic.simd = CoolProp::GENEXP_SIMD_NONE;
+        for (std::size_t i = 0; i < grid.size(); ++i){
+            CAPTURE(grid.tau[i]); CAPTURE(grid.delta[i]);
+            for (std::size_t max_order = 2; max_order <= 4; ++max_order){
+                CoolProp::HelmholtzDerivatives specialized, expected;
+                GenExp.all_upto(grid.tau[i], grid.delta[i], max_order, specialized);
+                generic.all_upto(grid.tau[i], grid.delta[i], max_order, expected);
+                CAPTURE(max_order);
+                // The coefficients in the kernels can differ in the last bit from the ones parsed from the JSON
+                CoolPropTesting::checkHelmholtzDerivatives(specialized, expected, 1e-12, 1e-12, max_order);
+            }
+        }
+    }
+}
+
 TEST_CASE("Check the PC-SAFT pressure function", "[pcsaft_pressure]")
 {
     double p = 101325.;